@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Interpreter.h"
+#include "Lexer.h"
+#include "MemoryStore.h"
+#include "Parser.h"
+
+// Benchmark harness: microbenchmarks for the interpreter's hot paths and
+// the front end, and macrobenchmarks that load, link and run each testdata
+// program. Reports ns/op and heap allocations per op and can write JSON or
+// compare against an earlier JSON run. Built at -O2 by `make bench`.
+//
+//   bench_runner [--filter substring] [--min-time ms] [--json out.json]
+//                [--compare base.json] [testdata dir]
+
+namespace fs = std::filesystem;
+
+// Every operator new in the process is counted
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Result {
+    std::string name;
+    double nsPerOp;
+    double allocsPerOp;
+    uint64_t ops;
+};
+
+struct Options {
+    std::string filter;
+    double minSeconds = 0.2;
+    std::string jsonPath;
+    std::string comparePath;
+    fs::path testDir = "testdata";
+};
+
+Options options;
+std::vector<Result> results;
+
+// Keeps the optimizer from discarding a benchmark's work
+volatile int64_t sink;
+
+// Runs body (which performs opsPerCall operations) with doubling repetition
+// counts until one batch takes at least the minimum time.
+void bench(const std::string& name, uint64_t opsPerCall, const std::function<void()>& body) {
+    if (name.find(options.filter) == std::string::npos) return;
+    body(); // Warm up: lazy compilation, first-touch allocations
+
+    using Clock = std::chrono::steady_clock;
+    for (uint64_t reps = 1;; reps *= 2) {
+        uint64_t allocsBefore = allocations.load();
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < reps; ++i) body();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        uint64_t allocs = allocations.load() - allocsBefore;
+        if (seconds >= options.minSeconds || reps >= (1ull << 40)) {
+            uint64_t ops = reps * opsPerCall;
+            results.push_back({name, seconds * 1e9 / ops, (double)allocs / ops, ops});
+            std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(12) << results.back().nsPerOp << " ns/op" << std::setw(10)
+                      << results.back().allocsPerOp << " allocs/op" << std::endl;
+            return;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Interpreter microbenchmarks. Each guest function loops $n times; one op is
+// one iteration.
+
+const char* kGuestSource = R"(
+    (module
+        (import "env" "identity" (func $identity (param i32) (result i32)))
+        (type $unary (func (param i32) (result i32)))
+        (table 2 funcref)
+        (elem (i32.const 0) $inc $dec)
+
+        (func $inc (param $x i32) (result i32) (i32.add (local.get $x) (i32.const 1)))
+        (func $dec (param $x i32) (result i32) (i32.sub (local.get $x) (i32.const 1)))
+
+        ;; Eight arithmetic instructions plus loop control per iteration
+        (func $dispatch (param $n i32) (result i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.eqz (local.get $n)))
+                    (local.set $acc (i32.xor (i32.add (i32.mul (local.get $acc) (i32.const 31))
+                                                      (i32.shl (local.get $n) (i32.const 3)))
+                                             (i32.and (local.get $n) (i32.const 255))))
+                    (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        (func $locals (param $n i32) (result i32)
+            (local $a i32) (local $b i32) (local $c i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.eqz (local.get $n)))
+                    (local.set $a (local.tee $b (local.get $n)))
+                    (local.set $c (local.get $a))
+                    (local.set $b (local.get $c))
+                    (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $b)
+        )
+        (func $calls (param $n i32) (result i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.eqz (local.get $n)))
+                    (local.set $acc (call $inc (local.get $acc)))
+                    (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        (func $indirect (param $n i32) (result i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.eqz (local.get $n)))
+                    (local.set $acc (call_indirect (type $unary) (local.get $acc)
+                                                   (i32.and (local.get $n) (i32.const 1))))
+                    (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        (func $host (param $n i32) (result i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.eqz (local.get $n)))
+                    (local.set $acc (call $identity (local.get $n)))
+                    (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        (func $empty (result i32) (i32.const 0))
+    )
+)";
+
+void guestBenchmarks() {
+    Lexer lexer(kGuestSource);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+    vm.registerHostFunction("env", "identity", [](std::vector<WasmValue>& args) { return args[0]; },
+                            {"i32"}, {"i32"});
+
+    const int32_t n = 10000;
+    for (const char* name : {"dispatch", "locals", "calls", "indirect", "host"}) {
+        bench(std::string("guest.") + name, n, [&vm, name]() { sink = vm.run(name, {WasmValue(n)}).i32; });
+    }
+    bench("guest.run_entry", 1, [&vm]() { sink = vm.run("empty", {}).i32; });
+    std::vector<WasmValue> results(1000);
+    FunctionRef empty = vm.lookup("empty");
+    bench("guest.run_batch_entry", results.size(), [&vm, &results, &empty]() {
+        vm.runBatch(empty, nullptr, results.size(), results.data());
+    });
+}
+
+// ---------------------------------------------------------------------------
+// MemoryStore microbenchmarks; one op is one call.
+
+void memoryBenchmarks() {
+    const int batch = 1000;
+    bench("memory.alloc", batch, []() {
+        MemoryStore store;
+        for (int i = 0; i < batch; ++i) sink = store.alloc(16);
+    });
+
+    MemoryStore store;
+    MemoryStore::Handle h = store.alloc(batch * 4);
+    bench("memory.write_i32", batch, [&store, h]() {
+        for (int i = 0; i < batch; ++i) store.write<int32_t>(h, i * 4, i);
+    });
+    bench("memory.read_i32", batch, [&store, h]() {
+        int64_t sum = 0;
+        for (int i = 0; i < batch; ++i) sum += store.read<int32_t>(h, i * 4);
+        sink = sum;
+    });
+    bench("memory.make_span", batch, []() {
+        MemoryStore spans;
+        MemoryStore::Handle base = spans.alloc(batch * 4);
+        for (int i = 0; i < batch; ++i) sink = spans.make_span(base, i * 4, 4);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Front end: a synthetic module with many small functions. One op is one
+// pass over the whole source; MB/s follows from the source size printed.
+
+std::string syntheticModule(int functions) {
+    std::ostringstream src;
+    src << "(module\n";
+    for (int i = 0; i < functions; ++i) {
+        src << "  (func $f" << i << " (param $n i32) (result i32)\n"
+            << "    (local $acc i32)\n"
+            << "    (block $done\n"
+            << "      (loop $next\n"
+            << "        (br_if $done (i32.eqz (local.get $n)))\n"
+            << "        (local.set $acc (i32.add (local.get $acc) (i32.mul (local.get $n) (i32.const " << i
+            << "))))\n"
+            << "        (local.set $n (i32.sub (local.get $n) (i32.const 1)))\n"
+            << "        (br $next)))\n"
+            << "    (local.get $acc))\n";
+    }
+    src << ")\n";
+    return src.str();
+}
+
+void frontendBenchmarks() {
+    static const std::string source = syntheticModule(1000);
+    if (std::string("frontend.lex").find(options.filter) != std::string::npos) {
+        std::cout << "(frontend source: " << source.size() << " bytes)" << std::endl;
+    }
+    bench("frontend.lex", 1, []() { sink = (int64_t)Lexer(source).tokenize().size(); });
+    bench("frontend.parse", 1, []() {
+        Lexer lexer(source);
+        sink = (int64_t)Parser(lexer).parse().functions.size();
+    });
+    bench("frontend.parse_lazy", 1, []() {
+        sink = (int64_t)Parser::parseLazy(source, nullptr).functions.size();
+    });
+    Lexer lexer(source);
+    const Module parsed = Parser(lexer).parse();
+    bench("frontend.compile", 1, [&parsed]() { sink = (int64_t)CompiledModule(parsed).functionCount(); });
+}
+
+// ---------------------------------------------------------------------------
+// Macrobenchmarks: each testdata main_*.wat, loaded, linked against its
+// libraries and run the way run_testdata does, with output discarded. The
+// programs are tiny, so they are scaled up by repetition: ".load_run" is
+// one full parse/compile/link/run, ".run" one call of main on a linked
+// instance.
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+std::shared_ptr<const CompiledModule> compileText(const std::string& text) {
+    Lexer lexer(text);
+    return std::make_shared<const CompiledModule>(Parser(lexer).parse());
+}
+
+void bindEnv(Interpreter& vm, MemoryStore& store) {
+    MemoryStore* s = &store;
+    vm.registerHostFunction("env", "alloc", [s](std::vector<WasmValue>& a) { return WasmValue(s->alloc(a[0].i32)); },
+                            {"i32"}, {"i32"});
+    vm.registerHostFunction("env", "make_span", [s](std::vector<WasmValue>& a) {
+        return WasmValue(s->make_span(a[0].i32, a[1].i32, a[2].i32));
+    }, {"i32", "i32", "i32"}, {"i32"});
+    vm.registerHostFunction("env", "write_i32", [s](std::vector<WasmValue>& a) {
+        s->write<int32_t>(a[0].i32, a[1].i32, a[2].i32);
+        return WasmValue();
+    }, {"i32", "i32", "i32"}, {});
+    vm.registerHostFunction("env", "read_i32", [s](std::vector<WasmValue>& a) {
+        return WasmValue(s->read<int32_t>(a[0].i32, a[1].i32));
+    }, {"i32", "i32"}, {"i32"});
+    vm.registerHostFunction("env", "write_u8", [s](std::vector<WasmValue>& a) {
+        s->write<uint8_t>(a[0].i32, a[1].i32, (uint8_t)a[2].i32);
+        return WasmValue();
+    }, {"i32", "i32", "i32"}, {});
+    vm.registerHostFunction("env", "read_u8", [s](std::vector<WasmValue>& a) {
+        return WasmValue((int32_t)s->read<uint8_t>(a[0].i32, a[1].i32));
+    }, {"i32", "i32"}, {"i32"});
+    vm.registerHostFunction("env", "putchar", [](std::vector<WasmValue>& a) {
+        sink = a[0].i32;
+        return WasmValue();
+    }, {"i32"}, {});
+}
+
+// A main module linked to its libraries, each in its own Interpreter over
+// one shared MemoryStore.
+struct LinkedProgram {
+    MemoryStore store;
+    std::map<std::string, std::unique_ptr<Interpreter>> libs;
+    std::unique_ptr<Interpreter> main;
+
+    LinkedProgram(const std::shared_ptr<const CompiledModule>& mainCompiled,
+                  const std::map<std::string, std::shared_ptr<const CompiledModule>>& libCompiled) {
+        for (const auto& lib : libCompiled) {
+            libs[lib.first] = std::make_unique<Interpreter>(lib.second, store);
+            bindEnv(*libs[lib.first], store);
+        }
+        main = std::make_unique<Interpreter>(mainCompiled, store);
+        bindEnv(*main, store);
+        for (const auto& imp : mainCompiled->module().imports) {
+            if (imp.module == "env") continue;
+            Interpreter* lib = libs.at(imp.module).get();
+            std::string field = imp.field;
+            main->registerHostFunction(imp.module, imp.field, [lib, field](std::vector<WasmValue>& args) {
+                return lib->run(field, args);
+            }, imp.paramTypes, imp.resultTypes);
+        }
+    }
+};
+
+void macroBenchmarks() {
+    if (!fs::exists(options.testDir)) return;
+    std::vector<fs::path> mains;
+    for (const auto& entry : fs::directory_iterator(options.testDir)) {
+        std::string file = entry.path().filename().string();
+        if (file.rfind("main_", 0) == 0 && entry.path().extension() == ".wat") mains.push_back(entry.path());
+    }
+    std::sort(mains.begin(), mains.end());
+
+    for (const auto& path : mains) {
+        std::string mainText = readFile(path);
+        std::map<std::string, std::string> libTexts;
+        {
+            auto probe = compileText(mainText);
+            for (const auto& imp : probe->module().imports) {
+                if (imp.module == "env" || libTexts.count(imp.module)) continue;
+                libTexts[imp.module] = readFile(path.parent_path() / ("lib_" + imp.module + ".wat"));
+            }
+        }
+        std::string name = "macro." + path.stem().string().substr(5);
+
+        bench(name + ".load_run", 1, [&mainText, &libTexts]() {
+            std::map<std::string, std::shared_ptr<const CompiledModule>> libs;
+            for (const auto& lib : libTexts) libs[lib.first] = compileText(lib.second);
+            LinkedProgram program(compileText(mainText), libs);
+            sink = program.main->run("main", {}).i32;
+        });
+
+        std::map<std::string, std::shared_ptr<const CompiledModule>> libs;
+        for (const auto& lib : libTexts) libs[lib.first] = compileText(lib.second);
+        auto program = std::make_shared<LinkedProgram>(compileText(mainText), libs);
+        bench(name + ".run", 1, [program]() { sink = program->main->run("main", {}).i32; });
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+void writeJson(const std::string& path) {
+    std::ofstream out(path);
+    out << "{\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "  {\"name\": \"" << r.name << "\", \"ns_per_op\": " << std::setprecision(6) << r.nsPerOp
+            << ", \"allocs_per_op\": " << r.allocsPerOp << ", \"ops\": " << r.ops << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]}\n";
+    if (!out) throw std::runtime_error("Could not write " + path);
+}
+
+// Reads the one-benchmark-per-line layout writeJson produces.
+std::map<std::string, double> readJson(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Could not open " + path);
+    std::map<std::string, double> base;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t ns = line.find("\"ns_per_op\": ");
+        if (name == std::string::npos || ns == std::string::npos) continue;
+        name += 9;
+        base[line.substr(name, line.find('"', name) - name)] = std::strtod(line.c_str() + ns + 13, nullptr);
+    }
+    return base;
+}
+
+void compare(const std::string& path) {
+    std::map<std::string, double> base = readJson(path);
+    std::cout << "\nCompared to " << path << ":" << std::endl;
+    for (const auto& r : results) {
+        auto it = base.find(r.name);
+        if (it == base.end() || it->second <= 0) continue;
+        double change = (r.nsPerOp / it->second - 1.0) * 100.0;
+        std::cout << std::left << std::setw(36) << r.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << it->second << " -> " << std::setw(10) << r.nsPerOp << " ns/op  "
+                  << std::showpos << std::setprecision(1) << change << "%" << std::noshowpos << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.minSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (arg == "--json" && i + 1 < argc) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--compare" && i + 1 < argc) {
+            options.comparePath = argv[++i];
+        } else {
+            options.testDir = arg;
+        }
+    }
+
+    try {
+        guestBenchmarks();
+        memoryBenchmarks();
+        frontendBenchmarks();
+        macroBenchmarks();
+        if (!options.jsonPath.empty()) writeJson(options.jsonPath);
+        if (!options.comparePath.empty()) compare(options.comparePath);
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
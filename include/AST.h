@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <variant>
 
@@ -39,11 +41,45 @@ enum class Opcode {
 
     // F64
     F64_ADD, F64_SUB, F64_MUL, F64_DIV,
+
+    // SIMD (v128). Loads and stores address a MemoryStore object: they take
+    // (handle, offset) operands instead of a linear memory address.
+    V128_CONST, V128_LOAD, V128_STORE,
+    V128_NOT, V128_AND, V128_ANDNOT, V128_OR, V128_XOR,
+    I32X4_SPLAT, I32X4_EXTRACT_LANE, I32X4_REPLACE_LANE,
+    I32X4_ADD, I32X4_SUB, I32X4_MUL, I32X4_NEG, I32X4_MIN_S, I32X4_MAX_S,
+    I32X4_EQ, I32X4_NE, I32X4_LT_S, I32X4_LT_U, I32X4_GT_S, I32X4_GT_U, I32X4_LE_S, I32X4_GE_S,
+    F32X4_SPLAT, F32X4_EXTRACT_LANE, F32X4_REPLACE_LANE,
+    F32X4_ADD, F32X4_SUB, F32X4_MUL, F32X4_DIV, F32X4_NEG, F32X4_ABS, F32X4_SQRT,
+    F32X4_EQ, F32X4_NE, F32X4_LT, F32X4_GT, F32X4_LE, F32X4_GE,
+    F64X2_SPLAT, F64X2_EXTRACT_LANE, F64X2_REPLACE_LANE,
+    F64X2_ADD, F64X2_SUB, F64X2_MUL, F64X2_DIV, F64X2_NEG, F64X2_ABS, F64X2_SQRT,
+    F64X2_EQ, F64X2_NE, F64X2_LT, F64X2_GT, F64X2_LE, F64X2_GE,
+
+    // Lowered forms only, never produced by a parser: local access to a
+    // v128 local, which spans two stack slots.
+    LOCAL_GET_WIDE, LOCAL_SET_WIDE, LOCAL_TEE_WIDE,
+
+    // Operand: the target labels then the default, separated by spaces
+    BR_TABLE,
+};
+
+// Raw 128-bit vector value, little endian lanes.
+struct V128 {
+    uint8_t bytes[16];
+
+    bool operator==(const V128& other) const {
+        for (int i = 0; i < 16; ++i) {
+            if (bytes[i] != other.bytes[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const V128& other) const { return !(*this == other); }
 };
 
 struct Instruction {
     Opcode opcode;
-    std::variant<int32_t, int64_t, float, double, std::string> operand;
+    std::variant<int32_t, int64_t, float, double, std::string, V128> operand;
 
     Instruction() : opcode(Opcode::NOP), operand(0) {} // Default constructor
     Instruction(Opcode op);
@@ -52,6 +88,7 @@ struct Instruction {
     Instruction(Opcode op, float val);
     Instruction(Opcode op, double val);
     Instruction(Opcode op, std::string val);
+    Instruction(Opcode op, V128 val);
 };
 
 struct Import {
@@ -71,6 +108,9 @@ struct Function {
     std::vector<std::string> localNames;
 
     std::vector<Instruction> body;
+    // Set instead of body by lazy parsing: the unparsed instruction text, a
+    // view into the buffer that Module::lazySource keeps alive.
+    std::string_view lazyBody;
 };
 
 struct StringDefinition {
@@ -90,6 +130,19 @@ struct Table {
     uint32_t max;
 };
 
+struct Global {
+    std::string name;
+    std::string type;
+    bool isMutable;
+    Instruction init; // Constant initializer (i32/i64/f32/f64.const)
+};
+
+struct Export {
+    std::string name;
+    std::string kind;   // func, table, global
+    std::string target; // Name or index of the exported item
+};
+
 struct ElementSegment {
     uint32_t tableIndex;
     Instruction offset; // Expression to calculate offset (usually i32.const)
@@ -103,4 +156,8 @@ struct Module {
     std::vector<Type> types;
     std::vector<Table> tables;
     std::vector<ElementSegment> elements;
+    std::vector<Global> globals;
+    std::vector<Export> exports;
+    // Owner of the source text behind Function::lazyBody views.
+    std::shared_ptr<const void> lazySource;
 };
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// Little-endian / LEB128 encoding helpers shared by the binary module formats.
+
+class ByteWriter {
+public:
+    std::vector<uint8_t> bytes;
+
+    void u8(uint8_t v) { bytes.push_back(v); }
+
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) bytes.push_back((v >> (8 * i)) & 0xFF);
+    }
+
+    void uleb(uint64_t v) {
+        do {
+            uint8_t byte = v & 0x7F;
+            v >>= 7;
+            if (v != 0) byte |= 0x80;
+            bytes.push_back(byte);
+        } while (v != 0);
+    }
+
+    void sleb(int64_t v) {
+        bool more = true;
+        while (more) {
+            uint8_t byte = v & 0x7F;
+            v >>= 7; // arithmetic shift
+            if ((v == 0 && !(byte & 0x40)) || (v == -1 && (byte & 0x40))) {
+                more = false;
+            } else {
+                byte |= 0x80;
+            }
+            bytes.push_back(byte);
+        }
+    }
+
+    template <typename T>
+    void raw(T v) {
+        uint8_t buf[sizeof(T)];
+        std::memcpy(buf, &v, sizeof(T));
+        bytes.insert(bytes.end(), buf, buf + sizeof(T));
+    }
+
+    void str(const std::string& s) {
+        uleb(s.size());
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+};
+
+// Reads from a caller-owned buffer (possibly mmap'd); never copies it.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : data(data), size(size), pos(0) {}
+
+    bool atEnd() const { return pos >= size; }
+    size_t offset() const { return pos; }
+    size_t remaining() const { return size - pos; }
+    const uint8_t* current() const { return data + pos; }
+
+    uint8_t u8() {
+        need(1);
+        return data[pos++];
+    }
+
+    uint32_t u32() {
+        need(4);
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= (uint32_t)data[pos + i] << (8 * i);
+        pos += 4;
+        return v;
+    }
+
+    uint64_t uleb() {
+        uint64_t result = 0;
+        int shift = 0;
+        while (true) {
+            uint8_t byte = u8();
+            if (shift >= 64) throw std::runtime_error("LEB128 value too long");
+            result |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) break;
+        }
+        return result;
+    }
+
+    int64_t sleb() {
+        uint64_t result = 0;
+        int shift = 0;
+        uint8_t byte;
+        do {
+            byte = u8();
+            if (shift >= 64) throw std::runtime_error("LEB128 value too long");
+            result |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        if (shift < 64 && (byte & 0x40)) result |= ~(uint64_t)0 << shift; // sign extend
+        return (int64_t)result;
+    }
+
+    template <typename T>
+    T raw() {
+        need(sizeof(T));
+        T v;
+        std::memcpy(&v, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+
+    std::string str() {
+        uint64_t len = uleb();
+        need(len);
+        std::string s(reinterpret_cast<const char*>(data + pos), len);
+        pos += len;
+        return s;
+    }
+
+    void skip(size_t n) {
+        need(n);
+        pos += n;
+    }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+
+    void need(uint64_t n) {
+        if (n > size - pos) throw std::runtime_error("Unexpected end of binary data");
+    }
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "AST.h"
+#include "Optimizer.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+// A lowered instruction. Every symbolic operand of the AST form (local names,
+// labels, callee names, type names, string aliases) is resolved to an index
+// once at compile time, so execution never touches strings.
+struct CompiledInstr {
+    Opcode opcode;
+    // Local slot, global, callee (Wasm function index space: imports first),
+    // signature id, string or v128 constant index, branch target pc or first
+    // br_table entry, depending on the opcode. Lane instructions keep their
+    // lane in i32, br_table its number of non-default targets.
+    int32_t index;
+    union {
+        int32_t i32;
+        int64_t i64;
+        float f32;
+        double f64;
+    };
+
+    CompiledInstr() : opcode(Opcode::NOP), index(0), i64(0) {}
+};
+
+// One br_table entry: the pc to resume at and, for validated code, the
+// operand stack height (relative to the frame's operand base) to cut to.
+struct BranchTarget {
+    int32_t pc;
+    int32_t height;
+};
+
+// Stack slots a value of the given type takes: two for v128, one otherwise.
+inline uint32_t slotCount(const std::string& type) { return type == "v128" ? 2 : 1; }
+
+struct CompiledFunction {
+    const Function* source;
+    // Sizes in stack slots, which differ from the declared counts once a
+    // v128 is involved
+    uint32_t numParams;
+    uint32_t numLocals; // params + declared locals + extraLocals
+    uint32_t resultSlots;
+    bool hasResult;
+    int32_t signature;
+    // Body still to be parsed and lowered on first use (see
+    // CompiledModule::function); code is empty until then.
+    bool lazy;
+    // Passed the Validator: runs without runtime type or underflow checks
+    // in a frame of exactly numLocals + maxStackDepth slots.
+    bool validated = false;
+    uint32_t maxStackDepth = 0;
+    std::string validationError; // Why validation failed, if it did
+    std::vector<V128> constants; // v128.const operands, by CompiledInstr::index
+    // br_table entries, each table followed by its default target
+    std::vector<BranchTarget> branchTable;
+    // Lowered body plus one trailing RETURN, so execution never runs off
+    // the end. Until the Optimizer has rewritten it, pc is 1:1 with
+    // Function::body.
+    std::vector<CompiledInstr> code;
+    OptimizerStats optimizerStats; // Zero unless the function was optimized or failed revalidation
+    // Locals the optimizer added after the declared ones, by type: those
+    // taken over from inlined callees (calls inlined one after another
+    // share them) and temporaries for values hoisted out of loops.
+    std::vector<std::string> extraLocals;
+    // How deep inlined calls nest in code: 0 without any
+    uint32_t inlineDepth = 0;
+};
+
+class Inliner;
+
+struct CompiledElement {
+    int32_t offset;
+    std::vector<int32_t> functionIndices;
+};
+
+// Immutable, fully resolved form of a Module. It is built once and then only
+// read, so any number of Interpreter instances on any number of threads can
+// execute the same CompiledModule concurrently without copying it.
+//
+// Functions whose body was recorded lazily (Parser::parseLazy) are parsed,
+// resolved and lowered the first time function() hands them out. This is
+// guarded by a per-function once flag, so concurrent first calls compile
+// once and all observe the same code; a body that fails to compile throws
+// from every call.
+//
+// Bodies that validate are then run through the Optimizer with the given
+// options, lazy ones included when they are compiled. Once every eager
+// body is lowered, the Inliner splices small callees into their callers.
+class CompiledModule {
+public:
+    explicit CompiledModule(Module mod, OptimizerOptions options = {});
+    ~CompiledModule();
+
+    CompiledModule(const CompiledModule&) = delete;
+    CompiledModule& operator=(const CompiledModule&) = delete;
+
+    const Module& module() const { return mod; }
+
+    size_t importCount() const { return mod.imports.size(); }
+    size_t functionCount() const { return functions.size(); }
+    const CompiledFunction& function(size_t index) const {
+        const CompiledFunction& cf = functions[index];
+        if (cf.lazy) compileLazy(index);
+        return cf;
+    }
+    // Number of lazily recorded functions that have been compiled so far.
+    size_t lazyCompiledCount() const { return lazyCompiled.load(); }
+
+    const OptimizerOptions& optimizerOptions() const { return optimizer; }
+    // Summed over the functions compiled so far; see
+    // CompiledFunction::optimizerStats for one function.
+    OptimizerStats optimizerStats() const {
+        std::lock_guard<std::mutex> lock(statsMtx);
+        return optimized;
+    }
+
+    // Returns the index into functions for a name, or -1.
+    int32_t findFunction(const std::string& name) const;
+
+    uint32_t tableSize() const { return tableMin; }
+    const std::vector<CompiledElement>& elements() const { return elems; }
+
+    // Length-prefixed payloads for the module's string constants, ready to be
+    // handed to MemoryStore::alloc_readonly.
+    const std::vector<std::vector<uint8_t>>& stringData() const { return strings; }
+
+    // Signatures are interned so that call_indirect checks compare ids.
+    const Type& signature(int32_t id) const { return signatures[id]; }
+    size_t signatureCount() const { return signatures.size(); }
+    // Signature id of a callee in the Wasm function index space. Unlike
+    // function(), this never triggers lazy compilation.
+    int32_t calleeSignature(int32_t funcIndex) const;
+
+private:
+    Module mod;
+    // Lazy entries get their code filled in on first use, under compileOnce.
+    mutable std::vector<CompiledFunction> functions;
+    std::unique_ptr<std::once_flag[]> compileOnce;
+    mutable std::atomic<size_t> lazyCompiled{0};
+    OptimizerOptions optimizer;
+    mutable std::mutex statsMtx;
+    mutable OptimizerStats optimized; // Guarded by statsMtx
+    std::unique_ptr<Inliner> inliner; // Null when inlining is off
+    std::unordered_map<std::string, int32_t> funcMap;
+    std::unordered_map<std::string, int32_t> importMap;
+    std::unordered_map<std::string, int32_t> stringMap;
+    std::unordered_map<std::string, int32_t> globalMap;
+    std::vector<Type> signatures; // canonical, unnamed
+    std::vector<int32_t> typeSignatures;
+    std::vector<int32_t> importSignatures;
+    std::vector<std::vector<uint8_t>> strings;
+    std::vector<CompiledElement> elems;
+    uint32_t tableMin = 0;
+
+    int32_t internSignature(const std::vector<std::string>& params,
+                            const std::vector<std::string>& results);
+    void compileFunction(size_t index);
+    void compileLazy(size_t index) const;
+    void lowerFunction(CompiledFunction& cf, const std::vector<Instruction>& body) const;
+    void inlineCalls(CompiledFunction& cf) const;
+    // Index in the Wasm function index space, or -1.
+    int32_t resolveCallee(const std::string& name) const;
+    int32_t resolveType(const std::string& name) const;
+    int resolveLocal(const std::string& id, const Function& func) const;
+    int32_t resolveGlobal(const std::string& id) const;
+};
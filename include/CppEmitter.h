@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CompiledModule.h"
+#include <string>
+
+// Translates a module to a C++ translation unit, for modules that are
+// compiled ahead of time instead of interpreted (the wat2cpp tool). The
+// input is the lowered code after the Optimizer and Inliner, with the
+// operand stack heights the Validator computes: each stack slot and local
+// becomes a typed C++ variable, branches become gotos, guest calls direct
+// calls, and host calls, strings and v128 loads/stores go through the
+// NativeModule base class the generated code derives from.
+//
+// The output registers itself under a name for NativeModule::create and
+// needs NativeModule.h (and Simd.h for v128 code) to build.
+class CppEmitter {
+public:
+    explicit CppEmitter(const CompiledModule& module);
+
+    // Throws std::runtime_error if a function did not pass the Validator:
+    // code without static stack heights cannot be translated.
+    std::string emit(const std::string& name) const;
+
+private:
+    const CompiledModule& module;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CompiledModule.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Replaces calls to small guest functions with the callee's code, saving
+// the frame set-up of a CALL on every call. The callee's locals become
+// locals of the caller: the arguments are stored into them from the
+// operand stack and the callee's own locals are zeroed, as a call would.
+// A callee that returns from the middle is wrapped in a block whose END
+// its returns branch to, with the result passed through a local.
+//
+// Only validated callees compiled up front are inlined, and never one that
+// is part of a cycle of calls, so expansion always ends. Callers are
+// processed callees first, so a callee brings along what was inlined into
+// it, up to OptimizerOptions::inlineMaxDepth levels.
+class Inliner {
+public:
+    // functions are the module's, with every eagerly lowered body in place.
+    Inliner(const std::vector<CompiledFunction>& functions, size_t importCount, const OptimizerOptions& options);
+
+    // Eagerly lowered functions, callees before callers where the call
+    // graph has no cycle.
+    const std::vector<size_t>& bottomUpOrder() const { return order; }
+
+    // Whether code of caller calls anything inlineCalls() would inline,
+    // size budget of the caller aside.
+    bool hasCandidates(const CompiledFunction& caller) const;
+
+    // Splices the calls in code, the lowered and validated body of caller,
+    // that are within budget. Adds the locals (to caller) and v128
+    // constants the inlined bodies need. Returns the number of calls
+    // replaced; the result must be validated again before it runs.
+    uint32_t inlineCalls(CompiledFunction& caller, std::vector<CompiledInstr>& code,
+                         std::vector<BranchTarget>& branchTable, std::vector<V128>& constants) const;
+
+private:
+    const std::vector<CompiledFunction>& functions;
+    int32_t imports;
+    OptimizerOptions opts;
+    std::vector<bool> recursive; // On a cycle of calls, by function index
+    std::vector<size_t> order;
+
+    // The callee of instr if it is a call that may be inlined, or null.
+    const CompiledFunction* candidate(const CompiledFunction& caller, const CompiledInstr& instr) const;
+};
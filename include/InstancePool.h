@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Hands out ready-to-run instances stamped from a snapshot. Every pooled
+// instance owns its MemoryStore and is reset to the snapshot when its lease
+// ends, so each acquire() sees freshly initialized state without paying for
+// instantiation. The pool must outlive its leases.
+class InstancePool {
+    struct Entry {
+        MemoryStore store;
+        std::unique_ptr<Interpreter> vm;
+    };
+
+public:
+    // Registers host functions on a newly created instance, bound to its store.
+    using Binder = std::function<void(Interpreter&, MemoryStore&)>;
+
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        Interpreter& operator*() const { return *entry->vm; }
+        Interpreter* operator->() const { return entry->vm.get(); }
+        MemoryStore& store() const { return entry->store; }
+
+    private:
+        friend class InstancePool;
+        Lease(InstancePool* pool, std::unique_ptr<Entry> entry);
+
+        InstancePool* pool;
+        std::unique_ptr<Entry> entry;
+    };
+
+    InstancePool(InstanceSnapshot snapshot, Binder binder, size_t prewarm = 0);
+
+    Lease acquire();
+
+    // Interpreter::runBatch fanned out over threads: the rows are cut into
+    // chunks, and each chunk runs on its own leased instance, so rows in one
+    // chunk share memory state while chunks are independent. chunkRows 0
+    // picks about four chunks per thread. Every chunk finishes before the
+    // first error (in row order) is rethrown.
+    void runBatch(const std::string& funcName, const std::vector<WasmValue>& args, std::vector<WasmValue>& results,
+                  ThreadPool& threads, size_t chunkRows = 0);
+
+    size_t idleCount() const;
+    size_t createdCount() const;
+
+private:
+    InstanceSnapshot snapshot;
+    Binder binder;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Entry>> idle;
+    size_t created = 0;
+
+    std::unique_ptr<Entry> create();
+    void release(std::unique_ptr<Entry> entry);
+};
@@ -1,18 +1,27 @@
 #pragma once
 
 #include "AST.h"
+#include "CompiledModule.h"
 #include "MemoryStore.h"
+#include "SamplingProfiler.h"
 #include <vector>
 #include <stack>
 #include <unordered_map>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+
+class Profiler;
+class PurityAnalysis;
 
 // Basic Wasm Values
 // Note: In a real engine we might use a union or std::variant.
 // For simplicity and standard compliance, we'll use a tagged union approach.
 struct WasmValue {
-    enum Type { I32, I64, F32, F64, VOID } type;
+    // PENDING is only ever returned by a host function that completes later;
+    // see Interpreter::resume(WasmValue).
+    enum Type { I32, I64, F32, F64, VOID, PENDING } type;
     union {
         int32_t i32;
         int64_t i64;
@@ -25,13 +34,54 @@ struct WasmValue {
     explicit WasmValue(int64_t v) : type(I64), i64(v) {}
     explicit WasmValue(float v) : type(F32), f32(v) {}
     explicit WasmValue(double v) : type(F64), f64(v) {}
+
+    static WasmValue pending() {
+        WasmValue v;
+        v.type = PENDING;
+        return v;
+    }
+    bool isPending() const { return type == PENDING; }
+};
+
+// Untagged 8-byte value used for operand stack and local slots. The code
+// that reads a slot knows its type (statically so for validated code), so
+// tags only exist at the host boundary: run() arguments and results and
+// host function calls, where tagged() restores one from a signature.
+union Slot {
+    int32_t i32;
+    int64_t i64;
+    float f32;
+    double f64;
+
+    Slot() : i64(0) {}
+    explicit Slot(int32_t v) : i32(v) {}
+    explicit Slot(int64_t v) : i64(v) {}
+    explicit Slot(float v) : f32(v) {}
+    explicit Slot(double v) : f64(v) {}
+
+    static Slot of(const WasmValue& v) {
+        Slot s;
+        s.i64 = v.i64; // Copies whichever member is active
+        return s;
+    }
+
+    WasmValue tagged(WasmValue::Type type) const {
+        switch (type) {
+            case WasmValue::I64: return WasmValue(i64);
+            case WasmValue::F32: return WasmValue(f32);
+            case WasmValue::F64: return WasmValue(f64);
+            default: return WasmValue(i32);
+        }
+    }
 };
+static_assert(sizeof(Slot) == 8, "stack slots must stay 8 bytes");
 
+// Locals live on the value stack: a call turns its arguments into the first
+// locals in place, and the frame's operands sit right above them.
 struct StackFrame {
-    Function* func;
+    const CompiledFunction* func;
     size_t pc; // program counter
-    std::vector<WasmValue> locals;
-    int returnHeight; // Stack height to return to
+    size_t locals; // Index of local 0 in the value stack; a return truncates to here
 };
 
 using HostFunction = std::function<WasmValue(std::vector<WasmValue>& args)>;
@@ -41,11 +91,50 @@ struct HostFuncEntry {
     int arity;
     std::vector<std::string> paramTypes;
     std::vector<std::string> resultTypes;
+    std::vector<WasmValue::Type> paramTags;
 };
 
+// A function resolved once for repeated calls; see Interpreter::lookup. Valid
+// for every instance of the CompiledModule it was looked up in.
+struct FunctionRef {
+    int32_t index = -1; // Defined function index
+    const CompiledFunction* func = nullptr;
+};
+
+// Thrown by run() and resume() when metered execution uses up its fuel.
+// When resumable, the instance keeps the suspended call and resume()
+// continues it once more fuel is set. Fuel that runs out in a run() nested
+// inside a host function cannot be suspended (the host's native frame is in
+// the way), so that run is unwound like a trap and resumable is false.
+class FuelExhausted : public std::runtime_error {
+public:
+    explicit FuelExhausted(bool resumable) : std::runtime_error("Out of fuel"), resumable(resumable) {}
+    bool resumable;
+};
+
+// Frozen state of an idle, fully initialized instance: its MemoryStore objects,
+// table, globals and string handles. MemoryStore buffers are shared
+// copy-on-write, so stamping out an instance from a snapshot costs a few
+// vector copies rather than a full instantiation.
+struct InstanceSnapshot {
+    std::shared_ptr<const CompiledModule> compiled;
+    MemoryStore memory;
+    std::vector<int32_t> table;
+    std::vector<int32_t> stringHandles;
+    std::vector<WasmValue> globals;
+};
+
+// An Interpreter is one execution instance: value/call stacks, bound host
+// functions, the function table and the string handles in its MemoryStore.
+// The code itself lives in a shared, immutable CompiledModule, so instances are
+// cheap and one per thread can run the same module concurrently.
 class Interpreter {
 public:
     Interpreter(Module& mod, MemoryStore& store);
+    Interpreter(std::shared_ptr<const CompiledModule> compiled, MemoryStore& store);
+    // Overwrites store with the snapshot's memory. Host functions are not part
+    // of a snapshot and must be registered on the new instance.
+    Interpreter(const InstanceSnapshot& snapshot, MemoryStore& store);
 
     // New API for full module imports
     void registerHostFunction(std::string modName, std::string fieldName, HostFunction func,
@@ -54,26 +143,145 @@ public:
 
     WasmValue run(std::string funcName, std::vector<WasmValue> args);
 
+    // Resolves and checks funcName once, for run() and runBatch().
+    FunctionRef lookup(const std::string& funcName) const;
+    WasmValue run(const FunctionRef& func, std::vector<WasmValue> args);
+    // Calls func once per row of a row-major argument matrix (count rows of
+    // the function's arity), writing one result per row. The rows run one
+    // after another on this instance, reusing its stacks, with none of run()'s
+    // per-call lookups. The first error stops the batch and is rethrown, with
+    // the results of earlier rows in place; rows cannot suspend.
+    void runBatch(const FunctionRef& func, const WasmValue* args, size_t count, WasmValue* results);
+    // Sizes results to the number of rows in args; for functions without
+    // parameters, results must already hold one entry per call.
+    void runBatch(const FunctionRef& func, const std::vector<WasmValue>& args, std::vector<WasmValue>& results);
+
+    // Fuel metering bounds how long run() and resume() may execute. Fuel is
+    // charged where control can repeat, never per instruction: a taken
+    // backward branch costs the number of instructions it jumps back over
+    // and a call costs one. When it runs out, FuelExhausted is thrown at the
+    // next back-edge or call. Instances start unmetered.
+    void setFuel(uint64_t units);
+    void clearFuel();
+    bool metered() const { return fuelMetered; }
+    uint64_t fuelRemaining() const { return fuel > 0 ? (uint64_t)fuel : 0; }
+
+    // A run() stopped by a resumable FuelExhausted stays on the stacks until
+    // resume() continues it (returning its result, or throwing again when the
+    // fuel runs out first) or cancel() drops it. No other run() can start
+    // on the instance meanwhile.
+    bool suspended() const { return suspendedFunc != nullptr; }
+    WasmValue resume();
+    void cancel();
+
+    // Asynchronous host calls: a host function that cannot answer yet
+    // returns WasmValue::pending(). run() (or resume()) then suspends the
+    // guest and returns WasmValue::pending() itself, and once the host has
+    // the answer, resume(result) pushes it as the call's result and
+    // continues. One thread can so drive many instances that each wait on
+    // I/O. Only the outermost run() can suspend; a pending result inside a
+    // run() nested in a host function is an error.
+    bool awaitingHost() const { return pendingImport >= 0; }
+    WasmValue resume(WasmValue hostResult);
+
+    const std::shared_ptr<const CompiledModule>& compiledModule() const { return compiled; }
+
+    // Feeds every later run() into profiler, which must be built for the same
+    // CompiledModule and outlive its attachment; nullptr detaches. Throws
+    // unless the interpreter was built with OPTRICH_PROFILE.
+    void setProfiler(Profiler* profiler);
+    // Keeps a signal-safe copy of the call stack for sampler, which must be
+    // built for the same CompiledModule and outlive its attachment; nullptr
+    // detaches. Only valid between calls to run().
+    void setSampler(SamplingProfiler* sampler);
+
+    // Caches the results of every function purity found pure, keyed on the
+    // argument values: a call with cached arguments takes the result without
+    // running the function (or charging more than the call's fuel). Each
+    // function gets a direct-mapped table of capacity entries (rounded up to
+    // a power of two) where a new result replaces whatever shared its slot.
+    // Caches are per instance, since string handles are. Capacity 0 turns
+    // memoization off. Only valid between calls to run().
+    struct MemoStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    void setMemoization(const PurityAnalysis& purity, size_t capacity = 1024);
+    // By defined function index; zero for functions that are not memoized.
+    MemoStats memoStats(size_t func) const;
+
+    // Only valid between calls to run().
+    InstanceSnapshot snapshot() const;
+    // Resets memory, table and globals to the snapshot, keeping host bindings.
+    void restore(const InstanceSnapshot& snapshot);
+
 private:
-    Module& module;
+    std::shared_ptr<const CompiledModule> compiled;
     MemoryStore& store;
     std::vector<StackFrame> callStack;
-    std::vector<WasmValue> valueStack;
-    std::unordered_map<std::string, size_t> funcMap;
-    std::unordered_map<std::string, HostFuncEntry> hostFuncs;
-    std::unordered_map<std::string, int32_t> stringHandles;
+    // Slots in use are [0, stackTop); the vector is only ever grown
+    std::vector<Slot> valueStack;
+    size_t stackTop = 0;
 
-    // Table storage: a simple vector of function names
-    // Null/empty slots mean uninitialized.
-    std::vector<std::string> table;
+    // Indexed by import index; unbound imports have an empty func.
+    std::vector<HostFuncEntry> hostFuncs;
+    // Indexed by string constant index.
+    std::vector<int32_t> stringHandles;
 
-    void push(WasmValue v);
-    WasmValue pop();
+    // Table storage: function indices, -1 means uninitialized.
+    std::vector<int32_t> table;
+    std::vector<WasmValue> globals;
+    Profiler* profiler = nullptr;
+    std::unique_ptr<GuestStackShadow> shadow; // Present while a sampler is attached
+    // Unmetered instances never get anywhere near running out
+    int64_t fuel = INT64_MAX;
+    bool fuelMetered = false;
+    const CompiledFunction* suspendedFunc = nullptr; // Entry point of the suspended run
+    int32_t pendingImport = -1; // Import whose result the suspended run awaits
 
-    void handleReturn();
+    struct MemoTable {
+        uint32_t keySlots;
+        uint32_t resultSlots;
+        uint64_t mask; // capacity - 1
+        std::vector<uint64_t> keyBits; // Per key slot: the bits the param type uses
+        std::vector<uint8_t> used;
+        std::vector<Slot> keys;    // capacity * keySlots
+        std::vector<Slot> results; // capacity * resultSlots
+        MemoStats stats;
+    };
+    // Indexed by defined function; null for functions that are not memoized
+    std::vector<std::unique_ptr<MemoTable>> memo;
+    // Calls that missed, waiting for their frame to return a result to cache
+    struct PendingMemo {
+        size_t depth; // callStack size while the frame is live
+        MemoTable* table;
+        size_t entry;
+        size_t keyOffset; // Into memoKeys; arguments are locals and may change
+    };
+    std::vector<PendingMemo> memoPending;
+    std::vector<Slot> memoKeys;
+
+    void instantiate();
 
-    void execute(Instruction& instr, StackFrame& frame);
+    void push(Slot v);
+
+    // Throws unless ref belongs to this module and no run is suspended.
+    void checkRef(const FunctionRef& ref) const;
+    // Calls ref with the function's arity of args from the top level.
+    WasmValue invoke(const FunctionRef& ref, const WasmValue* args);
+    // Runs until the call stack is back to baseDepth and returns the result
+    // of startFunc, or suspends when the fuel runs out or a host call is
+    // pending.
+    WasmValue execute(const CompiledFunction* startFunc, size_t baseHeight, size_t baseDepth,
+                      size_t profileDepth);
+    void unwind(size_t baseHeight, size_t baseDepth, size_t profileDepth);
+
+    void handleReturn();
+    void callFunction(int32_t funcIndex);
+    // Takes a cached result for the arguments on top of the stack, or arranges
+    // for the frame about to be pushed to cache its result. True on a hit.
+    bool memoLookup(MemoTable& table);
 
-    int resolveLocal(const std::string& id, Function* func);
-    Type* resolveType(const std::string& name);
+    template <bool Checked>
+    void runFrame();
 };
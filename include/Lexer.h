@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <optional>
@@ -16,20 +17,25 @@ enum class TokenType {
     END_OF_FILE
 };
 
+// Token text is a view into the buffer handed to the Lexer; it stays valid
+// only as long as that buffer does. STRING tokens hold the raw contents
+// between the quotes with escape sequences left in place.
 struct Token {
     TokenType type;
-    std::string text;
+    std::string_view text;
 };
 
+// The Lexer never copies its input. The caller owns the buffer (a string, a
+// MappedFile, ...) and must keep it alive while tokens are in use.
 class Lexer {
 public:
-    explicit Lexer(const std::string& input);
+    explicit Lexer(std::string_view input);
 
     Token next();
     std::vector<Token> tokenize();
 
 private:
-    std::string source;
+    std::string_view source;
     size_t pos;
 
     void skipWhitespace();
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "AST.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+struct LinkStats {
+    size_t modulesMerged = 0;   // Main plus the libraries pulled in
+    size_t importsResolved = 0; // Import entries that became direct calls
+    size_t functionsKept = 0;
+    size_t functionsDropped = 0;
+    size_t typesDropped = 0;
+    size_t stringsDropped = 0;
+    size_t globalsDropped = 0;
+    size_t importsDropped = 0; // Host imports nothing reachable calls
+};
+
+// Statically links a main module with the libraries it imports from into a
+// single Module, so one Interpreter runs the whole program and a call into
+// a library is an ordinary CALL instead of a host call into another
+// instance.
+//
+// An import whose module names an added library resolves to the library
+// function of that name (or export), which must have the same signature;
+// libraries may import from each other. Every other import stays an
+// import, shared between the modules that declare it. Library symbols are
+// renamed to "<library>.<name>" (unnamed ones after their index), with a
+// suffix where that still collides; main keeps its names.
+//
+// Only what main's exports, the given entry points and element segments
+// reach is kept: unreachable functions, types, strings, globals and imports
+// are dropped, and lazily recorded bodies are parsed only if reachable. At
+// most one of the linked modules may have a table, since call_indirect
+// always addresses table 0.
+class Linker {
+public:
+    // name is the module name imports use for lib, e.g. "math" for
+    // lib_math.wat in testdata.
+    void addLibrary(const std::string& name, Module lib);
+
+    // entryPoints are functions of main kept besides its exports, looked
+    // up like Interpreter::run looks them up. Throws std::runtime_error for
+    // unknown references and signature mismatches.
+    Module link(const Module& main, const std::vector<std::string>& entryPoints = {});
+
+    const LinkStats& stats() const { return linkStats; }
+
+private:
+    std::map<std::string, Module> libraries;
+    LinkStats linkStats;
+};
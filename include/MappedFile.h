@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. The mapping stays valid for the
+// lifetime of the object, so views into data() may be handed out freely.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+
+private:
+    uint8_t* ptr;
+    size_t length;
+};
@@ -7,6 +7,7 @@
 #include <variant>
 #include <cstring> // for memcpy
 #include <algorithm> // for std::fill
+#include <memory>
 
 class MemoryStore {
 public:
@@ -14,11 +15,18 @@ public:
     // If we want to detect null, we can start from 1. Let's start from 1.
     using Handle = int32_t;
 
+    // Storage is reference counted so that copying a MemoryStore is cheap:
+    // a copy shares every buffer and a writable buffer is only duplicated the
+    // first time either side writes to it (copy-on-write).
     struct MemoryBlock {
-        std::vector<uint8_t> storage; // Empty if it's a span/view
+        std::shared_ptr<std::vector<uint8_t>> storage; // Null if it's a span/view
         uint8_t* ptr;
         size_t size;
         bool readOnly = false;
+        Handle root = 0;       // Block owning the storage (itself unless a span)
+        size_t rootOffset = 0; // Offset of ptr within the root's storage
+        // On a root: the spans carved out of it, re-pointed when it unshares
+        std::vector<Handle> spans;
     };
 
     MemoryStore();
@@ -46,8 +54,19 @@ public:
         std::memcpy(dst, &value, sizeof(T));
     }
 
+    // Bounds-checked pointer to size bytes at offset, for handing a range to
+    // I/O without copying it. Valid until the next alloc or write.
+    const uint8_t* view(Handle handle, int32_t offset, int32_t size) {
+        if (size < 0) throw std::runtime_error("Out of bounds object access");
+        validate_access(handle, offset, size);
+        return objects[handle].ptr + offset;
+    }
+
+    size_t objectCount() const { return objects.size() - 1; }
+
 private:
     std::vector<MemoryBlock> objects;
 
     void validate_access(Handle handle, int32_t offset, size_t size, bool forWrite = false);
+    void unshare(Handle root);
 };
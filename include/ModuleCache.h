@@ -0,0 +1,36 @@
+#pragma once
+
+#include "AST.h"
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+// On-disk cache of parsed modules keyed by the SHA-256 of the WAT source text.
+// A hit mmaps the cached binary (see ModuleSerializer) and skips lexing and
+// parsing entirely; lowering it into a CompiledModule still runs. A miss
+// parses the text and writes the entry atomically, so concurrent processes
+// sharing a directory never observe partial files.
+// Each entry records the size and SHA-256 of its source, and one whose
+// source differs from the one being loaded is a miss.
+class ModuleCache {
+public:
+    explicit ModuleCache(std::string directory);
+
+    Module load(const std::string& source);
+    Module loadFile(const std::string& path);
+
+    // First 8 bytes of the source's SHA-256, which name its entry file.
+    static uint64_t contentHash(const char* data, size_t size);
+    std::string entryPath(uint64_t hash) const;
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+
+private:
+    std::string dir;
+    std::atomic<size_t> hitCount{0};
+    std::atomic<size_t> missCount{0};
+
+    Module loadSource(const char* data, size_t size);
+    void store(uint64_t hash, uint64_t sourceSize, const uint8_t* digest, const Module& mod);
+};
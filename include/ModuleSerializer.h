@@ -0,0 +1,52 @@
+#pragma once
+
+#include "AST.h"
+#include "ByteIO.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Compact binary form of a parsed Module, used by ModuleCache to skip lexing
+// and parsing on warm starts. Layout: "OPTM", u32 format version, a table of
+// unique strings, then every Module section in declaration order. Counts and
+// indices are LEB128, floats and v128 constants are raw little-endian, and
+// every string operand is a reference into the string table.
+//
+// Only the parsed AST is stored: lowering, validation and optimization (see
+// CompiledModule) still run on every load, cached or not.
+class ModuleWriter {
+public:
+    static const uint32_t kVersion = 3;
+
+    explicit ModuleWriter(const Module& mod);
+
+    std::vector<uint8_t> write();
+
+private:
+    const Module& mod;
+    ByteWriter body;
+    std::vector<const std::string*> stringTable;
+    std::unordered_map<std::string, uint32_t> stringIndex;
+
+    void writeString(const std::string& s);
+    void writeStrings(const std::vector<std::string>& list);
+    void writeInstruction(const Instruction& instr);
+};
+
+// Decodes a buffer produced by ModuleWriter. The buffer is only read, so it
+// may be an mmap'd file; throws std::runtime_error on malformed input.
+class ModuleReader {
+public:
+    ModuleReader(const uint8_t* data, size_t size);
+
+    Module read();
+
+private:
+    ByteReader in;
+    std::vector<std::string> strings;
+
+    const std::string& readString();
+    std::vector<std::string> readStrings();
+    Instruction readInstruction();
+    uint64_t readCount();
+};
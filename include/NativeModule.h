@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// What a module compiled ahead of time (see CppEmitter) keeps of its
+// source, for binding imports, looking up run() targets and setting up an
+// instance. Emitted as static data next to the code.
+struct NativeLayout {
+    struct Import {
+        std::string module;
+        std::string field;
+        std::vector<std::string> paramTypes;
+        std::vector<std::string> resultTypes;
+    };
+    struct Function {
+        std::string name; // Function name or export, as run() takes them
+        int32_t index;    // Defined function index
+    };
+    std::vector<Import> imports;
+    std::vector<Function> names;
+    // By defined function index
+    std::vector<std::vector<std::string>> paramTypes;
+    std::vector<std::vector<std::string>> resultTypes;
+    std::vector<int32_t> signatures;
+    // Parameter types by signature id, for call_indirect errors
+    std::vector<std::vector<std::string>> signatureParams;
+    // Length-prefixed payloads, as CompiledModule::stringData()
+    std::vector<std::vector<uint8_t>> strings;
+    // Defined function index per table entry, -1 where uninitialized
+    std::vector<int32_t> table;
+};
+
+// One instance of a module that wat2cpp translated to C++: the generated
+// class derives from this and holds one member function per guest
+// function, with the module's globals as typed members. Instances take host
+// functions and run guest functions through the same calls as an
+// Interpreter, and trap with the same messages.
+//
+// Native code has no fuel metering, profiling, snapshots or suspension: a
+// host function that returns WasmValue::pending() is an error.
+class NativeModule {
+public:
+    using Factory = std::unique_ptr<NativeModule> (*)(MemoryStore& store);
+
+    virtual ~NativeModule() = default;
+    NativeModule(const NativeModule&) = delete;
+    NativeModule& operator=(const NativeModule&) = delete;
+
+    // Instantiates the module generated under name (wat2cpp --name), or
+    // throws if none was linked in.
+    static std::unique_ptr<NativeModule> create(const std::string& name, MemoryStore& store);
+    static bool available(const std::string& name);
+    // Called by generated code at static initialization.
+    static bool registerFactory(const char* name, Factory factory);
+
+    void registerHostFunction(std::string modName, std::string fieldName, HostFunction func,
+                              const std::vector<std::string>& params,
+                              const std::vector<std::string>& results);
+
+    WasmValue run(std::string funcName, std::vector<WasmValue> args);
+
+protected:
+    NativeModule(const NativeLayout& layout, MemoryStore& store);
+
+    // Calls the defined function with its arguments, tags as run() got them.
+    virtual WasmValue invoke(int32_t func, const WasmValue* args) = 0;
+
+    const NativeLayout& layout;
+    MemoryStore& store;
+    std::vector<int32_t> stringHandles;
+    std::vector<int32_t> table;
+
+    WasmValue callHost(int32_t import, std::vector<WasmValue>& args);
+    // The function at table index idx, checked to have signature sig.
+    int32_t tableEntry(int32_t idx, int32_t sig) const;
+
+private:
+    std::vector<HostFunction> hostFuncs; // By import index
+};
+
+// Operations generated code calls where C++ alone would differ from the
+// interpreter: traps, wrapping arithmetic and bit-exact constants.
+namespace native {
+
+[[noreturn]] inline void trap(const char* message) { throw std::runtime_error(message); }
+
+inline float f32(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof f);
+    return f;
+}
+inline double f64(uint64_t bits) {
+    double d;
+    std::memcpy(&d, &bits, sizeof d);
+    return d;
+}
+
+inline int32_t add(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+inline int32_t sub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+inline int32_t mul(int32_t a, int32_t b) { return (int32_t)((uint32_t)a * (uint32_t)b); }
+inline int32_t divS(int32_t a, int32_t b) {
+    if (b == 0) trap("Integer divide by zero");
+    if (a == INT32_MIN && b == -1) trap("Integer overflow");
+    return a / b;
+}
+inline int32_t divU(int32_t a, int32_t b) {
+    if (b == 0) trap("Integer divide by zero");
+    return (int32_t)((uint32_t)a / (uint32_t)b);
+}
+inline int32_t remS(int32_t a, int32_t b) {
+    if (b == 0) trap("Integer divide by zero");
+    return b == -1 ? 0 : a % b;
+}
+inline int32_t remU(int32_t a, int32_t b) {
+    if (b == 0) trap("Integer divide by zero");
+    return (int32_t)((uint32_t)a % (uint32_t)b);
+}
+inline int32_t shl(int32_t a, int32_t b) { return (int32_t)((uint32_t)a << (b & 31)); }
+inline int32_t shrS(int32_t a, int32_t b) { return a >> (b & 31); }
+inline int32_t shrU(int32_t a, int32_t b) { return (int32_t)((uint32_t)a >> (b & 31)); }
+inline int32_t rotl(int32_t a, int32_t b) {
+    uint32_t x = (uint32_t)a, n = (uint32_t)b & 31;
+    return (int32_t)((x << n) | (x >> ((32 - n) & 31)));
+}
+inline int32_t rotr(int32_t a, int32_t b) {
+    uint32_t x = (uint32_t)a, n = (uint32_t)b & 31;
+    return (int32_t)((x >> n) | (x << ((32 - n) & 31)));
+}
+inline int32_t clz(int32_t a) { return a == 0 ? 32 : __builtin_clz((uint32_t)a); }
+inline int32_t ctz(int32_t a) { return a == 0 ? 32 : __builtin_ctz((uint32_t)a); }
+inline int32_t popcnt(int32_t a) { return __builtin_popcount((uint32_t)a); }
+
+} // namespace native
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Defined in CompiledModule.h, which holds the stats of each function
+struct BranchTarget;
+struct CompiledFunction;
+struct CompiledInstr;
+
+// Which passes run on lowered code; each can be turned off on its own.
+struct OptimizerOptions {
+    bool constantFolding = true;
+    bool copyPropagation = true;
+    bool deadStoreElimination = true;
+    bool unreachableCode = true;
+    // In loops: computes pure expressions of values the loop does not
+    // change once before it, and keeps linear functions of an induction
+    // variable up to date alongside it instead of recomputing them
+    bool loopInvariantMotion = true;
+    bool strengthReduction = true;
+    // Splices small callees into their callers (see Inliner)
+    bool inlining = true;
+    uint32_t inlineMaxSize = 16;         // Callee instructions, its trailing RETURN not counted
+    uint32_t inlineMaxDepth = 2;         // Inlined calls nested in inlined calls
+    uint32_t inlineMaxCallerSize = 4096; // Callers are not grown past this many instructions
+
+    static OptimizerOptions none() { return {false, false, false, false, false, false, false}; }
+    bool any() const {
+        return constantFolding || copyPropagation || deadStoreElimination || unreachableCode ||
+               loopInvariantMotion || strengthReduction || inlining;
+    }
+};
+
+// What the passes did, per function or summed over a module.
+struct OptimizerStats {
+    // Constant operations and identities (x + 0, x * 1, ...) evaluated at
+    // load time, and br_if/if on a constant condition resolved
+    uint64_t constantsFolded = 0;
+    // Local reads replaced by the local or constant that was copied into
+    // the local, and local.set followed by local.get of the same local
+    // fused into local.tee
+    uint64_t copiesPropagated = 0;
+    // Local writes removed because nothing reads the value
+    uint64_t deadStores = 0;
+    // Instructions removed because no path reaches them
+    uint64_t unreachableRemoved = 0;
+    // Loop-invariant expressions replaced by a read of a local set before
+    // the loop
+    uint64_t invariantsHoisted = 0;
+    // Expressions linear in an induction variable replaced by a read of a
+    // local stepped along with it
+    uint64_t strengthReduced = 0;
+    // Call sites replaced by the callee's body
+    uint64_t inlinedCalls = 0;
+    // Optimized code that failed validation and was dropped for the code
+    // as written; nonzero means an optimizer bug
+    uint64_t revalidationFailures = 0;
+    // Code size, including the trailing RETURN
+    uint64_t instructionsBefore = 0;
+    uint64_t instructionsAfter = 0;
+
+    OptimizerStats& operator+=(const OptimizerStats& other);
+};
+
+// Rewrites the lowered code of one function into fewer instructions with
+// the same behaviour. It runs after the Validator has accepted the code:
+// the passes rely on well-typed, balanced code and keep the structured
+// markers (block, loop, if, else, end) the Validator matches branches
+// against, so the result is validated again to recompute the branch
+// heights and the stack depth.
+//
+// All passes are local to a function and cheap: they repeat until nothing
+// changes, then the removed instructions are squeezed out and every branch
+// target is moved to match. The loop passes may add locals to the function
+// (CompiledFunction::extraLocals).
+class Optimizer {
+public:
+    explicit Optimizer(OptimizerOptions options = {});
+
+    const OptimizerOptions& options() const { return opts; }
+
+    // Optimizes code and branchTable, the lowered body of func, in place.
+    OptimizerStats optimize(CompiledFunction& func, std::vector<CompiledInstr>& code,
+                            std::vector<BranchTarget>& branchTable) const;
+
+private:
+    OptimizerOptions opts;
+};
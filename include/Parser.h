@@ -2,6 +2,7 @@
 
 #include "Lexer.h"
 #include "AST.h"
+#include "ThreadPool.h"
 #include <map>
 #include <stdexcept>
 #include <unordered_map>
@@ -10,27 +11,58 @@
 class Parser {
 public:
     explicit Parser(const std::vector<Token>& tokens);
+    // Streaming mode: tokens are pulled from the lexer as the parser needs
+    // them, so no token vector is ever materialized.
+    explicit Parser(Lexer& lexer);
 
     Module parse();
 
+    // Pre-scans the field boundaries of source, then parses function bodies
+    // on the pool while the remaining fields are parsed on the calling
+    // thread. Produces the same Module as parse(); must not be called from
+    // a task running on the same pool.
+    static Module parseParallel(std::string_view source, ThreadPool& pool);
+
+    // Lazy mode: only function signatures are parsed; each body is recorded
+    // as a view into source (Function::lazyBody) and parsed by
+    // CompiledModule on first call. owner must keep source alive and is
+    // stored in the Module.
+    static Module parseLazy(std::string_view source, std::shared_ptr<const void> owner);
+    // Parses the folded instructions of a lazily recorded function body.
+    static std::vector<Instruction> parseBody(std::string_view body);
+
+    static Opcode mapOpcode(std::string_view txt);
+    // Text name of an opcode, or an empty view for lowered-only opcodes.
+    static std::string_view opcodeName(Opcode op);
+
 private:
-    const std::vector<Token>& tokens;
+    const std::vector<Token>* tokens;
+    Lexer* lexer;
     size_t pos;
+    // Lexer mode lookahead window (the grammar needs at most one token
+    // beyond the current one).
+    Token window[2];
+    size_t windowHead;
+    size_t windowSize;
+    bool lazyBodies;
 
-    Token peek();
+    const Token& peek(size_t ahead = 0);
     Token consume();
     Token expect(TokenType type);
 
     void parseTopLevel(Module& mod);
+    void parseField(Module& mod);
     Import parseImport();
     Function parseFunc();
     Type parseType();
     Table parseTable();
     ElementSegment parseElem();
+    Global parseGlobal();
+    Export parseExport();
     void parseInstruction(std::vector<Instruction>& out);
 
     bool takesImmediate(Opcode op);
     Instruction parseImmediate(Opcode op);
-    Opcode mapOpcode(const std::string& txt);
-    void skipSExpr();
+    Instruction parseV128Const();
+    Token skipSExpr();
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CompiledModule.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Execution profile of one Interpreter: executed instructions per opcode,
+// calls and inclusive/exclusive time per function, and calls and time per
+// imported host function. Times are steady_clock nanoseconds.
+//
+// The Interpreter only feeds a Profiler when built with OPTRICH_PROFILE
+// (make PROFILE=1); otherwise the hooks are compiled out entirely and
+// Interpreter::setProfiler throws. A Profiler is not thread safe: attach
+// one per instance and merge the reports if needed.
+class Profiler {
+public:
+    struct FunctionStats {
+        uint64_t calls = 0;
+        // Inclusive time counts each outermost activation once, so recursion
+        // is not double counted; exclusive time excludes callees and host
+        // calls.
+        uint64_t inclusiveNanos = 0;
+        uint64_t exclusiveNanos = 0;
+    };
+
+    struct ImportStats {
+        uint64_t calls = 0;
+        uint64_t nanos = 0;
+    };
+
+    explicit Profiler(std::shared_ptr<const CompiledModule> module);
+
+    const std::shared_ptr<const CompiledModule>& module() const { return compiled; }
+
+    uint64_t opcodeCount(Opcode op) const { return opcodes[(size_t)op]; }
+    const FunctionStats& function(size_t index) const { return functions[index]; }
+    const ImportStats& import(size_t index) const { return imports[index]; }
+
+    // One line per distinct guest call stack, root first and separated by
+    // ';', followed by its exclusive time in nanoseconds: the folded format
+    // flamegraph.pl and similar tools read. Host calls appear as leaves.
+    void writeFolded(std::ostream& out) const;
+    void writeJson(std::ostream& out) const;
+
+    void reset();
+
+    // Hooks called by the Interpreter.
+    void countOpcode(Opcode op) { opcodes[(size_t)op]++; }
+    void enterFunction(int32_t funcIndex);
+    void exitFunction();
+    void hostCall(int32_t importIndex, uint64_t nanos);
+    // Drops activations above depth after a trap unwound them.
+    void unwind(size_t depth);
+    size_t depth() const { return active.size(); }
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    // Call stacks are interned into a tree so that attributing time to the
+    // current stack is a lookup, not a string build.
+    struct StackNode {
+        int32_t parent;
+        int32_t entry; // Defined function index, or -1 - import index
+        uint64_t nanos = 0;
+    };
+
+    struct Activation {
+        int32_t funcIndex;
+        int32_t node;
+        uint64_t start;
+        uint64_t childNanos;
+    };
+
+    std::shared_ptr<const CompiledModule> compiled;
+    std::array<uint64_t, 256> opcodes;
+    std::vector<FunctionStats> functions;
+    std::vector<ImportStats> imports;
+    std::vector<uint32_t> activeCount; // Activations on the stack per function
+    std::vector<Activation> active;
+    std::vector<StackNode> nodes;
+    std::unordered_map<uint64_t, int32_t> children; // (parent, entry) -> node
+
+    int32_t child(int32_t parent, int32_t entry);
+    std::string entryName(int32_t entry) const;
+    std::string opcodeLabel(Opcode op) const;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CompiledModule.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Classifies a module's defined functions as pure: the result depends only
+// on the arguments, and calling them has no effect besides possibly
+// trapping. A pure function makes no host calls, does not touch its
+// MemoryStore (v128.load/v128.store), reads no mutable global, writes no
+// global, makes no indirect call and only calls pure functions. Recursion
+// is fine: the analysis starts from "everything is pure" and removes
+// functions until nothing changes.
+//
+// The analysis reads lowered code, so it compiles any lazily recorded
+// function; one whose body fails to compile counts as impure.
+class PurityAnalysis {
+public:
+    explicit PurityAnalysis(const CompiledModule& module);
+
+    const CompiledModule& module() const { return compiled; }
+
+    // By defined function index.
+    bool isPure(size_t func) const { return pure[func]; }
+    // Why a function is impure, for diagnostics; empty when it is pure.
+    const std::string& reason(size_t func) const { return reasons[func]; }
+    size_t pureCount() const;
+
+private:
+    const CompiledModule& compiled;
+    std::vector<bool> pure;
+    std::vector<std::string> reasons;
+};
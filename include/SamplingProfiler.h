@@ -0,0 +1,125 @@
+#pragma once
+
+#include "CompiledModule.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SamplingProfiler;
+
+// Copy of an Interpreter's call stack that a signal handler can read at any
+// instant: fixed storage, no allocation, and a depth that is only published
+// after the frame below it is written. pc is the call site for callers and,
+// for the innermost frame, the target of the last taken branch, which is
+// enough to tell loops apart without a store per instruction.
+struct GuestStackShadow {
+    static constexpr uint32_t kMaxDepth = 256;
+
+    struct Frame {
+        int32_t func; // Defined function index
+        uint32_t pc;
+    };
+
+    SamplingProfiler* sampler;
+    Frame frames[kMaxDepth];
+    std::atomic<uint32_t> depth{0}; // May exceed kMaxDepth; deeper frames are not recorded
+
+    void push(int32_t func) {
+        uint32_t d = depth.load(std::memory_order_relaxed);
+        if (d < kMaxDepth) frames[d] = {func, 0};
+        std::atomic_signal_fence(std::memory_order_release);
+        depth.store(d + 1, std::memory_order_relaxed);
+    }
+    void pop() { depth.store(depth.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed); }
+    void setPc(uint32_t pc) {
+        uint32_t d = depth.load(std::memory_order_relaxed);
+        if (d - 1 < kMaxDepth) frames[d - 1].pc = pc;
+    }
+};
+
+// Statistical profiler over guest call stacks. While started, a SIGPROF
+// timer (setitimer ITIMER_PROF, so it measures CPU time) interrupts the
+// process; the handler copies the guest stack of whichever attached
+// Interpreter is running on the interrupted thread into a lock-free ring,
+// and a background thread folds the ring into per-stack and per-pc counts.
+//
+// Only one SamplingProfiler can be started at a time, since the timer and
+// the signal disposition are process wide. Interpreters attach with
+// Interpreter::setSampler.
+class SamplingProfiler {
+public:
+    struct HotSpot {
+        int32_t func;
+        uint32_t pc;
+        uint64_t samples;
+    };
+
+    explicit SamplingProfiler(std::shared_ptr<const CompiledModule> module,
+                              std::chrono::microseconds interval = std::chrono::microseconds(1000));
+    ~SamplingProfiler();
+
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    const std::shared_ptr<const CompiledModule>& module() const { return compiled; }
+
+    void start();
+    // Stops the timer and folds every pending sample in.
+    void stop();
+
+    // Samples that caught guest code, and samples taken while no attached
+    // interpreter was running on the interrupted thread.
+    uint64_t guestSamples() const;
+    uint64_t otherSamples() const { return outside.load(); }
+    // Samples lost because the ring was full.
+    uint64_t droppedSamples() const { return dropped.load(); }
+
+    // Innermost (function, pc) pairs, most sampled first.
+    std::vector<HotSpot> hotSpots() const;
+    // Folded stacks, root first, followed by their sample count.
+    void writeFolded(std::ostream& out) const;
+
+    // Makes stack the one sampled on the calling thread and returns the
+    // previous one; the Interpreter brackets each run() with this.
+    static GuestStackShadow* enterThread(GuestStackShadow* stack);
+
+    // Signal handler side; async-signal-safe.
+    void record(const GuestStackShadow& stack);
+    void recordOutside();
+
+private:
+    static constexpr size_t kRingSize = 1024;
+    static constexpr uint32_t kSampleDepth = 64; // Innermost frames kept per sample
+
+    struct Sample {
+        std::atomic<uint32_t> state{0}; // 0 free, 1 being written, 2 ready
+        uint32_t depth;
+        GuestStackShadow::Frame frames[kSampleDepth]; // Root-most kept frame first
+    };
+
+    std::shared_ptr<const CompiledModule> compiled;
+    std::chrono::microseconds interval;
+    std::unique_ptr<Sample[]> ring;
+    std::atomic<uint64_t> writeIndex{0};
+    std::atomic<uint64_t> outside{0};
+    std::atomic<uint64_t> dropped{0};
+
+    mutable std::mutex mtx; // Guards the aggregates and the thread state below
+    std::condition_variable cv;
+    std::thread aggregator;
+    bool running = false;
+    uint64_t samples = 0;
+    std::map<std::vector<int32_t>, uint64_t> stacks;
+    std::map<std::pair<int32_t, uint32_t>, uint64_t> pcs;
+
+    void drain();
+    std::string functionName(int32_t func) const;
+};
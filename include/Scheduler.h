@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Interpreter.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs many guest invocations as lightweight tasks over a fixed set of
+// worker threads. A task is one run() on a caller-owned Interpreter, whose
+// value and call stacks (grown on demand) are the task's execution stack;
+// no OS thread is tied to it between slices.
+//
+// Each worker owns a deque: it pushes and pops its own tasks at the back
+// and idle workers steal from the front of others'. A task gives up its
+// worker when its time slice (measured in fuel, see Interpreter::setFuel)
+// runs out, requeueing behind the worker's other tasks, or when a host
+// function returns WasmValue::pending(), parking until Task::complete()
+// hands in the result. The scheduler owns the fuel of the instances it
+// runs. Tasks started with spawn() from outside the workers, and parked
+// tasks completed from outside, go through a shared injection queue.
+class Scheduler {
+public:
+    class Task : public std::enable_shared_from_this<Task> {
+    public:
+        // Completes the host call the task is parked on; callable from any
+        // thread, including from inside the host function before it returns
+        // pending().
+        void complete(WasmValue hostResult);
+
+    private:
+        friend class Scheduler;
+        Task(Scheduler* scheduler, Interpreter& vm, std::string funcName, std::vector<WasmValue> args)
+            : scheduler(scheduler), vm(vm), funcName(std::move(funcName)), args(std::move(args)) {}
+
+        enum class State { Queued, Running, Parked };
+
+        Scheduler* scheduler;
+        Interpreter& vm;
+        std::string funcName;
+        std::vector<WasmValue> args;
+        std::promise<WasmValue> result;
+        bool started = false;
+
+        std::mutex mtx; // Guards the fields below
+        State state = State::Queued;
+        bool hasHostResult = false;
+        WasmValue hostResult;
+    };
+
+    // 0 threads picks one per hardware thread; a 0 slice runs every task
+    // unmetered until it finishes or parks.
+    explicit Scheduler(size_t threads = 0, uint64_t sliceFuel = 100000);
+    // Waits until no task is runnable, then joins the workers. Tasks still
+    // parked are abandoned: their futures report a broken promise.
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Queues vm.run(funcName, args). vm must stay alive and be used by no one
+    // else until the future is ready; errors from the run (traps, or fuel
+    // running out in a nested run) are rethrown by the future.
+    std::future<WasmValue> spawn(Interpreter& vm, std::string funcName, std::vector<WasmValue> args);
+
+    // The task running on the calling worker thread, for host functions that
+    // are about to return pending(); null elsewhere.
+    static std::shared_ptr<Task> currentTask();
+
+    // Counters for tuning: tasks taken from another worker's deque, slices
+    // that ended because the fuel ran out, and host calls parked on.
+    uint64_t stealCount() const { return steals.load(); }
+    uint64_t yieldCount() const { return yields.load(); }
+    uint64_t parkCount() const { return parks.load(); }
+
+private:
+    using TaskPtr = std::shared_ptr<Task>;
+
+    struct Worker {
+        std::mutex mtx;
+        std::deque<TaskPtr> tasks;
+    };
+
+    uint64_t sliceFuel;
+    std::vector<std::unique_ptr<Worker>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex injectMtx;
+    std::deque<TaskPtr> injected;
+
+    // Runnable tasks not yet taken by a worker, and tasks being run
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> running{0};
+    std::mutex sleepMtx;
+    std::condition_variable wake;    // Workers wait here for queued tasks
+    std::condition_variable drained; // The destructor waits here for quiescence
+    bool stopping = false;
+
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> yields{0};
+    std::atomic<uint64_t> parks{0};
+
+    void workerLoop(size_t self);
+    TaskPtr take(size_t self);
+    void runSlice(const TaskPtr& task);
+    // Makes task runnable: on the calling worker's deque (at the back, or
+    // behind its other tasks when yielding) or the injection queue.
+    void enqueue(TaskPtr task, bool yielding);
+};
@@ -0,0 +1,516 @@
+#pragma once
+
+#include "AST.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+// Kernels behind the v128 opcodes. simd::portable holds plain lane loops
+// that define the semantics; the functions in simd itself use SSE2 (every
+// x86-64 target) and SSE4.1 intrinsics where the target has them, and the
+// loops otherwise. Building with -mavx gets the VEX forms of the same
+// instructions. Comparisons produce all-ones or all-zero lanes.
+namespace simd {
+
+// "sse4.1", "sse2" or "portable", fixed at compile time.
+inline const char* backend() {
+#if defined(__SSE4_1__)
+    return "sse4.1";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "portable";
+#endif
+}
+
+template <typename Lane>
+inline V128 splat(Lane value) {
+    V128 r;
+    for (size_t i = 0; i < 16 / sizeof(Lane); ++i) std::memcpy(r.bytes + i * sizeof(Lane), &value, sizeof(Lane));
+    return r;
+}
+
+template <typename Lane>
+inline Lane extractLane(const V128& v, int lane) {
+    Lane value;
+    std::memcpy(&value, v.bytes + lane * sizeof(Lane), sizeof(Lane));
+    return value;
+}
+
+template <typename Lane>
+inline V128 replaceLane(V128 v, int lane, Lane value) {
+    std::memcpy(v.bytes + lane * sizeof(Lane), &value, sizeof(Lane));
+    return v;
+}
+
+namespace portable {
+
+template <typename Lane, typename Op>
+inline V128 map(const V128& a, Op op) {
+    constexpr size_t N = 16 / sizeof(Lane);
+    Lane x[N];
+    std::memcpy(x, a.bytes, 16);
+    for (size_t i = 0; i < N; ++i) x[i] = op(x[i]);
+    V128 r;
+    std::memcpy(r.bytes, x, 16);
+    return r;
+}
+
+template <typename Lane, typename Op>
+inline V128 zip(const V128& a, const V128& b, Op op) {
+    constexpr size_t N = 16 / sizeof(Lane);
+    Lane x[N], y[N];
+    std::memcpy(x, a.bytes, 16);
+    std::memcpy(y, b.bytes, 16);
+    for (size_t i = 0; i < N; ++i) x[i] = op(x[i], y[i]);
+    V128 r;
+    std::memcpy(r.bytes, x, 16);
+    return r;
+}
+
+// Mask is the unsigned integer type as wide as Lane.
+template <typename Lane, typename Mask, typename Op>
+inline V128 compare(const V128& a, const V128& b, Op op) {
+    constexpr size_t N = 16 / sizeof(Lane);
+    Lane x[N], y[N];
+    Mask m[N];
+    std::memcpy(x, a.bytes, 16);
+    std::memcpy(y, b.bytes, 16);
+    for (size_t i = 0; i < N; ++i) m[i] = op(x[i], y[i]) ? ~Mask(0) : Mask(0);
+    V128 r;
+    std::memcpy(r.bytes, m, 16);
+    return r;
+}
+
+inline V128 v128Not(const V128& a) { return map<uint64_t>(a, [](uint64_t x) { return uint64_t(~x); }); }
+inline V128 v128And(const V128& a, const V128& b) { return zip<uint64_t>(a, b, [](uint64_t x, uint64_t y) { return uint64_t(x & y); }); }
+inline V128 v128AndNot(const V128& a, const V128& b) { return zip<uint64_t>(a, b, [](uint64_t x, uint64_t y) { return uint64_t(x & ~y); }); }
+inline V128 v128Or(const V128& a, const V128& b) { return zip<uint64_t>(a, b, [](uint64_t x, uint64_t y) { return uint64_t(x | y); }); }
+inline V128 v128Xor(const V128& a, const V128& b) { return zip<uint64_t>(a, b, [](uint64_t x, uint64_t y) { return uint64_t(x ^ y); }); }
+inline V128 i32x4Add(const V128& a, const V128& b) { return zip<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return uint32_t(x + y); }); }
+inline V128 i32x4Sub(const V128& a, const V128& b) { return zip<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return uint32_t(x - y); }); }
+inline V128 i32x4Mul(const V128& a, const V128& b) { return zip<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return uint32_t(x * y); }); }
+inline V128 i32x4Neg(const V128& a) { return map<uint32_t>(a, [](uint32_t x) { return uint32_t(0u - x); }); }
+inline V128 i32x4MinS(const V128& a, const V128& b) { return zip<int32_t>(a, b, [](int32_t x, int32_t y) { return int32_t(x < y ? x : y); }); }
+inline V128 i32x4MaxS(const V128& a, const V128& b) { return zip<int32_t>(a, b, [](int32_t x, int32_t y) { return int32_t(x > y ? x : y); }); }
+inline V128 i32x4Eq(const V128& a, const V128& b) { return compare<int32_t, uint32_t>(a, b, [](int32_t x, int32_t y) { return x == y; }); }
+inline V128 i32x4Ne(const V128& a, const V128& b) { return compare<int32_t, uint32_t>(a, b, [](int32_t x, int32_t y) { return x != y; }); }
+inline V128 i32x4LtS(const V128& a, const V128& b) { return compare<int32_t, uint32_t>(a, b, [](int32_t x, int32_t y) { return x < y; }); }
+inline V128 i32x4LtU(const V128& a, const V128& b) { return compare<uint32_t, uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x < y; }); }
+inline V128 i32x4GtS(const V128& a, const V128& b) { return compare<int32_t, uint32_t>(a, b, [](int32_t x, int32_t y) { return x > y; }); }
+inline V128 i32x4GtU(const V128& a, const V128& b) { return compare<uint32_t, uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x > y; }); }
+inline V128 i32x4LeS(const V128& a, const V128& b) { return compare<int32_t, uint32_t>(a, b, [](int32_t x, int32_t y) { return x <= y; }); }
+inline V128 i32x4GeS(const V128& a, const V128& b) { return compare<int32_t, uint32_t>(a, b, [](int32_t x, int32_t y) { return x >= y; }); }
+inline V128 f32x4Add(const V128& a, const V128& b) { return zip<float>(a, b, [](float x, float y) { return float(x + y); }); }
+inline V128 f32x4Sub(const V128& a, const V128& b) { return zip<float>(a, b, [](float x, float y) { return float(x - y); }); }
+inline V128 f32x4Mul(const V128& a, const V128& b) { return zip<float>(a, b, [](float x, float y) { return float(x * y); }); }
+inline V128 f32x4Div(const V128& a, const V128& b) { return zip<float>(a, b, [](float x, float y) { return float(x / y); }); }
+inline V128 f32x4Neg(const V128& a) { return map<uint32_t>(a, [](uint32_t x) { return uint32_t(x ^ 0x80000000u); }); }
+inline V128 f32x4Abs(const V128& a) { return map<uint32_t>(a, [](uint32_t x) { return uint32_t(x & ~0x80000000u); }); }
+inline V128 f32x4Sqrt(const V128& a) { return map<float>(a, [](float x) { return float(std::sqrt(x)); }); }
+inline V128 f32x4Eq(const V128& a, const V128& b) { return compare<float, uint32_t>(a, b, [](float x, float y) { return x == y; }); }
+inline V128 f32x4Ne(const V128& a, const V128& b) { return compare<float, uint32_t>(a, b, [](float x, float y) { return x != y; }); }
+inline V128 f32x4Lt(const V128& a, const V128& b) { return compare<float, uint32_t>(a, b, [](float x, float y) { return x < y; }); }
+inline V128 f32x4Gt(const V128& a, const V128& b) { return compare<float, uint32_t>(a, b, [](float x, float y) { return x > y; }); }
+inline V128 f32x4Le(const V128& a, const V128& b) { return compare<float, uint32_t>(a, b, [](float x, float y) { return x <= y; }); }
+inline V128 f32x4Ge(const V128& a, const V128& b) { return compare<float, uint32_t>(a, b, [](float x, float y) { return x >= y; }); }
+inline V128 f64x2Add(const V128& a, const V128& b) { return zip<double>(a, b, [](double x, double y) { return double(x + y); }); }
+inline V128 f64x2Sub(const V128& a, const V128& b) { return zip<double>(a, b, [](double x, double y) { return double(x - y); }); }
+inline V128 f64x2Mul(const V128& a, const V128& b) { return zip<double>(a, b, [](double x, double y) { return double(x * y); }); }
+inline V128 f64x2Div(const V128& a, const V128& b) { return zip<double>(a, b, [](double x, double y) { return double(x / y); }); }
+inline V128 f64x2Neg(const V128& a) { return map<uint64_t>(a, [](uint64_t x) { return uint64_t(x ^ 0x8000000000000000ull); }); }
+inline V128 f64x2Abs(const V128& a) { return map<uint64_t>(a, [](uint64_t x) { return uint64_t(x & ~0x8000000000000000ull); }); }
+inline V128 f64x2Sqrt(const V128& a) { return map<double>(a, [](double x) { return double(std::sqrt(x)); }); }
+inline V128 f64x2Eq(const V128& a, const V128& b) { return compare<double, uint64_t>(a, b, [](double x, double y) { return x == y; }); }
+inline V128 f64x2Ne(const V128& a, const V128& b) { return compare<double, uint64_t>(a, b, [](double x, double y) { return x != y; }); }
+inline V128 f64x2Lt(const V128& a, const V128& b) { return compare<double, uint64_t>(a, b, [](double x, double y) { return x < y; }); }
+inline V128 f64x2Gt(const V128& a, const V128& b) { return compare<double, uint64_t>(a, b, [](double x, double y) { return x > y; }); }
+inline V128 f64x2Le(const V128& a, const V128& b) { return compare<double, uint64_t>(a, b, [](double x, double y) { return x <= y; }); }
+inline V128 f64x2Ge(const V128& a, const V128& b) { return compare<double, uint64_t>(a, b, [](double x, double y) { return x >= y; }); }
+
+} // namespace portable
+
+#if defined(__SSE2__)
+inline __m128i toInt(const V128& v) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(v.bytes)); }
+inline __m128 toF32(const V128& v) { return _mm_castsi128_ps(toInt(v)); }
+inline __m128d toF64(const V128& v) { return _mm_castsi128_pd(toInt(v)); }
+inline V128 fromInt(__m128i x) {
+    V128 r;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(r.bytes), x);
+    return r;
+}
+inline V128 fromF32(__m128 x) { return fromInt(_mm_castps_si128(x)); }
+inline V128 fromF64(__m128d x) { return fromInt(_mm_castpd_si128(x)); }
+inline __m128i allOnes() { return _mm_set1_epi32(-1); }
+// Flipping the sign bit turns unsigned order into signed order
+inline __m128i flipSign(__m128i x) { return _mm_xor_si128(x, _mm_set1_epi32(INT32_MIN)); }
+#endif
+
+inline V128 v128Not(const V128& a) {
+#if defined(__SSE2__)
+    return fromInt(_mm_xor_si128(toInt(a), allOnes()));
+#else
+    return portable::v128Not(a);
+#endif
+}
+
+inline V128 v128And(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_and_si128(toInt(a), toInt(b)));
+#else
+    return portable::v128And(a, b);
+#endif
+}
+
+inline V128 v128AndNot(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_andnot_si128(toInt(b), toInt(a)));
+#else
+    return portable::v128AndNot(a, b);
+#endif
+}
+
+inline V128 v128Or(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_or_si128(toInt(a), toInt(b)));
+#else
+    return portable::v128Or(a, b);
+#endif
+}
+
+inline V128 v128Xor(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_xor_si128(toInt(a), toInt(b)));
+#else
+    return portable::v128Xor(a, b);
+#endif
+}
+
+inline V128 i32x4Add(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_add_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4Add(a, b);
+#endif
+}
+
+inline V128 i32x4Sub(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_sub_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4Sub(a, b);
+#endif
+}
+
+inline V128 i32x4Mul(const V128& a, const V128& b) {
+#if defined(__SSE4_1__)
+    return fromInt(_mm_mullo_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4Mul(a, b);
+#endif
+}
+
+inline V128 i32x4Neg(const V128& a) {
+#if defined(__SSE2__)
+    return fromInt(_mm_sub_epi32(_mm_setzero_si128(), toInt(a)));
+#else
+    return portable::i32x4Neg(a);
+#endif
+}
+
+inline V128 i32x4MinS(const V128& a, const V128& b) {
+#if defined(__SSE4_1__)
+    return fromInt(_mm_min_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4MinS(a, b);
+#endif
+}
+
+inline V128 i32x4MaxS(const V128& a, const V128& b) {
+#if defined(__SSE4_1__)
+    return fromInt(_mm_max_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4MaxS(a, b);
+#endif
+}
+
+inline V128 i32x4Eq(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_cmpeq_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4Eq(a, b);
+#endif
+}
+
+inline V128 i32x4Ne(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_xor_si128(_mm_cmpeq_epi32(toInt(a), toInt(b)), allOnes()));
+#else
+    return portable::i32x4Ne(a, b);
+#endif
+}
+
+inline V128 i32x4LtS(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_cmplt_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4LtS(a, b);
+#endif
+}
+
+inline V128 i32x4LtU(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_cmplt_epi32(flipSign(toInt(a)), flipSign(toInt(b))));
+#else
+    return portable::i32x4LtU(a, b);
+#endif
+}
+
+inline V128 i32x4GtS(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_cmpgt_epi32(toInt(a), toInt(b)));
+#else
+    return portable::i32x4GtS(a, b);
+#endif
+}
+
+inline V128 i32x4GtU(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_cmpgt_epi32(flipSign(toInt(a)), flipSign(toInt(b))));
+#else
+    return portable::i32x4GtU(a, b);
+#endif
+}
+
+inline V128 i32x4LeS(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_xor_si128(_mm_cmpgt_epi32(toInt(a), toInt(b)), allOnes()));
+#else
+    return portable::i32x4LeS(a, b);
+#endif
+}
+
+inline V128 i32x4GeS(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromInt(_mm_xor_si128(_mm_cmplt_epi32(toInt(a), toInt(b)), allOnes()));
+#else
+    return portable::i32x4GeS(a, b);
+#endif
+}
+
+inline V128 f32x4Add(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_add_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Add(a, b);
+#endif
+}
+
+inline V128 f32x4Sub(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_sub_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Sub(a, b);
+#endif
+}
+
+inline V128 f32x4Mul(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_mul_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Mul(a, b);
+#endif
+}
+
+inline V128 f32x4Div(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_div_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Div(a, b);
+#endif
+}
+
+inline V128 f32x4Neg(const V128& a) {
+#if defined(__SSE2__)
+    return fromF32(_mm_xor_ps(toF32(a), _mm_set1_ps(-0.0f)));
+#else
+    return portable::f32x4Neg(a);
+#endif
+}
+
+inline V128 f32x4Abs(const V128& a) {
+#if defined(__SSE2__)
+    return fromF32(_mm_andnot_ps(_mm_set1_ps(-0.0f), toF32(a)));
+#else
+    return portable::f32x4Abs(a);
+#endif
+}
+
+inline V128 f32x4Sqrt(const V128& a) {
+#if defined(__SSE2__)
+    return fromF32(_mm_sqrt_ps(toF32(a)));
+#else
+    return portable::f32x4Sqrt(a);
+#endif
+}
+
+inline V128 f32x4Eq(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_cmpeq_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Eq(a, b);
+#endif
+}
+
+inline V128 f32x4Ne(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_cmpneq_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Ne(a, b);
+#endif
+}
+
+inline V128 f32x4Lt(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_cmplt_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Lt(a, b);
+#endif
+}
+
+inline V128 f32x4Gt(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_cmpgt_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Gt(a, b);
+#endif
+}
+
+inline V128 f32x4Le(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_cmple_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Le(a, b);
+#endif
+}
+
+inline V128 f32x4Ge(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF32(_mm_cmpge_ps(toF32(a), toF32(b)));
+#else
+    return portable::f32x4Ge(a, b);
+#endif
+}
+
+inline V128 f64x2Add(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_add_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Add(a, b);
+#endif
+}
+
+inline V128 f64x2Sub(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_sub_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Sub(a, b);
+#endif
+}
+
+inline V128 f64x2Mul(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_mul_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Mul(a, b);
+#endif
+}
+
+inline V128 f64x2Div(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_div_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Div(a, b);
+#endif
+}
+
+inline V128 f64x2Neg(const V128& a) {
+#if defined(__SSE2__)
+    return fromF64(_mm_xor_pd(toF64(a), _mm_set1_pd(-0.0)));
+#else
+    return portable::f64x2Neg(a);
+#endif
+}
+
+inline V128 f64x2Abs(const V128& a) {
+#if defined(__SSE2__)
+    return fromF64(_mm_andnot_pd(_mm_set1_pd(-0.0), toF64(a)));
+#else
+    return portable::f64x2Abs(a);
+#endif
+}
+
+inline V128 f64x2Sqrt(const V128& a) {
+#if defined(__SSE2__)
+    return fromF64(_mm_sqrt_pd(toF64(a)));
+#else
+    return portable::f64x2Sqrt(a);
+#endif
+}
+
+inline V128 f64x2Eq(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_cmpeq_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Eq(a, b);
+#endif
+}
+
+inline V128 f64x2Ne(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_cmpneq_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Ne(a, b);
+#endif
+}
+
+inline V128 f64x2Lt(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_cmplt_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Lt(a, b);
+#endif
+}
+
+inline V128 f64x2Gt(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_cmpgt_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Gt(a, b);
+#endif
+}
+
+inline V128 f64x2Le(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_cmple_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Le(a, b);
+#endif
+}
+
+inline V128 f64x2Ge(const V128& a, const V128& b) {
+#if defined(__SSE2__)
+    return fromF64(_mm_cmpge_pd(toF64(a), toF64(b)));
+#else
+    return portable::f64x2Ge(a, b);
+#endif
+}
+
+} // namespace simd
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct StdioOptions {
+    size_t bufferSize = 4096;
+    // Also flush after every write ending in a newline, for output someone
+    // watches as it happens.
+    bool lineBuffered = false;
+};
+
+// Buffered standard output for guest code, so that printing a message
+// costs one host call instead of one per character:
+//
+//   stdio.write (handle, offset, len)  a MemoryStore range
+//   stdio.putchar (c)                  one byte
+//   stdio.flush ()
+//
+// Small writes are copied into the buffer. A range that does not fit goes
+// out together with the buffered bytes in a single writev, straight from
+// the MemoryStore without another copy. The buffer is flushed when full,
+// on stdio.flush or flush(), on newlines if lineBuffered, and on
+// destruction.
+//
+// Bind every instance of one program to the same StdioHost to keep their
+// output in order. Not thread safe: like an Interpreter, it belongs to
+// one thread at a time.
+class StdioHost {
+public:
+    // Output to a file descriptor, which stays open
+    StdioHost(MemoryStore& store, int fd, StdioOptions options = {});
+    // Output to a stream, e.g. std::cout while a test captures it
+    StdioHost(MemoryStore& store, std::ostream& out, StdioOptions options = {});
+    ~StdioHost();
+
+    StdioHost(const StdioHost&) = delete;
+    StdioHost& operator=(const StdioHost&) = delete;
+
+    // Registers write, putchar and flush under module on vm, an
+    // Interpreter or NativeModule. Imports vm does not declare are skipped.
+    template <typename Instance>
+    void bind(Instance& vm, const std::string& module = "stdio") {
+        vm.registerHostFunction(module, "write", [this](std::vector<WasmValue>& args) {
+            write(args[0].i32, args[1].i32, args[2].i32);
+            return WasmValue();
+        }, {"i32", "i32", "i32"}, {});
+        vm.registerHostFunction(module, "putchar", [this](std::vector<WasmValue>& args) {
+            put((char)args[0].i32);
+            return WasmValue();
+        }, {"i32"}, {});
+        vm.registerHostFunction(module, "flush", [this](std::vector<WasmValue>&) {
+            flush();
+            return WasmValue();
+        }, {}, {});
+    }
+
+    void write(MemoryStore::Handle handle, int32_t offset, int32_t len);
+    void put(char c);
+    void flush();
+
+    // Bytes handed to the fd or stream so far, and in how many writes
+    size_t bytesWritten() const { return written; }
+    size_t sinkWrites() const { return writes; }
+
+private:
+    MemoryStore& store;
+    int fd;
+    std::ostream* stream; // Null when writing to fd
+    StdioOptions opts;
+    std::vector<char> buffer;
+    size_t used = 0;
+    size_t written = 0;
+    size_t writes = 0;
+
+    // The buffered bytes, then len bytes at data, in one write
+    void drain(const uint8_t* data, size_t len);
+};
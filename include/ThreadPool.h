@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads draining a FIFO of tasks. submit() returns a
+// future that carries the task's result or rethrows its exception. Tasks
+// must not block waiting on other tasks of the same pool.
+class ThreadPool {
+public:
+    // 0 picks one worker per hardware thread.
+    explicit ThreadPool(size_t threads = 0);
+    // Runs every queued task, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    template <typename F>
+    auto submit(F&& task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queue.emplace_back([packaged]() { (*packaged)(); });
+        }
+        cv.notify_one();
+        return result;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    void workerLoop();
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CompiledModule.h"
+#include <cstdint>
+#include <vector>
+
+// Static type checker for lowered function bodies. It tracks the type of
+// every operand stack slot, checks local, global and call signatures and
+// that each block or if branch ends at the height it started with (blocks
+// carry no values), and computes the deepest the operand stack can get.
+//
+// A function that validates can run without underflow or type checks:
+// its frame is sized once on entry, and every branch instruction is
+// annotated with the height of its target label (in CompiledInstr::i32, or
+// in the br_table entries) so that taking it discards exactly the operands
+// the label does not keep.
+class Validator {
+public:
+    explicit Validator(const CompiledModule& module);
+
+    // Checks code, the lowered body of func, and annotates its branches and
+    // the br_table entries they use. Returns the maximum operand stack
+    // depth; throws std::runtime_error describing the first violation.
+    // With heights, also records the operand stack height in slots before
+    // each pc, or -1 where no path reaches (after br, return or
+    // unreachable, up to the end of the enclosing block).
+    uint32_t validate(const CompiledFunction& func, std::vector<CompiledInstr>& code,
+                      std::vector<BranchTarget>& branchTable, std::vector<int32_t>* heights = nullptr) const;
+
+private:
+    const CompiledModule& module;
+};
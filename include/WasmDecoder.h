@@ -0,0 +1,51 @@
+#pragma once
+
+#include "AST.h"
+#include "ByteIO.h"
+#include <string>
+#include <vector>
+
+// Decodes the standard WebAssembly binary format into the same Module the
+// text Parser produces. Input can be pushed in arbitrary chunks with feed():
+// every section is decoded as soon as its last byte arrives and only an
+// incomplete trailing section is ever buffered.
+//
+// Supported: type, import (func), function, table, global, export, elem
+// (active, table 0), code, the "name" custom section, and an
+// "optrich.strings" custom section holding the module's string constants
+// (a vec of name/value pairs) referenced by the extension opcode 0xE0
+// (string.const, followed by a LEB128 string index).
+//
+// Calls, branches, locals and table entries are emitted as index operands,
+// which CompiledModule resolves like their named text counterparts.
+class WasmDecoder {
+public:
+    static const uint8_t kStringConstOpcode = 0xE0;
+
+    WasmDecoder();
+
+    void feed(const uint8_t* data, size_t size);
+    Module finish();
+
+    // Whole-buffer convenience wrapper; the buffer is never copied.
+    static Module decode(const uint8_t* data, size_t size);
+    static Module decodeFile(const std::string& path);
+
+private:
+    Module mod;
+    std::vector<uint8_t> pending;
+    bool headerSeen;
+    bool finished;
+    std::vector<uint32_t> functionTypes; // Type index per defined function
+    size_t codeBodies;
+
+    size_t consume(const uint8_t* data, size_t size);
+    void decodeSection(uint8_t id, ByteReader& in);
+    void decodeCustom(ByteReader& in);
+    void decodeNames(ByteReader& in);
+    void decodeCode(ByteReader& in, Function& func);
+
+    std::string valueType(uint8_t code);
+    Instruction constExpr(ByteReader& in);
+    void readSignature(uint32_t typeIndex, std::vector<std::string>& params, std::vector<std::string>& results);
+};
@@ -0,0 +1,59 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+    },
+    {
+        {"add", 0},
+    },
+    {
+        {"i32", "i32"},
+    },
+    {
+        {"i32"},
+    },
+    {0},
+    {
+        {"i32", "i32"},
+    },
+    {
+    },
+    {},
+};
+
+class Native_lib_math final : public NativeModule {
+public:
+    explicit Native_lib_math(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: return WasmValue(f0(args[0].i32, args[1].i32));
+            default: return WasmValue();
+        }
+    }
+
+private:
+    // $add
+    int32_t f0(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = l1;
+        si0 = native::add(si0, si1);
+        return si0;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("lib_math", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_lib_math(store)); });
+
+} // namespace
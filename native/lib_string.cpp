@@ -0,0 +1,307 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+        {"env", "alloc", {"i32"}, {"i32"}},
+        {"env", "write_u8", {"i32", "i32", "i32"}, {}},
+        {"env", "read_u8", {"i32", "i32"}, {"i32"}},
+        {"env", "write_i32", {"i32", "i32", "i32"}, {}},
+        {"env", "read_i32", {"i32", "i32"}, {"i32"}},
+        {"env", "putchar", {"i32"}, {}},
+    },
+    {
+        {"concat", 4},
+        {"create", 0},
+        {"get", 3},
+        {"length", 1},
+        {"print", 5},
+        {"set", 2},
+    },
+    {
+        {"i32"},
+        {"i32"},
+        {"i32", "i32", "i32"},
+        {"i32", "i32"},
+        {"i32", "i32"},
+        {"i32"},
+    },
+    {
+        {"i32"},
+        {"i32"},
+        {},
+        {"i32"},
+        {"i32"},
+        {},
+    },
+    {0, 0, 1, 2, 2, 3},
+    {
+        {"i32"},
+        {"i32", "i32", "i32"},
+        {"i32", "i32"},
+        {"i32"},
+    },
+    {
+    },
+    {},
+};
+
+class Native_lib_string final : public NativeModule {
+public:
+    explicit Native_lib_string(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: return WasmValue(f0(args[0].i32));
+            case 1: return WasmValue(f1(args[0].i32));
+            case 2: f2(args[0].i32, args[1].i32, args[2].i32); return WasmValue();
+            case 3: return WasmValue(f3(args[0].i32, args[1].i32));
+            case 4: return WasmValue(f4(args[0].i32, args[1].i32));
+            case 5: f5(args[0].i32); return WasmValue();
+            default: return WasmValue();
+        }
+    }
+
+private:
+    // $create
+    int32_t f0(int32_t l0) {
+        int32_t l1{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = 4;
+        si0 = native::add(si0, si1);
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l1 = si0;
+        si1 = 0;
+        si2 = l0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(3, args);
+        }
+        si0 = l1;
+        return si0;
+    }
+
+    // $length
+    int32_t f1(int32_t l0) {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = 0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(4, args).i32;
+        }
+        return si0;
+    }
+
+    // $set
+    void f2(int32_t l0, int32_t l1, int32_t l2) {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = l1;
+        si2 = 4;
+        si1 = native::add(si1, si2);
+        si2 = l2;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        return;
+    }
+
+    // $get
+    int32_t f3(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = l1;
+        si2 = 4;
+        si1 = native::add(si1, si2);
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        return si0;
+    }
+
+    // $concat
+    int32_t f4(int32_t l0, int32_t l1) {
+        int32_t l2{};
+        int32_t l3{};
+        int32_t l4{};
+        int32_t l5{};
+        int32_t l6{};
+        int32_t l7{};
+        int32_t l8{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        int32_t si3{};
+        int32_t si4{};
+        si0 = l0;
+        si1 = 0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(4, args).i32;
+        }
+        l2 = si0;
+        si0 = l1;
+        si1 = 0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(4, args).i32;
+        }
+        l3 = si0;
+        si0 = l2;
+        si1 = l3;
+        si0 = native::add(si0, si1);
+        l6 = si0;
+        si1 = 4;
+        si0 = native::add(si0, si1);
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l7 = si0;
+        si1 = 0;
+        si2 = l6;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(3, args);
+        }
+        si0 = l7;
+        l4 = si0;
+        si0 = 0;
+        l5 = si0;
+    L25:;
+        si0 = l5;
+        si1 = l2;
+        si0 = (int32_t)(si0 >= si1);
+        if (si0) goto L48;
+        si0 = l4;
+        si1 = l5;
+        si2 = l0;
+        si3 = l5;
+        si4 = 4;
+        si3 = native::add(si3, si4);
+        {
+            std::vector<WasmValue> args{WasmValue(si2), WasmValue(si3)};
+            si2 = callHost(2, args).i32;
+        }
+        l8 = si2;
+        si2 = 4;
+        si1 = native::add(si1, si2);
+        si2 = l8;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l5;
+        si1 = 1;
+        si0 = native::add(si0, si1);
+        l5 = si0;
+        goto L25;
+    L48:;
+        si0 = 0;
+        l5 = si0;
+    L52:;
+        si0 = l5;
+        si1 = l3;
+        si0 = (int32_t)(si0 >= si1);
+        if (si0) goto L77;
+        si0 = l4;
+        si1 = l2;
+        si2 = l5;
+        si1 = native::add(si1, si2);
+        si2 = l1;
+        si3 = l5;
+        si4 = 4;
+        si3 = native::add(si3, si4);
+        {
+            std::vector<WasmValue> args{WasmValue(si2), WasmValue(si3)};
+            si2 = callHost(2, args).i32;
+        }
+        l8 = si2;
+        si2 = 4;
+        si1 = native::add(si1, si2);
+        si2 = l8;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l5;
+        si1 = 1;
+        si0 = native::add(si0, si1);
+        l5 = si0;
+        goto L52;
+    L77:;
+        si0 = l4;
+        return si0;
+    }
+
+    // $print
+    void f5(int32_t l0) {
+        int32_t l1{};
+        int32_t l2{};
+        int32_t l3{};
+        int32_t l4{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = 0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(4, args).i32;
+        }
+        l1 = si0;
+        si0 = 0;
+        l2 = si0;
+    L8:;
+        si0 = l2;
+        si1 = l1;
+        si0 = (int32_t)(si0 >= si1);
+        if (si0) goto L25;
+        si0 = l0;
+        si1 = l2;
+        si2 = 4;
+        si1 = native::add(si1, si2);
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(5, args);
+        }
+        si0 = l2;
+        si1 = 1;
+        si0 = native::add(si0, si1);
+        l2 = si0;
+        goto L8;
+    L25:;
+        return;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("lib_string", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_lib_string(store)); });
+
+} // namespace
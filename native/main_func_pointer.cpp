@@ -0,0 +1,102 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+    },
+    {
+        {"add", 0},
+        {"main", 2},
+        {"sub", 1},
+    },
+    {
+        {"i32", "i32"},
+        {"i32", "i32"},
+        {},
+    },
+    {
+        {"i32"},
+        {"i32"},
+        {"i32"},
+    },
+    {0, 0, 2},
+    {
+        {"i32", "i32"},
+        {},
+        {},
+    },
+    {
+    },
+    {0, 1},
+};
+
+class Native_main_func_pointer final : public NativeModule {
+public:
+    explicit Native_main_func_pointer(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: return WasmValue(f0(args[0].i32, args[1].i32));
+            case 1: return WasmValue(f1(args[0].i32, args[1].i32));
+            case 2: return WasmValue(f2());
+            default: return WasmValue();
+        }
+    }
+
+private:
+    // $add
+    int32_t f0(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = l1;
+        si0 = native::add(si0, si1);
+        return si0;
+    }
+
+    // $sub
+    int32_t f1(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = l1;
+        si0 = native::sub(si0, si1);
+        return si0;
+    }
+
+    // $main
+    int32_t f2() {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = 10;
+        si1 = 20;
+        si2 = 0;
+        switch (tableEntry(si2, 0)) {
+            case 0: si0 = f0(si0, si1); break;
+            case 1: si0 = f1(si0, si1); break;
+            default: break;
+        }
+        si1 = 5;
+        si2 = 1;
+        switch (tableEntry(si2, 0)) {
+            case 0: si0 = f0(si0, si1); break;
+            case 1: si0 = f1(si0, si1); break;
+            default: break;
+        }
+        return si0;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("main_func_pointer", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_main_func_pointer(store)); });
+
+} // namespace
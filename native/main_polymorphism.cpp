@@ -0,0 +1,324 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+        {"env", "alloc", {"i32"}, {"i32"}},
+        {"env", "write_i32", {"i32", "i32", "i32"}, {}},
+        {"env", "read_i32", {"i32", "i32"}, {"i32"}},
+        {"env", "putchar", {"i32"}, {}},
+    },
+    {
+        {"Bike_start", 3},
+        {"Car_start", 1},
+        {"bike_set_v2", 2},
+        {"car_set_v1", 0},
+        {"main", 5},
+        {"move", 4},
+    },
+    {
+        {"i32", "i32"},
+        {"i32"},
+        {"i32", "i32"},
+        {"i32"},
+        {"i32"},
+        {},
+    },
+    {
+        {},
+        {},
+        {},
+        {},
+        {},
+        {"i32"},
+    },
+    {4, 0, 4, 0, 0, 5},
+    {
+        {"i32"},
+        {"i32"},
+        {"i32", "i32", "i32"},
+        {"i32", "i32"},
+        {"i32", "i32"},
+        {},
+    },
+    {
+    },
+    {-1, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+};
+
+class Native_main_polymorphism final : public NativeModule {
+public:
+    explicit Native_main_polymorphism(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: f0(args[0].i32, args[1].i32); return WasmValue();
+            case 1: f1(args[0].i32); return WasmValue();
+            case 2: f2(args[0].i32, args[1].i32); return WasmValue();
+            case 3: f3(args[0].i32); return WasmValue();
+            case 4: f4(args[0].i32); return WasmValue();
+            case 5: return WasmValue(f5());
+            default: return WasmValue();
+        }
+    }
+
+private:
+    // $car_set_v1
+    void f0(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = 0;
+        si2 = l1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        return;
+    }
+
+    // $Car_start
+    void f1(int32_t l0) {
+        int32_t l1{};
+        int32_t si0{};
+        int32_t si1{};
+        si0 = 67;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(3, args);
+        }
+        si0 = l0;
+        si1 = 0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        si1 = 48;
+        si0 = native::add(si0, si1);
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(3, args);
+        }
+        return;
+    }
+
+    // $bike_set_v2
+    void f2(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = 0;
+        si2 = l1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        return;
+    }
+
+    // $Bike_start
+    void f3(int32_t l0) {
+        int32_t l1{};
+        int32_t si0{};
+        int32_t si1{};
+        si0 = 66;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(3, args);
+        }
+        si0 = l0;
+        si1 = 0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        si1 = 48;
+        si0 = native::add(si0, si1);
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(3, args);
+        }
+        return;
+    }
+
+    // $move
+    void f4(int32_t l0) {
+        int32_t l1{};
+        int32_t l2{};
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = 4;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        l1 = si0;
+        si0 = l0;
+        si1 = 8;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        si1 = l1;
+        switch (tableEntry(si1, 0)) {
+            case 1: f1(si0); break;
+            case 3: f3(si0); break;
+            case 4: f4(si0); break;
+            default: break;
+        }
+        return;
+    }
+
+    // $main
+    int32_t f5() {
+        int32_t l0{};
+        int32_t l1{};
+        int32_t l2{};
+        int32_t l3{};
+        int32_t l4{};
+        int32_t l5{};
+        int32_t l6{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = 4;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l0 = si0;
+        si1 = 0;
+        si2 = 1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = 12;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l2 = si0;
+        si1 = 0;
+        si2 = 1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l2;
+        si1 = 4;
+        si2 = 1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l2;
+        si1 = 8;
+        si2 = l0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l2;
+        si1 = 4;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        l5 = si0;
+        si0 = l2;
+        si1 = 8;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        si1 = l5;
+        switch (tableEntry(si1, 0)) {
+            case 1: f1(si0); break;
+            case 3: f3(si0); break;
+            case 4: f4(si0); break;
+            default: break;
+        }
+        si0 = 4;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l1 = si0;
+        si1 = 0;
+        si2 = 2;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = 12;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l3 = si0;
+        si1 = 0;
+        si2 = 1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l3;
+        si1 = 4;
+        si2 = 2;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l3;
+        si1 = 8;
+        si2 = l1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l3;
+        si1 = 4;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        l5 = si0;
+        si0 = l3;
+        si1 = 8;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(2, args).i32;
+        }
+        si1 = l5;
+        switch (tableEntry(si1, 0)) {
+            case 1: f1(si0); break;
+            case 3: f3(si0); break;
+            case 4: f4(si0); break;
+            default: break;
+        }
+        si0 = 10;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(3, args);
+        }
+        si0 = 0;
+        return si0;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("main_polymorphism", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_main_polymorphism(store)); });
+
+} // namespace
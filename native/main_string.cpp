@@ -0,0 +1,173 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+        {"string", "create", {"i32"}, {"i32"}},
+        {"string", "set", {"i32", "i32", "i32"}, {}},
+        {"string", "get", {"i32", "i32"}, {"i32"}},
+        {"string", "concat", {"i32", "i32"}, {"i32"}},
+        {"string", "print", {"i32"}, {}},
+        {"env", "putchar", {"i32"}, {}},
+    },
+    {
+        {"main", 0},
+    },
+    {
+        {},
+    },
+    {
+        {"i32"},
+    },
+    {4},
+    {
+        {"i32"},
+        {"i32", "i32", "i32"},
+        {"i32", "i32"},
+        {"i32"},
+        {},
+    },
+    {
+    },
+    {},
+};
+
+class Native_main_string final : public NativeModule {
+public:
+    explicit Native_main_string(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: return WasmValue(f0());
+            default: return WasmValue();
+        }
+    }
+
+private:
+    // $main
+    int32_t f0() {
+        int32_t l0{};
+        int32_t l1{};
+        int32_t l2{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = 5;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l0 = si0;
+        si1 = 0;
+        si2 = 72;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l0;
+        si1 = 1;
+        si2 = 101;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l0;
+        si1 = 2;
+        si2 = 108;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l0;
+        si1 = 3;
+        si2 = 108;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l0;
+        si1 = 4;
+        si2 = 111;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = 6;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l1 = si0;
+        si1 = 0;
+        si2 = 32;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l1;
+        si1 = 1;
+        si2 = 87;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l1;
+        si1 = 2;
+        si2 = 111;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l1;
+        si1 = 3;
+        si2 = 114;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l1;
+        si1 = 4;
+        si2 = 108;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l1;
+        si1 = 5;
+        si2 = 100;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l0;
+        si1 = l1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(3, args).i32;
+        }
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(4, args);
+        }
+        si0 = 10;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(5, args);
+        }
+        si0 = 0;
+        return si0;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("main_string", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_main_string(store)); });
+
+} // namespace
@@ -0,0 +1,130 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+        {"string", "create", {"i32"}, {"i32"}},
+        {"string", "set", {"i32", "i32", "i32"}, {}},
+        {"string", "get", {"i32", "i32"}, {"i32"}},
+        {"string", "concat", {"i32", "i32"}, {"i32"}},
+        {"string", "print", {"i32"}, {}},
+        {"env", "putchar", {"i32"}, {}},
+    },
+    {
+        {"main", 0},
+    },
+    {
+        {},
+    },
+    {
+        {"i32"},
+    },
+    {4},
+    {
+        {"i32"},
+        {"i32", "i32", "i32"},
+        {"i32", "i32"},
+        {"i32"},
+        {},
+    },
+    {
+        {5, 0, 0, 0, 72, 101, 108, 108, 111},
+        {5, 0, 0, 0, 87, 111, 114, 108, 100},
+    },
+    {},
+};
+
+class Native_main_string_const final : public NativeModule {
+public:
+    explicit Native_main_string_const(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: return WasmValue(f0());
+            default: return WasmValue();
+        }
+    }
+
+private:
+    // $main
+    int32_t f0() {
+        int32_t l0{};
+        int32_t l1{};
+        int32_t l2{};
+        int32_t l3{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = stringHandles[0];
+        l0 = si0;
+        si0 = stringHandles[1];
+        l1 = si0;
+        si0 = l0;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(4, args);
+        }
+        si0 = 32;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(5, args);
+        }
+        si0 = l1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(4, args);
+        }
+        si0 = 10;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(5, args);
+        }
+        si0 = 1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            si0 = callHost(0, args).i32;
+        }
+        l3 = si0;
+        si1 = 0;
+        si2 = 32;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1), WasmValue(si2)};
+            callHost(1, args);
+        }
+        si0 = l0;
+        si1 = l3;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(3, args).i32;
+        }
+        si1 = l1;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(3, args).i32;
+        }
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(4, args);
+        }
+        si0 = 10;
+        {
+            std::vector<WasmValue> args{WasmValue(si0)};
+            callHost(5, args);
+        }
+        si0 = 0;
+        return si0;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("main_string_const", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_main_string_const(store)); });
+
+} // namespace
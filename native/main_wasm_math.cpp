@@ -0,0 +1,64 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+        {"math", "add", {"i32", "i32"}, {"i32"}},
+    },
+    {
+        {"main", 0},
+    },
+    {
+        {},
+    },
+    {
+        {"i32"},
+    },
+    {1},
+    {
+        {"i32", "i32"},
+        {},
+    },
+    {
+    },
+    {},
+};
+
+class Native_main_wasm_math final : public NativeModule {
+public:
+    explicit Native_main_wasm_math(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: return WasmValue(f0());
+            default: return WasmValue();
+        }
+    }
+
+private:
+    // $main
+    int32_t f0() {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = 10;
+        si1 = 32;
+        {
+            std::vector<WasmValue> args{WasmValue(si0), WasmValue(si1)};
+            si0 = callHost(0, args).i32;
+        }
+        return si0;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("main_wasm_math", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_main_wasm_math(store)); });
+
+} // namespace
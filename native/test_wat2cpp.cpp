@@ -0,0 +1,462 @@
+// Generated by wat2cpp; do not edit.
+#include "NativeModule.h"
+#include "Simd.h"
+
+// Stack slots and locals that some path never reads are expected
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+namespace {
+
+const NativeLayout nativeLayout = {
+    {
+        {"env", "log", {"i32"}, {"i32"}},
+    },
+    {
+        {"add", 0},
+        {"apply", 3},
+        {"bits", 6},
+        {"calls", 4},
+        {"divide", 7},
+        {"dot", 11},
+        {"echo", 9},
+        {"greeting", 14},
+        {"hsum", 12},
+        {"lanes", 13},
+        {"machine", 5},
+        {"mean", 10},
+        {"never", 8},
+        {"sub", 1},
+        {"twice", 2},
+    },
+    {
+        {"i32", "i32"},
+        {"i32", "i32"},
+        {"i32"},
+        {"i32", "i32", "i32"},
+        {},
+        {"i32"},
+        {"i32", "i32"},
+        {"i32", "i32"},
+        {},
+        {"i32"},
+        {"f64", "f64"},
+        {"i32", "i32", "i32"},
+        {"v128"},
+        {},
+        {},
+    },
+    {
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"i32"},
+        {"f64"},
+        {"i32"},
+        {"i32"},
+        {"f64"},
+        {"i32"},
+    },
+    {0, 0, 1, 2, 3, 1, 0, 0, 3, 1, 4, 2, 5, 6, 3},
+    {
+        {"i32", "i32"},
+        {"i32"},
+        {"i32", "i32", "i32"},
+        {},
+        {"f64", "f64"},
+        {"v128"},
+        {},
+    },
+    {
+        {6, 0, 0, 0, 110, 97, 116, 105, 118, 101},
+    },
+    {0, 1, 2, -1},
+};
+
+class Native_test_wat2cpp final : public NativeModule {
+public:
+    explicit Native_test_wat2cpp(MemoryStore& store) : NativeModule(nativeLayout, store) {}
+
+protected:
+    WasmValue invoke(int32_t func, const WasmValue* args) override {
+        switch (func) {
+            case 0: return WasmValue(f0(args[0].i32, args[1].i32));
+            case 1: return WasmValue(f1(args[0].i32, args[1].i32));
+            case 2: return WasmValue(f2(args[0].i32));
+            case 3: return WasmValue(f3(args[0].i32, args[1].i32, args[2].i32));
+            case 4: return WasmValue(f4());
+            case 5: return WasmValue(f5(args[0].i32));
+            case 6: return WasmValue(f6(args[0].i32, args[1].i32));
+            case 7: return WasmValue(f7(args[0].i32, args[1].i32));
+            case 8: return WasmValue(f8());
+            case 9: return WasmValue(f9(args[0].i32));
+            case 10: return WasmValue(f10(args[0].f64, args[1].f64));
+            case 11: return WasmValue(f11(args[0].i32, args[1].i32, args[2].i32));
+            case 13: return WasmValue(f13());
+            case 14: return WasmValue(f14());
+            default: return WasmValue();
+        }
+    }
+
+private:
+    int32_t g0 = 0;
+    double g1 = native::f64(0x3fe0000000000000ull);
+
+    // $add
+    int32_t f0(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = l1;
+        si0 = native::add(si0, si1);
+        return si0;
+    }
+
+    // $sub
+    int32_t f1(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = l1;
+        si0 = native::sub(si0, si1);
+        return si0;
+    }
+
+    // $twice
+    int32_t f2(int32_t l0) {
+        int32_t si0{};
+        int32_t si1{};
+        si0 = l0;
+        si1 = 2;
+        si0 = native::mul(si0, si1);
+        return si0;
+    }
+
+    // $apply
+    int32_t f3(int32_t l0, int32_t l1, int32_t l2) {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = g0;
+        si1 = 1;
+        si0 = native::add(si0, si1);
+        g0 = si0;
+        si0 = l1;
+        si1 = l2;
+        si2 = l0;
+        switch (tableEntry(si2, 0)) {
+            case 0: si0 = f0(si0, si1); break;
+            case 1: si0 = f1(si0, si1); break;
+            case 6: si0 = f6(si0, si1); break;
+            case 7: si0 = f7(si0, si1); break;
+            default: break;
+        }
+        return si0;
+    }
+
+    // $calls
+    int32_t f4() {
+        int32_t si0{};
+        si0 = g0;
+        return si0;
+    }
+
+    // $machine
+    int32_t f5(int32_t l0) {
+        int32_t l1{};
+        int32_t l2{};
+        int32_t si0{};
+        int32_t si1{};
+    L2:;
+        si0 = l0;
+        si1 = 15;
+        si0 = (si0 & si1);
+        l2 = si0;
+        si0 = l0;
+        si1 = 4;
+        si0 = native::shrU(si0, si1);
+        l0 = si0;
+        si0 = l2;
+        switch ((uint32_t)si0) {
+            case 0: goto L38;
+            case 1: goto L17;
+            case 2: goto L23;
+            case 3: goto L29;
+            default: goto L35;
+        }
+    L17:;
+        si0 = l1;
+        si1 = 1;
+        si0 = native::add(si0, si1);
+        l1 = si0;
+        goto L2;
+    L23:;
+        si0 = l1;
+        si1 = 2;
+        si0 = native::mul(si0, si1);
+        l1 = si0;
+        goto L2;
+    L29:;
+        si0 = 0;
+        si1 = l1;
+        si0 = native::sub(si0, si1);
+        l1 = si0;
+        goto L2;
+    L35:;
+        goto L2;
+    L38:;
+        si0 = l1;
+        return si0;
+    }
+
+    // $bits
+    int32_t f6(int32_t l0, int32_t l1) {
+        int32_t l2{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = l1;
+        si0 = native::rotl(si0, si1);
+        si1 = l1;
+        si2 = l0;
+        si1 = native::rotr(si1, si2);
+        si0 = (si0 ^ si1);
+        si1 = l0;
+        si1 = native::clz(si1);
+        si0 = native::add(si0, si1);
+        si1 = l1;
+        si1 = native::ctz(si1);
+        si0 = native::add(si0, si1);
+        si1 = l0;
+        si2 = l1;
+        si1 = (si1 | si2);
+        si1 = native::popcnt(si1);
+        si0 = native::add(si0, si1);
+        si1 = l0;
+        si2 = l1;
+        si1 = native::shrS(si1, si2);
+        si0 = native::add(si0, si1);
+        si1 = l1;
+        si2 = l0;
+        si1 = native::shl(si1, si2);
+        si0 = native::sub(si0, si1);
+        si1 = l0;
+        si2 = l1;
+        si1 = (int32_t)((uint32_t)si1 < (uint32_t)si2);
+        si0 = native::add(si0, si1);
+        si1 = l0;
+        si2 = l1;
+        si1 = (int32_t)(si1 >= si2);
+        si0 = native::add(si0, si1);
+        si1 = l0;
+        si2 = l1;
+        si1 = (si1 & si2);
+        si1 = (int32_t)(si1 == 0);
+        si0 = native::add(si0, si1);
+        l2 = si0;
+        si0 = l0;
+        si1 = l1;
+        si0 = (int32_t)((uint32_t)si0 > (uint32_t)si1);
+        if (!si0) goto L49;
+        si0 = l2;
+        si1 = 3;
+        si0 = native::mul(si0, si1);
+        l2 = si0;
+        goto L54;
+    L49:;
+        si0 = l2;
+        si1 = 7;
+        si0 = native::sub(si0, si1);
+        l2 = si0;
+    L54:;
+        si0 = l2;
+        return si0;
+    }
+
+    // $divide
+    int32_t f7(int32_t l0, int32_t l1) {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        si0 = l0;
+        si1 = l1;
+        si0 = native::divS(si0, si1);
+        si1 = l0;
+        si2 = l1;
+        si1 = native::remU(si1, si2);
+        si0 = native::add(si0, si1);
+        return si0;
+    }
+
+    // $never
+    int32_t f8() {
+        native::trap("Unreachable executed");
+    }
+
+    // $echo
+    int32_t f9(int32_t l0) {
+        int32_t l1{};
+        int32_t si0{};
+        int32_t si1{};
+    L2:;
+        si0 = l0;
+        si0 = (int32_t)(si0 == 0);
+        if (si0) goto L17;
+        si0 = l1;
+        si1 = l0;
+        {
+            std::vector<WasmValue> args{WasmValue(si1)};
+            si1 = callHost(0, args).i32;
+        }
+        si0 = native::add(si0, si1);
+        l1 = si0;
+        si0 = l0;
+        si1 = 1;
+        si0 = native::sub(si0, si1);
+        l0 = si0;
+        goto L2;
+    L17:;
+        si0 = l1;
+        return si0;
+    }
+
+    // $mean
+    double f10(double l0, double l1) {
+        double sd0{};
+        double sd1{};
+        sd0 = l0;
+        sd1 = l1;
+        sd0 = sd0 + sd1;
+        sd1 = g1;
+        sd0 = sd0 * sd1;
+        return sd0;
+    }
+
+    // $dot
+    int32_t f11(int32_t l0, int32_t l1, int32_t l2) {
+        V128 l3{};
+        int32_t l5{};
+        V128 l6{};
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        int32_t si3{};
+        int32_t si4{};
+        int32_t si5{};
+        int32_t si6{};
+        V128 sv0{};
+        V128 sv1{};
+        V128 sv2{};
+        V128 sv4{};
+    L2:;
+        si0 = l5;
+        si1 = l2;
+        si0 = (int32_t)(si0 >= si1);
+        if (si0) goto L27;
+        sv0 = l3;
+        si2 = l0;
+        si3 = l5;
+        si4 = 4;
+        si3 = native::mul(si3, si4);
+        sv2 = store.read<V128>(si2, si3);
+        si4 = l1;
+        si5 = l5;
+        si6 = 4;
+        si5 = native::mul(si5, si6);
+        sv4 = store.read<V128>(si4, si5);
+        sv2 = simd::i32x4Mul(sv2, sv4);
+        sv0 = simd::i32x4Add(sv0, sv2);
+        l3 = sv0;
+        si0 = l5;
+        si1 = 4;
+        si0 = native::add(si0, si1);
+        l5 = si0;
+        goto L2;
+    L27:;
+        sv0 = l3;
+        l6 = sv0;
+        sv0 = l6;
+        si0 = simd::extractLane<int32_t>(sv0, 0);
+        sv1 = l6;
+        si1 = simd::extractLane<int32_t>(sv1, 1);
+        si0 = native::add(si0, si1);
+        sv1 = l6;
+        si1 = simd::extractLane<int32_t>(sv1, 2);
+        sv2 = l6;
+        si2 = simd::extractLane<int32_t>(sv2, 3);
+        si1 = native::add(si1, si2);
+        si0 = native::add(si0, si1);
+        return si0;
+    }
+
+    // $hsum
+    int32_t f12(V128 l0) {
+        int32_t si0{};
+        int32_t si1{};
+        int32_t si2{};
+        V128 sv0{};
+        V128 sv1{};
+        V128 sv2{};
+        sv0 = l0;
+        si0 = simd::extractLane<int32_t>(sv0, 0);
+        sv1 = l0;
+        si1 = simd::extractLane<int32_t>(sv1, 1);
+        si0 = native::add(si0, si1);
+        sv1 = l0;
+        si1 = simd::extractLane<int32_t>(sv1, 2);
+        sv2 = l0;
+        si2 = simd::extractLane<int32_t>(sv2, 3);
+        si1 = native::add(si1, si2);
+        si0 = native::add(si0, si1);
+        return si0;
+    }
+
+    // $lanes
+    double f13() {
+        V128 l0{};
+        double sd0{};
+        double sd1{};
+        double sd2{};
+        double sd4{};
+        V128 sv0{};
+        V128 sv1{};
+        V128 sv2{};
+        sv0 = V128{{0, 0, 0, 0, 0, 0, 8, 64, 0, 0, 0, 0, 0, 0, 16, 192}};
+        sd2 = native::f64(0x3ff8000000000000ull);
+        sv2 = simd::splat<double>(sd2);
+        sv0 = simd::f64x2Mul(sv0, sv2);
+        l0 = sv0;
+        sv0 = l0;
+        sd0 = simd::extractLane<double>(sv0, 0);
+        sv1 = l0;
+        sd1 = simd::extractLane<double>(sv1, 1);
+        sv2 = l0;
+        sd4 = native::f64(0x4019000000000000ull);
+        sv2 = simd::replaceLane<double>(sv2, 0, sd4);
+        sv2 = simd::f64x2Sqrt(sv2);
+        sd2 = simd::extractLane<double>(sv2, 0);
+        sd1 = sd1 + sd2;
+        sd0 = sd0 + sd1;
+        return sd0;
+    }
+
+    // $greeting
+    int32_t f14() {
+        int32_t si0{};
+        si0 = stringHandles[0];
+        return si0;
+    }
+
+};
+
+const bool registered = NativeModule::registerFactory("test_wat2cpp", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new Native_test_wat2cpp(store)); });
+
+} // namespace
@@ -6,3 +6,4 @@ Instruction::Instruction(Opcode op, int64_t val) : opcode(op), operand(val) {}
 Instruction::Instruction(Opcode op, float val) : opcode(op), operand(val) {}
 Instruction::Instruction(Opcode op, double val) : opcode(op), operand(val) {}
 Instruction::Instruction(Opcode op, std::string val) : opcode(op), operand(val) {}
+Instruction::Instruction(Opcode op, V128 val) : opcode(op), operand(val) {}
@@ -0,0 +1,479 @@
+#include "CompiledModule.h"
+#include "Inliner.h"
+#include "Parser.h"
+#include "Validator.h"
+#include <stdexcept>
+#include <cctype>
+
+static bool isIndex(const std::string& id) {
+    return !id.empty() && isdigit(id[0]);
+}
+
+CompiledModule::CompiledModule(Module m, OptimizerOptions options) : mod(std::move(m)), optimizer(options) {
+    // Build Symbol Tables
+    for (size_t i = 0; i < mod.imports.size(); ++i) {
+        if (!mod.imports[i].alias.empty()) importMap[mod.imports[i].alias] = (int32_t)i;
+    }
+    for (size_t i = 0; i < mod.functions.size(); ++i) {
+        if (!mod.functions[i].name.empty()) funcMap[mod.functions[i].name] = (int32_t)i;
+    }
+    // Exported names are accepted by run() too, unless they shadow a function
+    for (const auto& exp : mod.exports) {
+        if (exp.kind != "func" || funcMap.count(exp.name)) continue;
+        int32_t callee = resolveCallee(exp.target);
+        if (callee < 0) {
+            throw std::runtime_error("Unknown function in export: " + exp.target);
+        }
+        if (callee >= (int32_t)mod.imports.size()) {
+            funcMap[exp.name] = callee - (int32_t)mod.imports.size();
+        }
+    }
+    for (size_t i = 0; i < mod.globals.size(); ++i) {
+        // Globals are stored as tagged scalars
+        if (mod.globals[i].type == "v128") {
+            throw std::runtime_error("Globals of type v128 are not supported: " + mod.globals[i].name);
+        }
+        if (!mod.globals[i].name.empty()) globalMap[mod.globals[i].name] = (int32_t)i;
+    }
+    for (const auto& t : mod.types) {
+        typeSignatures.push_back(internSignature(t.paramTypes, t.resultTypes));
+    }
+    for (const auto& imp : mod.imports) {
+        importSignatures.push_back(internSignature(imp.paramTypes, imp.resultTypes));
+    }
+
+    // Pre-encode string constants: 4 byte little endian length, then bytes
+    for (size_t i = 0; i < mod.strings.size(); ++i) {
+        const auto& strDef = mod.strings[i];
+        std::vector<uint8_t> data;
+        int32_t len = strDef.value.length();
+        data.push_back(len & 0xFF);
+        data.push_back((len >> 8) & 0xFF);
+        data.push_back((len >> 16) & 0xFF);
+        data.push_back((len >> 24) & 0xFF);
+        for (char c : strDef.value) {
+            data.push_back((uint8_t)c);
+        }
+        strings.push_back(std::move(data));
+        stringMap[strDef.name] = (int32_t)i;
+    }
+
+    // Resolve element segments against the function index
+    if (!mod.tables.empty()) {
+        tableMin = mod.tables[0].min;
+    }
+    for (const auto& elem : mod.elements) {
+        CompiledElement ce;
+        // Evaluate offset (simplistic: assume i32.const)
+        ce.offset = 0;
+        if (elem.offset.opcode == Opcode::I32_CONST) {
+            ce.offset = std::get<int32_t>(elem.offset.operand);
+        }
+        for (const auto& name : elem.functionNames) {
+            int32_t callee = resolveCallee(name);
+            if (callee < (int32_t)mod.imports.size()) {
+                throw std::runtime_error("Unknown function in table: " + name);
+            }
+            ce.functionIndices.push_back(callee - (int32_t)mod.imports.size());
+        }
+        elems.push_back(std::move(ce));
+    }
+
+    functions.resize(mod.functions.size());
+    compileOnce.reset(new std::once_flag[mod.functions.size()]);
+    // All headers first: validating a body needs every callee's signature
+    for (size_t i = 0; i < mod.functions.size(); ++i) {
+        compileFunction(i);
+    }
+    for (auto& cf : functions) {
+        if (!cf.lazy) lowerFunction(cf, cf.source->body);
+    }
+    if (optimizer.inlining) {
+        inliner.reset(new Inliner(functions, mod.imports.size(), optimizer));
+        for (size_t index : inliner->bottomUpOrder()) inlineCalls(functions[index]);
+    }
+}
+
+CompiledModule::~CompiledModule() = default;
+
+int32_t CompiledModule::calleeSignature(int32_t funcIndex) const {
+    if (funcIndex < (int32_t)importSignatures.size()) return importSignatures[funcIndex];
+    return functions[funcIndex - importSignatures.size()].signature;
+}
+
+int32_t CompiledModule::findFunction(const std::string& name) const {
+    auto it = funcMap.find(name);
+    return it == funcMap.end() ? -1 : it->second;
+}
+
+int32_t CompiledModule::internSignature(const std::vector<std::string>& params,
+                                        const std::vector<std::string>& results) {
+    for (size_t i = 0; i < signatures.size(); ++i) {
+        if (signatures[i].paramTypes == params && signatures[i].resultTypes == results) return (int32_t)i;
+    }
+    Type sig;
+    sig.paramTypes = params;
+    sig.resultTypes = results;
+    signatures.push_back(sig);
+    return (int32_t)signatures.size() - 1;
+}
+
+void CompiledModule::compileFunction(size_t index) {
+    const Function& func = mod.functions[index];
+    CompiledFunction& cf = functions[index];
+    cf.source = &func;
+    cf.numParams = 0;
+    for (const auto& t : func.paramTypes) cf.numParams += slotCount(t);
+    cf.numLocals = cf.numParams;
+    for (const auto& t : func.localTypes) cf.numLocals += slotCount(t);
+    cf.resultSlots = 0;
+    for (const auto& t : func.resultTypes) cf.resultSlots += slotCount(t);
+    cf.hasResult = !func.resultTypes.empty();
+    cf.signature = internSignature(func.paramTypes, func.resultTypes);
+    // Signatures are interned here either way; only lowering is deferred
+    cf.lazy = func.body.empty() && !func.lazyBody.empty();
+}
+
+void CompiledModule::compileLazy(size_t index) const {
+    std::call_once(compileOnce[index], [this, index]() {
+        CompiledFunction& cf = functions[index];
+        lowerFunction(cf, Parser::parseBody(cf.source->lazyBody));
+        if (inliner) inlineCalls(cf);
+        lazyCompiled++;
+    });
+}
+
+void CompiledModule::lowerFunction(CompiledFunction& cf, const std::vector<Instruction>& body) const {
+    const Function& func = *cf.source;
+
+    // Open block/loop constructs. Forward branches to a block are patched
+    // once its END is reached; loops branch back to their first instruction.
+    // An if jumps past its ELSE when the condition is false.
+    struct Label {
+        std::string name;
+        bool isLoop;
+        int32_t start;
+        std::vector<size_t> pending;
+        std::vector<size_t> pendingTable; // br_table entries
+        int32_t ifPc;
+    };
+    std::vector<Label> labels;
+    // Index into labels, or -1
+    auto findLabel = [&labels](const std::string& label) {
+        if (isIndex(label)) {
+            // Relative depth, 0 being the innermost construct
+            int depth = std::stoi(label);
+            return depth < (int)labels.size() ? (int)labels.size() - 1 - depth : -1;
+        }
+        for (int i = (int)labels.size() - 1; i >= 0; --i) {
+            if (labels[i].name == label) return i;
+        }
+        return -1;
+    };
+
+    // Slot offset of each declared local; v128 locals take two slots
+    std::vector<int32_t> localOffset;
+    std::vector<bool> localWide;
+    int32_t offset = 0;
+    for (const auto* types : {&func.paramTypes, &func.localTypes}) {
+        for (const auto& t : *types) {
+            localOffset.push_back(offset);
+            localWide.push_back(slotCount(t) == 2);
+            offset += slotCount(t);
+        }
+    }
+
+    std::vector<V128> constants;
+    std::vector<BranchTarget> branchTable;
+    std::vector<CompiledInstr> code(body.size() + 1);
+    code.back().opcode = Opcode::RETURN;
+    for (size_t pc = 0; pc < body.size(); ++pc) {
+        const Instruction& instr = body[pc];
+        CompiledInstr& out = code[pc];
+        out.opcode = instr.opcode;
+
+        switch (instr.opcode) {
+            case Opcode::I32_CONST:
+                out.i32 = std::get<int32_t>(instr.operand);
+                break;
+            case Opcode::I64_CONST:
+                out.i64 = std::get<int64_t>(instr.operand);
+                break;
+            case Opcode::F32_CONST:
+                out.f32 = std::get<float>(instr.operand);
+                break;
+            case Opcode::F64_CONST:
+                out.f64 = std::get<double>(instr.operand);
+                break;
+            case Opcode::STRING_CONST: {
+                const std::string& alias = std::get<std::string>(instr.operand);
+                auto it = stringMap.find(alias);
+                if (it != stringMap.end()) {
+                    out.index = it->second;
+                } else if (isIndex(alias) && std::stoul(alias) < mod.strings.size()) {
+                    out.index = std::stoi(alias);
+                } else {
+                    throw std::runtime_error("Unknown string constant: " + alias);
+                }
+                break;
+            }
+            case Opcode::LOCAL_GET:
+            case Opcode::LOCAL_SET:
+            case Opcode::LOCAL_TEE: {
+                int local = resolveLocal(std::get<std::string>(instr.operand), func);
+                if (local < 0 || (size_t)local >= localOffset.size()) {
+                    throw std::runtime_error("Local index out of range in " + func.name);
+                }
+                out.index = localOffset[local];
+                if (localWide[local]) {
+                    out.opcode = instr.opcode == Opcode::LOCAL_GET ? Opcode::LOCAL_GET_WIDE
+                               : instr.opcode == Opcode::LOCAL_SET ? Opcode::LOCAL_SET_WIDE
+                               : Opcode::LOCAL_TEE_WIDE;
+                }
+                break;
+            }
+            case Opcode::V128_CONST:
+                out.index = (int32_t)constants.size();
+                constants.push_back(std::get<V128>(instr.operand));
+                break;
+            case Opcode::I32X4_EXTRACT_LANE:
+            case Opcode::I32X4_REPLACE_LANE:
+            case Opcode::F32X4_EXTRACT_LANE:
+            case Opcode::F32X4_REPLACE_LANE:
+            case Opcode::F64X2_EXTRACT_LANE:
+            case Opcode::F64X2_REPLACE_LANE: {
+                int32_t lanes = instr.opcode >= Opcode::F64X2_SPLAT ? 2 : 4;
+                out.i32 = std::get<int32_t>(instr.operand);
+                if (out.i32 < 0 || out.i32 >= lanes) {
+                    throw std::runtime_error("Lane index out of range in " + func.name);
+                }
+                break;
+            }
+            case Opcode::GLOBAL_GET:
+            case Opcode::GLOBAL_SET:
+                out.index = resolveGlobal(std::get<std::string>(instr.operand));
+                if (instr.opcode == Opcode::GLOBAL_SET && !mod.globals[out.index].isMutable) {
+                    throw std::runtime_error("Global is immutable: " + std::get<std::string>(instr.operand));
+                }
+                break;
+            case Opcode::CALL:
+                out.index = resolveCallee(std::get<std::string>(instr.operand));
+                if (out.index < 0) {
+                    throw std::runtime_error("Unknown function: " + std::get<std::string>(instr.operand));
+                }
+                break;
+            case Opcode::CALL_INDIRECT: {
+                const std::string& typeName = std::get<std::string>(instr.operand);
+                int32_t typeIndex = resolveType(typeName);
+                if (typeIndex < 0) {
+                    throw std::runtime_error("Unknown type: " + typeName);
+                }
+                out.index = typeSignatures[typeIndex];
+                break;
+            }
+            case Opcode::BLOCK:
+            case Opcode::LOOP:
+            case Opcode::IF: {
+                std::string name;
+                if (std::holds_alternative<std::string>(instr.operand)) {
+                    name = std::get<std::string>(instr.operand);
+                }
+                int32_t ifPc = instr.opcode == Opcode::IF ? (int32_t)pc : -1;
+                labels.push_back({name, instr.opcode == Opcode::LOOP, (int32_t)pc + 1, {}, {}, ifPc});
+                break;
+            }
+            case Opcode::ELSE:
+                if (labels.empty() || labels.back().ifPc < 0) {
+                    throw std::runtime_error("else without if in " + func.name);
+                }
+                // The then-branch falls into ELSE, which skips the else-branch
+                code[labels.back().ifPc].index = (int32_t)pc + 1;
+                labels.back().ifPc = -1;
+                labels.back().pending.push_back(pc);
+                break;
+            case Opcode::END:
+                if (!labels.empty()) {
+                    Label& label = labels.back();
+                    for (size_t site : label.pending) code[site].index = (int32_t)pc + 1;
+                    for (size_t entry : label.pendingTable) branchTable[entry].pc = (int32_t)pc + 1;
+                    if (label.ifPc >= 0) code[label.ifPc].index = (int32_t)pc + 1;
+                    labels.pop_back();
+                }
+                break;
+            case Opcode::BR:
+            case Opcode::BR_IF: {
+                const std::string& label = std::get<std::string>(instr.operand);
+                int target = findLabel(label);
+                if (target < 0) {
+                    throw std::runtime_error("Label not found: " + label);
+                }
+                if (labels[target].isLoop) {
+                    out.index = labels[target].start;
+                } else {
+                    labels[target].pending.push_back(pc);
+                }
+                break;
+            }
+            case Opcode::BR_TABLE: {
+                // Resolved into a contiguous run of entries so dispatch is
+                // one bounds clamp and one index
+                const std::string& list = std::get<std::string>(instr.operand);
+                out.index = (int32_t)branchTable.size();
+                size_t begin = 0;
+                while (begin < list.size()) {
+                    size_t end = list.find(' ', begin);
+                    if (end == std::string::npos) end = list.size();
+                    std::string label = list.substr(begin, end - begin);
+                    begin = end + 1;
+                    int target = findLabel(label);
+                    if (target < 0) {
+                        throw std::runtime_error("Label not found: " + label);
+                    }
+                    if (labels[target].isLoop) {
+                        branchTable.push_back({labels[target].start, 0});
+                    } else {
+                        labels[target].pendingTable.push_back(branchTable.size());
+                        branchTable.push_back({0, 0});
+                    }
+                }
+                out.i32 = (int32_t)branchTable.size() - out.index - 1;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    // Blocks left open by a truncated body branch to its end.
+    for (const auto& label : labels) {
+        for (size_t site : label.pending) {
+            code[site].index = (int32_t)body.size();
+        }
+        for (size_t entry : label.pendingTable) {
+            branchTable[entry].pc = (int32_t)body.size();
+        }
+        if (label.ifPc >= 0) code[label.ifPc].index = (int32_t)body.size();
+    }
+
+    // Code that fails validation still runs, on the checked path
+    try {
+        cf.maxStackDepth = Validator(*this).validate(cf, code, branchTable);
+        cf.validated = true;
+    } catch (const std::runtime_error& e) {
+        cf.validated = false;
+        cf.validationError = e.what();
+    }
+    if (cf.validated && optimizer.any()) {
+        std::vector<CompiledInstr> optimizedCode = code;
+        std::vector<BranchTarget> optimizedTable = branchTable;
+        uint32_t numLocals = cf.numLocals;
+        size_t extraLocals = cf.extraLocals.size();
+        OptimizerStats stats = Optimizer(optimizer).optimize(cf, optimizedCode, optimizedTable);
+        // Validated again for the new branch heights and stack depth. Should
+        // that ever fail, the code as written still works, without the
+        // locals the optimizer added; the failure is counted so tests catch
+        // it.
+        try {
+            cf.maxStackDepth = Validator(*this).validate(cf, optimizedCode, optimizedTable);
+            code = std::move(optimizedCode);
+            branchTable = std::move(optimizedTable);
+            cf.optimizerStats = stats;
+            std::lock_guard<std::mutex> lock(statsMtx);
+            optimized += stats;
+        } catch (const std::runtime_error&) {
+            cf.numLocals = numLocals;
+            cf.extraLocals.resize(extraLocals);
+            cf.optimizerStats.revalidationFailures++;
+            std::lock_guard<std::mutex> lock(statsMtx);
+            optimized.revalidationFailures++;
+        }
+    }
+    cf.constants = std::move(constants);
+    cf.branchTable = std::move(branchTable);
+    cf.code = std::move(code);
+}
+
+void CompiledModule::inlineCalls(CompiledFunction& cf) const {
+    if (!cf.validated || !inliner->hasCandidates(cf)) return;
+    std::vector<CompiledInstr> code = cf.code;
+    std::vector<BranchTarget> branchTable = cf.branchTable;
+    std::vector<V128> constants = cf.constants;
+    uint32_t numLocals = cf.numLocals;
+    std::vector<std::string> extraLocals = cf.extraLocals;
+    uint32_t inlineDepth = cf.inlineDepth;
+    uint32_t inlined = inliner->inlineCalls(cf, code, branchTable, constants);
+    if (inlined == 0) return;
+    // The spliced code gets the passes again, across the seams
+    OptimizerStats stats = Optimizer(optimizer).optimize(cf, code, branchTable);
+    stats.inlinedCalls = inlined;
+    try {
+        cf.maxStackDepth = Validator(*this).validate(cf, code, branchTable);
+    } catch (const std::runtime_error&) {
+        // Keeps the calls, as in lowerFunction
+        cf.numLocals = numLocals;
+        cf.extraLocals = std::move(extraLocals);
+        cf.inlineDepth = inlineDepth;
+        cf.optimizerStats.revalidationFailures++;
+        std::lock_guard<std::mutex> lock(statsMtx);
+        optimized.revalidationFailures++;
+        return;
+    }
+    // The size before stays the lowered body's
+    size_t before = cf.code.size();
+    stats.instructionsBefore = stats.instructionsAfter = 0;
+    cf.optimizerStats += stats;
+    cf.optimizerStats.instructionsAfter = code.size();
+    std::lock_guard<std::mutex> lock(statsMtx);
+    optimized += stats;
+    optimized.instructionsAfter = optimized.instructionsAfter - before + code.size();
+    cf.code = std::move(code);
+    cf.branchTable = std::move(branchTable);
+    cf.constants = std::move(constants);
+}
+
+int32_t CompiledModule::resolveCallee(const std::string& name) const {
+    auto imp = importMap.find(name);
+    if (imp != importMap.end()) return imp->second;
+
+    auto fn = funcMap.find(name);
+    if (fn != funcMap.end()) return (int32_t)mod.imports.size() + fn->second;
+
+    if (isIndex(name)) {
+        // Wasm function index space: imports first, then defined functions
+        size_t idx = std::stoul(name);
+        if (idx < mod.imports.size() + mod.functions.size()) return (int32_t)idx;
+    }
+    return -1;
+}
+
+int32_t CompiledModule::resolveType(const std::string& name) const {
+    for (size_t i = 0; i < mod.types.size(); ++i) {
+        if (mod.types[i].name == name) return (int32_t)i;
+    }
+    if (isIndex(name)) {
+        size_t idx = std::stoul(name);
+        if (idx < mod.types.size()) return (int32_t)idx;
+    }
+    return -1;
+}
+
+int CompiledModule::resolveLocal(const std::string& id, const Function& func) const {
+    if (isIndex(id)) return std::stoi(id);
+
+    for (size_t i = 0; i < func.paramNames.size(); ++i) {
+        if (func.paramNames[i] == id) return i;
+    }
+    for (size_t i = 0; i < func.localNames.size(); ++i) {
+        if (func.localNames[i] == id) return func.paramNames.size() + i;
+    }
+    throw std::runtime_error("Unknown local: " + id);
+}
+
+int32_t CompiledModule::resolveGlobal(const std::string& id) const {
+    auto it = globalMap.find(id);
+    if (it != globalMap.end()) return it->second;
+    if (isIndex(id)) {
+        size_t idx = std::stoul(id);
+        if (idx < mod.globals.size()) return (int32_t)idx;
+    }
+    throw std::runtime_error("Unknown global: " + id);
+}
@@ -0,0 +1,564 @@
+#include "CppEmitter.h"
+#include "Validator.h"
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const char* cppType(const std::string& type) {
+    if (type == "i64") return "int64_t";
+    if (type == "f32") return "float";
+    if (type == "f64") return "double";
+    if (type == "v128") return "V128";
+    return "int32_t";
+}
+
+// WasmValue member holding a value of type
+const char* member(const std::string& type) {
+    if (type == "i64") return "i64";
+    if (type == "f32") return "f32";
+    if (type == "f64") return "f64";
+    return "i32";
+}
+
+std::string quote(const std::string& s) {
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20 || c >= 0x7f) {
+            char buf[8];
+            std::snprintf(buf, sizeof buf, "\\%03o", c);
+            out += buf;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string typeList(const std::vector<std::string>& types) {
+    std::string out = "{";
+    for (size_t i = 0; i < types.size(); ++i) out += (i ? ", " : "") + quote(types[i]);
+    return out + "}";
+}
+
+// A constant as a C++ expression with exactly its bits.
+std::string literal(const CompiledInstr& instr) {
+    char buf[64];
+    switch (instr.opcode) {
+        case Opcode::I64_CONST:
+            std::snprintf(buf, sizeof buf, "(int64_t)0x%016" PRIx64 "ull", (uint64_t)instr.i64);
+            break;
+        case Opcode::F32_CONST: {
+            uint32_t bits;
+            std::memcpy(&bits, &instr.f32, sizeof bits);
+            std::snprintf(buf, sizeof buf, "native::f32(0x%08" PRIx32 "u)", bits);
+            break;
+        }
+        case Opcode::F64_CONST:
+            std::snprintf(buf, sizeof buf, "native::f64(0x%016" PRIx64 "ull)", (uint64_t)instr.i64);
+            break;
+        default:
+            if (instr.i32 == INT32_MIN) return "INT32_MIN";
+            std::snprintf(buf, sizeof buf, "%" PRId32, instr.i32);
+            break;
+    }
+    return buf;
+}
+
+std::string call(const char* name, const std::string& a, const std::string& b) {
+    return std::string(name) + "(" + a + ", " + b + ")";
+}
+
+std::string compare(const char* op, const std::string& a, const std::string& b, bool isUnsigned) {
+    if (isUnsigned) return "(int32_t)((uint32_t)" + a + " " + op + " (uint32_t)" + b + ")";
+    return "(int32_t)(" + a + " " + op + " " + b + ")";
+}
+
+std::string i32Binary(Opcode op, const std::string& a, const std::string& b) {
+    switch (op) {
+        case Opcode::I32_EQ: return compare("==", a, b, false);
+        case Opcode::I32_NE: return compare("!=", a, b, false);
+        case Opcode::I32_LT_S: return compare("<", a, b, false);
+        case Opcode::I32_LT_U: return compare("<", a, b, true);
+        case Opcode::I32_GT_S: return compare(">", a, b, false);
+        case Opcode::I32_GT_U: return compare(">", a, b, true);
+        case Opcode::I32_LE_S: return compare("<=", a, b, false);
+        case Opcode::I32_LE_U: return compare("<=", a, b, true);
+        case Opcode::I32_GE_S: return compare(">=", a, b, false);
+        case Opcode::I32_GE_U: return compare(">=", a, b, true);
+        case Opcode::I32_ADD: return call("native::add", a, b);
+        case Opcode::I32_SUB: return call("native::sub", a, b);
+        case Opcode::I32_MUL: return call("native::mul", a, b);
+        case Opcode::I32_DIV_S: return call("native::divS", a, b);
+        case Opcode::I32_DIV_U: return call("native::divU", a, b);
+        case Opcode::I32_REM_S: return call("native::remS", a, b);
+        case Opcode::I32_REM_U: return call("native::remU", a, b);
+        case Opcode::I32_AND: return "(" + a + " & " + b + ")";
+        case Opcode::I32_OR: return "(" + a + " | " + b + ")";
+        case Opcode::I32_XOR: return "(" + a + " ^ " + b + ")";
+        case Opcode::I32_SHL: return call("native::shl", a, b);
+        case Opcode::I32_SHR_S: return call("native::shrS", a, b);
+        case Opcode::I32_SHR_U: return call("native::shrU", a, b);
+        case Opcode::I32_ROTL: return call("native::rotl", a, b);
+        default: return call("native::rotr", a, b);
+    }
+}
+
+struct SimdOp {
+    Opcode opcode;
+    const char* kernel;
+};
+
+const SimdOp simdUnary[] = {
+    {Opcode::V128_NOT, "v128Not"},     {Opcode::I32X4_NEG, "i32x4Neg"},   {Opcode::F32X4_NEG, "f32x4Neg"},
+    {Opcode::F32X4_ABS, "f32x4Abs"},   {Opcode::F32X4_SQRT, "f32x4Sqrt"}, {Opcode::F64X2_NEG, "f64x2Neg"},
+    {Opcode::F64X2_ABS, "f64x2Abs"},   {Opcode::F64X2_SQRT, "f64x2Sqrt"},
+};
+
+const SimdOp simdBinary[] = {
+    {Opcode::V128_AND, "v128And"},     {Opcode::V128_ANDNOT, "v128AndNot"}, {Opcode::V128_OR, "v128Or"},
+    {Opcode::V128_XOR, "v128Xor"},     {Opcode::I32X4_ADD, "i32x4Add"},     {Opcode::I32X4_SUB, "i32x4Sub"},
+    {Opcode::I32X4_MUL, "i32x4Mul"},   {Opcode::I32X4_MIN_S, "i32x4MinS"},  {Opcode::I32X4_MAX_S, "i32x4MaxS"},
+    {Opcode::I32X4_EQ, "i32x4Eq"},     {Opcode::I32X4_NE, "i32x4Ne"},       {Opcode::I32X4_LT_S, "i32x4LtS"},
+    {Opcode::I32X4_LT_U, "i32x4LtU"},  {Opcode::I32X4_GT_S, "i32x4GtS"},    {Opcode::I32X4_GT_U, "i32x4GtU"},
+    {Opcode::I32X4_LE_S, "i32x4LeS"},  {Opcode::I32X4_GE_S, "i32x4GeS"},    {Opcode::F32X4_ADD, "f32x4Add"},
+    {Opcode::F32X4_SUB, "f32x4Sub"},   {Opcode::F32X4_MUL, "f32x4Mul"},     {Opcode::F32X4_DIV, "f32x4Div"},
+    {Opcode::F32X4_EQ, "f32x4Eq"},     {Opcode::F32X4_NE, "f32x4Ne"},       {Opcode::F32X4_LT, "f32x4Lt"},
+    {Opcode::F32X4_GT, "f32x4Gt"},     {Opcode::F32X4_LE, "f32x4Le"},       {Opcode::F32X4_GE, "f32x4Ge"},
+    {Opcode::F64X2_ADD, "f64x2Add"},   {Opcode::F64X2_SUB, "f64x2Sub"},     {Opcode::F64X2_MUL, "f64x2Mul"},
+    {Opcode::F64X2_DIV, "f64x2Div"},   {Opcode::F64X2_EQ, "f64x2Eq"},       {Opcode::F64X2_NE, "f64x2Ne"},
+    {Opcode::F64X2_LT, "f64x2Lt"},     {Opcode::F64X2_GT, "f64x2Gt"},       {Opcode::F64X2_LE, "f64x2Le"},
+    {Opcode::F64X2_GE, "f64x2Ge"},
+};
+
+const char* simdKernel(const SimdOp* ops, size_t count, Opcode op) {
+    for (size_t i = 0; i < count; ++i) {
+        if (ops[i].opcode == op) return ops[i].kernel;
+    }
+    return nullptr;
+}
+
+// Emits one guest function as a member function f<index>. Locals are
+// named by slot (l<slot>), operand stack entries by type and the height in
+// slots they sit at (si<h>, sl<h>, sf<h>, sd<h>, sv<h>): the Validator
+// fixes both for every pc, and since blocks carry no values a branch never
+// has to move anything, only goto its target.
+class FunctionEmitter {
+public:
+    FunctionEmitter(const CompiledModule& module, size_t index, std::ostream& out, bool& usesSimd)
+        : module(module), cf(module.function(index)), index(index), out(out), usesSimd(usesSimd) {}
+
+    void emit();
+
+private:
+    const CompiledModule& module;
+    const CompiledFunction& cf;
+    size_t index;
+    std::ostream& out;
+    bool& usesSimd;
+    std::vector<std::string> localTypes; // By slot; the second slot of a v128 is empty
+    std::map<std::string, const char*> stackVars;
+    std::ostringstream body;
+
+    std::string stack(const std::string& type, int32_t height) {
+        std::string name = std::string("s") + (type == "i32"   ? 'i'
+                                               : type == "i64" ? 'l'
+                                               : type == "f32" ? 'f'
+                                               : type == "f64" ? 'd'
+                                                               : 'v') +
+                           std::to_string(height);
+        stackVars.emplace(name, cppType(type));
+        return name;
+    }
+    std::string i32(int32_t height) { return stack("i32", height); }
+    std::string local(int32_t slot) const { return "l" + std::to_string(slot); }
+
+    void line(const std::string& text) { body << "        " << text << "\n"; }
+    // Arguments of a call with params on the stack below height; returns
+    // the height the first one sits at.
+    int32_t arguments(const std::vector<std::string>& params, int32_t height, std::vector<std::string>& args);
+    void emitCall(const CompiledInstr& instr, int32_t h);
+    void emitCallIndirect(const CompiledInstr& instr, int32_t h);
+    void emitInstr(const CompiledInstr& instr, int32_t h);
+};
+
+int32_t FunctionEmitter::arguments(const std::vector<std::string>& params, int32_t height,
+                                   std::vector<std::string>& args) {
+    int32_t base = height;
+    for (const auto& t : params) base -= slotCount(t);
+    int32_t at = base;
+    for (const auto& t : params) {
+        args.push_back(stack(t, at));
+        at += slotCount(t);
+    }
+    return base;
+}
+
+void FunctionEmitter::emitCall(const CompiledInstr& instr, int32_t h) {
+    int32_t imports = (int32_t)module.importCount();
+    const Type& sig = module.signature(module.calleeSignature(instr.index));
+    std::vector<std::string> args;
+    int32_t base = arguments(sig.paramTypes, h, args);
+    std::string result = sig.resultTypes.empty() ? "" : stack(sig.resultTypes[0], base) + " = ";
+    if (instr.index >= imports) {
+        std::string list;
+        for (size_t i = 0; i < args.size(); ++i) list += (i ? ", " : "") + args[i];
+        line(result + "f" + std::to_string(instr.index - imports) + "(" + list + ");");
+        return;
+    }
+    // Host boundary: tagged values, as the Interpreter passes them
+    bool scalar = true;
+    for (const auto* types : {&sig.paramTypes, &sig.resultTypes}) {
+        for (const auto& t : *types) scalar &= t != "v128";
+    }
+    line("{");
+    if (scalar) {
+        std::string list;
+        for (size_t i = 0; i < args.size(); ++i) list += (i ? ", " : "") + ("WasmValue(" + args[i] + ")");
+        line("    std::vector<WasmValue> args{" + list + "};");
+        std::string host = "callHost(" + std::to_string(instr.index) + ", args)";
+        line("    " + (sig.resultTypes.empty() ? host : result + host + "." + member(sig.resultTypes[0])) + ";");
+    } else {
+        // Never bound, so this reports the unknown import
+        line("    std::vector<WasmValue> args;");
+        line("    callHost(" + std::to_string(instr.index) + ", args);");
+    }
+    line("}");
+}
+
+void FunctionEmitter::emitCallIndirect(const CompiledInstr& instr, int32_t h) {
+    const Type& sig = module.signature(instr.index);
+    std::vector<std::string> args;
+    int32_t base = arguments(sig.paramTypes, h - 1, args);
+    std::string result = sig.resultTypes.empty() ? "" : stack(sig.resultTypes[0], base) + " = ";
+    std::string list;
+    for (size_t i = 0; i < args.size(); ++i) list += (i ? ", " : "") + args[i];
+    line("switch (tableEntry(" + i32(h - 1) + ", " + std::to_string(instr.index) + ")) {");
+    for (size_t f = 0; f < module.functionCount(); ++f) {
+        if (module.function(f).signature != instr.index) continue;
+        line("    case " + std::to_string(f) + ": " + result + "f" + std::to_string(f) + "(" + list + "); break;");
+    }
+    line("    default: break;");
+    line("}");
+}
+
+void FunctionEmitter::emitInstr(const CompiledInstr& instr, int32_t h) {
+    Opcode op = instr.opcode;
+    const char* kernel;
+    switch (op) {
+        case Opcode::NOP: case Opcode::BLOCK: case Opcode::LOOP: case Opcode::END:
+            break;
+        case Opcode::I32_CONST: line(i32(h) + " = " + literal(instr) + ";"); break;
+        case Opcode::I64_CONST: line(stack("i64", h) + " = " + literal(instr) + ";"); break;
+        case Opcode::F32_CONST: line(stack("f32", h) + " = " + literal(instr) + ";"); break;
+        case Opcode::F64_CONST: line(stack("f64", h) + " = " + literal(instr) + ";"); break;
+        case Opcode::STRING_CONST:
+            line(i32(h) + " = stringHandles[" + std::to_string(instr.index) + "];");
+            break;
+
+        case Opcode::I32_EQZ: line(i32(h - 1) + " = (int32_t)(" + i32(h - 1) + " == 0);"); break;
+        case Opcode::I32_CLZ: line(i32(h - 1) + " = native::clz(" + i32(h - 1) + ");"); break;
+        case Opcode::I32_CTZ: line(i32(h - 1) + " = native::ctz(" + i32(h - 1) + ");"); break;
+        case Opcode::I32_POPCNT: line(i32(h - 1) + " = native::popcnt(" + i32(h - 1) + ");"); break;
+        case Opcode::F64_ADD: case Opcode::F64_SUB: case Opcode::F64_MUL: case Opcode::F64_DIV: {
+            const char* sym = op == Opcode::F64_ADD ? " + " : op == Opcode::F64_SUB ? " - " : op == Opcode::F64_MUL ? " * " : " / ";
+            line(stack("f64", h - 2) + " = " + stack("f64", h - 2) + sym + stack("f64", h - 1) + ";");
+            break;
+        }
+
+        case Opcode::LOCAL_GET: case Opcode::LOCAL_GET_WIDE: {
+            const std::string& type = localTypes[instr.index];
+            line(stack(type, h) + " = " + local(instr.index) + ";");
+            break;
+        }
+        case Opcode::LOCAL_SET: case Opcode::LOCAL_SET_WIDE: case Opcode::LOCAL_TEE: case Opcode::LOCAL_TEE_WIDE: {
+            const std::string& type = localTypes[instr.index];
+            line(local(instr.index) + " = " + stack(type, h - (int32_t)slotCount(type)) + ";");
+            break;
+        }
+        case Opcode::GLOBAL_GET: {
+            const std::string& type = module.module().globals[instr.index].type;
+            line(stack(type, h) + " = g" + std::to_string(instr.index) + ";");
+            break;
+        }
+        case Opcode::GLOBAL_SET: {
+            const std::string& type = module.module().globals[instr.index].type;
+            line("g" + std::to_string(instr.index) + " = " + stack(type, h - 1) + ";");
+            break;
+        }
+
+        case Opcode::CALL: emitCall(instr, h); break;
+        case Opcode::CALL_INDIRECT: emitCallIndirect(instr, h); break;
+
+        case Opcode::BR: case Opcode::ELSE:
+            line("goto L" + std::to_string(instr.index) + ";");
+            break;
+        case Opcode::BR_IF:
+            line("if (" + i32(h - 1) + ") goto L" + std::to_string(instr.index) + ";");
+            break;
+        case Opcode::IF:
+            line("if (!" + i32(h - 1) + ") goto L" + std::to_string(instr.index) + ";");
+            break;
+        case Opcode::BR_TABLE: {
+            // Out of range indices take the default, the last entry
+            line("switch ((uint32_t)" + i32(h - 1) + ") {");
+            for (int32_t i = 0; i < instr.i32; ++i) {
+                line("    case " + std::to_string(i) + ": goto L" +
+                     std::to_string(cf.branchTable[instr.index + i].pc) + ";");
+            }
+            line("    default: goto L" + std::to_string(cf.branchTable[instr.index + instr.i32].pc) + ";");
+            line("}");
+            break;
+        }
+        case Opcode::RETURN:
+            if (cf.hasResult) {
+                const std::string& type = cf.source->resultTypes[0];
+                line("return " + stack(type, h - (int32_t)slotCount(type)) + ";");
+            } else {
+                line("return;");
+            }
+            break;
+        case Opcode::UNREACHABLE: line("native::trap(\"Unreachable executed\");"); break;
+
+        case Opcode::V128_CONST: {
+            const V128& v = cf.constants[instr.index];
+            std::string bytes;
+            for (int i = 0; i < 16; ++i) bytes += (i ? ", " : "") + std::to_string(v.bytes[i]);
+            line(stack("v128", h) + " = V128{{" + bytes + "}};");
+            break;
+        }
+        case Opcode::V128_LOAD:
+            line(stack("v128", h - 2) + " = store.read<V128>(" + i32(h - 2) + ", " + i32(h - 1) + ");");
+            break;
+        case Opcode::V128_STORE:
+            line("store.write<V128>(" + i32(h - 4) + ", " + i32(h - 3) + ", " + stack("v128", h - 2) + ");");
+            break;
+        case Opcode::I32X4_SPLAT: case Opcode::F32X4_SPLAT: case Opcode::F64X2_SPLAT: {
+            const char* lane = op == Opcode::I32X4_SPLAT ? "i32" : op == Opcode::F32X4_SPLAT ? "f32" : "f64";
+            usesSimd = true;
+            line(stack("v128", h - 1) + " = simd::splat<" + cppType(lane) + ">(" + stack(lane, h - 1) + ");");
+            break;
+        }
+        case Opcode::I32X4_EXTRACT_LANE: case Opcode::F32X4_EXTRACT_LANE: case Opcode::F64X2_EXTRACT_LANE: {
+            const char* lane = op == Opcode::I32X4_EXTRACT_LANE   ? "i32"
+                               : op == Opcode::F32X4_EXTRACT_LANE ? "f32"
+                                                                  : "f64";
+            usesSimd = true;
+            line(stack(lane, h - 2) + " = simd::extractLane<" + cppType(lane) + ">(" + stack("v128", h - 2) + ", " +
+                 std::to_string(instr.i32) + ");");
+            break;
+        }
+        case Opcode::I32X4_REPLACE_LANE: case Opcode::F32X4_REPLACE_LANE: case Opcode::F64X2_REPLACE_LANE: {
+            const char* lane = op == Opcode::I32X4_REPLACE_LANE   ? "i32"
+                               : op == Opcode::F32X4_REPLACE_LANE ? "f32"
+                                                                  : "f64";
+            usesSimd = true;
+            line(stack("v128", h - 3) + " = simd::replaceLane<" + cppType(lane) + ">(" + stack("v128", h - 3) + ", " +
+                 std::to_string(instr.i32) + ", " + stack(lane, h - 1) + ");");
+            break;
+        }
+
+        default:
+            if (op >= Opcode::I32_EQ && op <= Opcode::I32_ROTR && op != Opcode::I32_CLZ && op != Opcode::I32_CTZ &&
+                op != Opcode::I32_POPCNT) {
+                line(i32(h - 2) + " = " + i32Binary(op, i32(h - 2), i32(h - 1)) + ";");
+            } else if ((kernel = simdKernel(simdUnary, sizeof simdUnary / sizeof *simdUnary, op))) {
+                usesSimd = true;
+                line(stack("v128", h - 2) + " = simd::" + kernel + "(" + stack("v128", h - 2) + ");");
+            } else if ((kernel = simdKernel(simdBinary, sizeof simdBinary / sizeof *simdBinary, op))) {
+                usesSimd = true;
+                line(stack("v128", h - 4) + " = simd::" + kernel + "(" + stack("v128", h - 4) + ", " +
+                     stack("v128", h - 2) + ");");
+            } else {
+                throw std::runtime_error("opcode " + std::to_string((int)op) + " cannot be translated");
+            }
+            break;
+    }
+}
+
+void FunctionEmitter::emit() {
+    const Function& source = *cf.source;
+    if (!cf.validated) {
+        throw std::runtime_error("Cannot translate " + source.name + ": " + cf.validationError);
+    }
+    std::vector<CompiledInstr> code = cf.code;
+    std::vector<BranchTarget> branchTable = cf.branchTable;
+    std::vector<int32_t> heights;
+    Validator(module).validate(cf, code, branchTable, &heights);
+
+    for (const auto* types : {&source.paramTypes, &source.localTypes, &cf.extraLocals}) {
+        for (const auto& t : *types) {
+            localTypes.push_back(t);
+            if (slotCount(t) == 2) localTypes.push_back("");
+        }
+    }
+
+    // Labels only where a reachable branch lands
+    std::vector<bool> target(code.size() + 1, false);
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        if (heights[pc] < 0) continue;
+        const CompiledInstr& instr = code[pc];
+        switch (instr.opcode) {
+            case Opcode::BR: case Opcode::BR_IF: case Opcode::IF: case Opcode::ELSE:
+                target[instr.index] = true;
+                break;
+            case Opcode::BR_TABLE:
+                for (int32_t i = 0; i <= instr.i32; ++i) target[branchTable[instr.index + i].pc] = true;
+                break;
+            default:
+                break;
+        }
+    }
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        if (target[pc]) body << "    L" << pc << ":;\n";
+        if (heights[pc] >= 0) emitInstr(code[pc], heights[pc]);
+    }
+
+    // $name (params) -> result
+    std::string result = cf.hasResult ? cppType(source.resultTypes[0]) : "void";
+    out << "    // $" << source.name << "\n";
+    out << "    " << result << " f" << index << "(";
+    uint32_t slot = 0;
+    for (size_t i = 0; i < source.paramTypes.size(); ++i) {
+        out << (i ? ", " : "") << cppType(source.paramTypes[i]) << " " << local(slot);
+        slot += slotCount(source.paramTypes[i]);
+    }
+    out << ") {\n";
+    for (; slot < cf.numLocals; ++slot) {
+        if (localTypes[slot].empty()) continue;
+        out << "        " << cppType(localTypes[slot]) << " " << local(slot) << "{};\n";
+    }
+    for (const auto& var : stackVars) out << "        " << var.second << " " << var.first << "{};\n";
+    out << body.str() << "    }\n\n";
+}
+
+} // namespace
+
+CppEmitter::CppEmitter(const CompiledModule& module) : module(module) {}
+
+std::string CppEmitter::emit(const std::string& name) const {
+    const Module& mod = module.module();
+    std::string cls = "Native_";
+    for (char c : name) cls += std::isalnum((unsigned char)c) ? c : '_';
+
+    bool usesSimd = false;
+    std::ostringstream functions;
+    for (size_t f = 0; f < module.functionCount(); ++f) FunctionEmitter(module, f, functions, usesSimd).emit();
+
+    std::ostringstream out;
+    out << "// Generated by wat2cpp; do not edit.\n";
+    out << "#include \"NativeModule.h\"\n";
+    if (usesSimd) out << "#include \"Simd.h\"\n";
+    out << "\n// Stack slots and locals that some path never reads are expected\n";
+    out << "#pragma GCC diagnostic ignored \"-Wunused-parameter\"\n";
+    out << "#pragma GCC diagnostic ignored \"-Wunused-variable\"\n";
+    out << "#pragma GCC diagnostic ignored \"-Wunused-but-set-variable\"\n\n";
+    out << "namespace {\n\n";
+
+    // Layout
+    out << "const NativeLayout nativeLayout = {\n    {\n";
+    for (const auto& imp : mod.imports) {
+        out << "        {" << quote(imp.module) << ", " << quote(imp.field) << ", " << typeList(imp.paramTypes)
+            << ", " << typeList(imp.resultTypes) << "},\n";
+    }
+    out << "    },\n    {\n";
+    std::vector<std::string> names;
+    for (const auto& fn : mod.functions) {
+        if (!fn.name.empty()) names.push_back(fn.name);
+    }
+    for (const auto& exp : mod.exports) {
+        if (exp.kind == "func") names.push_back(exp.name);
+    }
+    std::map<std::string, int32_t> resolved;
+    for (const auto& n : names) {
+        int32_t f = module.findFunction(n);
+        if (f >= 0) resolved.emplace(n, f);
+    }
+    for (const auto& r : resolved) out << "        {" << quote(r.first) << ", " << r.second << "},\n";
+    out << "    },\n    {\n";
+    for (size_t f = 0; f < module.functionCount(); ++f) {
+        out << "        " << typeList(module.function(f).source->paramTypes) << ",\n";
+    }
+    out << "    },\n    {\n";
+    for (size_t f = 0; f < module.functionCount(); ++f) {
+        out << "        " << typeList(module.function(f).source->resultTypes) << ",\n";
+    }
+    out << "    },\n    {";
+    for (size_t f = 0; f < module.functionCount(); ++f) out << (f ? ", " : "") << module.function(f).signature;
+    out << "},\n    {\n";
+    for (size_t s = 0; s < module.signatureCount(); ++s) {
+        out << "        " << typeList(module.signature((int32_t)s).paramTypes) << ",\n";
+    }
+    out << "    },\n    {\n";
+    for (const auto& data : module.stringData()) {
+        out << "        {";
+        for (size_t i = 0; i < data.size(); ++i) out << (i ? ", " : "") << (int)data[i];
+        out << "},\n";
+    }
+    out << "    },\n    {";
+    std::vector<int32_t> table(module.tableSize(), -1);
+    for (const auto& elem : module.elements()) {
+        for (size_t i = 0; i < elem.functionIndices.size(); ++i) {
+            if (elem.offset + i < table.size()) table[elem.offset + i] = elem.functionIndices[i];
+        }
+    }
+    for (size_t i = 0; i < table.size(); ++i) out << (i ? ", " : "") << table[i];
+    out << "},\n};\n\n";
+
+    // The instance: globals and code
+    out << "class " << cls << " final : public NativeModule {\n";
+    out << "public:\n";
+    out << "    explicit " << cls << "(MemoryStore& store) : NativeModule(nativeLayout, store) {}\n\n";
+    out << "protected:\n";
+    out << "    WasmValue invoke(int32_t func, const WasmValue* args) override {\n";
+    out << "        switch (func) {\n";
+    for (size_t f = 0; f < module.functionCount(); ++f) {
+        const Function& source = *module.function(f).source;
+        bool scalar = true;
+        std::string list;
+        for (size_t i = 0; i < source.paramTypes.size(); ++i) {
+            scalar &= source.paramTypes[i] != "v128";
+            list += (i ? ", " : "") + ("args[" + std::to_string(i) + "]." + member(source.paramTypes[i]));
+        }
+        for (const auto& t : source.resultTypes) scalar &= t != "v128";
+        if (!scalar) continue; // run() refuses these
+        std::string invocation = "f" + std::to_string(f) + "(" + list + ")";
+        out << "            case " << f << ": ";
+        if (source.resultTypes.empty()) {
+            out << invocation << "; return WasmValue();\n";
+        } else {
+            out << "return WasmValue(" << invocation << ");\n";
+        }
+    }
+    out << "            default: return WasmValue();\n";
+    out << "        }\n    }\n\n";
+    out << "private:\n";
+    for (size_t g = 0; g < mod.globals.size(); ++g) {
+        const Global& global = mod.globals[g];
+        CompiledInstr init;
+        init.opcode = global.init.opcode;
+        switch (global.init.opcode) {
+            case Opcode::I64_CONST: init.i64 = std::get<int64_t>(global.init.operand); break;
+            case Opcode::F32_CONST: init.f32 = std::get<float>(global.init.operand); break;
+            case Opcode::F64_CONST: init.f64 = std::get<double>(global.init.operand); break;
+            default: init.opcode = Opcode::I32_CONST; init.i32 = std::get<int32_t>(global.init.operand); break;
+        }
+        out << "    " << cppType(global.type) << " g" << g << " = " << literal(init) << ";\n";
+    }
+    if (!mod.globals.empty()) out << "\n";
+    out << functions.str();
+    out << "};\n\n";
+    out << "const bool registered = NativeModule::registerFactory(" << quote(name)
+        << ", [](MemoryStore& store) -> std::unique_ptr<NativeModule> { return std::unique_ptr<NativeModule>(new "
+        << cls << "(store)); });\n\n";
+    out << "} // namespace\n";
+    return out.str();
+}
@@ -0,0 +1,257 @@
+#include "Inliner.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+bool isBranch(Opcode op) {
+    return op == Opcode::BR || op == Opcode::BR_IF || op == Opcode::IF || op == Opcode::ELSE;
+}
+
+bool isLocalAccess(Opcode op) {
+    return (op >= Opcode::LOCAL_GET && op <= Opcode::LOCAL_TEE) ||
+           (op >= Opcode::LOCAL_GET_WIDE && op <= Opcode::LOCAL_TEE_WIDE);
+}
+
+CompiledInstr localSet(const std::string& type, int32_t slot) {
+    CompiledInstr instr;
+    instr.opcode = slotCount(type) == 2 ? Opcode::LOCAL_SET_WIDE : Opcode::LOCAL_SET;
+    instr.index = slot;
+    return instr;
+}
+
+CompiledInstr localGet(const std::string& type, int32_t slot) {
+    CompiledInstr instr;
+    instr.opcode = slotCount(type) == 2 ? Opcode::LOCAL_GET_WIDE : Opcode::LOCAL_GET;
+    instr.index = slot;
+    return instr;
+}
+
+} // namespace
+
+Inliner::Inliner(const std::vector<CompiledFunction>& functions, size_t importCount,
+                 const OptimizerOptions& options)
+    : functions(functions), imports((int32_t)importCount), opts(options), recursive(functions.size(), false) {
+    size_t n = functions.size();
+    std::vector<std::vector<size_t>> callees(n);
+    for (size_t f = 0; f < n; ++f) {
+        if (functions[f].lazy) continue;
+        for (const auto& instr : functions[f].code) {
+            if (instr.opcode != Opcode::CALL || instr.index < imports) continue;
+            size_t callee = instr.index - imports;
+            if (functions[callee].lazy) continue;
+            if (callee == f) recursive[f] = true;
+            callees[f].push_back(callee);
+        }
+    }
+
+    // Tarjan's strongly connected components: each component is complete,
+    // and its callees already listed, when it is popped
+    std::vector<int32_t> index(n, -1), low(n, 0);
+    std::vector<bool> onStack(n, false);
+    std::vector<size_t> stack;
+    int32_t counter = 0;
+    std::function<void(size_t)> visit = [&](size_t v) {
+        index[v] = low[v] = counter++;
+        stack.push_back(v);
+        onStack[v] = true;
+        for (size_t w : callees[v]) {
+            if (index[w] < 0) {
+                visit(w);
+                low[v] = std::min(low[v], low[w]);
+            } else if (onStack[w]) {
+                low[v] = std::min(low[v], index[w]);
+            }
+        }
+        if (low[v] != index[v]) return;
+        size_t first = order.size();
+        size_t w;
+        do {
+            w = stack.back();
+            stack.pop_back();
+            onStack[w] = false;
+            order.push_back(w);
+        } while (w != v);
+        if (order.size() - first > 1) {
+            for (size_t i = first; i < order.size(); ++i) recursive[order[i]] = true;
+        }
+    };
+    for (size_t f = 0; f < n; ++f) {
+        if (!functions[f].lazy && index[f] < 0) visit(f);
+    }
+}
+
+const CompiledFunction* Inliner::candidate(const CompiledFunction& caller, const CompiledInstr& instr) const {
+    if (instr.opcode != Opcode::CALL || instr.index < imports) return nullptr;
+    size_t index = instr.index - imports;
+    const CompiledFunction& callee = functions[index];
+    if (callee.lazy || !callee.validated || recursive[index] || &callee == &caller ||
+        callee.code.size() - 1 > opts.inlineMaxSize || callee.inlineDepth >= opts.inlineMaxDepth) {
+        return nullptr;
+    }
+    return &callee;
+}
+
+bool Inliner::hasCandidates(const CompiledFunction& caller) const {
+    if (!opts.inlining) return false;
+    for (const auto& instr : caller.code) {
+        if (candidate(caller, instr)) return true;
+    }
+    return false;
+}
+
+uint32_t Inliner::inlineCalls(CompiledFunction& caller, std::vector<CompiledInstr>& code,
+                              std::vector<BranchTarget>& branchTable, std::vector<V128>& constants) const {
+    if (!opts.inlining) return 0;
+
+    // Locals for the inlined bodies go after all the caller has. Sites
+    // share them, but not the extra locals the optimizer already added.
+    size_t firstInlined = caller.extraLocals.size();
+    uint32_t nextSlot = caller.numLocals;
+    std::vector<uint32_t> inlinedSlot;
+    int32_t zeroV128 = -1;
+
+    size_t callerTable = branchTable.size();
+    std::vector<int32_t> newPc(code.size() + 1);
+    std::vector<size_t> callerBranches; // Where the caller's own branches went
+    std::vector<CompiledInstr> out;
+    out.reserve(code.size());
+    uint32_t inlined = 0;
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        newPc[pc] = (int32_t)out.size();
+        const CompiledInstr& instr = code[pc];
+        const CompiledFunction* callee = candidate(caller, instr);
+        if (callee && out.size() + (code.size() - pc) + callee->code.size() + callee->numLocals >
+                          opts.inlineMaxCallerSize) {
+            callee = nullptr;
+        }
+        if (!callee) {
+            if (isBranch(instr.opcode)) callerBranches.push_back(out.size());
+            out.push_back(instr);
+            continue;
+        }
+
+        // Give each callee local a caller local of the same type, reusing
+        // those earlier sites took
+        const Function& source = *callee->source;
+        std::vector<const std::string*> calleeLocals;
+        for (const auto* types : {&source.paramTypes, &source.localTypes, &callee->extraLocals}) {
+            for (const auto& t : *types) calleeLocals.push_back(&t);
+        }
+        std::vector<bool> taken(inlinedSlot.size(), false);
+        auto allocate = [&](const std::string& type) {
+            for (size_t i = 0; i < taken.size(); ++i) {
+                if (!taken[i] && caller.extraLocals[firstInlined + i] == type) {
+                    taken[i] = true;
+                    return inlinedSlot[i];
+                }
+            }
+            caller.extraLocals.push_back(type);
+            inlinedSlot.push_back(nextSlot);
+            taken.push_back(true);
+            nextSlot += slotCount(type);
+            return inlinedSlot.back();
+        };
+        std::vector<int32_t> slotMap(callee->numLocals);
+        std::vector<uint32_t> localSlot;
+        uint32_t calleeSlot = 0;
+        for (const std::string* t : calleeLocals) {
+            uint32_t slot = allocate(*t);
+            localSlot.push_back(slot);
+            for (uint32_t i = 0; i < slotCount(*t); ++i) slotMap[calleeSlot + i] = (int32_t)(slot + i);
+            calleeSlot += slotCount(*t);
+        }
+
+        // Arguments come off the stack last one first; other locals start
+        // at zero on every call
+        size_t params = source.paramTypes.size();
+        for (size_t k = params; k > 0; --k) {
+            out.push_back(localSet(*calleeLocals[k - 1], localSlot[k - 1]));
+        }
+        for (size_t k = params; k < calleeLocals.size(); ++k) {
+            CompiledInstr zero;
+            const std::string& type = *calleeLocals[k];
+            if (type == "i32") {
+                zero.opcode = Opcode::I32_CONST;
+            } else if (type == "i64") {
+                zero.opcode = Opcode::I64_CONST;
+            } else if (type == "f32") {
+                zero.opcode = Opcode::F32_CONST;
+            } else if (type == "f64") {
+                zero.opcode = Opcode::F64_CONST;
+            } else {
+                if (zeroV128 < 0) {
+                    zeroV128 = (int32_t)constants.size();
+                    constants.push_back(V128{});
+                }
+                zero.opcode = Opcode::V128_CONST;
+                zero.index = zeroV128;
+            }
+            out.push_back(zero);
+            out.push_back(localSet(type, localSlot[k]));
+        }
+
+        // Where each callee instruction lands. Without a return before the
+        // trailing one the body simply falls through into the caller.
+        size_t last = callee->code.size() - 1;
+        bool earlyReturn = false;
+        for (size_t cpc = 0; cpc < last && !earlyReturn; ++cpc) {
+            earlyReturn = callee->code[cpc].opcode == Opcode::RETURN;
+        }
+        const std::string* resultType = callee->hasResult ? &source.resultTypes[0] : nullptr;
+        int32_t resultSlot = earlyReturn && resultType ? (int32_t)allocate(*resultType) : -1;
+        uint32_t returnSize = resultSlot >= 0 ? 2 : 1;
+        std::vector<int32_t> pos(last + 1);
+        int32_t at = (int32_t)out.size() + (earlyReturn ? 1 : 0);
+        for (size_t cpc = 0; cpc <= last; ++cpc) {
+            pos[cpc] = at;
+            at += callee->code[cpc].opcode == Opcode::RETURN ? returnSize : 1;
+        }
+        int32_t exit = pos[last] + (resultSlot >= 0 ? 2 : 1); // END + 1
+
+        if (earlyReturn) {
+            CompiledInstr block;
+            block.opcode = Opcode::BLOCK;
+            out.push_back(block);
+        }
+        int32_t constantBase = (int32_t)constants.size();
+        constants.insert(constants.end(), callee->constants.begin(), callee->constants.end());
+        for (size_t cpc = 0; cpc < last; ++cpc) {
+            CompiledInstr c = callee->code[cpc];
+            if (isLocalAccess(c.opcode)) {
+                c.index = slotMap[c.index];
+            } else if (isBranch(c.opcode)) {
+                c.index = pos[c.index];
+            } else if (c.opcode == Opcode::BR_TABLE) {
+                int32_t first = (int32_t)branchTable.size();
+                for (int32_t i = 0; i <= c.i32; ++i) {
+                    branchTable.push_back({pos[callee->branchTable[c.index + i].pc], 0});
+                }
+                c.index = first;
+            } else if (c.opcode == Opcode::V128_CONST) {
+                c.index += constantBase;
+            } else if (c.opcode == Opcode::RETURN) {
+                if (resultSlot >= 0) out.push_back(localSet(*resultType, resultSlot));
+                c.opcode = Opcode::BR;
+                c.index = exit;
+            }
+            out.push_back(c);
+        }
+        if (earlyReturn) {
+            if (resultSlot >= 0) out.push_back(localSet(*resultType, resultSlot));
+            CompiledInstr end;
+            end.opcode = Opcode::END;
+            out.push_back(end);
+            if (resultSlot >= 0) out.push_back(localGet(*resultType, resultSlot));
+        }
+        inlined++;
+        caller.inlineDepth = std::max(caller.inlineDepth, callee->inlineDepth + 1);
+    }
+    newPc[code.size()] = (int32_t)out.size();
+
+    for (size_t at : callerBranches) out[at].index = newPc[out[at].index];
+    for (size_t i = 0; i < callerTable; ++i) branchTable[i].pc = newPc[branchTable[i].pc];
+    caller.numLocals = nextSlot;
+    code = std::move(out);
+    return inlined;
+}
@@ -0,0 +1,93 @@
+#include "InstancePool.h"
+#include <algorithm>
+
+InstancePool::Lease::Lease(InstancePool* pool, std::unique_ptr<Entry> entry)
+    : pool(pool), entry(std::move(entry)) {}
+
+InstancePool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), entry(std::move(other.entry)) {}
+
+InstancePool::Lease::~Lease() {
+    if (entry) pool->release(std::move(entry));
+}
+
+InstancePool::InstancePool(InstanceSnapshot snapshot, Binder binder, size_t prewarm)
+    : snapshot(std::move(snapshot)), binder(std::move(binder)) {
+    for (size_t i = 0; i < prewarm; ++i) {
+        idle.push_back(create());
+    }
+}
+
+InstancePool::Lease InstancePool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            std::unique_ptr<Entry> entry = std::move(idle.back());
+            idle.pop_back();
+            return Lease(this, std::move(entry));
+        }
+    }
+    return Lease(this, create());
+}
+
+void InstancePool::runBatch(const std::string& funcName, const std::vector<WasmValue>& args,
+                            std::vector<WasmValue>& results, ThreadPool& threads, size_t chunkRows) {
+    int32_t funcIndex = snapshot.compiled->findFunction(funcName);
+    if (funcIndex < 0) {
+        throw std::runtime_error("Function not found: " + funcName);
+    }
+    size_t arity = snapshot.compiled->function(funcIndex).source->paramTypes.size();
+    size_t rows = arity ? args.size() / arity : results.size();
+    if (arity ? args.size() % arity != 0 : !args.empty()) {
+        throw std::runtime_error("Batch arguments are not a whole number of rows");
+    }
+    results.resize(rows);
+    if (chunkRows == 0) chunkRows = std::max<size_t>(1, (rows + threads.size() * 4 - 1) / (threads.size() * 4));
+
+    std::vector<std::future<void>> chunks;
+    for (size_t first = 0; first < rows; first += chunkRows) {
+        size_t count = std::min(chunkRows, rows - first);
+        chunks.push_back(threads.submit([this, &funcName, &args, &results, arity, first, count]() {
+            Lease lease = acquire();
+            FunctionRef func = lease->lookup(funcName);
+            lease->runBatch(func, args.data() + first * arity, count, results.data() + first);
+        }));
+    }
+    std::exception_ptr failure;
+    for (auto& chunk : chunks) {
+        try {
+            chunk.get();
+        } catch (...) {
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    if (failure) std::rethrow_exception(failure);
+}
+
+size_t InstancePool::idleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
+
+size_t InstancePool::createdCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return created;
+}
+
+std::unique_ptr<InstancePool::Entry> InstancePool::create() {
+    auto entry = std::make_unique<Entry>();
+    entry->vm = std::make_unique<Interpreter>(snapshot, entry->store);
+    if (binder) binder(*entry->vm, entry->store);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    created++;
+    return entry;
+}
+
+void InstancePool::release(std::unique_ptr<Entry> entry) {
+    // Reset outside the lock; the snapshot is only ever read.
+    entry->vm->restore(snapshot);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.push_back(std::move(entry));
+}
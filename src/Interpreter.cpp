@@ -1,56 +1,122 @@
 #include "Interpreter.h"
+#include "Profiler.h"
+#include "PurityAnalysis.h"
+#include "Simd.h"
+#include <algorithm>
 
-Interpreter::Interpreter(Module& mod, MemoryStore& store) : module(mod), store(store) {
-    // Build Symbol Tables
-    for (size_t i = 0; i < module.functions.size(); ++i) {
-        funcMap[module.functions[i].name] = i;
+// v128 values have no WasmValue form, so they cannot cross the host boundary.
+static void checkHostTypes(const std::vector<std::string>& types, const std::string& what) {
+    for (const auto& t : types) {
+        if (t == "v128") throw std::runtime_error("v128 is not supported at the host boundary: " + what);
     }
+}
 
-    // Initialize Strings
-    for (const auto& strDef : module.strings) {
-        std::vector<uint8_t> data;
-        int32_t len = strDef.value.length();
-
-        // 4 bytes length
-        data.push_back(len & 0xFF);
-        data.push_back((len >> 8) & 0xFF);
-        data.push_back((len >> 16) & 0xFF);
-        data.push_back((len >> 24) & 0xFF);
-
-        // String bytes
-        for (char c : strDef.value) {
-            data.push_back((uint8_t)c);
-        }
+// Publishes an instance's shadow stack to the sampler for one run() on
+// this thread, restoring whatever was published before.
+class ShadowScope {
+public:
+    explicit ShadowScope(GuestStackShadow* stack)
+        : active(stack != nullptr), previous(active ? SamplingProfiler::enterThread(stack) : nullptr) {}
+    ~ShadowScope() {
+        if (active) SamplingProfiler::enterThread(previous);
+    }
+
+private:
+    bool active;
+    GuestStackShadow* previous;
+};
+
+static WasmValue::Type tagFor(const std::string& type) {
+    if (type == "i64") return WasmValue::I64;
+    if (type == "f32") return WasmValue::F32;
+    if (type == "f64") return WasmValue::F64;
+    return WasmValue::I32;
+}
+
+Interpreter::Interpreter(Module& mod, MemoryStore& store)
+    : compiled(std::make_shared<const CompiledModule>(mod)), store(store) {
+    instantiate();
+}
 
+Interpreter::Interpreter(std::shared_ptr<const CompiledModule> compiled, MemoryStore& store)
+    : compiled(std::move(compiled)), store(store) {
+    instantiate();
+}
+
+Interpreter::Interpreter(const InstanceSnapshot& snapshot, MemoryStore& store)
+    : compiled(snapshot.compiled), store(store) {
+    hostFuncs.resize(compiled->importCount());
+    restore(snapshot);
+}
+
+void Interpreter::instantiate() {
+    hostFuncs.resize(compiled->importCount());
+
+    // Initialize Strings
+    for (const auto& data : compiled->stringData()) {
         // Allocate readonly
-        int32_t handle = store.alloc_readonly(data);
-        stringHandles[strDef.name] = handle;
+        stringHandles.push_back(store.alloc_readonly(data));
     }
 
     // Initialize Table
-    if (!module.tables.empty()) {
-        const auto& tbl = module.tables[0];
-        table.resize(tbl.min);
-    }
-    for (const auto& elem : module.elements) {
-        // Evaluate offset (simplistic: assume i32.const)
-        int32_t offset = 0;
-        if (elem.offset.opcode == Opcode::I32_CONST) {
-             offset = std::get<int32_t>(elem.offset.operand);
+    table.assign(compiled->tableSize(), -1);
+    for (const auto& elem : compiled->elements()) {
+        for (size_t i = 0; i < elem.functionIndices.size(); ++i) {
+             if (elem.offset + i < table.size()) {
+                 table[elem.offset + i] = elem.functionIndices[i];
+             }
         }
+    }
 
-        for (size_t i = 0; i < elem.functionNames.size(); ++i) {
-             if (offset + i < table.size()) {
-                 table[offset + i] = elem.functionNames[i];
-             }
+    // Initialize Globals
+    for (const auto& g : compiled->module().globals) {
+        switch (g.init.opcode) {
+            case Opcode::I64_CONST: globals.push_back(WasmValue(std::get<int64_t>(g.init.operand))); break;
+            case Opcode::F32_CONST: globals.push_back(WasmValue(std::get<float>(g.init.operand))); break;
+            case Opcode::F64_CONST: globals.push_back(WasmValue(std::get<double>(g.init.operand))); break;
+            default: globals.push_back(WasmValue(std::get<int32_t>(g.init.operand))); break;
         }
     }
 }
 
+InstanceSnapshot Interpreter::snapshot() const {
+    if (!callStack.empty()) {
+        throw std::runtime_error("Cannot snapshot a running instance");
+    }
+    InstanceSnapshot snap;
+    snap.compiled = compiled;
+    snap.memory = store;
+    snap.table = table;
+    snap.stringHandles = stringHandles;
+    snap.globals = globals;
+    return snap;
+}
+
+void Interpreter::restore(const InstanceSnapshot& snapshot) {
+    if (snapshot.compiled != compiled) {
+        throw std::runtime_error("Snapshot belongs to a different module");
+    }
+    store = snapshot.memory;
+    table = snapshot.table;
+    stringHandles = snapshot.stringHandles;
+    globals = snapshot.globals;
+    callStack.clear();
+    stackTop = 0;
+    suspendedFunc = nullptr;
+    pendingImport = -1;
+    memoPending.clear();
+    memoKeys.clear();
+    // Cached results may hold the old string handles
+    for (auto& table : memo) {
+        if (table) std::fill(table->used.begin(), table->used.end(), 0);
+    }
+}
+
 void Interpreter::registerHostFunction(std::string modName, std::string fieldName, HostFunction func,
                                        const std::vector<std::string>& params,
                                        const std::vector<std::string>& results) {
     // Scan module imports to see if this host function is needed
+    const Module& module = compiled->module();
     int importIndex = 0;
     for (const auto& imp : module.imports) {
         if (imp.module == modName && imp.field == fieldName) {
@@ -61,375 +127,924 @@ void Interpreter::registerHostFunction(std::string modName, std::string fieldNam
             if (imp.resultTypes != results) {
                 throw std::runtime_error("Import signature mismatch (results) for " + modName + "." + fieldName);
             }
+            checkHostTypes(params, modName + "." + fieldName);
+            checkHostTypes(results, modName + "." + fieldName);
 
             HostFuncEntry entry;
             entry.func = func;
             entry.arity = (int)params.size();
             entry.paramTypes = params;
             entry.resultTypes = results;
+            for (const auto& p : params) entry.paramTags.push_back(tagFor(p));
 
-            // Link by alias if present
-            if (!imp.alias.empty()) {
-                hostFuncs[imp.alias] = entry;
-            }
-            hostFuncs[std::to_string(importIndex)] = entry;
+            hostFuncs[importIndex] = entry;
         }
         importIndex++;
     }
 }
 
-WasmValue Interpreter::run(std::string funcName, std::vector<WasmValue> args) {
-    if (funcMap.find(funcName) == funcMap.end()) {
-        throw std::runtime_error("Function not found: " + funcName);
+void Interpreter::setProfiler(Profiler* p) {
+#ifdef OPTRICH_PROFILE
+    if (p && p->module() != compiled) {
+        throw std::runtime_error("Profiler belongs to a different module");
     }
+    profiler = p;
+#else
+    if (p) throw std::runtime_error("Profiling support is compiled out; rebuild with -DOPTRICH_PROFILE");
+#endif
+}
 
-    size_t funcIndex = funcMap[funcName];
-    Function* startFunc = &module.functions[funcIndex];
+void Interpreter::setSampler(SamplingProfiler* sampler) {
+    if (!callStack.empty()) {
+        throw std::runtime_error("Cannot attach a sampler to a running instance");
+    }
+    if (!sampler) {
+        shadow.reset();
+        return;
+    }
+    if (sampler->module() != compiled) {
+        throw std::runtime_error("Sampler belongs to a different module");
+    }
+    shadow.reset(new GuestStackShadow());
+    shadow->sampler = sampler;
+}
 
-    StackFrame frame;
-    frame.func = startFunc;
-    frame.pc = 0;
-    frame.returnHeight = 0;
+FunctionRef Interpreter::lookup(const std::string& funcName) const {
+    int32_t funcIndex = compiled->findFunction(funcName);
+    if (funcIndex < 0) {
+        throw std::runtime_error("Function not found: " + funcName);
+    }
+    const CompiledFunction* func = &compiled->function(funcIndex);
+    checkHostTypes(func->source->paramTypes, funcName);
+    checkHostTypes(func->source->resultTypes, funcName);
+    return FunctionRef{funcIndex, func};
+}
 
-    if (args.size() != startFunc->paramTypes.size()) {
-            throw std::runtime_error("Argument mismatch");
+void Interpreter::setMemoization(const PurityAnalysis& purity, size_t capacity) {
+    if (!callStack.empty()) {
+        throw std::runtime_error("Cannot change memoization of a running instance");
     }
-    for (const auto& arg : args) {
-        frame.locals.push_back(arg);
+    if (&purity.module() != compiled.get()) {
+        throw std::runtime_error("Purity analysis belongs to a different module");
     }
-    for (const auto& lType : startFunc->localTypes) {
-            (void)lType;
-            frame.locals.push_back(WasmValue((int32_t)0)); // Default init
+    memo.clear();
+    if (capacity == 0) return;
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    memo.resize(compiled->functionCount());
+    for (size_t f = 0; f < memo.size(); ++f) {
+        if (!purity.isPure(f)) continue;
+        const CompiledFunction& cf = compiled->function(f);
+        auto table = std::make_unique<MemoTable>();
+        table->keySlots = cf.numParams;
+        table->resultSlots = cf.hasResult ? cf.resultSlots : 0;
+        table->mask = size - 1;
+        // Slots only define the bits their type uses
+        for (const auto& type : cf.source->paramTypes) {
+            uint64_t bits = (type == "i32" || type == "f32") ? 0xFFFFFFFFull : ~0ull;
+            for (uint32_t i = 0; i < slotCount(type); ++i) table->keyBits.push_back(bits);
+        }
+        table->used.assign(size, 0);
+        table->keys.resize(size * table->keySlots);
+        table->results.resize(size * table->resultSlots);
+        memo[f] = std::move(table);
     }
+}
 
-    callStack.push_back(frame);
+Interpreter::MemoStats Interpreter::memoStats(size_t func) const {
+    return func < memo.size() && memo[func] ? memo[func]->stats : MemoStats();
+}
 
-    while (!callStack.empty()) {
-        StackFrame& current = callStack.back();
-        if (current.pc >= current.func->body.size()) {
-            handleReturn();
-            continue;
-        }
+WasmValue Interpreter::run(std::string funcName, std::vector<WasmValue> args) {
+    return run(lookup(funcName), std::move(args));
+}
 
-        Instruction& instr = current.func->body[current.pc];
-        current.pc++;
+WasmValue Interpreter::run(const FunctionRef& ref, std::vector<WasmValue> args) {
+    checkRef(ref);
+    if (args.size() != ref.func->source->paramTypes.size()) {
+            throw std::runtime_error("Argument mismatch");
+    }
+    return invoke(ref, args.data());
+}
 
-        execute(instr, current);
+void Interpreter::runBatch(const FunctionRef& ref, const WasmValue* args, size_t count, WasmValue* results) {
+    checkRef(ref);
+    size_t arity = ref.func->source->paramTypes.size();
+    for (size_t i = 0; i < count; ++i) {
+        WasmValue res;
+        try {
+            res = invoke(ref, args + i * arity);
+        } catch (const FuelExhausted&) {
+            cancel(); // A batch has no caller to resume it
+            throw;
+        }
+        if (res.isPending()) {
+            cancel();
+            throw std::runtime_error("Host calls cannot be pending in runBatch");
+        }
+        results[i] = res;
     }
+}
 
-    if (!valueStack.empty()) {
-            return valueStack.back();
+void Interpreter::runBatch(const FunctionRef& ref, const std::vector<WasmValue>& args,
+                           std::vector<WasmValue>& results) {
+    size_t arity = ref.func ? ref.func->source->paramTypes.size() : 0;
+    size_t count = arity ? args.size() / arity : results.size();
+    if (arity && args.size() % arity != 0) {
+        throw std::runtime_error("Batch arguments are not a whole number of rows");
     }
-    return WasmValue();
+    if (!arity && !args.empty()) {
+        throw std::runtime_error("Argument mismatch");
+    }
+    results.resize(count);
+    runBatch(ref, args.data(), count, results.data());
 }
 
-void Interpreter::push(WasmValue v) { valueStack.push_back(v); }
+void Interpreter::checkRef(const FunctionRef& ref) const {
+    if (suspendedFunc) {
+        throw std::runtime_error("Instance has a suspended run; resume() or cancel() it first");
+    }
+    if (!ref.func || ref.index < 0 || (size_t)ref.index >= compiled->functionCount() ||
+        &compiled->function(ref.index) != ref.func) {
+        throw std::runtime_error("Function reference belongs to a different module");
+    }
+}
 
-WasmValue Interpreter::pop() {
-    if (valueStack.empty()) throw std::runtime_error("Stack underflow");
-    WasmValue v = valueStack.back();
-    valueStack.pop_back();
-    return v;
+WasmValue Interpreter::invoke(const FunctionRef& ref, const WasmValue* args) {
+    // Leave the stacks as we found them so instances can be reused
+    size_t baseHeight = stackTop;
+    size_t baseDepth = callStack.size();
+    size_t profileDepth = 0;
+#ifdef OPTRICH_PROFILE
+    if (profiler) profileDepth = profiler->depth();
+#endif
+    size_t arity = ref.func->source->paramTypes.size();
+    for (size_t i = 0; i < arity; ++i) {
+        push(Slot::of(args[i]));
+    }
+    callFunction(ref.index);
+    return execute(ref.func, baseHeight, baseDepth, profileDepth);
 }
 
-void Interpreter::handleReturn() {
-    bool hasResult = !callStack.back().func->resultTypes.empty();
-    WasmValue res;
-    if (hasResult) res = pop();
+WasmValue Interpreter::resume() {
+    if (!suspendedFunc) {
+        throw std::runtime_error("No suspended run to resume");
+    }
+    if (pendingImport >= 0) {
+        throw std::runtime_error("Run is waiting on a host call; resume it with the call's result");
+    }
+    const CompiledFunction* startFunc = suspendedFunc;
+    suspendedFunc = nullptr;
+    // Only outermost runs suspend, so they started from empty stacks
+    return execute(startFunc, 0, 0, 0);
+}
 
-    size_t height = static_cast<size_t>(callStack.back().returnHeight);
-    while (valueStack.size() > height) {
-        valueStack.pop_back();
+WasmValue Interpreter::resume(WasmValue hostResult) {
+    if (pendingImport < 0) {
+        throw std::runtime_error("No host call is pending");
     }
-    if (hasResult) push(res);
+    const HostFuncEntry& entry = hostFuncs[pendingImport];
+    if (!entry.resultTypes.empty()) {
+        if (hostResult.type != tagFor(entry.resultTypes[0])) {
+            const Import& imp = compiled->module().imports[pendingImport];
+            throw std::runtime_error("Host result type mismatch for " + imp.module + "." + imp.field);
+        }
+        push(Slot::of(hostResult));
+    }
+    pendingImport = -1;
+    const CompiledFunction* startFunc = suspendedFunc;
+    suspendedFunc = nullptr;
+    return execute(startFunc, 0, 0, 0);
+}
 
-    callStack.pop_back();
+void Interpreter::cancel() {
+    if (!suspendedFunc) return;
+    suspendedFunc = nullptr;
+    pendingImport = -1;
+    unwind(0, 0, 0);
 }
 
-void Interpreter::execute(Instruction& instr, StackFrame& frame) {
-    switch (instr.opcode) {
-        case Opcode::I32_CONST:
-            push(WasmValue(std::get<int32_t>(instr.operand)));
-            break;
-        case Opcode::F64_CONST:
-            push(WasmValue(std::get<double>(instr.operand)));
-            break;
-        case Opcode::STRING_CONST: {
-            std::string alias = std::get<std::string>(instr.operand);
-            if (stringHandles.find(alias) == stringHandles.end()) {
-                throw std::runtime_error("Unknown string constant: " + alias);
-            }
-            push(WasmValue(stringHandles[alias]));
-            break;
-        }
-        case Opcode::I32_ADD: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a + b));
-            break;
-        }
-            case Opcode::I32_SUB: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a - b));
-            break;
-        }
-        case Opcode::F64_ADD: {
-            double b = pop().f64;
-            double a = pop().f64;
-            push(WasmValue(a + b));
-            break;
-        }
-        case Opcode::F64_SUB: {
-            double b = pop().f64;
-            double a = pop().f64;
-            push(WasmValue(a - b));
-            break;
+void Interpreter::setFuel(uint64_t units) {
+    fuel = (int64_t)std::min<uint64_t>(units, INT64_MAX);
+    fuelMetered = true;
+}
+
+void Interpreter::clearFuel() {
+    fuel = INT64_MAX;
+    fuelMetered = false;
+}
+
+WasmValue Interpreter::execute(const CompiledFunction* startFunc, size_t baseHeight, size_t baseDepth,
+                               size_t profileDepth) {
+    ShadowScope sampled(shadow.get());
+    try {
+        // runFrame leaves a frame with its state synced when the fuel runs
+        // out or a host call is pending
+        while (callStack.size() > baseDepth && fuel >= 0 && pendingImport < 0) {
+            if (callStack.back().func->validated) {
+                runFrame<false>();
+            } else {
+                runFrame<true>();
+            }
         }
-        case Opcode::F64_MUL: {
-            double b = pop().f64;
-            double a = pop().f64;
-            push(WasmValue(a * b));
-            break;
+    } catch (...) {
+        unwind(baseHeight, baseDepth, profileDepth);
+        throw;
+    }
+
+    if (pendingImport >= 0) {
+        if (baseDepth == 0) {
+            suspendedFunc = startFunc;
+            return WasmValue::pending();
         }
-        case Opcode::F64_DIV: {
-            double b = pop().f64;
-            double a = pop().f64;
-            push(WasmValue(a / b));
-            break;
+        const Import& imp = compiled->module().imports[pendingImport];
+        pendingImport = -1;
+        unwind(baseHeight, baseDepth, profileDepth);
+        throw std::runtime_error("Host call " + imp.module + "." + imp.field +
+                                 " cannot be pending inside a nested run");
+    }
+    if (callStack.size() > baseDepth) {
+        if (baseDepth == 0) {
+            suspendedFunc = startFunc;
+            throw FuelExhausted(true);
         }
-        case Opcode::LOCAL_GET: {
-            std::string id = std::get<std::string>(instr.operand);
-            int idx = resolveLocal(id, frame.func);
-            push(frame.locals[idx]);
-            break;
+        unwind(baseHeight, baseDepth, profileDepth);
+        throw FuelExhausted(false);
+    }
+
+    // Host boundary: the result is tagged from the function's signature
+    WasmValue res;
+    if (stackTop > baseHeight && startFunc->hasResult) {
+            res = valueStack[stackTop - 1].tagged(tagFor(startFunc->source->resultTypes[0]));
+    }
+    stackTop = baseHeight;
+    return res;
+}
+
+void Interpreter::unwind(size_t baseHeight, size_t baseDepth, [[maybe_unused]] size_t profileDepth) {
+#ifdef OPTRICH_PROFILE
+    if (profiler) profiler->unwind(profileDepth);
+#endif
+    callStack.resize(baseDepth);
+    if (shadow) shadow->depth.store((uint32_t)baseDepth);
+    stackTop = baseHeight;
+    while (!memoPending.empty() && memoPending.back().depth > baseDepth) {
+        memoKeys.resize(memoPending.back().keyOffset);
+        memoPending.pop_back();
+    }
+}
+
+void Interpreter::push(Slot v) {
+    if (stackTop == valueStack.size()) valueStack.resize(valueStack.size() * 2 + 64);
+    valueStack[stackTop++] = v;
+}
+
+void Interpreter::handleReturn() {
+#ifdef OPTRICH_PROFILE
+    if (profiler) profiler->exitFunction();
+#endif
+    if (shadow) shadow->pop();
+    const StackFrame& frame = callStack.back();
+    if (frame.func->hasResult) {
+        uint32_t n = frame.func->resultSlots;
+        if (stackTop < frame.locals + frame.func->numLocals + n) throw std::runtime_error("Stack underflow");
+        // The result replaces the frame, arguments included
+        std::copy(valueStack.begin() + stackTop - n, valueStack.begin() + stackTop, valueStack.begin() + frame.locals);
+        stackTop = frame.locals + n;
+    } else {
+        stackTop = frame.locals;
+    }
+    if (!memoPending.empty() && memoPending.back().depth == callStack.size()) {
+        const PendingMemo& pending = memoPending.back();
+        MemoTable& table = *pending.table;
+        std::copy(memoKeys.begin() + pending.keyOffset, memoKeys.begin() + pending.keyOffset + table.keySlots,
+                  table.keys.begin() + pending.entry * table.keySlots);
+        std::copy(valueStack.begin() + frame.locals, valueStack.begin() + frame.locals + table.resultSlots,
+                  table.results.begin() + pending.entry * table.resultSlots);
+        table.used[pending.entry] = 1;
+        memoKeys.resize(pending.keyOffset);
+        memoPending.pop_back();
+    }
+    callStack.pop_back();
+}
+
+bool Interpreter::memoLookup(MemoTable& table) {
+    const Slot* args = valueStack.data() + stackTop - table.keySlots;
+    uint64_t hash = 0x9e3779b97f4a7c15ull;
+    for (uint32_t i = 0; i < table.keySlots; ++i) {
+        hash = (hash ^ ((uint64_t)args[i].i64 & table.keyBits[i])) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+    size_t entry = hash & table.mask;
+
+    if (table.used[entry]) {
+        const Slot* key = table.keys.data() + entry * table.keySlots;
+        bool same = true;
+        for (uint32_t i = 0; i < table.keySlots && same; ++i) {
+            same = (((uint64_t)key[i].i64 ^ (uint64_t)args[i].i64) & table.keyBits[i]) == 0;
         }
-        case Opcode::LOCAL_SET: {
-            std::string id = std::get<std::string>(instr.operand);
-            int idx = resolveLocal(id, frame.func);
-            frame.locals[idx] = pop();
-            break;
+        if (same) {
+            // The result replaces the arguments, as a return would leave it
+            table.stats.hits++;
+            size_t base = stackTop - table.keySlots;
+            if (base + table.resultSlots > valueStack.size()) valueStack.resize(base + table.resultSlots);
+            std::copy(table.results.begin() + entry * table.resultSlots,
+                      table.results.begin() + (entry + 1) * table.resultSlots, valueStack.begin() + base);
+            stackTop = base + table.resultSlots;
+            return true;
         }
-        case Opcode::CALL: {
-            std::string funcName = std::get<std::string>(instr.operand);
+    }
+    table.stats.misses++;
+    memoPending.push_back({callStack.size() + 1, &table, entry, memoKeys.size()});
+    memoKeys.insert(memoKeys.end(), args, args + table.keySlots);
+    return false;
+}
 
-            if (hostFuncs.count(funcName)) {
-                auto& entry = hostFuncs[funcName];
-                int arity = entry.arity;
+void Interpreter::callFunction(int32_t funcIndex) {
+    const CompiledFunction* callee = &compiled->function(funcIndex);
+    fuel -= 1; // Checked by the run loop before the callee starts
+    if (!memo.empty() && memo[funcIndex] && memoLookup(*memo[funcIndex])) return;
+#ifdef OPTRICH_PROFILE
+    if (profiler) profiler->enterFunction(funcIndex);
+#endif
+    if (shadow) {
+        if (!callStack.empty()) shadow->setPc((uint32_t)callStack.back().pc); // The call site
+        shadow->push(funcIndex);
+    }
 
-                std::vector<WasmValue> args;
-                for(int i=0; i<arity; ++i) args.push_back(WasmValue());
-                for(int i=arity-1; i>=0; --i) args[i] = pop();
+    StackFrame newFrame;
+    newFrame.func = callee;
+    newFrame.pc = 0;
+    // Arguments are already in order on the value stack and become the
+    // first locals in place
+    newFrame.locals = stackTop - callee->numParams;
 
-                WasmValue res = entry.func(args);
-                if (res.type != WasmValue::VOID) push(res);
+    // Validated code gets its whole frame now and never checks again;
+    // checked code grows the stack on demand
+    size_t frameEnd = newFrame.locals + callee->numLocals + callee->maxStackDepth;
+    if (frameEnd > valueStack.size()) {
+        valueStack.resize(std::max(frameEnd, valueStack.size() * 2));
+    }
+    std::fill(valueStack.begin() + stackTop, valueStack.begin() + newFrame.locals + callee->numLocals,
+              Slot()); // Locals start zeroed
+    stackTop = newFrame.locals + callee->numLocals;
 
-            } else if (funcMap.count(funcName)) {
-                size_t idx = funcMap[funcName];
-                Function* callee = &module.functions[idx];
+    callStack.push_back(newFrame);
+}
 
-                StackFrame newFrame;
-                newFrame.func = callee;
-                newFrame.pc = 0;
-                newFrame.returnHeight = valueStack.size() - callee->paramTypes.size();
+// Runs the innermost frame until it calls, returns or traps. With Checked
+// set every pop is checked against the frame's operand base and every push
+// against the end of the stack; validated functions run with Checked off,
+// relying on the Validator's guarantees and their preallocated frame.
+template <bool Checked>
+void Interpreter::runFrame() {
+    StackFrame& frame = callStack.back();
+    const CompiledFunction* func = frame.func;
+    const CompiledInstr* code = func->code.data();
+    const size_t codeSize = func->code.size();
+    size_t pc = frame.pc;
+    const size_t localsIndex = frame.locals;
+    GuestStackShadow* const sampled = shadow.get();
 
-                size_t nargs = callee->paramTypes.size();
-                std::vector<WasmValue> args(nargs);
-                for(int i = nargs-1; i>=0; --i) {
-                    args[i] = pop();
-                }
-                for(auto& a : args) newFrame.locals.push_back(a);
+    Slot* locals = valueStack.data() + localsIndex;
+    Slot* base = locals + func->numLocals;
+    Slot* sp = valueStack.data() + stackTop;
+    // Kept local so stack stores cannot alias it; sync() writes it back, so
+    // a trap does not charge what the frame spent since it was last entered
+    int64_t fuelLeft = fuel;
 
-                for(const auto& lt : callee->localTypes) {
-                    (void)lt;
-                    newFrame.locals.push_back(WasmValue((int32_t)0));
-                }
+    // Pointers into valueStack are re-derived whenever it may have moved
+    auto reload = [&]() {
+        locals = valueStack.data() + localsIndex;
+        base = locals + func->numLocals;
+        sp = valueStack.data() + stackTop;
+    };
+    // Publishes pc and stack height before anything that leaves this frame
+    auto sync = [&]() {
+        callStack.back().pc = pc;
+        stackTop = sp - valueStack.data();
+        fuel = fuelLeft;
+    };
+    auto pop = [&]() -> Slot {
+        if (Checked && sp == base) throw std::runtime_error("Stack underflow");
+        return *--sp;
+    };
+    auto push = [&](Slot v) {
+        if (Checked && sp == valueStack.data() + valueStack.size()) {
+            stackTop = sp - valueStack.data();
+            valueStack.resize(valueStack.size() * 2 + 64);
+            reload();
+        }
+        *sp++ = v;
+    };
+    // A v128 is two slots, low half first
+    auto popV128 = [&]() -> V128 {
+        Slot hi = pop();
+        Slot lo = pop();
+        V128 v;
+        std::memcpy(v.bytes, &lo, 8);
+        std::memcpy(v.bytes + 8, &hi, 8);
+        return v;
+    };
+    auto pushV128 = [&](const V128& v) {
+        Slot lo, hi;
+        std::memcpy(&lo, v.bytes, 8);
+        std::memcpy(&hi, v.bytes + 8, 8);
+        push(lo);
+        push(hi);
+    };
+    // Charges a taken branch from 'from' (the pc after the branch) to pc.
+    // True when the fuel ran out on a back-edge; the caller syncs and leaves
+    // the frame, which then resumes at the branch target.
+    auto outOfFuel = [&](size_t from) {
+        return __builtin_expect(pc < from && (fuelLeft -= (int64_t)(from - pc)) < 0, 0);
+    };
+    auto unaryV128 = [&](V128 (*op)(const V128&)) { pushV128(op(popV128())); };
+    auto binaryV128 = [&](V128 (*op)(const V128&, const V128&)) {
+        V128 b = popV128();
+        V128 a = popV128();
+        pushV128(op(a, b));
+    };
 
-                callStack.push_back(newFrame);
-            } else {
-                throw std::runtime_error("Unknown function: " + funcName);
-            }
-            break;
+    while (true) {
+        if (Checked && pc >= codeSize) {
+            sync();
+            handleReturn();
+            return;
         }
-        case Opcode::CALL_INDIRECT: {
-            // Operand is the TYPE name
-            std::string typeName = std::get<std::string>(instr.operand);
-            int32_t idx = pop().i32;
-
-            if (idx < 0 || idx >= (int32_t)table.size()) {
-                throw std::runtime_error("Undefined table index: " + std::to_string(idx));
-            }
-            std::string funcName = table[idx];
-            if (funcName.empty()) {
-                throw std::runtime_error("Uninitialized table element at index " + std::to_string(idx));
-            }
-
-            // Resolve Type
-            Type* expectedType = resolveType(typeName);
-            if (!expectedType) {
-                 throw std::runtime_error("Unknown type: " + typeName);
-            }
-
-            // Check if function exists
-            if (funcMap.count(funcName)) {
-                 size_t fIdx = funcMap[funcName];
-                 Function* callee = &module.functions[fIdx];
-
-                 // Check Signature
-                 if (callee->paramTypes != expectedType->paramTypes) {
-                     throw std::runtime_error("Indirect call signature mismatch (params)");
-                 }
-                 if (callee->resultTypes != expectedType->resultTypes) {
-                     throw std::runtime_error("Indirect call signature mismatch (results)");
-                 }
-
-                 // Perform Call
-                 StackFrame newFrame;
-                 newFrame.func = callee;
-                 newFrame.pc = 0;
-                 newFrame.returnHeight = valueStack.size() - callee->paramTypes.size();
-
-                 size_t nargs = callee->paramTypes.size();
-                 std::vector<WasmValue> args(nargs);
-                 for(int i = nargs-1; i>=0; --i) {
-                     args[i] = pop();
-                 }
-                 for(auto& a : args) newFrame.locals.push_back(a);
-
-                 for(const auto& lt : callee->localTypes) {
-                     (void)lt;
-                     newFrame.locals.push_back(WasmValue((int32_t)0));
-                 }
-                 callStack.push_back(newFrame);
-            } else {
-                 throw std::runtime_error("Unknown function in table: " + funcName);
+        const CompiledInstr& instr = code[pc++];
+#ifdef OPTRICH_PROFILE
+        if (profiler) profiler->countOpcode(instr.opcode);
+#endif
+
+        switch (instr.opcode) {
+            case Opcode::I32_CONST:
+                push(Slot(instr.i32));
+                break;
+            case Opcode::I64_CONST:
+                push(Slot(instr.i64));
+                break;
+            case Opcode::F32_CONST:
+                push(Slot(instr.f32));
+                break;
+            case Opcode::F64_CONST:
+                push(Slot(instr.f64));
+                break;
+            case Opcode::STRING_CONST:
+                push(Slot(stringHandles[instr.index]));
+                break;
+            case Opcode::I32_ADD: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a + b));
+                break;
             }
-            break;
-        }
-        case Opcode::I32_EQ: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a == b ? 1 : 0));
-            break;
-        }
-        case Opcode::I32_NE: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a != b ? 1 : 0));
-            break;
-        }
-        case Opcode::I32_LT_S: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a < b ? 1 : 0));
-            break;
-        }
-        case Opcode::I32_GT_S: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a > b ? 1 : 0));
-            break;
-        }
-        case Opcode::I32_LE_S: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a <= b ? 1 : 0));
-            break;
-        }
-        case Opcode::I32_GE_S: {
-            int32_t b = pop().i32;
-            int32_t a = pop().i32;
-            push(WasmValue(a >= b ? 1 : 0));
-            break;
-        }
-        case Opcode::BLOCK:
-        case Opcode::LOOP:
-        case Opcode::END:
-            break;
-        case Opcode::BR:
-        case Opcode::BR_IF: {
-            bool shouldJump = true;
-            if (instr.opcode == Opcode::BR_IF) {
-                int32_t cond = pop().i32;
-                if (cond == 0) shouldJump = false;
-            }
-
-            if (shouldJump) {
-                std::string label = std::get<std::string>(instr.operand);
-                int scanPC = frame.pc - 1;
-                bool found = false;
-                while (scanPC >= 0) {
-                    Instruction& scanInstr = frame.func->body[scanPC];
-                    if (scanInstr.opcode == Opcode::LOOP &&
-                        std::holds_alternative<std::string>(scanInstr.operand) &&
-                        std::get<std::string>(scanInstr.operand) == label) {
-                        frame.pc = scanPC;
-                        found = true;
-                        break;
+            case Opcode::I32_SUB: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a - b));
+                break;
+            }
+            case Opcode::I32_MUL: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)(a * b)));
+                break;
+            }
+            case Opcode::I32_DIV_S: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                if (b == 0) throw std::runtime_error("Integer divide by zero");
+                if (a == INT32_MIN && b == -1) throw std::runtime_error("Integer overflow");
+                push(Slot(a / b));
+                break;
+            }
+            case Opcode::I32_DIV_U: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                if (b == 0) throw std::runtime_error("Integer divide by zero");
+                push(Slot((int32_t)(a / b)));
+                break;
+            }
+            case Opcode::I32_REM_S: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                if (b == 0) throw std::runtime_error("Integer divide by zero");
+                push(Slot(b == -1 ? 0 : a % b));
+                break;
+            }
+            case Opcode::I32_REM_U: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                if (b == 0) throw std::runtime_error("Integer divide by zero");
+                push(Slot((int32_t)(a % b)));
+                break;
+            }
+            case Opcode::I32_AND: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a & b));
+                break;
+            }
+            case Opcode::I32_OR: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a | b));
+                break;
+            }
+            case Opcode::I32_XOR: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a ^ b));
+                break;
+            }
+            case Opcode::I32_SHL: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)(a << (b & 31))));
+                break;
+            }
+            case Opcode::I32_SHR_S: {
+                uint32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a >> (b & 31)));
+                break;
+            }
+            case Opcode::I32_SHR_U: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)(a >> (b & 31))));
+                break;
+            }
+            case Opcode::I32_ROTL: {
+                uint32_t b = pop().i32 & 31;
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)((a << b) | (a >> ((32 - b) & 31)))));
+                break;
+            }
+            case Opcode::I32_ROTR: {
+                uint32_t b = pop().i32 & 31;
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)((a >> b) | (a << ((32 - b) & 31)))));
+                break;
+            }
+            case Opcode::I32_CLZ: {
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)(a == 0 ? 32 : __builtin_clz(a))));
+                break;
+            }
+            case Opcode::I32_CTZ: {
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)(a == 0 ? 32 : __builtin_ctz(a))));
+                break;
+            }
+            case Opcode::I32_POPCNT: {
+                uint32_t a = pop().i32;
+                push(Slot((int32_t)__builtin_popcount(a)));
+                break;
+            }
+            case Opcode::F64_ADD: {
+                double b = pop().f64;
+                double a = pop().f64;
+                push(Slot(a + b));
+                break;
+            }
+            case Opcode::F64_SUB: {
+                double b = pop().f64;
+                double a = pop().f64;
+                push(Slot(a - b));
+                break;
+            }
+            case Opcode::F64_MUL: {
+                double b = pop().f64;
+                double a = pop().f64;
+                push(Slot(a * b));
+                break;
+            }
+            case Opcode::F64_DIV: {
+                double b = pop().f64;
+                double a = pop().f64;
+                push(Slot(a / b));
+                break;
+            }
+            case Opcode::I32_EQZ: {
+                int32_t a = pop().i32;
+                push(Slot(a == 0 ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_EQ: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a == b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_NE: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a != b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_LT_S: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a < b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_LT_U: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                push(Slot(a < b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_GT_U: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                push(Slot(a > b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_LE_U: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                push(Slot(a <= b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_GE_U: {
+                uint32_t b = pop().i32;
+                uint32_t a = pop().i32;
+                push(Slot(a >= b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_GT_S: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a > b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_LE_S: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a <= b ? 1 : 0));
+                break;
+            }
+            case Opcode::I32_GE_S: {
+                int32_t b = pop().i32;
+                int32_t a = pop().i32;
+                push(Slot(a >= b ? 1 : 0));
+                break;
+            }
+            case Opcode::LOCAL_GET:
+                push(locals[instr.index]);
+                break;
+            case Opcode::LOCAL_SET:
+                locals[instr.index] = pop();
+                break;
+            case Opcode::LOCAL_TEE:
+                if (Checked && sp == base) throw std::runtime_error("Stack underflow");
+                locals[instr.index] = sp[-1];
+                break;
+            case Opcode::LOCAL_GET_WIDE:
+                push(locals[instr.index]);
+                push(locals[instr.index + 1]);
+                break;
+            case Opcode::LOCAL_SET_WIDE:
+                locals[instr.index + 1] = pop();
+                locals[instr.index] = pop();
+                break;
+            case Opcode::LOCAL_TEE_WIDE:
+                if (Checked && sp - base < 2) throw std::runtime_error("Stack underflow");
+                locals[instr.index] = sp[-2];
+                locals[instr.index + 1] = sp[-1];
+                break;
+            case Opcode::V128_CONST:
+                pushV128(func->constants[instr.index]);
+                break;
+            case Opcode::V128_LOAD: {
+                int32_t offset = pop().i32;
+                int32_t handle = pop().i32;
+                pushV128(store.read<V128>(handle, offset));
+                break;
+            }
+            case Opcode::V128_STORE: {
+                V128 v = popV128();
+                int32_t offset = pop().i32;
+                int32_t handle = pop().i32;
+                store.write<V128>(handle, offset, v);
+                break;
+            }
+            case Opcode::V128_NOT: unaryV128(simd::v128Not); break;
+            case Opcode::V128_AND: binaryV128(simd::v128And); break;
+            case Opcode::V128_ANDNOT: binaryV128(simd::v128AndNot); break;
+            case Opcode::V128_OR: binaryV128(simd::v128Or); break;
+            case Opcode::V128_XOR: binaryV128(simd::v128Xor); break;
+            case Opcode::I32X4_SPLAT:
+                pushV128(simd::splat<int32_t>(pop().i32));
+                break;
+            case Opcode::I32X4_EXTRACT_LANE:
+                push(Slot(simd::extractLane<int32_t>(popV128(), instr.i32)));
+                break;
+            case Opcode::I32X4_REPLACE_LANE: {
+                int32_t lane = pop().i32;
+                pushV128(simd::replaceLane<int32_t>(popV128(), instr.i32, lane));
+                break;
+            }
+            case Opcode::I32X4_ADD: binaryV128(simd::i32x4Add); break;
+            case Opcode::I32X4_SUB: binaryV128(simd::i32x4Sub); break;
+            case Opcode::I32X4_MUL: binaryV128(simd::i32x4Mul); break;
+            case Opcode::I32X4_NEG: unaryV128(simd::i32x4Neg); break;
+            case Opcode::I32X4_MIN_S: binaryV128(simd::i32x4MinS); break;
+            case Opcode::I32X4_MAX_S: binaryV128(simd::i32x4MaxS); break;
+            case Opcode::I32X4_EQ: binaryV128(simd::i32x4Eq); break;
+            case Opcode::I32X4_NE: binaryV128(simd::i32x4Ne); break;
+            case Opcode::I32X4_LT_S: binaryV128(simd::i32x4LtS); break;
+            case Opcode::I32X4_LT_U: binaryV128(simd::i32x4LtU); break;
+            case Opcode::I32X4_GT_S: binaryV128(simd::i32x4GtS); break;
+            case Opcode::I32X4_GT_U: binaryV128(simd::i32x4GtU); break;
+            case Opcode::I32X4_LE_S: binaryV128(simd::i32x4LeS); break;
+            case Opcode::I32X4_GE_S: binaryV128(simd::i32x4GeS); break;
+            case Opcode::F32X4_SPLAT:
+                pushV128(simd::splat<float>(pop().f32));
+                break;
+            case Opcode::F32X4_EXTRACT_LANE:
+                push(Slot(simd::extractLane<float>(popV128(), instr.i32)));
+                break;
+            case Opcode::F32X4_REPLACE_LANE: {
+                float lane = pop().f32;
+                pushV128(simd::replaceLane<float>(popV128(), instr.i32, lane));
+                break;
+            }
+            case Opcode::F32X4_ADD: binaryV128(simd::f32x4Add); break;
+            case Opcode::F32X4_SUB: binaryV128(simd::f32x4Sub); break;
+            case Opcode::F32X4_MUL: binaryV128(simd::f32x4Mul); break;
+            case Opcode::F32X4_DIV: binaryV128(simd::f32x4Div); break;
+            case Opcode::F32X4_NEG: unaryV128(simd::f32x4Neg); break;
+            case Opcode::F32X4_ABS: unaryV128(simd::f32x4Abs); break;
+            case Opcode::F32X4_SQRT: unaryV128(simd::f32x4Sqrt); break;
+            case Opcode::F32X4_EQ: binaryV128(simd::f32x4Eq); break;
+            case Opcode::F32X4_NE: binaryV128(simd::f32x4Ne); break;
+            case Opcode::F32X4_LT: binaryV128(simd::f32x4Lt); break;
+            case Opcode::F32X4_GT: binaryV128(simd::f32x4Gt); break;
+            case Opcode::F32X4_LE: binaryV128(simd::f32x4Le); break;
+            case Opcode::F32X4_GE: binaryV128(simd::f32x4Ge); break;
+            case Opcode::F64X2_SPLAT:
+                pushV128(simd::splat<double>(pop().f64));
+                break;
+            case Opcode::F64X2_EXTRACT_LANE:
+                push(Slot(simd::extractLane<double>(popV128(), instr.i32)));
+                break;
+            case Opcode::F64X2_REPLACE_LANE: {
+                double lane = pop().f64;
+                pushV128(simd::replaceLane<double>(popV128(), instr.i32, lane));
+                break;
+            }
+            case Opcode::F64X2_ADD: binaryV128(simd::f64x2Add); break;
+            case Opcode::F64X2_SUB: binaryV128(simd::f64x2Sub); break;
+            case Opcode::F64X2_MUL: binaryV128(simd::f64x2Mul); break;
+            case Opcode::F64X2_DIV: binaryV128(simd::f64x2Div); break;
+            case Opcode::F64X2_NEG: unaryV128(simd::f64x2Neg); break;
+            case Opcode::F64X2_ABS: unaryV128(simd::f64x2Abs); break;
+            case Opcode::F64X2_SQRT: unaryV128(simd::f64x2Sqrt); break;
+            case Opcode::F64X2_EQ: binaryV128(simd::f64x2Eq); break;
+            case Opcode::F64X2_NE: binaryV128(simd::f64x2Ne); break;
+            case Opcode::F64X2_LT: binaryV128(simd::f64x2Lt); break;
+            case Opcode::F64X2_GT: binaryV128(simd::f64x2Gt); break;
+            case Opcode::F64X2_LE: binaryV128(simd::f64x2Le); break;
+            case Opcode::F64X2_GE: binaryV128(simd::f64x2Ge); break;
+            case Opcode::GLOBAL_GET:
+                push(Slot::of(globals[instr.index]));
+                break;
+            case Opcode::GLOBAL_SET:
+                // Keeps the global's tag; only the payload changes
+                globals[instr.index].i64 = pop().i64;
+                break;
+            case Opcode::CALL: {
+                int32_t idx = instr.index;
+                int32_t numImports = (int32_t)compiled->importCount();
+
+                if (idx < numImports) {
+                    auto& entry = hostFuncs[idx];
+                    if (!entry.func) {
+                        const Import& imp = compiled->module().imports[idx];
+                        throw std::runtime_error("Unknown function: " + imp.module + "." + imp.field);
                     }
-                    scanPC--;
-                }
+                    int arity = entry.arity;
 
-                if (!found) {
-                    scanPC = frame.pc - 1;
-                    int blockPC = -1;
-                    while (scanPC >= 0) {
-                         Instruction& scanInstr = frame.func->body[scanPC];
-                         if (scanInstr.opcode == Opcode::BLOCK &&
-                            std::holds_alternative<std::string>(scanInstr.operand) &&
-                            std::get<std::string>(scanInstr.operand) == label) {
-                             blockPC = scanPC;
-                             break;
-                         }
-                         scanPC--;
+                    // Host boundary: slots get their tags back from the import's signature
+                    std::vector<WasmValue> args(arity);
+                    for(int i=arity-1; i>=0; --i) args[i] = pop().tagged(entry.paramTags[i]);
+
+                    // The host may re-enter this instance and move the stack
+                    sync();
+#ifdef OPTRICH_PROFILE
+                    uint64_t hostStart = profiler ? Profiler::now() : 0;
+#endif
+                    WasmValue res = entry.func(args);
+#ifdef OPTRICH_PROFILE
+                    if (profiler) profiler->hostCall(idx, Profiler::now() - hostStart);
+#endif
+                    reload();
+                    fuelLeft = fuel; // Nested runs spend from the same budget
+                    if (res.type == WasmValue::PENDING) {
+                        // Already synced past the call; resume(result) pushes the result
+                        pendingImport = idx;
+                        return;
                     }
+                    if (Checked ? res.type != WasmValue::VOID : !entry.resultTypes.empty()) push(Slot::of(res));
+                } else {
+                    const CompiledFunction& callee = compiled->function(idx - numImports);
+                    if (Checked && (size_t)(sp - base) < callee.numParams) throw std::runtime_error("Stack underflow");
+                    sync();
+                    callFunction(idx - numImports);
+                    return;
+                }
+                break;
+            }
+            case Opcode::CALL_INDIRECT: {
+                // Index is the interned signature of the expected type
+                int32_t idx = pop().i32;
 
-                    if (blockPC != -1) {
-                        int depth = 0;
-                        int forwardPC = blockPC;
-                        while (forwardPC < (int)frame.func->body.size()) {
-                            Instruction& fInstr = frame.func->body[forwardPC];
-                            if (fInstr.opcode == Opcode::BLOCK || fInstr.opcode == Opcode::LOOP) {
-                                depth++;
-                            } else if (fInstr.opcode == Opcode::END) {
-                                depth--;
-                                if (depth == 0) {
-                                    frame.pc = forwardPC + 1;
-                                    found = true;
-                                    break;
-                                }
-                            }
-                            forwardPC++;
-                        }
+                if (idx < 0 || idx >= (int32_t)table.size()) {
+                    throw std::runtime_error("Undefined table index: " + std::to_string(idx));
+                }
+                int32_t funcIndex = table[idx];
+                if (funcIndex < 0) {
+                    throw std::runtime_error("Uninitialized table element at index " + std::to_string(idx));
+                }
+
+                // Check Signature
+                const CompiledFunction& callee = compiled->function(funcIndex);
+                if (callee.signature != instr.index) {
+                    const Type& expected = compiled->signature(instr.index);
+                    if (callee.source->paramTypes != expected.paramTypes) {
+                        throw std::runtime_error("Indirect call signature mismatch (params)");
                     }
+                    throw std::runtime_error("Indirect call signature mismatch (results)");
                 }
+                if (Checked && (size_t)(sp - base) < callee.numParams) throw std::runtime_error("Stack underflow");
 
-                if (!found) {
-                     throw std::runtime_error("Label not found: " + label);
+                sync();
+                callFunction(funcIndex);
+                return;
+            }
+            case Opcode::UNREACHABLE:
+                throw std::runtime_error("Unreachable executed");
+            case Opcode::RETURN:
+                sync();
+                handleReturn();
+                return;
+            case Opcode::BLOCK:
+            case Opcode::LOOP:
+            case Opcode::END:
+                break;
+            case Opcode::BR: {
+                // Target resolved at compile time; validated code also
+                // drops whatever the target label does not keep
+                size_t from = pc;
+                pc = instr.index;
+                if (!Checked) sp = base + instr.i32;
+                if (sampled) sampled->setPc((uint32_t)pc);
+                if (outOfFuel(from)) {
+                    sync();
+                    return;
+                }
+                break;
+            }
+            case Opcode::BR_IF:
+                if (pop().i32 != 0) {
+                    size_t from = pc;
+                    pc = instr.index;
+                    if (!Checked) sp = base + instr.i32;
+                    if (sampled) sampled->setPc((uint32_t)pc);
+                    if (outOfFuel(from)) {
+                        sync();
+                        return;
+                    }
+                }
+                break;
+            case Opcode::BR_TABLE: {
+                // Out of range indices take the default, the last entry
+                uint32_t i = (uint32_t)pop().i32;
+                if (i > (uint32_t)instr.i32) i = (uint32_t)instr.i32;
+                const BranchTarget& target = func->branchTable[instr.index + i];
+                size_t from = pc;
+                pc = target.pc;
+                if (!Checked) sp = base + target.height;
+                if (sampled) sampled->setPc((uint32_t)pc);
+                if (outOfFuel(from)) {
+                    sync();
+                    return;
                 }
+                break;
             }
-            break;
+            case Opcode::IF:
+                if (pop().i32 == 0) pc = instr.index;
+                break;
+            case Opcode::ELSE:
+                // Reached only at the end of the then-branch
+                pc = instr.index;
+                break;
+            default:
+                break;
         }
-        default:
-            break;
-    }
-}
-
-int Interpreter::resolveLocal(const std::string& id, Function* func) {
-    if (isdigit(id[0])) return std::stoi(id);
-
-    for(size_t i=0; i<func->paramNames.size(); ++i) {
-        if (func->paramNames[i] == id) return i;
-    }
-    for(size_t i=0; i<func->localNames.size(); ++i) {
-        if (func->localNames[i] == id) return func->paramNames.size() + i;
-    }
-    throw std::runtime_error("Unknown local: " + id);
-}
-
-Type* Interpreter::resolveType(const std::string& name) {
-    for (auto& t : module.types) {
-        if (t.name == name) return &t;
     }
-    return nullptr;
 }
@@ -1,7 +1,7 @@
 #include "Lexer.h"
 #include <cctype>
 
-Lexer::Lexer(const std::string& input) : source(input), pos(0) {}
+Lexer::Lexer(std::string_view input) : source(input), pos(0) {}
 
 Token Lexer::next() {
     skipWhitespace();
@@ -9,8 +9,8 @@ Token Lexer::next() {
 
     char c = source[pos];
 
-    if (c == '(') { pos++; return {TokenType::LPAREN, "("}; }
-    if (c == ')') { pos++; return {TokenType::RPAREN, ")"}; }
+    if (c == '(') { pos++; return {TokenType::LPAREN, source.substr(pos - 1, 1)}; }
+    if (c == ')') { pos++; return {TokenType::RPAREN, source.substr(pos - 1, 1)}; }
 
     if (c == '"') return readString();
     if (c == '$') return readIdentifier();
@@ -18,7 +18,7 @@ Token Lexer::next() {
     if (isalpha(c)) return readKeyword();
 
     pos++;
-    return {TokenType::KEYWORD, std::string(1, c)};
+    return {TokenType::KEYWORD, source.substr(pos - 1, 1)};
 }
 
 std::vector<Token> Lexer::tokenize() {
@@ -47,15 +47,16 @@ void Lexer::skipWhitespace() {
 
 Token Lexer::readString() {
     pos++;
-    std::string res;
+    size_t start = pos;
     while (pos < source.length() && source[pos] != '"') {
         if (source[pos] == '\\') {
             pos++;
         }
-        res += source[pos++];
+        pos++;
     }
+    size_t end = pos < source.length() ? pos : source.length();
     if (pos < source.length()) pos++;
-    return {TokenType::STRING, res};
+    return {TokenType::STRING, source.substr(start, end - start)};
 }
 
 Token Lexer::readIdentifier() {
@@ -0,0 +1,468 @@
+#include "Linker.h"
+#include "Parser.h"
+#include <cctype>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+bool isIndex(const std::string& id) {
+    return !id.empty() && isdigit((unsigned char)id[0]);
+}
+
+// A function of the linked program: defined in one of the modules, or a
+// host import
+struct Callee {
+    bool host;
+    size_t id; // Into LinkJob::functions or LinkJob::hosts
+};
+
+// One input module and its symbols
+struct Unit {
+    std::string name; // Import module name; empty for main
+    const Module* mod;
+    size_t firstFunction; // Id of its function 0
+    std::unordered_map<std::string, int32_t> calleeNames; // Wasm function index space
+    std::unordered_map<std::string, int32_t> typeNames;
+    std::unordered_map<std::string, int32_t> stringNames;
+    std::unordered_map<std::string, int32_t> globalNames;
+    // By import index; resolving guards against import cycles
+    std::vector<Callee> imports;
+    std::vector<char> importState; // 0 unresolved, 1 resolving, 2 resolved
+    std::vector<bool> liveTypes, liveStrings, liveGlobals;
+    std::vector<std::string> typeRenames, stringRenames, globalRenames;
+
+    std::string prefix() const { return name.empty() ? "" : name + "."; }
+    std::string label() const { return name.empty() ? "main" : name; }
+};
+
+class LinkJob {
+public:
+    LinkJob(const Module& main, const std::map<std::string, Module>& libraries, LinkStats& stats);
+
+    Module run(const std::vector<std::string>& entryPoints);
+
+private:
+    const std::map<std::string, Module>& libraries;
+    LinkStats& stats;
+    std::vector<Unit> units;
+    std::map<std::string, size_t> unitOf;
+    std::vector<std::pair<size_t, size_t>> functions; // (unit, defined index)
+    std::vector<const Import*> hosts;
+    std::map<std::pair<std::string, std::string>, size_t> hostIds;
+
+    std::vector<bool> liveFunctions, liveHosts;
+    std::vector<std::vector<Instruction>> parsedBodies; // Lazily recorded bodies, by id
+    std::vector<size_t> worklist;
+    std::vector<std::string> functionRenames, hostRenames;
+
+    void addUnit(const std::string& name, const Module& mod);
+
+    int32_t findCallee(const Unit& unit, const std::string& ref) const;
+    int32_t findFunction(const Unit& unit, const std::string& name) const;
+    static int32_t find(const std::unordered_map<std::string, int32_t>& names, const std::string& ref, size_t count);
+    int32_t typeIndex(const Unit& unit, const std::string& ref) const;
+    int32_t stringIndex(const Unit& unit, const std::string& ref) const;
+    int32_t globalIndex(const Unit& unit, const std::string& ref) const;
+
+    Callee callee(size_t unit, int32_t index);
+    Callee resolveImport(size_t unit, size_t index);
+    const std::vector<std::string>& params(const Callee& c) const;
+    const std::vector<std::string>& results(const Callee& c) const;
+
+    const Function& function(size_t id) const { return units[functions[id].first].mod->functions[functions[id].second]; }
+    const std::vector<Instruction>& body(size_t id);
+
+    void markCallee(const Callee& c);
+    void markBody(size_t id);
+    void assignNames();
+    const std::string& nameOf(const Callee& c) const { return c.host ? hostRenames[c.id] : functionRenames[c.id]; }
+    Instruction rewrite(size_t unit, const Instruction& instr);
+};
+
+LinkJob::LinkJob(const Module& main, const std::map<std::string, Module>& libraries, LinkStats& stats)
+    : libraries(libraries), stats(stats) {
+    addUnit("", main);
+    // Libraries are pulled in as imports name them, including each other's
+    for (size_t u = 0; u < units.size(); ++u) {
+        for (const auto& imp : units[u].mod->imports) {
+            auto lib = libraries.find(imp.module);
+            if (lib != libraries.end() && !unitOf.count(imp.module)) addUnit(imp.module, lib->second);
+        }
+    }
+}
+
+void LinkJob::addUnit(const std::string& name, const Module& mod) {
+    unitOf[name] = units.size();
+    units.emplace_back();
+    Unit& unit = units.back();
+    unit.name = name;
+    unit.mod = &mod;
+    unit.firstFunction = functions.size();
+    for (size_t i = 0; i < mod.imports.size(); ++i) {
+        if (!mod.imports[i].alias.empty()) unit.calleeNames.emplace(mod.imports[i].alias, (int32_t)i);
+    }
+    for (size_t i = 0; i < mod.functions.size(); ++i) {
+        if (!mod.functions[i].name.empty()) {
+            unit.calleeNames.emplace(mod.functions[i].name, (int32_t)(mod.imports.size() + i));
+        }
+        functions.push_back({units.size() - 1, i});
+    }
+    for (size_t i = 0; i < mod.types.size(); ++i) unit.typeNames.emplace(mod.types[i].name, (int32_t)i);
+    for (size_t i = 0; i < mod.strings.size(); ++i) unit.stringNames.emplace(mod.strings[i].name, (int32_t)i);
+    for (size_t i = 0; i < mod.globals.size(); ++i) {
+        if (!mod.globals[i].name.empty()) unit.globalNames.emplace(mod.globals[i].name, (int32_t)i);
+    }
+    unit.imports.resize(mod.imports.size());
+    unit.importState.assign(mod.imports.size(), 0);
+    unit.liveTypes.assign(mod.types.size(), false);
+    unit.liveStrings.assign(mod.strings.size(), false);
+    unit.liveGlobals.assign(mod.globals.size(), false);
+}
+
+int32_t LinkJob::find(const std::unordered_map<std::string, int32_t>& names, const std::string& ref, size_t count) {
+    auto it = names.find(ref);
+    if (it != names.end()) return it->second;
+    if (isIndex(ref)) {
+        size_t idx = std::stoul(ref);
+        if (idx < count) return (int32_t)idx;
+    }
+    return -1;
+}
+
+int32_t LinkJob::findCallee(const Unit& unit, const std::string& ref) const {
+    return find(unit.calleeNames, ref, unit.mod->imports.size() + unit.mod->functions.size());
+}
+
+// As Interpreter::run looks up a name: function names, then exports
+int32_t LinkJob::findFunction(const Unit& unit, const std::string& name) const {
+    const Module& mod = *unit.mod;
+    for (size_t i = 0; i < mod.functions.size(); ++i) {
+        if (mod.functions[i].name == name) return (int32_t)(mod.imports.size() + i);
+    }
+    for (const auto& exp : mod.exports) {
+        if (exp.kind == "func" && exp.name == name) return findCallee(unit, exp.target);
+    }
+    return -1;
+}
+
+int32_t LinkJob::typeIndex(const Unit& unit, const std::string& ref) const {
+    int32_t idx = find(unit.typeNames, ref, unit.mod->types.size());
+    if (idx < 0) throw std::runtime_error("Unknown type: " + ref);
+    return idx;
+}
+
+int32_t LinkJob::stringIndex(const Unit& unit, const std::string& ref) const {
+    int32_t idx = find(unit.stringNames, ref, unit.mod->strings.size());
+    if (idx < 0) throw std::runtime_error("Unknown string: " + ref);
+    return idx;
+}
+
+int32_t LinkJob::globalIndex(const Unit& unit, const std::string& ref) const {
+    int32_t idx = find(unit.globalNames, ref, unit.mod->globals.size());
+    if (idx < 0) throw std::runtime_error("Unknown global: " + ref);
+    return idx;
+}
+
+Callee LinkJob::callee(size_t unit, int32_t index) {
+    size_t imports = units[unit].mod->imports.size();
+    if ((size_t)index >= imports) return {false, units[unit].firstFunction + index - imports};
+    return resolveImport(unit, index);
+}
+
+Callee LinkJob::resolveImport(size_t unit, size_t index) {
+    Unit& u = units[unit];
+    if (u.importState[index] == 2) return u.imports[index];
+    const Import& imp = u.mod->imports[index];
+    if (u.importState[index] == 1) throw std::runtime_error("Import cycle through " + imp.module + "." + imp.field);
+    u.importState[index] = 1;
+
+    Callee resolved;
+    auto lib = unitOf.find(imp.module);
+    if (lib == unitOf.end()) {
+        // Stays a host import, one entry for every module that declares it
+        auto key = std::make_pair(imp.module, imp.field);
+        auto it = hostIds.find(key);
+        if (it == hostIds.end()) {
+            it = hostIds.emplace(key, hosts.size()).first;
+            hosts.push_back(&imp);
+        }
+        resolved = {true, it->second};
+    } else {
+        int32_t target = findFunction(units[lib->second], imp.field);
+        if (target < 0) throw std::runtime_error("Unknown function: " + imp.module + "." + imp.field);
+        resolved = callee(lib->second, target);
+        stats.importsResolved++;
+    }
+    if (params(resolved) != imp.paramTypes) {
+        throw std::runtime_error("Import signature mismatch (params) for " + imp.module + "." + imp.field);
+    }
+    if (results(resolved) != imp.resultTypes) {
+        throw std::runtime_error("Import signature mismatch (results) for " + imp.module + "." + imp.field);
+    }
+    units[unit].imports[index] = resolved;
+    units[unit].importState[index] = 2;
+    return resolved;
+}
+
+const std::vector<std::string>& LinkJob::params(const Callee& c) const {
+    return c.host ? hosts[c.id]->paramTypes : function(c.id).paramTypes;
+}
+
+const std::vector<std::string>& LinkJob::results(const Callee& c) const {
+    return c.host ? hosts[c.id]->resultTypes : function(c.id).resultTypes;
+}
+
+const std::vector<Instruction>& LinkJob::body(size_t id) {
+    const Function& func = function(id);
+    if (!func.body.empty() || func.lazyBody.empty()) return func.body;
+    if (parsedBodies[id].empty()) parsedBodies[id] = Parser::parseBody(func.lazyBody);
+    return parsedBodies[id];
+}
+
+void LinkJob::markCallee(const Callee& c) {
+    if (c.host) {
+        liveHosts[c.id] = true;
+    } else if (!liveFunctions[c.id]) {
+        liveFunctions[c.id] = true;
+        worklist.push_back(c.id);
+    }
+}
+
+void LinkJob::markBody(size_t id) {
+    size_t unit = functions[id].first;
+    Unit& u = units[unit];
+    for (const auto& instr : body(id)) {
+        switch (instr.opcode) {
+            case Opcode::CALL: {
+                const std::string& ref = std::get<std::string>(instr.operand);
+                int32_t idx = findCallee(u, ref);
+                if (idx < 0) throw std::runtime_error("Unknown function: " + ref);
+                markCallee(callee(unit, idx));
+                break;
+            }
+            case Opcode::CALL_INDIRECT:
+                u.liveTypes[typeIndex(u, std::get<std::string>(instr.operand))] = true;
+                break;
+            case Opcode::STRING_CONST:
+                u.liveStrings[stringIndex(u, std::get<std::string>(instr.operand))] = true;
+                break;
+            case Opcode::GLOBAL_GET:
+            case Opcode::GLOBAL_SET:
+                u.liveGlobals[globalIndex(u, std::get<std::string>(instr.operand))] = true;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Main's explicit names first, so that they never change, then each
+// library's; generated names only after a module's explicit ones.
+void LinkJob::assignNames() {
+    std::set<std::string> callees, types, strings, globals;
+    auto claim = [](std::set<std::string>& used, const std::string& base) {
+        std::string name = base;
+        for (int n = 2; !used.insert(name).second; ++n) name = base + "#" + std::to_string(n);
+        return name;
+    };
+    functionRenames.resize(functions.size());
+    hostRenames.resize(hosts.size());
+    for (auto& u : units) {
+        const Module& mod = *u.mod;
+        std::string prefix = u.prefix();
+        u.typeRenames.resize(mod.types.size());
+        u.stringRenames.resize(mod.strings.size());
+        u.globalRenames.resize(mod.globals.size());
+        for (bool generated : {false, true}) {
+            for (size_t i = 0; i < mod.imports.size(); ++i) {
+                const Callee& c = u.imports[i];
+                if (u.importState[i] != 2 || !c.host || !liveHosts[c.id] || !hostRenames[c.id].empty()) continue;
+                const Import& imp = mod.imports[i];
+                if (imp.alias.empty() != generated) continue;
+                hostRenames[c.id] = claim(callees, generated ? imp.module + "." + imp.field : prefix + imp.alias);
+            }
+            for (size_t i = 0; i < mod.functions.size(); ++i) {
+                size_t id = u.firstFunction + i;
+                if (!liveFunctions[id] || mod.functions[i].name.empty() != generated) continue;
+                functionRenames[id] = claim(callees, prefix + (generated ? "f" + std::to_string(i) : mod.functions[i].name));
+            }
+            for (size_t i = 0; i < mod.types.size(); ++i) {
+                if (!u.liveTypes[i] || mod.types[i].name.empty() != generated) continue;
+                u.typeRenames[i] = claim(types, prefix + (generated ? "t" + std::to_string(i) : mod.types[i].name));
+            }
+            for (size_t i = 0; i < mod.strings.size(); ++i) {
+                if (!u.liveStrings[i] || mod.strings[i].name.empty() != generated) continue;
+                u.stringRenames[i] = claim(strings, prefix + (generated ? "s" + std::to_string(i) : mod.strings[i].name));
+            }
+            for (size_t i = 0; i < mod.globals.size(); ++i) {
+                if (!u.liveGlobals[i] || mod.globals[i].name.empty() != generated) continue;
+                u.globalRenames[i] = claim(globals, prefix + (generated ? "g" + std::to_string(i) : mod.globals[i].name));
+            }
+        }
+    }
+}
+
+Instruction LinkJob::rewrite(size_t unit, const Instruction& instr) {
+    const Unit& u = units[unit];
+    Instruction out = instr;
+    switch (instr.opcode) {
+        case Opcode::CALL:
+            out.operand = nameOf(callee(unit, findCallee(u, std::get<std::string>(instr.operand))));
+            break;
+        case Opcode::CALL_INDIRECT:
+            out.operand = u.typeRenames[typeIndex(u, std::get<std::string>(instr.operand))];
+            break;
+        case Opcode::STRING_CONST:
+            out.operand = u.stringRenames[stringIndex(u, std::get<std::string>(instr.operand))];
+            break;
+        case Opcode::GLOBAL_GET:
+        case Opcode::GLOBAL_SET:
+            out.operand = u.globalRenames[globalIndex(u, std::get<std::string>(instr.operand))];
+            break;
+        default:
+            break;
+    }
+    return out;
+}
+
+Module LinkJob::run(const std::vector<std::string>& entryPoints) {
+    liveFunctions.assign(functions.size(), false);
+    parsedBodies.resize(functions.size());
+
+    // call_indirect addresses table 0, so only one module may bring a table
+    size_t tableUnit = units.size();
+    for (size_t u = 0; u < units.size(); ++u) {
+        if (units[u].mod->tables.empty() && units[u].mod->elements.empty()) continue;
+        if (tableUnit != units.size()) {
+            throw std::runtime_error("Cannot link the tables of both " + units[tableUnit].label() + " and " +
+                                     units[u].label());
+        }
+        tableUnit = u;
+    }
+
+    // Every import resolves, even if nothing reachable calls it, so that a
+    // broken library is reported the same whatever main uses
+    for (size_t u = 0; u < units.size(); ++u) {
+        for (size_t i = 0; i < units[u].mod->imports.size(); ++i) resolveImport(u, i);
+    }
+    liveHosts.assign(hosts.size(), false);
+
+    // Roots: main's exports, the entry points and table elements
+    Unit& main = units[0];
+    for (const auto& exp : main.mod->exports) {
+        if (exp.kind == "func") {
+            int32_t idx = findCallee(main, exp.target);
+            if (idx < 0) throw std::runtime_error("Unknown function in export: " + exp.target);
+            markCallee(callee(0, idx));
+        } else if (exp.kind == "global") {
+            main.liveGlobals[globalIndex(main, exp.target)] = true;
+        }
+    }
+    for (const auto& name : entryPoints) {
+        int32_t idx = findFunction(main, name);
+        if (idx < 0) throw std::runtime_error("Function not found: " + name);
+        markCallee(callee(0, idx));
+    }
+    if (tableUnit != units.size()) {
+        for (const auto& elem : units[tableUnit].mod->elements) {
+            for (const auto& name : elem.functionNames) {
+                int32_t idx = findCallee(units[tableUnit], name);
+                if (idx < 0) throw std::runtime_error("Unknown function in table: " + name);
+                markCallee(callee(tableUnit, idx));
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        size_t id = worklist.back();
+        worklist.pop_back();
+        markBody(id);
+    }
+
+    assignNames();
+
+    Module out;
+    for (size_t h = 0; h < hosts.size(); ++h) {
+        if (!liveHosts[h]) {
+            stats.importsDropped++;
+            continue;
+        }
+        Import imp = *hosts[h];
+        imp.alias = hostRenames[h];
+        out.imports.push_back(std::move(imp));
+    }
+    for (size_t u = 0; u < units.size(); ++u) {
+        const Unit& unit = units[u];
+        const Module& mod = *unit.mod;
+        for (size_t i = 0; i < mod.functions.size(); ++i) {
+            size_t id = unit.firstFunction + i;
+            if (!liveFunctions[id]) {
+                stats.functionsDropped++;
+                continue;
+            }
+            Function func = mod.functions[i];
+            func.name = functionRenames[id];
+            func.body.clear();
+            func.lazyBody = {};
+            for (const auto& instr : body(id)) func.body.push_back(rewrite(u, instr));
+            out.functions.push_back(std::move(func));
+            stats.functionsKept++;
+        }
+        for (size_t i = 0; i < mod.types.size(); ++i) {
+            if (!unit.liveTypes[i]) {
+                stats.typesDropped++;
+                continue;
+            }
+            out.types.push_back(mod.types[i]);
+            out.types.back().name = unit.typeRenames[i];
+        }
+        for (size_t i = 0; i < mod.strings.size(); ++i) {
+            if (!unit.liveStrings[i]) {
+                stats.stringsDropped++;
+                continue;
+            }
+            out.strings.push_back({unit.stringRenames[i], mod.strings[i].value});
+        }
+        for (size_t i = 0; i < mod.globals.size(); ++i) {
+            if (!unit.liveGlobals[i]) {
+                stats.globalsDropped++;
+                continue;
+            }
+            out.globals.push_back(mod.globals[i]);
+            out.globals.back().name = unit.globalRenames[i];
+        }
+    }
+    if (tableUnit != units.size()) {
+        const Unit& unit = units[tableUnit];
+        out.tables = unit.mod->tables;
+        for (const auto& elem : unit.mod->elements) {
+            ElementSegment merged = elem;
+            for (auto& name : merged.functionNames) name = nameOf(callee(tableUnit, findCallee(unit, name)));
+            out.elements.push_back(std::move(merged));
+        }
+    }
+    for (const auto& exp : main.mod->exports) {
+        Export merged = exp;
+        if (exp.kind == "func") {
+            merged.target = nameOf(callee(0, findCallee(main, exp.target)));
+        } else if (exp.kind == "global") {
+            merged.target = main.globalRenames[globalIndex(main, exp.target)];
+        }
+        out.exports.push_back(std::move(merged));
+    }
+    stats.modulesMerged = units.size();
+    return out;
+}
+
+} // namespace
+
+void Linker::addLibrary(const std::string& name, Module lib) {
+    libraries[name] = std::move(lib);
+}
+
+Module Linker::link(const Module& main, const std::vector<std::string>& entryPoints) {
+    linkStats = LinkStats();
+    return LinkJob(main, libraries, linkStats).run(entryPoints);
+}
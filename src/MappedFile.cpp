@@ -0,0 +1,33 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) : ptr(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Could not open file: " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Could not stat file: " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+
+    // mmap of length 0 is invalid; an empty file maps to nothing.
+    if (length > 0) {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Could not map file: " + path);
+        }
+        ptr = static_cast<uint8_t*>(p);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (ptr) munmap(ptr, length);
+}
@@ -3,20 +3,20 @@
 MemoryStore::MemoryStore() {
     // Reserve index 0 as null/invalid
     // We push an empty block with nullptr/size 0
-    objects.push_back({{}, nullptr, 0, false});
+    objects.push_back({nullptr, nullptr, 0, false, 0, 0, {}});
 }
 
 MemoryStore::Handle MemoryStore::alloc(int32_t size) {
     if (size < 0) throw std::runtime_error("Negative allocation size");
 
     MemoryBlock block;
-    block.storage.resize(size);
-    // Initialize with zeros? Wasm memory is zero-initialized.
-    std::fill(block.storage.begin(), block.storage.end(), 0);
+    // Wasm memory is zero-initialized.
+    block.storage = std::make_shared<std::vector<uint8_t>>(size, 0);
 
-    block.ptr = block.storage.data();
+    block.ptr = block.storage->data();
     block.size = static_cast<size_t>(size);
     block.readOnly = false;
+    block.root = static_cast<Handle>(objects.size());
 
     objects.push_back(std::move(block));
     return static_cast<Handle>(objects.size() - 1);
@@ -24,10 +24,11 @@ MemoryStore::Handle MemoryStore::alloc(int32_t size) {
 
 MemoryStore::Handle MemoryStore::alloc_readonly(const std::vector<uint8_t>& data) {
     MemoryBlock block;
-    block.storage = data; // Copy data
-    block.ptr = block.storage.data();
+    block.storage = std::make_shared<std::vector<uint8_t>>(data); // Copy data
+    block.ptr = block.storage->data();
     block.size = data.size();
     block.readOnly = true;
+    block.root = static_cast<Handle>(objects.size());
 
     objects.push_back(std::move(block));
     return static_cast<Handle>(objects.size() - 1);
@@ -53,9 +54,14 @@ MemoryStore::Handle MemoryStore::make_span(Handle handle, int32_t offset, int32_
     span.ptr = original.ptr + offset;
     span.size = static_cast<size_t>(size);
     span.readOnly = original.readOnly; // Inherit read-only status
+    span.root = original.root;
+    span.rootOffset = original.rootOffset + static_cast<size_t>(offset);
 
+    Handle root = span.root;
     objects.push_back(std::move(span));
-    return static_cast<Handle>(objects.size() - 1);
+    Handle spanHandle = static_cast<Handle>(objects.size() - 1);
+    objects[root].spans.push_back(spanHandle);
+    return spanHandle;
 }
 
 void MemoryStore::validate_access(Handle handle, int32_t offset, size_t size, bool forWrite) {
@@ -69,4 +75,19 @@ void MemoryStore::validate_access(Handle handle, int32_t offset, size_t size, bo
     if (offset < 0 || static_cast<size_t>(offset + size) > block.size) {
         throw std::runtime_error("Out of bounds object access");
     }
+    if (forWrite && objects[block.root].storage.use_count() > 1) {
+        unshare(block.root);
+    }
+}
+
+void MemoryStore::unshare(Handle root) {
+    MemoryBlock& owner = objects[root];
+    owner.storage = std::make_shared<std::vector<uint8_t>>(*owner.storage);
+
+    // Re-point the owner and every span carved out of it
+    uint8_t* base = owner.storage->data();
+    owner.ptr = base + owner.rootOffset;
+    for (Handle span : owner.spans) {
+        objects[span].ptr = base + objects[span].rootOffset;
+    }
 }
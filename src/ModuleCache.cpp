@@ -0,0 +1,170 @@
+#include "ModuleCache.h"
+#include "Lexer.h"
+#include "MappedFile.h"
+#include "ModuleSerializer.h"
+#include "Parser.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Entries start with the size and SHA-256 of the source they were parsed
+// from, so that a file name hash collision is a miss, not another module.
+const size_t kDigestSize = 32;
+using Digest = std::array<uint8_t, kDigestSize>;
+
+Digest sha256(const char* data, size_t size) {
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+    uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+    auto compress = [&](const uint8_t* block) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 |
+                   block[4 * i + 3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            hh = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    };
+
+    size_t full = size / 64 * 64;
+    for (size_t i = 0; i < full; i += 64) compress(reinterpret_cast<const uint8_t*>(data) + i);
+    // Padding: 0x80, zeros, then the length in bits, big endian
+    uint8_t tail[128] = {};
+    size_t rest = size - full;
+    if (rest) std::memcpy(tail, data + full, rest);
+    tail[rest] = 0x80;
+    size_t tailSize = rest < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)size * 8;
+    for (int i = 0; i < 8; ++i) tail[tailSize - 1 - i] = (uint8_t)(bits >> (8 * i));
+    for (size_t i = 0; i < tailSize; i += 64) compress(tail + i);
+
+    Digest out;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 4; ++j) out[4 * i + j] = (uint8_t)(h[i] >> (24 - 8 * j));
+    }
+    return out;
+}
+
+// Entry files are named after the first 8 bytes of the digest.
+uint64_t digestPrefix(const Digest& digest) {
+    uint64_t h = 0;
+    for (size_t i = 0; i < 8; ++i) h = h << 8 | digest[i];
+    return h;
+}
+
+} // namespace
+
+ModuleCache::ModuleCache(std::string directory) : dir(std::move(directory)) {
+    fs::create_directories(dir);
+}
+
+Module ModuleCache::load(const std::string& source) {
+    return loadSource(source.data(), source.size());
+}
+
+Module ModuleCache::loadFile(const std::string& path) {
+    MappedFile file(path);
+    return loadSource(reinterpret_cast<const char*>(file.data()), file.size());
+}
+
+uint64_t ModuleCache::contentHash(const char* data, size_t size) {
+    return digestPrefix(sha256(data, size));
+}
+
+std::string ModuleCache::entryPath(uint64_t hash) const {
+    // The format version is part of the name so a format change misses
+    char name[48];
+    snprintf(name, sizeof(name), "%016llx.v%u.optm", (unsigned long long)hash, (unsigned)ModuleWriter::kVersion);
+    return (fs::path(dir) / name).string();
+}
+
+Module ModuleCache::loadSource(const char* data, size_t size) {
+    // One pass over the source: the digest both names and checks the entry
+    Digest digest = sha256(data, size);
+    uint64_t hash = digestPrefix(digest);
+    std::string path = entryPath(hash);
+
+    if (fs::exists(path)) {
+        try {
+            MappedFile cached(path);
+            ByteReader header(cached.data(), cached.size());
+            uint64_t sourceSize = header.raw<uint64_t>();
+            bool same = sourceSize == size && header.remaining() >= kDigestSize &&
+                        std::memcmp(header.current(), digest.data(), kDigestSize) == 0;
+            if (same) {
+                header.skip(kDigestSize);
+                Module mod = ModuleReader(header.current(), header.remaining()).read();
+                hitCount++;
+                return mod;
+            }
+            // Another source with the same file name hash: a miss, and the
+            // entry is replaced below
+        } catch (const std::exception&) {
+            // Corrupt or stale entry: fall through and rewrite it
+        }
+    }
+
+    missCount++;
+    Lexer lexer(std::string_view(data, size));
+    Module mod = Parser(lexer).parse();
+    store(hash, size, digest.data(), mod);
+    return mod;
+}
+
+void ModuleCache::store(uint64_t hash, uint64_t sourceSize, const uint8_t* digest, const Module& mod) {
+    ByteWriter header;
+    header.raw<uint64_t>(sourceSize);
+    header.bytes.insert(header.bytes.end(), digest, digest + kDigestSize);
+    std::vector<uint8_t> bytes = ModuleWriter(mod).write();
+
+    std::string path = entryPath(hash);
+    std::string tmp = path + ".tmp." + std::to_string(getpid()) + "." +
+                      std::to_string(reinterpret_cast<uintptr_t>(&mod));
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return; // Caching is best effort
+        out.write(reinterpret_cast<const char*>(header.bytes.data()), header.bytes.size());
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        if (!out) {
+            out.close();
+            fs::remove(tmp);
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) fs::remove(tmp, ec);
+}
@@ -0,0 +1,255 @@
+#include "ModuleSerializer.h"
+#include "Parser.h"
+#include <stdexcept>
+
+static const char kMagic[4] = {'O', 'P', 'T', 'M'};
+
+enum OperandTag : uint8_t { TAG_I32, TAG_I64, TAG_F32, TAG_F64, TAG_STRING, TAG_V128 };
+
+ModuleWriter::ModuleWriter(const Module& mod) : mod(mod) {}
+
+std::vector<uint8_t> ModuleWriter::write() {
+    body.uleb(mod.imports.size());
+    for (const auto& imp : mod.imports) {
+        writeString(imp.module);
+        writeString(imp.field);
+        writeString(imp.alias);
+        writeStrings(imp.paramTypes);
+        writeStrings(imp.resultTypes);
+    }
+
+    body.uleb(mod.types.size());
+    for (const auto& t : mod.types) {
+        writeString(t.name);
+        writeStrings(t.paramTypes);
+        writeStrings(t.resultTypes);
+    }
+
+    body.uleb(mod.tables.size());
+    for (const auto& tbl : mod.tables) {
+        writeString(tbl.name);
+        body.uleb(tbl.min);
+        body.uleb(tbl.max);
+    }
+
+    body.uleb(mod.elements.size());
+    for (const auto& elem : mod.elements) {
+        body.uleb(elem.tableIndex);
+        writeInstruction(elem.offset);
+        writeStrings(elem.functionNames);
+    }
+
+    body.uleb(mod.globals.size());
+    for (const auto& g : mod.globals) {
+        writeString(g.name);
+        writeString(g.type);
+        body.u8(g.isMutable ? 1 : 0);
+        writeInstruction(g.init);
+    }
+
+    body.uleb(mod.exports.size());
+    for (const auto& exp : mod.exports) {
+        writeString(exp.name);
+        writeString(exp.kind);
+        writeString(exp.target);
+    }
+
+    body.uleb(mod.strings.size());
+    for (const auto& str : mod.strings) {
+        writeString(str.name);
+        writeString(str.value);
+    }
+
+    body.uleb(mod.functions.size());
+    for (const auto& func : mod.functions) {
+        writeString(func.name);
+        writeStrings(func.paramTypes);
+        writeStrings(func.paramNames);
+        writeStrings(func.resultTypes);
+        writeStrings(func.localTypes);
+        writeStrings(func.localNames);
+        // Lazily parsed functions are written out in full
+        std::vector<Instruction> parsed;
+        if (func.body.empty() && !func.lazyBody.empty()) parsed = Parser::parseBody(func.lazyBody);
+        const std::vector<Instruction>& code = parsed.empty() ? func.body : parsed;
+        body.uleb(code.size());
+        for (const auto& instr : code) {
+            writeInstruction(instr);
+        }
+    }
+
+    // Header and string table go in front of the body that references them
+    ByteWriter out;
+    for (char c : kMagic) out.u8((uint8_t)c);
+    out.u32(kVersion);
+    out.uleb(stringTable.size());
+    for (const std::string* s : stringTable) {
+        out.str(*s);
+    }
+    out.bytes.insert(out.bytes.end(), body.bytes.begin(), body.bytes.end());
+    return std::move(out.bytes);
+}
+
+void ModuleWriter::writeString(const std::string& s) {
+    auto it = stringIndex.find(s);
+    if (it == stringIndex.end()) {
+        it = stringIndex.emplace(s, (uint32_t)stringTable.size()).first;
+        stringTable.push_back(&it->first);
+    }
+    body.uleb(it->second);
+}
+
+void ModuleWriter::writeStrings(const std::vector<std::string>& list) {
+    body.uleb(list.size());
+    for (const auto& s : list) writeString(s);
+}
+
+void ModuleWriter::writeInstruction(const Instruction& instr) {
+    body.uleb((uint32_t)instr.opcode);
+    switch (instr.operand.index()) {
+        case 0:
+            body.u8(TAG_I32);
+            body.sleb(std::get<int32_t>(instr.operand));
+            break;
+        case 1:
+            body.u8(TAG_I64);
+            body.sleb(std::get<int64_t>(instr.operand));
+            break;
+        case 2:
+            body.u8(TAG_F32);
+            body.raw<float>(std::get<float>(instr.operand));
+            break;
+        case 3:
+            body.u8(TAG_F64);
+            body.raw<double>(std::get<double>(instr.operand));
+            break;
+        case 5:
+            body.u8(TAG_V128);
+            body.raw<V128>(std::get<V128>(instr.operand));
+            break;
+        default:
+            body.u8(TAG_STRING);
+            writeString(std::get<std::string>(instr.operand));
+            break;
+    }
+}
+
+ModuleReader::ModuleReader(const uint8_t* data, size_t size) : in(data, size) {}
+
+Module ModuleReader::read() {
+    for (char c : kMagic) {
+        if (in.u8() != (uint8_t)c) throw std::runtime_error("Not a compiled module (bad magic)");
+    }
+    if (in.u32() != ModuleWriter::kVersion) {
+        throw std::runtime_error("Unsupported compiled module version");
+    }
+
+    uint64_t numStrings = readCount();
+    strings.reserve(numStrings);
+    for (uint64_t i = 0; i < numStrings; ++i) {
+        strings.push_back(in.str());
+    }
+
+    Module mod;
+
+    mod.imports.resize(readCount());
+    for (auto& imp : mod.imports) {
+        imp.module = readString();
+        imp.field = readString();
+        imp.alias = readString();
+        imp.paramTypes = readStrings();
+        imp.resultTypes = readStrings();
+    }
+
+    mod.types.resize(readCount());
+    for (auto& t : mod.types) {
+        t.name = readString();
+        t.paramTypes = readStrings();
+        t.resultTypes = readStrings();
+    }
+
+    mod.tables.resize(readCount());
+    for (auto& tbl : mod.tables) {
+        tbl.name = readString();
+        tbl.min = (uint32_t)in.uleb();
+        tbl.max = (uint32_t)in.uleb();
+    }
+
+    mod.elements.resize(readCount());
+    for (auto& elem : mod.elements) {
+        elem.tableIndex = (uint32_t)in.uleb();
+        elem.offset = readInstruction();
+        elem.functionNames = readStrings();
+    }
+
+    mod.globals.resize(readCount());
+    for (auto& g : mod.globals) {
+        g.name = readString();
+        g.type = readString();
+        g.isMutable = in.u8() != 0;
+        g.init = readInstruction();
+    }
+
+    mod.exports.resize(readCount());
+    for (auto& exp : mod.exports) {
+        exp.name = readString();
+        exp.kind = readString();
+        exp.target = readString();
+    }
+
+    mod.strings.resize(readCount());
+    for (auto& str : mod.strings) {
+        str.name = readString();
+        str.value = readString();
+    }
+
+    mod.functions.resize(readCount());
+    for (auto& func : mod.functions) {
+        func.name = readString();
+        func.paramTypes = readStrings();
+        func.paramNames = readStrings();
+        func.resultTypes = readStrings();
+        func.localTypes = readStrings();
+        func.localNames = readStrings();
+        func.body.resize(readCount());
+        for (auto& instr : func.body) {
+            instr = readInstruction();
+        }
+    }
+
+    if (!in.atEnd()) throw std::runtime_error("Trailing data in compiled module");
+    return mod;
+}
+
+const std::string& ModuleReader::readString() {
+    uint64_t idx = in.uleb();
+    if (idx >= strings.size()) throw std::runtime_error("Bad string reference in compiled module");
+    return strings[idx];
+}
+
+std::vector<std::string> ModuleReader::readStrings() {
+    std::vector<std::string> list(readCount());
+    for (auto& s : list) s = readString();
+    return list;
+}
+
+Instruction ModuleReader::readInstruction() {
+    Opcode op = (Opcode)in.uleb();
+    switch (in.u8()) {
+        case TAG_I32: return Instruction(op, (int32_t)in.sleb());
+        case TAG_I64: return Instruction(op, (int64_t)in.sleb());
+        case TAG_F32: return Instruction(op, in.raw<float>());
+        case TAG_F64: return Instruction(op, in.raw<double>());
+        case TAG_STRING: return Instruction(op, readString());
+        case TAG_V128: return Instruction(op, in.raw<V128>());
+        default: throw std::runtime_error("Bad operand tag in compiled module");
+    }
+}
+
+uint64_t ModuleReader::readCount() {
+    // Every element takes at least one byte, which bounds resize() on
+    // corrupt input.
+    uint64_t n = in.uleb();
+    if (n > in.remaining()) throw std::runtime_error("Bad element count in compiled module");
+    return n;
+}
@@ -0,0 +1,114 @@
+#include "NativeModule.h"
+#include <map>
+#include <mutex>
+
+namespace {
+
+std::mutex& registryMutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+std::map<std::string, NativeModule::Factory>& registry() {
+    static std::map<std::string, NativeModule::Factory> factories;
+    return factories;
+}
+
+} // namespace
+
+bool NativeModule::registerFactory(const char* name, Factory factory) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    return registry().emplace(name, factory).second;
+}
+
+bool NativeModule::available(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    return registry().count(name) != 0;
+}
+
+std::unique_ptr<NativeModule> NativeModule::create(const std::string& name, MemoryStore& store) {
+    Factory factory;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto it = registry().find(name);
+        if (it == registry().end()) throw std::runtime_error("No native module named " + name);
+        factory = it->second;
+    }
+    return factory(store);
+}
+
+NativeModule::NativeModule(const NativeLayout& layout, MemoryStore& store)
+    : layout(layout), store(store), table(layout.table), hostFuncs(layout.imports.size()) {
+    for (const auto& data : layout.strings) stringHandles.push_back(store.alloc_readonly(data));
+}
+
+void NativeModule::registerHostFunction(std::string modName, std::string fieldName, HostFunction func,
+                                        const std::vector<std::string>& params,
+                                        const std::vector<std::string>& results) {
+    for (size_t i = 0; i < layout.imports.size(); ++i) {
+        const NativeLayout::Import& imp = layout.imports[i];
+        if (imp.module != modName || imp.field != fieldName) continue;
+        if (imp.paramTypes != params) {
+            throw std::runtime_error("Import signature mismatch (params) for " + modName + "." + fieldName);
+        }
+        if (imp.resultTypes != results) {
+            throw std::runtime_error("Import signature mismatch (results) for " + modName + "." + fieldName);
+        }
+        for (const auto* types : {&params, &results}) {
+            for (const auto& t : *types) {
+                if (t == "v128") {
+                    throw std::runtime_error("v128 is not supported at the host boundary: " + modName + "." +
+                                             fieldName);
+                }
+            }
+        }
+        hostFuncs[i] = func;
+    }
+}
+
+WasmValue NativeModule::run(std::string funcName, std::vector<WasmValue> args) {
+    for (const auto& f : layout.names) {
+        if (f.name != funcName) continue;
+        for (const auto* types : {&layout.paramTypes[f.index], &layout.resultTypes[f.index]}) {
+            for (const auto& t : *types) {
+                if (t == "v128") throw std::runtime_error("v128 is not supported at the host boundary: " + funcName);
+            }
+        }
+        if (args.size() != layout.paramTypes[f.index].size()) {
+            throw std::runtime_error("Argument mismatch");
+        }
+        return invoke(f.index, args.data());
+    }
+    throw std::runtime_error("Function not found: " + funcName);
+}
+
+WasmValue NativeModule::callHost(int32_t import, std::vector<WasmValue>& args) {
+    const HostFunction& func = hostFuncs[import];
+    if (!func) {
+        const NativeLayout::Import& imp = layout.imports[import];
+        throw std::runtime_error("Unknown function: " + imp.module + "." + imp.field);
+    }
+    WasmValue res = func(args);
+    if (res.isPending()) {
+        const NativeLayout::Import& imp = layout.imports[import];
+        throw std::runtime_error("Host call " + imp.module + "." + imp.field + " cannot be pending in native code");
+    }
+    return res;
+}
+
+int32_t NativeModule::tableEntry(int32_t idx, int32_t sig) const {
+    if (idx < 0 || idx >= (int32_t)table.size()) {
+        throw std::runtime_error("Undefined table index: " + std::to_string(idx));
+    }
+    int32_t func = table[idx];
+    if (func < 0) {
+        throw std::runtime_error("Uninitialized table element at index " + std::to_string(idx));
+    }
+    if (layout.signatures[func] != sig) {
+        if (layout.paramTypes[func] != layout.signatureParams[sig]) {
+            throw std::runtime_error("Indirect call signature mismatch (params)");
+        }
+        throw std::runtime_error("Indirect call signature mismatch (results)");
+    }
+    return func;
+}
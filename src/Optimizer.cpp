@@ -0,0 +1,870 @@
+#include "Optimizer.h"
+#include "CompiledModule.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+
+OptimizerStats& OptimizerStats::operator+=(const OptimizerStats& other) {
+    constantsFolded += other.constantsFolded;
+    copiesPropagated += other.copiesPropagated;
+    deadStores += other.deadStores;
+    unreachableRemoved += other.unreachableRemoved;
+    invariantsHoisted += other.invariantsHoisted;
+    strengthReduced += other.strengthReduced;
+    inlinedCalls += other.inlinedCalls;
+    revalidationFailures += other.revalidationFailures;
+    instructionsBefore += other.instructionsBefore;
+    instructionsAfter += other.instructionsAfter;
+    return *this;
+}
+
+namespace {
+
+// Structured markers the Validator matches labels against; never removed
+// on their own.
+bool isMarker(Opcode op) {
+    return op == Opcode::BLOCK || op == Opcode::LOOP || op == Opcode::IF || op == Opcode::ELSE || op == Opcode::END;
+}
+
+bool isScalarConst(Opcode op) {
+    return op == Opcode::I32_CONST || op == Opcode::I64_CONST || op == Opcode::F32_CONST || op == Opcode::F64_CONST;
+}
+
+// Pushes one value and does nothing else, so it can go along with the
+// instruction that consumes the value.
+bool isPureProducer(Opcode op) {
+    return isScalarConst(op) || op == Opcode::STRING_CONST || op == Opcode::LOCAL_GET || op == Opcode::GLOBAL_GET;
+}
+
+bool isI32Binary(Opcode op) {
+    return (op >= Opcode::I32_EQ && op <= Opcode::I32_GE_U) || (op >= Opcode::I32_ADD && op <= Opcode::I32_ROTR);
+}
+
+bool isI32Unary(Opcode op) {
+    return op == Opcode::I32_EQZ || (op >= Opcode::I32_CLZ && op <= Opcode::I32_POPCNT);
+}
+
+bool isF64Binary(Opcode op) { return op >= Opcode::F64_ADD && op <= Opcode::F64_DIV; }
+
+// Same results as the interpreter; false for operations that would trap,
+// which are left to trap at run time.
+bool evalI32Binary(Opcode op, int32_t a, int32_t b, int32_t& out) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (op) {
+        case Opcode::I32_EQ: out = a == b; return true;
+        case Opcode::I32_NE: out = a != b; return true;
+        case Opcode::I32_LT_S: out = a < b; return true;
+        case Opcode::I32_LT_U: out = ua < ub; return true;
+        case Opcode::I32_GT_S: out = a > b; return true;
+        case Opcode::I32_GT_U: out = ua > ub; return true;
+        case Opcode::I32_LE_S: out = a <= b; return true;
+        case Opcode::I32_LE_U: out = ua <= ub; return true;
+        case Opcode::I32_GE_S: out = a >= b; return true;
+        case Opcode::I32_GE_U: out = ua >= ub; return true;
+        case Opcode::I32_ADD: out = (int32_t)(ua + ub); return true;
+        case Opcode::I32_SUB: out = (int32_t)(ua - ub); return true;
+        case Opcode::I32_MUL: out = (int32_t)(ua * ub); return true;
+        case Opcode::I32_DIV_S:
+            if (b == 0 || (a == INT32_MIN && b == -1)) return false;
+            out = a / b;
+            return true;
+        case Opcode::I32_DIV_U:
+            if (b == 0) return false;
+            out = (int32_t)(ua / ub);
+            return true;
+        case Opcode::I32_REM_S:
+            if (b == 0) return false;
+            out = b == -1 ? 0 : a % b;
+            return true;
+        case Opcode::I32_REM_U:
+            if (b == 0) return false;
+            out = (int32_t)(ua % ub);
+            return true;
+        case Opcode::I32_AND: out = a & b; return true;
+        case Opcode::I32_OR: out = a | b; return true;
+        case Opcode::I32_XOR: out = a ^ b; return true;
+        case Opcode::I32_SHL: out = (int32_t)(ua << (ub & 31)); return true;
+        case Opcode::I32_SHR_S: out = a >> (ub & 31); return true;
+        case Opcode::I32_SHR_U: out = (int32_t)(ua >> (ub & 31)); return true;
+        case Opcode::I32_ROTL: ub &= 31; out = (int32_t)((ua << ub) | (ua >> ((32 - ub) & 31))); return true;
+        case Opcode::I32_ROTR: ub &= 31; out = (int32_t)((ua >> ub) | (ua << ((32 - ub) & 31))); return true;
+        default: return false;
+    }
+}
+
+int32_t evalI32Unary(Opcode op, int32_t a) {
+    uint32_t ua = (uint32_t)a;
+    switch (op) {
+        case Opcode::I32_EQZ: return a == 0;
+        case Opcode::I32_CLZ: return ua == 0 ? 32 : __builtin_clz(ua);
+        case Opcode::I32_CTZ: return ua == 0 ? 32 : __builtin_ctz(ua);
+        default: return __builtin_popcount(ua);
+    }
+}
+
+double evalF64Binary(Opcode op, double a, double b) {
+    switch (op) {
+        case Opcode::F64_ADD: return a + b;
+        case Opcode::F64_SUB: return a - b;
+        case Opcode::F64_MUL: return a * b;
+        default: return a / b;
+    }
+}
+
+bool traps(Opcode op) { return op >= Opcode::I32_DIV_S && op <= Opcode::I32_REM_U; }
+
+CompiledInstr makeInstr(Opcode op, int32_t index = 0) {
+    CompiledInstr instr;
+    instr.opcode = op;
+    instr.index = index;
+    return instr;
+}
+
+// One value on the operand stack while a loop body is scanned: the
+// instructions start..root compute it, with nothing else in between.
+struct LoopValue {
+    int32_t start = 0;
+    int32_t root = 0;
+    int32_t count = 1;      // Instructions still there
+    bool invariant = false; // Reads only constants and locals the loop leaves alone
+    bool linear = false;    // i32, coef * iv plus something invariant
+    bool usesIv = false;
+    bool constant = false;  // A single i32.const, holding value
+    int32_t value = 0;
+    uint32_t coef = 0;
+};
+
+// True when x op c is x for every x.
+bool isIdentity(Opcode op, int32_t c) {
+    switch (op) {
+        case Opcode::I32_ADD: case Opcode::I32_SUB: case Opcode::I32_OR: case Opcode::I32_XOR:
+        case Opcode::I32_SHL: case Opcode::I32_SHR_S: case Opcode::I32_SHR_U:
+        case Opcode::I32_ROTL: case Opcode::I32_ROTR:
+            return c == 0;
+        case Opcode::I32_MUL: case Opcode::I32_DIV_S: case Opcode::I32_DIV_U:
+            return c == 1;
+        case Opcode::I32_AND:
+            return c == -1;
+        default:
+            return false;
+    }
+}
+
+// The passes mark instructions removed instead of erasing them, so pcs stay
+// put until compact(). A removed instruction behaves as a NOP: a branch to
+// it resumes at the next instruction still there.
+class FunctionOptimizer {
+public:
+    FunctionOptimizer(CompiledFunction& func, std::vector<CompiledInstr>& code,
+                      std::vector<BranchTarget>& branchTable, OptimizerStats& stats)
+        : func(func), code(code), branchTable(branchTable), stats(stats), removed(code.size(), false) {}
+
+    bool foldConstants();
+    bool propagateCopies();
+    bool eliminateDeadStores();
+    bool removeUnreachable();
+    // Runs the loop passes, then compact(): code they add only becomes
+    // visible to the other passes once it is in place.
+    bool optimizeLoops(bool hoist, bool reduce);
+    // Erases the removed instructions, puts inserted ones in place and
+    // moves every branch target.
+    void compact();
+
+private:
+    CompiledFunction& func;
+    std::vector<CompiledInstr>& code;
+    std::vector<BranchTarget>& branchTable;
+    OptimizerStats& stats;
+    std::vector<bool> removed;
+    std::vector<bool> isTarget; // Indexed by pc, one past the end included
+    // Code to insert before or after an instruction; a branch to the
+    // instruction lands before the former and skips the latter. Empty
+    // unless a loop pass is under way.
+    std::vector<std::vector<CompiledInstr>> before, after;
+
+    int32_t size() const { return (int32_t)code.size(); }
+
+    void findTargets() {
+        isTarget.assign(code.size() + 1, false);
+        for (int32_t pc = 0; pc < size(); ++pc) {
+            if (removed[pc]) continue;
+            const CompiledInstr& instr = code[pc];
+            switch (instr.opcode) {
+                case Opcode::BR: case Opcode::BR_IF: case Opcode::IF: case Opcode::ELSE:
+                    isTarget[instr.index] = true;
+                    break;
+                case Opcode::BR_TABLE:
+                    for (int32_t i = 0; i <= instr.i32; ++i) isTarget[branchTable[instr.index + i].pc] = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Neighbouring instructions still there, or -1 / size().
+    int32_t prev(int32_t pc) const {
+        do --pc; while (pc >= 0 && removed[pc]);
+        return pc;
+    }
+    int32_t next(int32_t pc) const {
+        do ++pc; while (pc < size() && removed[pc]);
+        return pc;
+    }
+
+    // Whether control can enter anywhere in (from, to], i.e. whether the
+    // instructions from..to are not always executed in sequence.
+    bool entered(int32_t from, int32_t to) const {
+        for (int32_t pc = from + 1; pc <= to; ++pc) {
+            if (isTarget[pc]) return true;
+        }
+        return false;
+    }
+
+    void remove(int32_t pc) { removed[pc] = true; }
+    void removeRange(int32_t begin, int32_t end) {
+        for (int32_t pc = begin; pc < end; ++pc) removed[pc] = true;
+    }
+
+    template <typename F>
+    void forEachSuccessor(int32_t pc, F&& f) const {
+        const CompiledInstr& instr = code[pc];
+        Opcode op = removed[pc] ? Opcode::NOP : instr.opcode;
+        switch (op) {
+            case Opcode::BR: case Opcode::ELSE:
+                f(instr.index);
+                return;
+            case Opcode::BR_IF: case Opcode::IF:
+                f(instr.index);
+                break;
+            case Opcode::BR_TABLE:
+                for (int32_t i = 0; i <= instr.i32; ++i) f(branchTable[instr.index + i].pc);
+                return;
+            case Opcode::RETURN: case Opcode::UNREACHABLE:
+                return;
+            default:
+                break;
+        }
+        if (pc + 1 < size()) f(pc + 1);
+    }
+
+    void resolveIf(int32_t pc, bool taken);
+
+    // Loops (LOOP pc, END pc) some branch inside goes back to, outermost
+    // first.
+    std::vector<std::pair<int32_t, int32_t>> findLoops() const;
+    // Writes to each local slot within (head, end), inserted code included.
+    std::vector<uint32_t> writesIn(int32_t head, int32_t end) const;
+    bool hoistInvariants(int32_t head, int32_t end);
+    bool reduceInductionVariables(int32_t head, int32_t end);
+    template <typename Wanted, typename Found>
+    void scanLoop(int32_t head, int32_t end, const std::vector<uint32_t>& writes, int32_t iv, Wanted&& wanted,
+                  Found&& found) const;
+
+    int32_t addLocal(const char* type) {
+        func.extraLocals.push_back(type);
+        int32_t slot = (int32_t)func.numLocals;
+        func.numLocals += slotCount(type);
+        return slot;
+    }
+    // The instructions of v, and a string that is equal for equal code.
+    std::vector<CompiledInstr> codeOf(const LoopValue& v) const {
+        std::vector<CompiledInstr> out;
+        for (int32_t pc = v.start; pc <= v.root; ++pc) {
+            if (!removed[pc]) out.push_back(code[pc]);
+        }
+        return out;
+    }
+    static std::string keyOf(const std::vector<CompiledInstr>& instrs) {
+        std::string key;
+        for (const auto& instr : instrs) {
+            key.append((const char*)&instr.opcode, sizeof(instr.opcode));
+            key.append((const char*)&instr.index, sizeof(instr.index));
+            key.append((const char*)&instr.i64, sizeof(instr.i64));
+        }
+        return key;
+    }
+    // Leaves a read of slot where v was computed.
+    void replace(const LoopValue& v, int32_t slot) {
+        removeRange(v.start, v.root);
+        code[v.root] = makeInstr(Opcode::LOCAL_GET, slot);
+    }
+};
+
+bool FunctionOptimizer::foldConstants() {
+    findTargets();
+    bool changed = false;
+    for (int32_t pc = 0; pc < size(); ++pc) {
+        if (removed[pc]) continue;
+        CompiledInstr& instr = code[pc];
+        Opcode op = instr.opcode;
+        int32_t b = prev(pc);
+        if (b < 0 || entered(b, pc)) continue;
+        CompiledInstr& rhs = code[b];
+        int32_t a = prev(b);
+        bool pair = a >= 0 && !entered(a, b);
+
+        if (isI32Binary(op) && rhs.opcode == Opcode::I32_CONST) {
+            int32_t result;
+            if (pair && code[a].opcode == Opcode::I32_CONST && evalI32Binary(op, code[a].i32, rhs.i32, result)) {
+                code[a].i32 = result;
+            } else if (!isIdentity(op, rhs.i32)) {
+                continue;
+            }
+            remove(b);
+            remove(pc);
+        } else if (isI32Unary(op) && rhs.opcode == Opcode::I32_CONST) {
+            rhs.i32 = evalI32Unary(op, rhs.i32);
+            remove(pc);
+        } else if (isF64Binary(op) && rhs.opcode == Opcode::F64_CONST && pair &&
+                   code[a].opcode == Opcode::F64_CONST) {
+            code[a].f64 = evalF64Binary(op, code[a].f64, rhs.f64);
+            remove(b);
+            remove(pc);
+        } else if (op == Opcode::BR_IF && rhs.opcode == Opcode::I32_CONST) {
+            if (rhs.i32 != 0) {
+                instr.opcode = Opcode::BR;
+            } else {
+                remove(pc);
+            }
+            remove(b);
+        } else if (op == Opcode::IF && rhs.opcode == Opcode::I32_CONST) {
+            resolveIf(pc, rhs.i32 != 0);
+            remove(b);
+        } else {
+            continue;
+        }
+        stats.constantsFolded++;
+        changed = true;
+    }
+    return changed;
+}
+
+// An if on a known condition becomes a plain block holding the branch that
+// runs; the other branch goes. Branches to the if's label target the
+// block's END + 1 just the same.
+void FunctionOptimizer::resolveIf(int32_t pc, bool taken) {
+    int32_t elsePc = -1;
+    int32_t endPc = pc;
+    int depth = 0;
+    for (int32_t i = next(pc); i < size(); i = next(i)) {
+        Opcode op = code[i].opcode;
+        if (op == Opcode::BLOCK || op == Opcode::LOOP || op == Opcode::IF) {
+            depth++;
+        } else if (op == Opcode::ELSE && depth == 0) {
+            elsePc = i;
+        } else if (op == Opcode::END) {
+            if (depth == 0) {
+                endPc = i;
+                break;
+            }
+            depth--;
+        }
+    }
+    code[pc].opcode = Opcode::BLOCK;
+    if (taken) {
+        if (elsePc >= 0) removeRange(elsePc, endPc);
+    } else {
+        removeRange(pc + 1, elsePc >= 0 ? elsePc + 1 : endPc);
+    }
+}
+
+bool FunctionOptimizer::propagateCopies() {
+    findTargets();
+    // What each local slot is known to hold at the current pc, along the
+    // straight-line code since the last branch target
+    enum class Kind : uint8_t { None, Copy, Const };
+    struct Fact {
+        Kind kind = Kind::None;
+        CompiledInstr value; // The constant, or a LOCAL_GET of the source
+    };
+    std::vector<Fact> facts(func.numLocals);
+    auto kill = [&facts](int32_t slot) {
+        facts[slot].kind = Kind::None;
+        for (auto& f : facts) {
+            if (f.kind == Kind::Copy && f.value.index == slot) f.kind = Kind::None;
+        }
+    };
+
+    bool changed = false;
+    for (int32_t pc = 0; pc < size(); ++pc) {
+        if (removed[pc]) continue;
+        if (isTarget[pc]) {
+            for (auto& f : facts) f.kind = Kind::None;
+        }
+        CompiledInstr& instr = code[pc];
+        switch (instr.opcode) {
+            case Opcode::LOCAL_GET: {
+                const Fact& f = facts[instr.index];
+                if (f.kind == Kind::None) break;
+                instr = f.value;
+                stats.copiesPropagated++;
+                changed = true;
+                break;
+            }
+            case Opcode::LOCAL_SET:
+            case Opcode::LOCAL_TEE: {
+                int32_t slot = instr.index;
+                kill(slot);
+                int32_t src = prev(pc);
+                if (src >= 0 && !entered(src, pc)) {
+                    const CompiledInstr& value = code[src];
+                    if (value.opcode == Opcode::LOCAL_GET && value.index != slot) {
+                        facts[slot] = {Kind::Copy, value};
+                    } else if (isScalarConst(value.opcode)) {
+                        facts[slot] = {Kind::Const, value};
+                    }
+                }
+                // Reads of a copy are rewritten instead; the set then dies
+                int32_t use = next(pc);
+                if (instr.opcode == Opcode::LOCAL_SET && facts[slot].kind == Kind::None && use < size() &&
+                    !entered(pc, use) && code[use].opcode == Opcode::LOCAL_GET && code[use].index == slot) {
+                    instr.opcode = Opcode::LOCAL_TEE;
+                    remove(use);
+                    stats.copiesPropagated++;
+                    changed = true;
+                }
+                break;
+            }
+            case Opcode::LOCAL_SET_WIDE:
+            case Opcode::LOCAL_TEE_WIDE:
+                kill(instr.index);
+                kill(instr.index + 1);
+                break;
+            default:
+                break;
+        }
+    }
+    return changed;
+}
+
+bool FunctionOptimizer::eliminateDeadStores() {
+    bool stores = false;
+    for (int32_t pc = 0; pc < size() && !stores; ++pc) {
+        stores = !removed[pc] && (code[pc].opcode == Opcode::LOCAL_SET || code[pc].opcode == Opcode::LOCAL_TEE);
+    }
+    if (!stores) return false;
+    findTargets();
+    // Backward liveness of local slots, one bit set per pc
+    size_t words = (func.numLocals + 63) / 64;
+    std::vector<uint64_t> liveIn(code.size() * words, 0);
+    std::vector<uint64_t> out(words);
+    auto liveOut = [&](int32_t pc) {
+        std::fill(out.begin(), out.end(), 0);
+        forEachSuccessor(pc, [&](int32_t succ) {
+            if (succ >= size()) return;
+            for (size_t w = 0; w < words; ++w) out[w] |= liveIn[succ * words + w];
+        });
+    };
+    auto set = [](std::vector<uint64_t>& bits, size_t base, int32_t slot, bool live) {
+        uint64_t mask = 1ull << (slot % 64);
+        if (live) {
+            bits[base + slot / 64] |= mask;
+        } else {
+            bits[base + slot / 64] &= ~mask;
+        }
+    };
+
+    std::vector<uint64_t> in(words);
+    bool again = true;
+    while (again) {
+        again = false;
+        for (int32_t pc = size() - 1; pc >= 0; --pc) {
+            liveOut(pc);
+            in = out;
+            if (!removed[pc]) {
+                const CompiledInstr& instr = code[pc];
+                switch (instr.opcode) {
+                    case Opcode::LOCAL_GET: set(in, 0, instr.index, true); break;
+                    case Opcode::LOCAL_GET_WIDE:
+                        set(in, 0, instr.index, true);
+                        set(in, 0, instr.index + 1, true);
+                        break;
+                    case Opcode::LOCAL_SET: case Opcode::LOCAL_TEE: set(in, 0, instr.index, false); break;
+                    case Opcode::LOCAL_SET_WIDE: case Opcode::LOCAL_TEE_WIDE:
+                        set(in, 0, instr.index, false);
+                        set(in, 0, instr.index + 1, false);
+                        break;
+                    default: break;
+                }
+            }
+            if (!std::equal(in.begin(), in.end(), liveIn.begin() + pc * words)) {
+                std::copy(in.begin(), in.end(), liveIn.begin() + pc * words);
+                again = true;
+            }
+        }
+    }
+
+    bool changed = false;
+    for (int32_t pc = 0; pc < size(); ++pc) {
+        if (removed[pc]) continue;
+        Opcode op = code[pc].opcode;
+        if (op != Opcode::LOCAL_SET && op != Opcode::LOCAL_TEE) continue;
+        int32_t slot = code[pc].index;
+        liveOut(pc);
+        if (out[slot / 64] & (1ull << (slot % 64))) continue;
+        if (op == Opcode::LOCAL_TEE) {
+            // The value stays on the stack for its other user
+            remove(pc);
+        } else {
+            // There is no drop, so the value's producer has to go too
+            int32_t src = prev(pc);
+            if (src < 0 || entered(src, pc) || !isPureProducer(code[src].opcode)) continue;
+            remove(src);
+            remove(pc);
+        }
+        stats.deadStores++;
+        changed = true;
+    }
+    return changed;
+}
+
+bool FunctionOptimizer::removeUnreachable() {
+    std::vector<bool> reached(code.size(), false);
+    std::vector<int32_t> work{0};
+    reached[0] = true;
+    while (!work.empty()) {
+        int32_t pc = work.back();
+        work.pop_back();
+        forEachSuccessor(pc, [&](int32_t succ) {
+            if (succ < size() && !reached[succ]) {
+                reached[succ] = true;
+                work.push_back(succ);
+            }
+        });
+    }
+    bool changed = false;
+    // Markers stay so blocks remain balanced, and so does the trailing
+    // RETURN the Validator expects last
+    for (int32_t pc = 0; pc + 1 < size(); ++pc) {
+        if (removed[pc] || reached[pc] || isMarker(code[pc].opcode)) continue;
+        remove(pc);
+        stats.unreachableRemoved++;
+        changed = true;
+    }
+    return changed;
+}
+
+void FunctionOptimizer::compact() {
+    bool inserted = !before.empty();
+    if (!inserted && std::find(removed.begin(), removed.end(), true) == removed.end()) return;
+    // newPc[pc] is where the first instruction at or after pc ends up,
+    // code inserted before it included
+    std::vector<int32_t> newPc(code.size() + 1);
+    int32_t kept = 0;
+    for (int32_t pc = 0; pc < size(); ++pc) {
+        newPc[pc] = kept;
+        if (inserted) kept += (int32_t)before[pc].size();
+        if (!removed[pc]) kept++;
+        if (inserted) kept += (int32_t)after[pc].size();
+    }
+    newPc[code.size()] = kept;
+
+    std::vector<CompiledInstr> out;
+    out.reserve(kept);
+    for (int32_t pc = 0; pc < size(); ++pc) {
+        if (inserted) out.insert(out.end(), before[pc].begin(), before[pc].end());
+        if (removed[pc]) {
+            if (inserted) out.insert(out.end(), after[pc].begin(), after[pc].end());
+            continue;
+        }
+        CompiledInstr instr = code[pc];
+        switch (instr.opcode) {
+            case Opcode::BR: case Opcode::BR_IF: case Opcode::IF: case Opcode::ELSE:
+                instr.index = newPc[instr.index];
+                break;
+            default:
+                break;
+        }
+        out.push_back(instr);
+        if (inserted) out.insert(out.end(), after[pc].begin(), after[pc].end());
+    }
+    for (auto& entry : branchTable) entry.pc = newPc[entry.pc];
+    code = std::move(out);
+    removed.assign(code.size(), false);
+    before.clear();
+    after.clear();
+}
+
+std::vector<std::pair<int32_t, int32_t>> FunctionOptimizer::findLoops() const {
+    std::vector<std::pair<int32_t, int32_t>> loops;
+    std::vector<int32_t> open; // LOOP pc, or -1 for a block or if
+    for (int32_t pc = 0; pc < size(); pc = next(pc)) {
+        Opcode op = code[pc].opcode;
+        if (op == Opcode::BLOCK || op == Opcode::IF) {
+            open.push_back(-1);
+        } else if (op == Opcode::LOOP) {
+            open.push_back(pc);
+        } else if (op == Opcode::END && !open.empty()) {
+            int32_t head = open.back();
+            open.pop_back();
+            if (head < 0) continue;
+            bool backEdge = false;
+            for (int32_t i = next(head); i < pc && !backEdge; i = next(i)) {
+                forEachSuccessor(i, [&](int32_t succ) { backEdge |= succ == head + 1; });
+            }
+            if (backEdge) loops.push_back({head, pc});
+        }
+    }
+    std::sort(loops.begin(), loops.end());
+    return loops;
+}
+
+std::vector<uint32_t> FunctionOptimizer::writesIn(int32_t head, int32_t end) const {
+    std::vector<uint32_t> writes(func.numLocals, 0);
+    auto count = [&writes](const CompiledInstr& instr) {
+        switch (instr.opcode) {
+            case Opcode::LOCAL_SET: case Opcode::LOCAL_TEE:
+                writes[instr.index]++;
+                break;
+            case Opcode::LOCAL_SET_WIDE: case Opcode::LOCAL_TEE_WIDE:
+                writes[instr.index]++;
+                writes[instr.index + 1]++;
+                break;
+            default:
+                break;
+        }
+    };
+    for (int32_t pc = head + 1; pc < end; ++pc) {
+        if (!removed[pc]) count(code[pc]);
+        if (before.empty()) continue;
+        for (const auto& instr : before[pc]) count(instr);
+        for (const auto& instr : after[pc]) count(instr);
+    }
+    return writes;
+}
+
+// Follows the operand stack through the loop body as far as it is made of
+// constants, local reads and pure arithmetic that cannot trap; anything
+// else, and any branch target, starts over. found() gets each value that
+// wanted() accepts once it stops growing into a larger accepted value.
+// With iv >= 0 values are also tracked as linear functions of that local.
+template <typename Wanted, typename Found>
+void FunctionOptimizer::scanLoop(int32_t head, int32_t end, const std::vector<uint32_t>& writes, int32_t iv,
+                                 Wanted&& wanted, Found&& found) const {
+    std::vector<LoopValue> stack;
+    auto flush = [&] {
+        for (const auto& v : stack) {
+            if (wanted(v)) found(v);
+        }
+        stack.clear();
+    };
+    for (int32_t pc = next(head); pc < end; pc = next(pc)) {
+        if (isTarget[pc]) flush();
+        const CompiledInstr& instr = code[pc];
+        Opcode op = instr.opcode;
+        LoopValue v;
+        v.start = v.root = pc;
+        if (isScalarConst(op)) {
+            v.invariant = true;
+            v.linear = v.constant = op == Opcode::I32_CONST;
+            v.value = instr.i32;
+        } else if (op == Opcode::LOCAL_GET) {
+            v.usesIv = instr.index == iv;
+            v.invariant = writes[instr.index] == 0;
+            v.linear = v.usesIv || v.invariant;
+            v.coef = v.usesIv ? 1 : 0;
+        } else if (isI32Unary(op) && !stack.empty()) {
+            LoopValue a = stack.back();
+            stack.pop_back();
+            v.start = a.start;
+            v.count = a.count + 1;
+            v.invariant = v.linear = a.invariant;
+            v.usesIv = a.usesIv;
+            if (wanted(a) && !wanted(v)) found(a);
+        } else if (((isI32Binary(op) && !traps(op)) || isF64Binary(op)) && stack.size() >= 2) {
+            LoopValue b = stack.back();
+            stack.pop_back();
+            LoopValue a = stack.back();
+            stack.pop_back();
+            v.start = a.start;
+            v.count = a.count + b.count + 1;
+            v.invariant = a.invariant && b.invariant;
+            v.usesIv = a.usesIv || b.usesIv;
+            switch (op) {
+                case Opcode::I32_ADD:
+                    v.linear = a.linear && b.linear;
+                    v.coef = a.coef + b.coef;
+                    break;
+                case Opcode::I32_SUB:
+                    v.linear = a.linear && b.linear;
+                    v.coef = a.coef - b.coef;
+                    break;
+                case Opcode::I32_MUL:
+                    v.linear = a.linear && b.linear && (a.constant || b.constant);
+                    v.coef = a.constant ? (uint32_t)a.value * b.coef : a.coef * (uint32_t)b.value;
+                    break;
+                case Opcode::I32_SHL:
+                    v.linear = a.linear && b.constant;
+                    v.coef = a.coef << (b.value & 31);
+                    break;
+                default:
+                    v.linear = v.invariant && !isF64Binary(op);
+                    break;
+            }
+            if (!v.linear) v.coef = 0;
+            if (wanted(a) && !wanted(v)) found(a);
+            if (wanted(b) && !wanted(v)) found(b);
+        } else {
+            flush();
+            continue;
+        }
+        stack.push_back(v);
+    }
+    flush();
+}
+
+// A pure expression of values the loop never changes is computed once in
+// front of the loop into a new local, which the loop reads instead. Equal
+// expressions share the local. Nothing here can trap, so computing one the
+// loop might not have reached is harmless.
+bool FunctionOptimizer::hoistInvariants(int32_t head, int32_t end) {
+    std::vector<LoopValue> found;
+    scanLoop(head, end, writesIn(head, end), -1, [](const LoopValue& v) { return v.invariant; },
+             [&found](const LoopValue& v) {
+                 if (v.count >= 2) found.push_back(v);
+             });
+    std::vector<std::pair<std::string, int32_t>> hoisted;
+    for (const auto& v : found) {
+        std::vector<CompiledInstr> instrs = codeOf(v);
+        std::string key = keyOf(instrs);
+        auto it = std::find_if(hoisted.begin(), hoisted.end(), [&key](const auto& h) { return h.first == key; });
+        int32_t slot;
+        if (it != hoisted.end()) {
+            slot = it->second;
+        } else {
+            slot = addLocal(isF64Binary(code[v.root].opcode) ? "f64" : "i32");
+            hoisted.push_back({key, slot});
+            before[head].insert(before[head].end(), instrs.begin(), instrs.end());
+            before[head].push_back(makeInstr(Opcode::LOCAL_SET, slot));
+        }
+        replace(v, slot);
+        stats.invariantsHoisted++;
+    }
+    return !found.empty();
+}
+
+// An induction variable is an i32 local the loop writes exactly once, as
+// i = i + c. An expression coef * i + invariant then changes by coef * c
+// at that write: it gets a local set in front of the loop and stepped
+// right after the write, and the loop reads the local instead. The step
+// costs four instructions per iteration, so this only pays when it saves
+// more than that.
+bool FunctionOptimizer::reduceInductionVariables(int32_t head, int32_t end) {
+    struct Induction {
+        int32_t slot, write, update;
+        uint32_t step;
+    };
+    std::vector<Induction> ivs;
+    std::vector<uint32_t> writes = writesIn(head, end);
+    for (int32_t pc = next(head); pc < end; pc = next(pc)) {
+        const CompiledInstr& instr = code[pc];
+        if ((instr.opcode != Opcode::LOCAL_SET && instr.opcode != Opcode::LOCAL_TEE) || writes[instr.index] != 1) {
+            continue;
+        }
+        int32_t op = prev(pc);
+        int32_t c = prev(op);
+        int32_t get = prev(c);
+        if (get <= head || entered(get, pc) || code[get].opcode != Opcode::LOCAL_GET ||
+            code[get].index != instr.index || code[c].opcode != Opcode::I32_CONST ||
+            (code[op].opcode != Opcode::I32_ADD && code[op].opcode != Opcode::I32_SUB)) {
+            continue;
+        }
+        uint32_t step = code[op].opcode == Opcode::I32_ADD ? (uint32_t)code[c].i32 : 0u - (uint32_t)code[c].i32;
+        ivs.push_back({instr.index, pc, op, step});
+    }
+
+    // Whole expression, its pieces replaced so far and savings
+    struct Group {
+        std::string key;
+        std::vector<CompiledInstr> instrs;
+        std::vector<LoopValue> uses;
+        int32_t saved = 0;
+    };
+    const int32_t stepCost = 4;
+    bool changed = false;
+    for (const auto& iv : ivs) {
+        std::vector<Group> groups;
+        scanLoop(head, end, writesIn(head, end), iv.slot,
+                 [](const LoopValue& v) { return v.linear && v.usesIv && v.coef != 0; },
+                 [&](const LoopValue& v) {
+                     if (v.count < 3 || v.root == iv.update) return;
+                     std::vector<CompiledInstr> instrs = codeOf(v);
+                     std::string key = keyOf(instrs);
+                     auto it = std::find_if(groups.begin(), groups.end(), [&key](const Group& g) { return g.key == key; });
+                     if (it == groups.end()) it = groups.insert(groups.end(), {key, instrs, {}, 0});
+                     it->uses.push_back(v);
+                     it->saved += v.count - 1;
+                 });
+        for (const auto& g : groups) {
+            if (g.saved <= stepCost) continue;
+            int32_t slot = addLocal("i32");
+            before[head].insert(before[head].end(), g.instrs.begin(), g.instrs.end());
+            before[head].push_back(makeInstr(Opcode::LOCAL_SET, slot));
+            CompiledInstr delta = makeInstr(Opcode::I32_CONST);
+            delta.i32 = (int32_t)(g.uses[0].coef * iv.step);
+            after[iv.write].insert(after[iv.write].end(), {makeInstr(Opcode::LOCAL_GET, slot), delta,
+                                                           makeInstr(Opcode::I32_ADD), makeInstr(Opcode::LOCAL_SET, slot)});
+            for (const auto& v : g.uses) replace(v, slot);
+            stats.strengthReduced += g.uses.size();
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool FunctionOptimizer::optimizeLoops(bool hoist, bool reduce) {
+    if (std::none_of(code.begin(), code.end(), [](const CompiledInstr& i) { return i.opcode == Opcode::LOOP; })) {
+        return false;
+    }
+    findTargets();
+    std::vector<std::pair<int32_t, int32_t>> loops = findLoops();
+    if (loops.empty()) return false;
+    before.assign(code.size(), {});
+    after.assign(code.size(), {});
+    bool changed = false;
+    // Outer loops first, so what they hoist is already a local read when
+    // the inner ones are scanned
+    if (hoist) {
+        for (const auto& loop : loops) changed |= hoistInvariants(loop.first, loop.second);
+    }
+    if (reduce) {
+        for (const auto& loop : loops) changed |= reduceInductionVariables(loop.first, loop.second);
+    }
+    if (changed) {
+        compact();
+    } else {
+        before.clear();
+        after.clear();
+    }
+    return changed;
+}
+
+} // namespace
+
+Optimizer::Optimizer(OptimizerOptions options) : opts(options) {}
+
+OptimizerStats Optimizer::optimize(CompiledFunction& func, std::vector<CompiledInstr>& code,
+                                   std::vector<BranchTarget>& branchTable) const {
+    OptimizerStats stats;
+    stats.instructionsBefore = code.size();
+    if (opts.any() && !code.empty()) {
+        FunctionOptimizer pass(func, code, branchTable, stats);
+        // One pass feeds the next: a propagated constant folds, and the
+        // store it came from dies. Bounded, as a safety net.
+        for (int round = 0; round < 8; ++round) {
+            bool changed = false;
+            if (opts.copyPropagation) changed |= pass.propagateCopies();
+            if (opts.constantFolding) changed |= pass.foldConstants();
+            if (opts.deadStoreElimination) changed |= pass.eliminateDeadStores();
+            if (opts.unreachableCode) changed |= pass.removeUnreachable();
+            if (opts.loopInvariantMotion || opts.strengthReduction) {
+                changed |= pass.optimizeLoops(opts.loopInvariantMotion, opts.strengthReduction);
+            }
+            if (!changed) break;
+        }
+        pass.compact();
+    }
+    stats.instructionsAfter = code.size();
+    return stats;
+}
@@ -1,28 +1,212 @@
 #include "Parser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), pos(0) {}
+namespace {
+
+const Token kEndOfFile{TokenType::END_OF_FILE, ""};
+
+// Identifiers are stored without their '$' sigil.
+std::string stripSigil(std::string_view text) {
+    if (!text.empty() && text[0] == '$') text.remove_prefix(1);
+    return std::string(text);
+}
+
+// STRING tokens keep their escapes; a backslash takes the next character
+// literally.
+std::string unescape(std::string_view raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] == '\\' && i + 1 < raw.size()) ++i;
+        out += raw[i];
+    }
+    return out;
+}
+
+template <typename T>
+T parseInteger(std::string_view text) {
+    T value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("Invalid integer literal: " + std::string(text));
+    }
+    return value;
+}
+
+template <typename T>
+T parseFloat(std::string_view text) {
+    T value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("Invalid float literal: " + std::string(text));
+    }
+    return value;
+}
+
+} // namespace
+
+Parser::Parser(const std::vector<Token>& tokens)
+    : tokens(&tokens), lexer(nullptr), pos(0), windowHead(0), windowSize(0), lazyBodies(false) {}
+
+Parser::Parser(Lexer& lexer)
+    : tokens(nullptr), lexer(&lexer), pos(0), windowHead(0), windowSize(0), lazyBodies(false) {}
 
 Module Parser::parse() {
     Module module;
-    while (pos < tokens.size() && tokens[pos].type != TokenType::END_OF_FILE) {
+    while (peek().type != TokenType::END_OF_FILE) {
         parseTopLevel(module);
     }
     return module;
 }
 
-Token Parser::peek() {
-    if (pos >= tokens.size()) return {TokenType::END_OF_FILE, ""};
-    return tokens[pos];
+namespace {
+
+// Byte range of one module field, "(func ...)" included.
+struct FieldRange {
+    size_t begin;
+    size_t end;
+    bool isFunc;
+};
+
+// Finds the fields of every top-level form by tracking parenthesis depth
+// only, skipping comments and string literals. This is much cheaper than
+// tokenizing, so it can run on one thread ahead of the parallel parse.
+std::vector<FieldRange> scanFields(std::string_view src, std::vector<size_t>& forms) {
+    std::vector<FieldRange> fields;
+    int depth = 0;
+    size_t fieldStart = 0;
+    for (size_t i = 0; i < src.size(); ++i) {
+        char c = src[i];
+        if (c == ';' && i + 1 < src.size() && src[i + 1] == ';') {
+            while (i < src.size() && src[i] != '\n') i++;
+        } else if (c == '"') {
+            for (i++; i < src.size() && src[i] != '"'; i++) {
+                if (src[i] == '\\') i++;
+            }
+        } else if (c == '(') {
+            if (depth == 0) forms.push_back(i);
+            if (depth == 1) fieldStart = i;
+            depth++;
+        } else if (c == ')') {
+            if (--depth < 0) throw std::runtime_error("Unbalanced parentheses");
+            if (depth == 1) {
+                Lexer lexer(src.substr(fieldStart + 1));
+                fields.push_back({fieldStart, i + 1, lexer.next().text == "func"});
+            }
+        }
+    }
+    if (depth != 0) throw std::runtime_error("Unbalanced parentheses");
+    return fields;
+}
+
+} // namespace
+
+Module Parser::parseParallel(std::string_view source, ThreadPool& pool) {
+    std::vector<size_t> forms;
+    std::vector<FieldRange> fields = scanFields(source, forms);
+    for (size_t start : forms) {
+        Lexer lexer(source.substr(start));
+        lexer.next();
+        if (lexer.next().text != "module") throw std::runtime_error("Expected module");
+    }
+
+    std::vector<const FieldRange*> funcs;
+    for (const auto& f : fields) {
+        if (f.isFunc) funcs.push_back(&f);
+    }
+
+    // A few chunks per worker keeps the pool busy without paying one task
+    // per function; each chunk keeps its functions in source order.
+    size_t chunks = std::min(funcs.size(), pool.size() * 4);
+    std::vector<std::future<std::vector<Function>>> parsed;
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t first = funcs.size() * c / chunks;
+        size_t last = funcs.size() * (c + 1) / chunks;
+        parsed.push_back(pool.submit([&source, &funcs, first, last]() {
+            Module fragment;
+            for (size_t i = first; i < last; ++i) {
+                Lexer lexer(source.substr(funcs[i]->begin, funcs[i]->end - funcs[i]->begin));
+                Parser(lexer).parseField(fragment);
+            }
+            return std::move(fragment.functions);
+        }));
+    }
+
+    Module module;
+    try {
+        // Everything but function bodies is small; parse it here meanwhile.
+        for (const auto& f : fields) {
+            if (f.isFunc) continue;
+            Lexer lexer(source.substr(f.begin, f.end - f.begin));
+            Parser(lexer).parseField(module);
+        }
+
+        module.functions.reserve(funcs.size());
+        for (auto& chunk : parsed) {
+            for (auto& func : chunk.get()) {
+                module.functions.push_back(std::move(func));
+            }
+        }
+    } catch (...) {
+        // Chunks still running read source and fields; they must finish
+        // before the error unwinds this frame.
+        for (auto& chunk : parsed) {
+            if (chunk.valid()) chunk.wait();
+        }
+        throw;
+    }
+    return module;
+}
+
+Module Parser::parseLazy(std::string_view source, std::shared_ptr<const void> owner) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    parser.lazyBodies = true;
+    Module module = parser.parse();
+    module.lazySource = std::move(owner);
+    return module;
+}
+
+std::vector<Instruction> Parser::parseBody(std::string_view body) {
+    Lexer lexer(body);
+    Parser parser(lexer);
+    std::vector<Instruction> out;
+    while (parser.peek().type != TokenType::END_OF_FILE) {
+        parser.parseInstruction(out);
+    }
+    return out;
+}
+
+const Token& Parser::peek(size_t ahead) {
+    if (tokens) {
+        size_t i = pos + ahead;
+        return i < tokens->size() ? (*tokens)[i] : kEndOfFile;
+    }
+    while (windowSize <= ahead) {
+        window[(windowHead + windowSize) % 2] = lexer->next();
+        windowSize++;
+    }
+    return window[(windowHead + ahead) % 2];
 }
 
 Token Parser::consume() {
-    return tokens[pos++];
+    Token t = peek();
+    if (tokens) {
+        if (pos < tokens->size()) pos++;
+    } else {
+        windowHead = (windowHead + 1) % 2;
+        windowSize--;
+    }
+    return t;
 }
 
 Token Parser::expect(TokenType type) {
     Token t = consume();
     if (t.type != type) {
-        throw std::runtime_error("Unexpected token: " + t.text + " expected type " + std::to_string((int)type));
+        throw std::runtime_error("Unexpected token: " + std::string(t.text) + " expected type " + std::to_string((int)type));
     }
     return t;
 }
@@ -35,106 +219,113 @@ void Parser::parseTopLevel(Module& mod) {
     }
 
     while (peek().type == TokenType::LPAREN) {
-        size_t checkpoint = pos;
-        consume(); // (
-        Token fieldName = peek();
-        if (fieldName.text == "func") {
-            consume();
-            mod.functions.push_back(parseFunc());
-        } else if (fieldName.text == "import") {
-            consume();
-            mod.imports.push_back(parseImport());
-        } else if (fieldName.text == "type") {
-            consume();
-            mod.types.push_back(parseType());
-        } else if (fieldName.text == "table") {
-            consume();
-            mod.tables.push_back(parseTable());
-        } else if (fieldName.text == "elem") {
-            consume();
-            mod.elements.push_back(parseElem());
-        } else if (fieldName.text == "string") {
-            consume();
-            StringDefinition strDef;
-            if (peek().type == TokenType::IDENTIFIER) {
-                std::string raw = consume().text;
-                if (!raw.empty() && raw[0] == '$') raw = raw.substr(1);
-                strDef.name = raw;
-            } else {
-                throw std::runtime_error("Expected identifier for string definition");
-            }
-            if (peek().type == TokenType::STRING) {
-                strDef.value = consume().text;
-            } else {
-                throw std::runtime_error("Expected string value for string definition");
-            }
-            mod.strings.push_back(strDef);
-            expect(TokenType::RPAREN);
+        parseField(mod);
+    }
+    expect(TokenType::RPAREN);
+}
+
+void Parser::parseField(Module& mod) {
+    expect(TokenType::LPAREN);
+    Token fieldName = peek();
+    if (fieldName.text == "func") {
+        consume();
+        mod.functions.push_back(parseFunc());
+    } else if (fieldName.text == "import") {
+        consume();
+        mod.imports.push_back(parseImport());
+    } else if (fieldName.text == "type") {
+        consume();
+        mod.types.push_back(parseType());
+    } else if (fieldName.text == "table") {
+        consume();
+        mod.tables.push_back(parseTable());
+    } else if (fieldName.text == "elem") {
+        consume();
+        mod.elements.push_back(parseElem());
+    } else if (fieldName.text == "global") {
+        consume();
+        mod.globals.push_back(parseGlobal());
+    } else if (fieldName.text == "export") {
+        consume();
+        mod.exports.push_back(parseExport());
+    } else if (fieldName.text == "string") {
+        consume();
+        StringDefinition strDef;
+        if (peek().type == TokenType::IDENTIFIER) {
+            strDef.name = stripSigil(consume().text);
+        } else {
+            throw std::runtime_error("Expected identifier for string definition");
+        }
+        if (peek().type == TokenType::STRING) {
+            strDef.value = unescape(consume().text);
         } else {
-            pos = checkpoint + 1;
-            skipSExpr();
+            throw std::runtime_error("Expected string value for string definition");
         }
+        mod.strings.push_back(strDef);
+        expect(TokenType::RPAREN);
+    } else {
+        skipSExpr();
     }
-    expect(TokenType::RPAREN);
 }
 
 Function Parser::parseFunc() {
     Function func;
 
     if (peek().type == TokenType::IDENTIFIER) {
-        std::string raw = consume().text;
-        if (!raw.empty() && raw[0] == '$') raw = raw.substr(1);
-        func.name = raw;
+        func.name = stripSigil(consume().text);
     }
 
     while (peek().type != TokenType::RPAREN) {
         if (peek().type == TokenType::LPAREN) {
-            size_t checkpoint = pos;
-            consume(); // (
-            Token inner = peek();
+            Token inner = peek(1);
             if (inner.text == "param") {
+                consume(); // (
                 consume();
                 // (param $x i32) or (param i32)
                 while (peek().type != TokenType::RPAREN) {
                     std::string name = "";
                     if (peek().type == TokenType::IDENTIFIER) {
-                        name = consume().text;
-                        if (!name.empty() && name[0] == '$') name = name.substr(1);
+                        name = stripSigil(consume().text);
                     }
                     if (peek().type == TokenType::KEYWORD) {
-                        func.paramTypes.push_back(consume().text);
+                        func.paramTypes.push_back(std::string(consume().text));
                         func.paramNames.push_back(name);
                     }
                 }
                 expect(TokenType::RPAREN);
             } else if (inner.text == "result") {
+                consume(); // (
                 consume();
                 while (peek().type != TokenType::RPAREN) {
-                    func.resultTypes.push_back(consume().text);
+                    func.resultTypes.push_back(std::string(consume().text));
                 }
                 expect(TokenType::RPAREN);
             } else if (inner.text == "local") {
+                consume(); // (
                 consume();
                 while (peek().type != TokenType::RPAREN) {
                         std::string name = "";
                         if (peek().type == TokenType::IDENTIFIER) {
-                            name = consume().text;
-                            if (!name.empty() && name[0] == '$') name = name.substr(1);
+                            name = stripSigil(consume().text);
                         }
                         if (peek().type == TokenType::KEYWORD) {
-                            func.localTypes.push_back(consume().text);
+                            func.localTypes.push_back(std::string(consume().text));
                             func.localNames.push_back(name);
                         }
                 }
                 expect(TokenType::RPAREN);
+            } else if (lazyBodies) {
+                // Record the body's text and skip it; parseBody reads it later
+                const char* begin = func.lazyBody.empty() ? peek().text.data() : func.lazyBody.data();
+                consume(); // (
+                Token last = skipSExpr();
+                func.lazyBody = std::string_view(begin, last.text.data() + last.text.size() - begin);
             } else {
-                // Instruction
-                pos = checkpoint; // Go back to (
                 parseInstruction(func.body);
             }
         } else {
             // Only S-expressions supported
-            throw std::runtime_error("Flat instructions are not supported. Found token: " + peek().text);
+            throw std::runtime_error("Flat instructions are not supported. Found token: " + std::string(peek().text));
         }
     }
     expect(TokenType::RPAREN);
@@ -144,9 +335,7 @@ Function Parser::parseFunc() {
 Type Parser::parseType() {
     Type t;
     if (peek().type == TokenType::IDENTIFIER) {
-        std::string raw = consume().text;
-        if (!raw.empty() && raw[0] == '$') raw = raw.substr(1);
-        t.name = raw;
+        t.name = stripSigil(consume().text);
     }
 
     expect(TokenType::LPAREN);
@@ -161,12 +350,12 @@ Type Parser::parseType() {
                      consume(); // skip name
                  }
                  if (peek().type == TokenType::KEYWORD) {
-                     t.paramTypes.push_back(consume().text);
+                     t.paramTypes.push_back(std::string(consume().text));
                  }
              }
         } else if (inner.text == "result") {
              while (peek().type != TokenType::RPAREN) {
-                 t.resultTypes.push_back(consume().text);
+                 t.resultTypes.push_back(std::string(consume().text));
              }
         } else {
              throw std::runtime_error("Unexpected token in type definition");
@@ -182,17 +371,15 @@ Table Parser::parseTable() {
     Table tbl;
     // (table $name? min max? funcref)
     if (peek().type == TokenType::IDENTIFIER) {
-        std::string raw = consume().text;
-        if (!raw.empty() && raw[0] == '$') raw = raw.substr(1);
-        tbl.name = raw;
+        tbl.name = stripSigil(consume().text);
     }
 
     Token t1 = consume();
     if (t1.type != TokenType::INTEGER) throw std::runtime_error("Expected min size for table");
-    tbl.min = std::stoi(t1.text);
+    tbl.min = parseInteger<int32_t>(t1.text);
 
     if (peek().type == TokenType::INTEGER) {
-        tbl.max = std::stoi(consume().text);
+        tbl.max = parseInteger<int32_t>(consume().text);
     } else {
         tbl.max = tbl.min;
     }
@@ -211,19 +398,59 @@ ElementSegment Parser::parseElem() {
     // The offset must be i32.const
     if (consume().text != "i32.const") throw std::runtime_error("Expected i32.const in elem offset");
     Token off = consume();
-    elem.offset = Instruction(Opcode::I32_CONST, (int32_t)std::stoi(off.text));
+    elem.offset = Instruction(Opcode::I32_CONST, parseInteger<int32_t>(off.text));
     expect(TokenType::RPAREN);
 
     while (peek().type != TokenType::RPAREN) {
         Token funcName = consume();
-        std::string name = funcName.text;
-        if (!name.empty() && name[0] == '$') name = name.substr(1);
-        elem.functionNames.push_back(name);
+        elem.functionNames.push_back(stripSigil(funcName.text));
     }
     expect(TokenType::RPAREN);
     return elem;
 }
 
+Global Parser::parseGlobal() {
+    Global g;
+    // (global $name? (mut type) | type (const-expr))
+    if (peek().type == TokenType::IDENTIFIER) {
+        g.name = stripSigil(consume().text);
+    }
+
+    g.isMutable = false;
+    if (peek().type == TokenType::LPAREN) {
+        consume();
+        if (consume().text != "mut") throw std::runtime_error("Expected mut in global type");
+        g.type = std::string(expect(TokenType::KEYWORD).text);
+        g.isMutable = true;
+        expect(TokenType::RPAREN);
+    } else {
+        g.type = std::string(expect(TokenType::KEYWORD).text);
+    }
+
+    expect(TokenType::LPAREN);
+    Opcode op = mapOpcode(consume().text);
+    if (op != Opcode::I32_CONST && op != Opcode::I64_CONST && op != Opcode::F32_CONST && op != Opcode::F64_CONST) {
+        throw std::runtime_error("Expected constant initializer for global");
+    }
+    g.init = parseImmediate(op);
+    expect(TokenType::RPAREN);
+    expect(TokenType::RPAREN);
+    return g;
+}
+
+Export Parser::parseExport() {
+    Export exp;
+    // (export "name" (func $f))
+    exp.name = unescape(expect(TokenType::STRING).text);
+    expect(TokenType::LPAREN);
+    exp.kind = std::string(expect(TokenType::KEYWORD).text);
+    std::string target = stripSigil(consume().text);
+    exp.target = target;
+    expect(TokenType::RPAREN);
+    expect(TokenType::RPAREN);
+    return exp;
+}
+
 void Parser::parseInstruction(std::vector<Instruction>& out) {
     if (peek().type == TokenType::LPAREN) {
         // Folded: (opcode arg1 arg2)
@@ -243,6 +470,51 @@ void Parser::parseInstruction(std::vector<Instruction>& out) {
              expect(TokenType::RPAREN);
              out.push_back(Instruction(Opcode::END)); // END
         }
+        else if (op == Opcode::IF) {
+            // (if $label? cond... (then ...) (else ...)?) becomes
+            // cond IF then-body [ELSE else-body] END
+            std::string label;
+            if (peek().type == TokenType::IDENTIFIER) label = stripSigil(consume().text);
+            if (peek().type == TokenType::LPAREN && peek(1).text == "result") {
+                throw std::runtime_error("Block results are not supported");
+            }
+            while (!(peek().type == TokenType::LPAREN && peek(1).text == "then")) {
+                if (peek().type == TokenType::RPAREN) throw std::runtime_error("Expected (then ...) in if");
+                parseInstruction(out);
+            }
+            out.push_back(Instruction(Opcode::IF, label));
+            consume(); // (
+            consume(); // then
+            while (peek().type != TokenType::RPAREN) {
+                parseInstruction(out);
+            }
+            expect(TokenType::RPAREN);
+            if (peek().type == TokenType::LPAREN && peek(1).text == "else") {
+                consume(); // (
+                consume(); // else
+                out.push_back(Instruction(Opcode::ELSE));
+                while (peek().type != TokenType::RPAREN) {
+                    parseInstruction(out);
+                }
+                expect(TokenType::RPAREN);
+            }
+            expect(TokenType::RPAREN);
+            out.push_back(Instruction(Opcode::END));
+        }
+        else if (op == Opcode::BR_TABLE) {
+            // (br_table $l... $default (index))
+            std::string labels;
+            while (peek().type == TokenType::IDENTIFIER || peek().type == TokenType::INTEGER) {
+                if (!labels.empty()) labels += ' ';
+                labels += stripSigil(consume().text);
+            }
+            if (labels.empty()) throw std::runtime_error("Expected labels in br_table");
+            while (peek().type != TokenType::RPAREN) {
+                parseInstruction(out);
+            }
+            expect(TokenType::RPAREN);
+            out.push_back(Instruction(Opcode::BR_TABLE, labels));
+        }
         else if (op == Opcode::CALL_INDIRECT) {
             // (call_indirect (type $t) (arg1) ... (index))
             // This is folded. In RPN: arg1 ... index call_indirect $t
@@ -255,9 +527,7 @@ void Parser::parseInstruction(std::vector<Instruction>& out) {
                 consume();
                 if (consume().text != "type") throw std::runtime_error("Expected type in call_indirect");
                 Token typeName = consume();
-                std::string val = typeName.text;
-                if (!val.empty() && val[0] == '$') val = val.substr(1);
-                instr.operand = val;
+                instr.operand = stripSigil(typeName.text);
                 expect(TokenType::RPAREN);
             } else {
                  throw std::runtime_error("Expected type annotation for call_indirect");
@@ -290,7 +560,7 @@ void Parser::parseInstruction(std::vector<Instruction>& out) {
             out.push_back(Instruction(op));
         }
     } else {
-        throw std::runtime_error("Flat instructions are not supported. Found token: " + peek().text);
+        throw std::runtime_error("Flat instructions are not supported. Found token: " + std::string(peek().text));
     }
 }
 
@@ -312,6 +582,13 @@ bool Parser::takesImmediate(Opcode op) {
         case Opcode::BLOCK:
         case Opcode::LOOP:
         case Opcode::STRING_CONST:
+        case Opcode::V128_CONST:
+        case Opcode::I32X4_EXTRACT_LANE:
+        case Opcode::I32X4_REPLACE_LANE:
+        case Opcode::F32X4_EXTRACT_LANE:
+        case Opcode::F32X4_REPLACE_LANE:
+        case Opcode::F64X2_EXTRACT_LANE:
+        case Opcode::F64X2_REPLACE_LANE:
             return true;
         default:
             return false;
@@ -331,84 +608,297 @@ Instruction Parser::parseImmediate(Opcode op) {
         if (typeKwd.text != "type") throw std::runtime_error("Expected (type ...) in call_indirect");
         Token typeName = consume();
         if (typeName.type != TokenType::IDENTIFIER) throw std::runtime_error("Expected type identifier");
-        std::string t = typeName.text;
-        if (!t.empty() && t[0] == '$') t = t.substr(1);
+        std::string t = stripSigil(typeName.text);
         expect(TokenType::RPAREN);
 
         // Return instruction with the type alias as operand
         return Instruction(op, t);
     }
 
+    if (op == Opcode::V128_CONST) return parseV128Const();
+
     Token t = consume();
-    if (op == Opcode::I32_CONST) return Instruction(op, (int32_t)std::stoi(t.text));
-    if (op == Opcode::I64_CONST) return Instruction(op, (int64_t)std::stoll(t.text));
-    if (op == Opcode::F32_CONST) return Instruction(op, std::stof(t.text));
-    if (op == Opcode::F64_CONST) return Instruction(op, std::stod(t.text));
+    if (op == Opcode::I32_CONST) return Instruction(op, parseInteger<int32_t>(t.text));
+    if (op == Opcode::I64_CONST) return Instruction(op, parseInteger<int64_t>(t.text));
+    if (op == Opcode::F32_CONST) return Instruction(op, parseFloat<float>(t.text));
+    if (op == Opcode::F64_CONST) return Instruction(op, parseFloat<double>(t.text));
+    if (op >= Opcode::I32X4_SPLAT && op <= Opcode::F64X2_GE) {
+        // Lane index of extract_lane/replace_lane; CompiledModule checks its range
+        if (t.type != TokenType::INTEGER) throw std::runtime_error("Expected lane index: " + std::string(t.text));
+        return Instruction(op, parseInteger<int32_t>(t.text));
+    }
 
     // Identifiers or indices
     if (t.type == TokenType::IDENTIFIER || t.type == TokenType::INTEGER) {
-        std::string val = t.text;
-        if (!val.empty() && val[0] == '$') val = val.substr(1);
-        return Instruction(op, val); // Store as string, resolve later
+        return Instruction(op, stripSigil(t.text)); // Store as string, resolve later
     }
 
-    throw std::runtime_error("Invalid immediate for opcode: " + t.text);
+    throw std::runtime_error("Invalid immediate for opcode: " + std::string(t.text));
 }
 
-Opcode Parser::mapOpcode(const std::string& txt) {
-    static const std::unordered_map<std::string, Opcode> map = {
-        {"i32.const", Opcode::I32_CONST},
-        {"i32.add", Opcode::I32_ADD},
-        {"i32.sub", Opcode::I32_SUB},
-        {"i32.mul", Opcode::I32_MUL},
-        {"f64.const", Opcode::F64_CONST},
-        {"f64.add", Opcode::F64_ADD},
-        {"f64.sub", Opcode::F64_SUB},
-        {"f64.mul", Opcode::F64_MUL},
-        {"f64.div", Opcode::F64_DIV},
-        {"local.get", Opcode::LOCAL_GET},
-        {"local.set", Opcode::LOCAL_SET},
-        {"call", Opcode::CALL},
-        {"call_indirect", Opcode::CALL_INDIRECT},
-        {"return", Opcode::RETURN},
-        {"block", Opcode::BLOCK},
-        {"loop", Opcode::LOOP},
-        {"br", Opcode::BR},
-        {"br_if", Opcode::BR_IF},
-        {"end", Opcode::END},
-        {"i32.eq", Opcode::I32_EQ},
-        {"i32.ne", Opcode::I32_NE},
-        {"i32.lt_s", Opcode::I32_LT_S},
-        {"i32.gt_s", Opcode::I32_GT_S},
-        {"i32.le_s", Opcode::I32_LE_S},
-        {"i32.ge_s", Opcode::I32_GE_S},
-        {"string.const", Opcode::STRING_CONST},
+// (v128.const shape lane...), lanes listed from lane 0 up.
+Instruction Parser::parseV128Const() {
+    std::string_view shape = expect(TokenType::KEYWORD).text;
+    V128 value;
+    auto lanes = [&](auto zero, auto parse) {
+        using Lane = decltype(zero);
+        for (size_t i = 0; i < 16 / sizeof(Lane); ++i) {
+            Lane lane = parse(consume().text);
+            std::memcpy(value.bytes + i * sizeof(Lane), &lane, sizeof(Lane));
+        }
     };
-    if (map.count(txt)) return map.at(txt);
-    if (txt.find("store") != std::string::npos || txt.find("load") != std::string::npos) {
+    if (shape == "i32x4") {
+        lanes(int32_t(0), parseInteger<int32_t>);
+    } else if (shape == "i64x2") {
+        lanes(int64_t(0), parseInteger<int64_t>);
+    } else if (shape == "f32x4") {
+        lanes(0.0f, parseFloat<float>);
+    } else if (shape == "f64x2") {
+        lanes(0.0, parseFloat<double>);
+    } else {
+        throw std::runtime_error("Unsupported v128.const shape: " + std::string(shape));
+    }
+    return Instruction(Opcode::V128_CONST, value);
+}
+
+namespace {
+
+struct OpcodeName {
+    std::string_view name;
+    Opcode opcode;
+};
+
+constexpr OpcodeName kOpcodeNames[] = {
+    {"i32.const", Opcode::I32_CONST},
+    {"i32.add", Opcode::I32_ADD},
+    {"i32.sub", Opcode::I32_SUB},
+    {"i32.mul", Opcode::I32_MUL},
+    {"i64.const", Opcode::I64_CONST},
+    {"f32.const", Opcode::F32_CONST},
+    {"f64.const", Opcode::F64_CONST},
+    {"f64.add", Opcode::F64_ADD},
+    {"f64.sub", Opcode::F64_SUB},
+    {"f64.mul", Opcode::F64_MUL},
+    {"f64.div", Opcode::F64_DIV},
+    {"local.get", Opcode::LOCAL_GET},
+    {"local.set", Opcode::LOCAL_SET},
+    {"local.tee", Opcode::LOCAL_TEE},
+    {"global.get", Opcode::GLOBAL_GET},
+    {"global.set", Opcode::GLOBAL_SET},
+    {"call", Opcode::CALL},
+    {"call_indirect", Opcode::CALL_INDIRECT},
+    {"return", Opcode::RETURN},
+    {"block", Opcode::BLOCK},
+    {"loop", Opcode::LOOP},
+    {"br", Opcode::BR},
+    {"br_if", Opcode::BR_IF},
+    {"br_table", Opcode::BR_TABLE},
+    {"if", Opcode::IF},
+    {"else", Opcode::ELSE},
+    {"end", Opcode::END},
+    {"i32.eqz", Opcode::I32_EQZ},
+    {"i32.eq", Opcode::I32_EQ},
+    {"i32.ne", Opcode::I32_NE},
+    {"i32.lt_s", Opcode::I32_LT_S},
+    {"i32.lt_u", Opcode::I32_LT_U},
+    {"i32.gt_s", Opcode::I32_GT_S},
+    {"i32.gt_u", Opcode::I32_GT_U},
+    {"i32.le_s", Opcode::I32_LE_S},
+    {"i32.le_u", Opcode::I32_LE_U},
+    {"i32.ge_s", Opcode::I32_GE_S},
+    {"i32.ge_u", Opcode::I32_GE_U},
+    {"i32.clz", Opcode::I32_CLZ},
+    {"i32.ctz", Opcode::I32_CTZ},
+    {"i32.popcnt", Opcode::I32_POPCNT},
+    {"i32.div_s", Opcode::I32_DIV_S},
+    {"i32.div_u", Opcode::I32_DIV_U},
+    {"i32.rem_s", Opcode::I32_REM_S},
+    {"i32.rem_u", Opcode::I32_REM_U},
+    {"i32.and", Opcode::I32_AND},
+    {"i32.or", Opcode::I32_OR},
+    {"i32.xor", Opcode::I32_XOR},
+    {"i32.shl", Opcode::I32_SHL},
+    {"i32.shr_s", Opcode::I32_SHR_S},
+    {"i32.shr_u", Opcode::I32_SHR_U},
+    {"i32.rotl", Opcode::I32_ROTL},
+    {"i32.rotr", Opcode::I32_ROTR},
+    {"unreachable", Opcode::UNREACHABLE},
+    {"nop", Opcode::NOP},
+    {"string.const", Opcode::STRING_CONST},
+    {"v128.const", Opcode::V128_CONST},
+    {"v128.load", Opcode::V128_LOAD},
+    {"v128.store", Opcode::V128_STORE},
+    {"v128.not", Opcode::V128_NOT},
+    {"v128.and", Opcode::V128_AND},
+    {"v128.andnot", Opcode::V128_ANDNOT},
+    {"v128.or", Opcode::V128_OR},
+    {"v128.xor", Opcode::V128_XOR},
+    {"i32x4.splat", Opcode::I32X4_SPLAT},
+    {"i32x4.extract_lane", Opcode::I32X4_EXTRACT_LANE},
+    {"i32x4.replace_lane", Opcode::I32X4_REPLACE_LANE},
+    {"i32x4.add", Opcode::I32X4_ADD},
+    {"i32x4.sub", Opcode::I32X4_SUB},
+    {"i32x4.mul", Opcode::I32X4_MUL},
+    {"i32x4.neg", Opcode::I32X4_NEG},
+    {"i32x4.min_s", Opcode::I32X4_MIN_S},
+    {"i32x4.max_s", Opcode::I32X4_MAX_S},
+    {"i32x4.eq", Opcode::I32X4_EQ},
+    {"i32x4.ne", Opcode::I32X4_NE},
+    {"i32x4.lt_s", Opcode::I32X4_LT_S},
+    {"i32x4.lt_u", Opcode::I32X4_LT_U},
+    {"i32x4.gt_s", Opcode::I32X4_GT_S},
+    {"i32x4.gt_u", Opcode::I32X4_GT_U},
+    {"i32x4.le_s", Opcode::I32X4_LE_S},
+    {"i32x4.ge_s", Opcode::I32X4_GE_S},
+    {"f32x4.splat", Opcode::F32X4_SPLAT},
+    {"f32x4.extract_lane", Opcode::F32X4_EXTRACT_LANE},
+    {"f32x4.replace_lane", Opcode::F32X4_REPLACE_LANE},
+    {"f32x4.add", Opcode::F32X4_ADD},
+    {"f32x4.sub", Opcode::F32X4_SUB},
+    {"f32x4.mul", Opcode::F32X4_MUL},
+    {"f32x4.div", Opcode::F32X4_DIV},
+    {"f32x4.neg", Opcode::F32X4_NEG},
+    {"f32x4.abs", Opcode::F32X4_ABS},
+    {"f32x4.sqrt", Opcode::F32X4_SQRT},
+    {"f32x4.eq", Opcode::F32X4_EQ},
+    {"f32x4.ne", Opcode::F32X4_NE},
+    {"f32x4.lt", Opcode::F32X4_LT},
+    {"f32x4.gt", Opcode::F32X4_GT},
+    {"f32x4.le", Opcode::F32X4_LE},
+    {"f32x4.ge", Opcode::F32X4_GE},
+    {"f64x2.splat", Opcode::F64X2_SPLAT},
+    {"f64x2.extract_lane", Opcode::F64X2_EXTRACT_LANE},
+    {"f64x2.replace_lane", Opcode::F64X2_REPLACE_LANE},
+    {"f64x2.add", Opcode::F64X2_ADD},
+    {"f64x2.sub", Opcode::F64X2_SUB},
+    {"f64x2.mul", Opcode::F64X2_MUL},
+    {"f64x2.div", Opcode::F64X2_DIV},
+    {"f64x2.neg", Opcode::F64X2_NEG},
+    {"f64x2.abs", Opcode::F64X2_ABS},
+    {"f64x2.sqrt", Opcode::F64X2_SQRT},
+    {"f64x2.eq", Opcode::F64X2_EQ},
+    {"f64x2.ne", Opcode::F64X2_NE},
+    {"f64x2.lt", Opcode::F64X2_LT},
+    {"f64x2.gt", Opcode::F64X2_GT},
+    {"f64x2.le", Opcode::F64X2_LE},
+    {"f64x2.ge", Opcode::F64X2_GE},
+};
+constexpr size_t kOpcodeCount = sizeof(kOpcodeNames) / sizeof(kOpcodeNames[0]);
+
+// Two-level perfect hash built at compile time: the first hash picks a
+// bucket, and each bucket stores the seed that sends its keys to distinct
+// slots. A lookup is two hashes and one string compare.
+constexpr size_t kOpcodeBuckets = 64;
+constexpr size_t kOpcodeSlots = 256;
+
+constexpr uint32_t hashName(std::string_view s, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : s) {
+        h ^= (uint8_t)c;
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+struct OpcodeHash {
+    uint16_t seed[kOpcodeBuckets];
+    int16_t slot[kOpcodeSlots];
+};
+
+constexpr OpcodeHash buildOpcodeHash() {
+    OpcodeHash ph{};
+    for (size_t i = 0; i < kOpcodeSlots; ++i) ph.slot[i] = -1;
+
+    size_t bucketSize[kOpcodeBuckets] = {};
+    for (size_t i = 0; i < kOpcodeCount; ++i) {
+        bucketSize[hashName(kOpcodeNames[i].name, 0) % kOpcodeBuckets]++;
+    }
+
+    // Place the largest buckets first, while slots are still plentiful
+    bool placed[kOpcodeBuckets] = {};
+    for (size_t round = 0; round < kOpcodeBuckets; ++round) {
+        size_t bucket = 0;
+        size_t best = 0;
+        for (size_t b = 0; b < kOpcodeBuckets; ++b) {
+            if (!placed[b] && bucketSize[b] >= best) {
+                bucket = b;
+                best = bucketSize[b];
+            }
+        }
+        placed[bucket] = true;
+        if (best == 0) continue;
+
+        for (uint16_t seed = 1;; ++seed) {
+            size_t slots[kOpcodeCount] = {};
+            size_t n = 0;
+            bool ok = true;
+            for (size_t i = 0; i < kOpcodeCount && ok; ++i) {
+                if (hashName(kOpcodeNames[i].name, 0) % kOpcodeBuckets != bucket) continue;
+                size_t slot = hashName(kOpcodeNames[i].name, seed) % kOpcodeSlots;
+                if (ph.slot[slot] >= 0) ok = false;
+                for (size_t j = 0; j < n && ok; ++j) {
+                    if (slots[j] == slot) ok = false;
+                }
+                slots[n++] = slot;
+            }
+            if (!ok) continue;
+            n = 0;
+            for (size_t i = 0; i < kOpcodeCount; ++i) {
+                if (hashName(kOpcodeNames[i].name, 0) % kOpcodeBuckets != bucket) continue;
+                ph.slot[slots[n++]] = (int16_t)i;
+            }
+            ph.seed[bucket] = seed;
+            break;
+        }
+    }
+    return ph;
+}
+
+constexpr OpcodeHash kOpcodeHash = buildOpcodeHash();
+
+} // namespace
+
+Opcode Parser::mapOpcode(std::string_view txt) {
+    uint16_t seed = kOpcodeHash.seed[hashName(txt, 0) % kOpcodeBuckets];
+    int16_t index = kOpcodeHash.slot[hashName(txt, seed) % kOpcodeSlots];
+    if (index >= 0 && kOpcodeNames[index].name == txt) return kOpcodeNames[index].opcode;
+
+    if (txt.find("store") != std::string_view::npos || txt.find("load") != std::string_view::npos) {
             throw std::runtime_error("Memory instructions not supported");
     }
     return Opcode::NOP;
 }
 
-void Parser::skipSExpr() {
+std::string_view Parser::opcodeName(Opcode op) {
+    for (const auto& entry : kOpcodeNames) {
+        if (entry.opcode == op) return entry.name;
+    }
+    return {};
+}
+
+Token Parser::skipSExpr() {
     int depth = 1;
-    while (depth > 0 && pos < tokens.size()) {
-        Token t = consume();
+    Token t{TokenType::RPAREN, ""};
+    while (depth > 0) {
+        if (peek().type == TokenType::END_OF_FILE) {
+            throw std::runtime_error("Unexpected end of input");
+        }
+        t = consume();
         if (t.type == TokenType::LPAREN) depth++;
         if (t.type == TokenType::RPAREN) depth--;
     }
+    return t; // The closing paren
 }
 
 Import Parser::parseImport() {
     Import imp;
     Token modToken = consume();
     if (modToken.type != TokenType::STRING) throw std::runtime_error("Expected module name string");
-    imp.module = modToken.text;
+    imp.module = unescape(modToken.text);
 
     Token fieldToken = consume();
     if (fieldToken.type != TokenType::STRING) throw std::runtime_error("Expected field name string");
-    imp.field = fieldToken.text;
+    imp.field = unescape(fieldToken.text);
 
     expect(TokenType::LPAREN);
     Token kind = consume();
@@ -417,9 +907,7 @@ Import Parser::parseImport() {
     }
 
     if (peek().type == TokenType::IDENTIFIER) {
-        std::string val = consume().text;
-        if (!val.empty() && val[0] == '$') val = val.substr(1);
-        imp.alias = val;
+        imp.alias = stripSigil(consume().text);
     }
 
     while (peek().type != TokenType::RPAREN) {
@@ -431,13 +919,13 @@ Import Parser::parseImport() {
                      consume(); // skip param name
                  }
                  if (peek().type == TokenType::KEYWORD) {
-                     imp.paramTypes.push_back(consume().text);
+                     imp.paramTypes.push_back(std::string(consume().text));
                  }
             }
             expect(TokenType::RPAREN);
         } else if (inner.text == "result") {
             while (peek().type != TokenType::RPAREN) {
-                imp.resultTypes.push_back(consume().text);
+                imp.resultTypes.push_back(std::string(consume().text));
             }
             expect(TokenType::RPAREN);
         } else {
@@ -0,0 +1,144 @@
+#include "Profiler.h"
+#include "Parser.h"
+#include <algorithm>
+#include <map>
+
+static_assert((size_t)Opcode::BR_TABLE < 256, "Profiler::opcodes holds 256 opcodes");
+
+namespace {
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+Profiler::Profiler(std::shared_ptr<const CompiledModule> module) : compiled(std::move(module)) {
+    reset();
+}
+
+void Profiler::reset() {
+    opcodes.fill(0);
+    functions.assign(compiled->functionCount(), FunctionStats());
+    imports.assign(compiled->importCount(), ImportStats());
+    activeCount.assign(compiled->functionCount(), 0);
+    active.clear();
+    nodes.clear();
+    children.clear();
+    nodes.push_back({-1, 0}); // Root
+}
+
+int32_t Profiler::child(int32_t parent, int32_t entry) {
+    uint64_t key = ((uint64_t)(uint32_t)parent << 32) | (uint32_t)entry;
+    auto it = children.find(key);
+    if (it != children.end()) return it->second;
+    nodes.push_back({parent, entry});
+    int32_t node = (int32_t)nodes.size() - 1;
+    children.emplace(key, node);
+    return node;
+}
+
+void Profiler::enterFunction(int32_t funcIndex) {
+    functions[funcIndex].calls++;
+    activeCount[funcIndex]++;
+    int32_t node = child(active.empty() ? 0 : active.back().node, funcIndex);
+    active.push_back({funcIndex, node, now(), 0});
+}
+
+void Profiler::exitFunction() {
+    const Activation a = active.back();
+    active.pop_back();
+    uint64_t total = now() - a.start;
+    uint64_t exclusive = total > a.childNanos ? total - a.childNanos : 0;
+
+    FunctionStats& stats = functions[a.funcIndex];
+    stats.exclusiveNanos += exclusive;
+    nodes[a.node].nanos += exclusive;
+    if (--activeCount[a.funcIndex] == 0) stats.inclusiveNanos += total;
+    if (!active.empty()) active.back().childNanos += total;
+}
+
+void Profiler::hostCall(int32_t importIndex, uint64_t nanos) {
+    imports[importIndex].calls++;
+    imports[importIndex].nanos += nanos;
+    int32_t node = child(active.empty() ? 0 : active.back().node, -1 - importIndex);
+    nodes[node].nanos += nanos;
+    if (!active.empty()) active.back().childNanos += nanos;
+}
+
+void Profiler::unwind(size_t depth) {
+    while (active.size() > depth) exitFunction();
+}
+
+std::string Profiler::entryName(int32_t entry) const {
+    const Module& mod = compiled->module();
+    if (entry < 0) {
+        const Import& imp = mod.imports[-1 - entry];
+        return imp.module + "." + imp.field;
+    }
+    const std::string& name = mod.functions[entry].name;
+    return name.empty() ? "func" + std::to_string(mod.imports.size() + entry) : name;
+}
+
+std::string Profiler::opcodeLabel(Opcode op) const {
+    // Lowered-only forms are reported under the instruction they came from
+    switch (op) {
+        case Opcode::LOCAL_GET_WIDE: op = Opcode::LOCAL_GET; break;
+        case Opcode::LOCAL_SET_WIDE: op = Opcode::LOCAL_SET; break;
+        case Opcode::LOCAL_TEE_WIDE: op = Opcode::LOCAL_TEE; break;
+        default: break;
+    }
+    std::string_view name = Parser::opcodeName(op);
+    return name.empty() ? "opcode" + std::to_string((int)op) : std::string(name);
+}
+
+void Profiler::writeFolded(std::ostream& out) const {
+    std::vector<std::pair<std::string, uint64_t>> lines;
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        std::string path;
+        for (int32_t n = (int32_t)i; n > 0; n = nodes[n].parent) {
+            path = path.empty() ? entryName(nodes[n].entry) : entryName(nodes[n].entry) + ";" + path;
+        }
+        lines.emplace_back(std::move(path), nodes[i].nanos);
+    }
+    std::sort(lines.begin(), lines.end());
+    for (const auto& line : lines) out << line.first << " " << line.second << "\n";
+}
+
+void Profiler::writeJson(std::ostream& out) const {
+    std::map<std::string, uint64_t> counts;
+    for (size_t i = 0; i < opcodes.size(); ++i) {
+        if (opcodes[i]) counts[opcodeLabel((Opcode)i)] += opcodes[i];
+    }
+
+    out << "{\n  \"opcodes\": {";
+    const char* sep = "";
+    for (const auto& c : counts) {
+        out << sep << "\n    " << jsonString(c.first) << ": " << c.second;
+        sep = ",";
+    }
+    out << "\n  },\n  \"functions\": [";
+    sep = "";
+    for (size_t i = 0; i < functions.size(); ++i) {
+        const FunctionStats& f = functions[i];
+        if (!f.calls) continue;
+        out << sep << "\n    {\"name\": " << jsonString(entryName((int32_t)i)) << ", \"calls\": " << f.calls
+            << ", \"inclusive_ns\": " << f.inclusiveNanos << ", \"exclusive_ns\": " << f.exclusiveNanos << "}";
+        sep = ",";
+    }
+    out << "\n  ],\n  \"imports\": [";
+    sep = "";
+    for (size_t i = 0; i < imports.size(); ++i) {
+        const ImportStats& imp = imports[i];
+        if (!imp.calls) continue;
+        out << sep << "\n    {\"name\": " << jsonString(entryName(-1 - (int32_t)i)) << ", \"calls\": " << imp.calls
+            << ", \"ns\": " << imp.nanos << "}";
+        sep = ",";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,80 @@
+#include "PurityAnalysis.h"
+#include <algorithm>
+
+PurityAnalysis::PurityAnalysis(const CompiledModule& module)
+    : compiled(module), pure(module.functionCount(), true), reasons(module.functionCount()) {
+    const Module& mod = module.module();
+    int32_t numImports = (int32_t)module.importCount();
+    size_t n = module.functionCount();
+
+    // Local effects first; calls between defined functions are collected
+    // for the fixed point below
+    std::vector<std::vector<size_t>> callees(n);
+    for (size_t f = 0; f < n; ++f) {
+        const CompiledFunction* func = nullptr;
+        try {
+            func = &module.function(f);
+        } catch (const std::exception& e) {
+            pure[f] = false;
+            reasons[f] = std::string("does not compile: ") + e.what();
+            continue;
+        }
+        for (const CompiledInstr& instr : func->code) {
+            std::string why;
+            switch (instr.opcode) {
+                case Opcode::CALL:
+                    if (instr.index < numImports) {
+                        const Import& imp = mod.imports[instr.index];
+                        why = "calls host function " + imp.module + "." + imp.field;
+                    } else {
+                        callees[f].push_back(instr.index - numImports);
+                    }
+                    break;
+                case Opcode::CALL_INDIRECT:
+                    why = "makes an indirect call";
+                    break;
+                case Opcode::GLOBAL_GET:
+                    if (mod.globals[instr.index].isMutable) why = "reads a mutable global";
+                    break;
+                case Opcode::GLOBAL_SET:
+                    why = "writes a global";
+                    break;
+                case Opcode::V128_LOAD:
+                    why = "reads memory";
+                    break;
+                case Opcode::V128_STORE:
+                    why = "writes memory";
+                    break;
+                default:
+                    break;
+            }
+            if (!why.empty()) {
+                pure[f] = false;
+                reasons[f] = why;
+                break;
+            }
+        }
+    }
+
+    // A function calling an impure one is impure, until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t f = 0; f < n; ++f) {
+            if (!pure[f]) continue;
+            for (size_t callee : callees[f]) {
+                if (!pure[callee]) {
+                    pure[f] = false;
+                    const std::string& name = mod.functions[callee].name;
+                    reasons[f] = "calls impure function " + (name.empty() ? std::to_string(numImports + callee) : name);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+size_t PurityAnalysis::pureCount() const {
+    return (size_t)std::count(pure.begin(), pure.end(), true);
+}
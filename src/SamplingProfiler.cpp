@@ -0,0 +1,172 @@
+#include "SamplingProfiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <stdexcept>
+#include <sys/time.h>
+
+namespace {
+
+std::atomic<SamplingProfiler*> activeSampler{nullptr};
+std::atomic<int> handlersRunning{0};
+struct sigaction previousAction;
+
+// Stack of the attached Interpreter running on this thread, if any. Set
+// with SamplingProfiler::enterThread; constant initialized, so the handler
+// can read it without TLS setup.
+thread_local GuestStackShadow* currentStack = nullptr;
+
+void onProfilingSignal(int) {
+    int savedErrno = errno;
+    handlersRunning.fetch_add(1);
+    SamplingProfiler* sampler = activeSampler.load();
+    GuestStackShadow* stack = currentStack;
+    if (sampler) {
+        if (stack && stack->sampler == sampler) {
+            sampler->record(*stack);
+        } else {
+            sampler->recordOutside();
+        }
+    }
+    handlersRunning.fetch_sub(1);
+    errno = savedErrno;
+}
+
+} // namespace
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the signal handler needs lock-free atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the signal handler needs lock-free atomics");
+
+GuestStackShadow* SamplingProfiler::enterThread(GuestStackShadow* stack) {
+    GuestStackShadow* previous = currentStack;
+    currentStack = stack;
+    return previous;
+}
+
+SamplingProfiler::SamplingProfiler(std::shared_ptr<const CompiledModule> module, std::chrono::microseconds interval)
+    : compiled(std::move(module)), interval(interval), ring(new Sample[kRingSize]) {
+    if (interval.count() <= 0) throw std::runtime_error("Sampling interval must be positive");
+}
+
+SamplingProfiler::~SamplingProfiler() {
+    stop();
+}
+
+void SamplingProfiler::start() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (running) return;
+    SamplingProfiler* expected = nullptr;
+    if (!activeSampler.compare_exchange_strong(expected, this)) {
+        throw std::runtime_error("Another SamplingProfiler is already running");
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = onProfilingSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &previousAction);
+
+    struct itimerval timer = {};
+    timer.it_interval.tv_sec = interval.count() / 1000000;
+    timer.it_interval.tv_usec = interval.count() % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        sigaction(SIGPROF, &previousAction, nullptr);
+        activeSampler.store(nullptr);
+        throw std::runtime_error("setitimer(ITIMER_PROF) failed");
+    }
+
+    running = true;
+    aggregator = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (running) {
+            cv.wait_for(lock, std::chrono::milliseconds(10));
+            drain();
+        }
+    });
+}
+
+void SamplingProfiler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!running) return;
+        struct itimerval timer = {};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        sigaction(SIGPROF, &previousAction, nullptr);
+        activeSampler.store(nullptr);
+        // A handler on another thread may still be writing into the ring
+        while (handlersRunning.load() != 0) std::this_thread::yield();
+        running = false;
+    }
+    cv.notify_all();
+    aggregator.join();
+    std::lock_guard<std::mutex> lock(mtx);
+    drain();
+}
+
+void SamplingProfiler::record(const GuestStackShadow& stack) {
+    Sample& sample = ring[writeIndex.fetch_add(1) % kRingSize];
+    uint32_t free = 0;
+    if (!sample.state.compare_exchange_strong(free, 1)) {
+        dropped.fetch_add(1);
+        return;
+    }
+    uint32_t depth = std::min(stack.depth.load(std::memory_order_relaxed), GuestStackShadow::kMaxDepth);
+    std::atomic_signal_fence(std::memory_order_acquire);
+    uint32_t begin = depth > kSampleDepth ? depth - kSampleDepth : 0;
+    sample.depth = depth - begin;
+    for (uint32_t i = begin; i < depth; ++i) sample.frames[i - begin] = stack.frames[i];
+    sample.state.store(2, std::memory_order_release);
+}
+
+void SamplingProfiler::recordOutside() {
+    outside.fetch_add(1);
+}
+
+void SamplingProfiler::drain() {
+    for (size_t i = 0; i < kRingSize; ++i) {
+        Sample& sample = ring[i];
+        if (sample.state.load(std::memory_order_acquire) != 2) continue;
+        if (sample.depth > 0) {
+            std::vector<int32_t> stack(sample.depth);
+            for (uint32_t f = 0; f < sample.depth; ++f) stack[f] = sample.frames[f].func;
+            stacks[stack]++;
+            const GuestStackShadow::Frame& leaf = sample.frames[sample.depth - 1];
+            pcs[{leaf.func, leaf.pc}]++;
+            samples++;
+        } else {
+            outside.fetch_add(1);
+        }
+        sample.state.store(0, std::memory_order_release);
+    }
+}
+
+uint64_t SamplingProfiler::guestSamples() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return samples;
+}
+
+std::vector<SamplingProfiler::HotSpot> SamplingProfiler::hotSpots() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<HotSpot> spots;
+    for (const auto& entry : pcs) spots.push_back({entry.first.first, entry.first.second, entry.second});
+    std::stable_sort(spots.begin(), spots.end(),
+                     [](const HotSpot& a, const HotSpot& b) { return a.samples > b.samples; });
+    return spots;
+}
+
+std::string SamplingProfiler::functionName(int32_t func) const {
+    const Module& mod = compiled->module();
+    const std::string& name = mod.functions[func].name;
+    return name.empty() ? "func" + std::to_string(mod.imports.size() + func) : name;
+}
+
+void SamplingProfiler::writeFolded(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto& entry : stacks) {
+        for (size_t i = 0; i < entry.first.size(); ++i) {
+            out << (i ? ";" : "") << functionName(entry.first[i]);
+        }
+        out << " " << entry.second << "\n";
+    }
+}
@@ -0,0 +1,207 @@
+#include "Scheduler.h"
+
+namespace {
+
+// Set on worker threads only
+thread_local Scheduler* workerOf = nullptr;
+thread_local size_t workerIndex = 0;
+thread_local Scheduler::Task* runningTask = nullptr;
+
+} // namespace
+
+void Scheduler::Task::complete(WasmValue value) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (hasHostResult) {
+        throw std::runtime_error("Task already has a pending host result");
+    }
+    hostResult = value;
+    hasHostResult = true;
+    // Still running means the host function has not returned pending() yet;
+    // the worker requeues the task once it has
+    if (state == State::Parked) {
+        state = State::Queued;
+        lock.unlock();
+        scheduler->enqueue(shared_from_this(), false);
+    }
+}
+
+Scheduler::Scheduler(size_t threads, uint64_t sliceFuel) : sliceFuel(sliceFuel) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) queues.push_back(std::make_unique<Worker>());
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        drained.wait(lock, [this]() { return queued.load() == 0 && running.load() == 0; });
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+std::future<WasmValue> Scheduler::spawn(Interpreter& vm, std::string funcName, std::vector<WasmValue> args) {
+    TaskPtr task(new Task(this, vm, std::move(funcName), std::move(args)));
+    std::future<WasmValue> result = task->result.get_future();
+    enqueue(std::move(task), false);
+    return result;
+}
+
+std::shared_ptr<Scheduler::Task> Scheduler::currentTask() {
+    return runningTask ? runningTask->shared_from_this() : nullptr;
+}
+
+void Scheduler::enqueue(TaskPtr task, bool yielding) {
+    if (workerOf == this) {
+        Worker& own = *queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if (yielding) {
+            own.tasks.push_front(std::move(task));
+        } else {
+            own.tasks.push_back(std::move(task));
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(injectMtx);
+        injected.push_back(std::move(task));
+    }
+    queued.fetch_add(1);
+    {
+        // Pairs with the predicate check in workerLoop, so the wakeup is not lost
+        std::lock_guard<std::mutex> lock(sleepMtx);
+    }
+    wake.notify_one();
+}
+
+Scheduler::TaskPtr Scheduler::take(size_t self) {
+    TaskPtr task;
+    {
+        Worker& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+    if (!task) {
+        std::lock_guard<std::mutex> lock(injectMtx);
+        if (!injected.empty()) {
+            task = std::move(injected.front());
+            injected.pop_front();
+        }
+    }
+    if (!task) {
+        // Steal the oldest task of another worker, starting somewhere new
+        // each time so thieves spread out over the victims
+        thread_local size_t cursor = 0;
+        size_t n = queues.size();
+        for (size_t i = 1; i < n && !task; ++i) {
+            Worker& victim = *queues[(self + i + cursor) % n];
+            std::lock_guard<std::mutex> lock(victim.mtx);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                steals.fetch_add(1);
+            }
+        }
+        cursor++;
+    }
+    if (task) {
+        // Counted as running before it stops counting as queued, so the
+        // destructor never sees both at zero in between
+        running.fetch_add(1);
+        queued.fetch_sub(1);
+    }
+    return task;
+}
+
+void Scheduler::workerLoop(size_t self) {
+    workerOf = this;
+    workerIndex = self;
+    while (true) {
+        if (TaskPtr task = take(self)) {
+            runSlice(task);
+            task.reset();
+            if (running.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMtx);
+                drained.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+void Scheduler::runSlice(const TaskPtr& task) {
+    Interpreter& vm = task->vm;
+    WasmValue hostResult;
+    {
+        std::lock_guard<std::mutex> lock(task->mtx);
+        task->state = Task::State::Running;
+        if (task->hasHostResult) {
+            hostResult = task->hostResult;
+            task->hasHostResult = false;
+        }
+    }
+
+    Task* previous = runningTask;
+    runningTask = task.get();
+    WasmValue res;
+    bool yielded = false;
+    std::exception_ptr failure;
+    try {
+        if (sliceFuel) {
+            vm.setFuel(sliceFuel);
+        } else {
+            vm.clearFuel();
+        }
+        if (!task->started) {
+            task->started = true;
+            res = vm.run(task->funcName, std::move(task->args));
+        } else if (vm.awaitingHost()) {
+            res = vm.resume(hostResult);
+        } else {
+            res = vm.resume();
+        }
+    } catch (const FuelExhausted& e) {
+        yielded = e.resumable;
+        if (!yielded) failure = std::current_exception();
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    runningTask = previous;
+
+    if (failure) {
+        task->result.set_exception(failure);
+        return;
+    }
+    if (yielded) {
+        yields.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(task->mtx);
+            task->state = Task::State::Queued;
+        }
+        enqueue(task, true);
+        return;
+    }
+    if (res.isPending()) {
+        parks.fetch_add(1);
+        std::unique_lock<std::mutex> lock(task->mtx);
+        if (task->hasHostResult) {
+            // Completed before the host function even returned
+            task->state = Task::State::Queued;
+            lock.unlock();
+            enqueue(task, false);
+        } else {
+            task->state = Task::State::Parked;
+        }
+        return;
+    }
+    task->result.set_value(res);
+}
@@ -0,0 +1,81 @@
+#include "StdioHost.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/uio.h>
+
+StdioHost::StdioHost(MemoryStore& store, int fd, StdioOptions options)
+    : store(store), fd(fd), stream(nullptr), opts(options), buffer(options.bufferSize) {}
+
+StdioHost::StdioHost(MemoryStore& store, std::ostream& out, StdioOptions options)
+    : store(store), fd(-1), stream(&out), opts(options), buffer(options.bufferSize) {}
+
+StdioHost::~StdioHost() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // Nowhere left to report it
+    }
+}
+
+void StdioHost::write(MemoryStore::Handle handle, int32_t offset, int32_t len) {
+    const uint8_t* data = store.view(handle, offset, len);
+    if (used + (size_t)len > buffer.size()) {
+        drain(data, len);
+        return;
+    }
+    std::memcpy(buffer.data() + used, data, len);
+    used += len;
+    if (opts.lineBuffered && len > 0 && data[len - 1] == '\n') flush();
+}
+
+void StdioHost::put(char c) {
+    if (used == buffer.size()) drain(nullptr, 0);
+    if (buffer.empty()) {
+        drain(reinterpret_cast<const uint8_t*>(&c), 1);
+        return;
+    }
+    buffer[used++] = c;
+    if (opts.lineBuffered && c == '\n') flush();
+}
+
+void StdioHost::flush() {
+    if (used > 0) drain(nullptr, 0);
+    if (stream) stream->flush();
+}
+
+void StdioHost::drain(const uint8_t* data, size_t len) {
+    size_t total = used + len;
+    if (total == 0) return;
+    if (stream) {
+        stream->write(buffer.data(), used);
+        stream->write(reinterpret_cast<const char*>(data), len);
+        if (!*stream) throw std::runtime_error("Output stream write failed");
+    } else {
+        struct iovec iov[2] = {{buffer.data(), used}, {const_cast<uint8_t*>(data), len}};
+        struct iovec* next = iov;
+        int count = 2;
+        size_t left = total;
+        // writev may take less than everything
+        while (left > 0) {
+            ssize_t n = ::writev(fd, next, count);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+            }
+            left -= n;
+            while (count > 0 && (size_t)n >= next->iov_len) {
+                n -= next->iov_len;
+                ++next;
+                --count;
+            }
+            if (count > 0) {
+                next->iov_base = static_cast<char*>(next->iov_base) + n;
+                next->iov_len -= n;
+            }
+        }
+    }
+    used = 0;
+    written += total;
+    writes++;
+}
@@ -0,0 +1,33 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task(); // Exceptions are captured by the packaged_task
+    }
+}
@@ -0,0 +1,322 @@
+#include "Validator.h"
+#include <stdexcept>
+
+namespace {
+
+enum class ValType : uint8_t { I32, I64, F32, F64, V128, Unknown };
+
+ValType toValType(const std::string& name) {
+    if (name == "i32") return ValType::I32;
+    if (name == "i64") return ValType::I64;
+    if (name == "f32") return ValType::F32;
+    if (name == "f64") return ValType::F64;
+    if (name == "v128") return ValType::V128;
+    throw std::runtime_error("unsupported value type " + name);
+}
+
+const char* typeName(ValType t) {
+    switch (t) {
+        case ValType::I32: return "i32";
+        case ValType::I64: return "i64";
+        case ValType::F32: return "f32";
+        case ValType::F64: return "f64";
+        case ValType::V128: return "v128";
+        default: return "any";
+    }
+}
+
+uint32_t width(ValType t) { return t == ValType::V128 ? 2 : 1; }
+
+// One open construct: the function body itself, or a block or loop.
+struct Control {
+    uint32_t height;     // Operand stack height on entry, in values
+    uint32_t slots;      // The same height in stack slots
+    int32_t target;      // pc that branches to this label resume at
+    bool unreachable;    // After br/return/unreachable: the stack is polymorphic
+};
+
+class FunctionChecker {
+public:
+    FunctionChecker(const CompiledModule& module, const CompiledFunction& func,
+                    std::vector<BranchTarget>& branchTable)
+        : module(module), func(func), branchTable(branchTable), slots(0), maxDepth(0) {}
+
+    uint32_t run(std::vector<CompiledInstr>& code, std::vector<int32_t>* heights);
+
+private:
+    const CompiledModule& module;
+    const CompiledFunction& func;
+    std::vector<BranchTarget>& branchTable;
+    std::vector<ValType> locals; // By slot offset; a v128 fills two entries
+    std::vector<ValType> results;
+    std::vector<ValType> stack;
+    std::vector<Control> controls;
+    uint32_t slots; // Height of stack in slots
+    uint32_t maxDepth;
+
+    void push(ValType t) {
+        stack.push_back(t);
+        slots += width(t);
+        if (slots > maxDepth) maxDepth = slots;
+    }
+
+    ValType pop(ValType expected) {
+        const Control& c = controls.back();
+        if (stack.size() == c.height) {
+            if (c.unreachable) return expected;
+            throw std::runtime_error(std::string("stack underflow, expected ") + typeName(expected));
+        }
+        ValType actual = stack.back();
+        stack.pop_back();
+        slots -= width(actual);
+        if (actual != expected && actual != ValType::Unknown && expected != ValType::Unknown) {
+            throw std::runtime_error(std::string("type mismatch, expected ") + typeName(expected) +
+                                     " but found " + typeName(actual));
+        }
+        return actual == ValType::Unknown ? expected : actual;
+    }
+
+    void popAll(const std::vector<std::string>& types) {
+        for (size_t i = types.size(); i > 0; --i) pop(toValType(types[i - 1]));
+    }
+
+    void pushAll(const std::vector<std::string>& types) {
+        if (types.size() > 1) throw std::runtime_error("multiple results are not supported");
+        for (const auto& t : types) push(toValType(t));
+    }
+
+    void setUnreachable() {
+        stack.resize(controls.back().height);
+        slots = controls.back().slots;
+        controls.back().unreachable = true;
+    }
+
+    const Control& branchTarget(int32_t targetPc) const {
+        for (size_t i = controls.size(); i > 1; --i) {
+            if (controls[i - 1].target == targetPc) return controls[i - 1];
+        }
+        throw std::runtime_error("branch to an unknown label");
+    }
+
+    void binary(ValType operand, ValType result) {
+        pop(operand);
+        pop(operand);
+        push(result);
+    }
+
+    void unary(ValType operand, ValType result) {
+        pop(operand);
+        push(result);
+    }
+
+    void replaceLane(ValType lane) {
+        pop(lane);
+        pop(ValType::V128);
+        push(ValType::V128);
+    }
+};
+
+uint32_t FunctionChecker::run(std::vector<CompiledInstr>& code, std::vector<int32_t>* heights) {
+    const Function& source = *func.source;
+    for (const auto* types : {&source.paramTypes, &source.localTypes}) {
+        for (const auto& t : *types) locals.insert(locals.end(), slotCount(t), toValType(t));
+    }
+    for (const auto& t : func.extraLocals) locals.insert(locals.end(), slotCount(t), toValType(t));
+    for (const auto& t : source.resultTypes) results.push_back(toValType(t));
+    if (results.size() > 1) throw std::runtime_error("multiple results are not supported");
+
+    // Blocks and ifs resume after their END; find each one up front so
+    // forward branches can be matched to their label.
+    std::vector<int32_t> blockEnd(code.size(), -1);
+    std::vector<size_t> open;
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        Opcode op = code[pc].opcode;
+        if (op == Opcode::BLOCK || op == Opcode::LOOP || op == Opcode::IF) open.push_back(pc);
+        if (op == Opcode::END && !open.empty()) {
+            blockEnd[open.back()] = (int32_t)pc;
+            open.pop_back();
+        }
+    }
+
+    controls.push_back({0, 0, -1, false});
+    size_t last = code.size() - 1; // The implicit RETURN closing the body
+    if (heights) heights->assign(code.size(), -1);
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        CompiledInstr& instr = code[pc];
+        if (heights && !controls.back().unreachable) (*heights)[pc] = (int32_t)slots;
+        switch (instr.opcode) {
+            case Opcode::I32_CONST:
+            case Opcode::STRING_CONST:
+                push(ValType::I32);
+                break;
+            case Opcode::I64_CONST: push(ValType::I64); break;
+            case Opcode::F32_CONST: push(ValType::F32); break;
+            case Opcode::F64_CONST: push(ValType::F64); break;
+
+            case Opcode::I32_ADD: case Opcode::I32_SUB: case Opcode::I32_MUL:
+            case Opcode::I32_DIV_S: case Opcode::I32_DIV_U: case Opcode::I32_REM_S: case Opcode::I32_REM_U:
+            case Opcode::I32_AND: case Opcode::I32_OR: case Opcode::I32_XOR:
+            case Opcode::I32_SHL: case Opcode::I32_SHR_S: case Opcode::I32_SHR_U:
+            case Opcode::I32_ROTL: case Opcode::I32_ROTR:
+            case Opcode::I32_EQ: case Opcode::I32_NE:
+            case Opcode::I32_LT_S: case Opcode::I32_LT_U: case Opcode::I32_GT_S: case Opcode::I32_GT_U:
+            case Opcode::I32_LE_S: case Opcode::I32_LE_U: case Opcode::I32_GE_S: case Opcode::I32_GE_U:
+                binary(ValType::I32, ValType::I32);
+                break;
+            case Opcode::I32_EQZ: case Opcode::I32_CLZ: case Opcode::I32_CTZ: case Opcode::I32_POPCNT:
+                unary(ValType::I32, ValType::I32);
+                break;
+            case Opcode::F64_ADD: case Opcode::F64_SUB: case Opcode::F64_MUL: case Opcode::F64_DIV:
+                binary(ValType::F64, ValType::F64);
+                break;
+
+            case Opcode::LOCAL_GET:
+            case Opcode::LOCAL_GET_WIDE:
+                push(locals[instr.index]);
+                break;
+            case Opcode::LOCAL_SET:
+            case Opcode::LOCAL_SET_WIDE:
+                pop(locals[instr.index]);
+                break;
+            case Opcode::LOCAL_TEE:
+            case Opcode::LOCAL_TEE_WIDE:
+                unary(locals[instr.index], locals[instr.index]);
+                break;
+
+            case Opcode::V128_CONST: push(ValType::V128); break;
+            case Opcode::V128_LOAD:
+                binary(ValType::I32, ValType::V128); // handle, offset
+                break;
+            case Opcode::V128_STORE:
+                pop(ValType::V128);
+                pop(ValType::I32);
+                pop(ValType::I32);
+                break;
+            case Opcode::V128_NOT: case Opcode::I32X4_NEG:
+            case Opcode::F32X4_NEG: case Opcode::F32X4_ABS: case Opcode::F32X4_SQRT:
+            case Opcode::F64X2_NEG: case Opcode::F64X2_ABS: case Opcode::F64X2_SQRT:
+                unary(ValType::V128, ValType::V128);
+                break;
+            case Opcode::V128_AND: case Opcode::V128_ANDNOT: case Opcode::V128_OR: case Opcode::V128_XOR:
+            case Opcode::I32X4_ADD: case Opcode::I32X4_SUB: case Opcode::I32X4_MUL:
+            case Opcode::I32X4_MIN_S: case Opcode::I32X4_MAX_S:
+            case Opcode::I32X4_EQ: case Opcode::I32X4_NE: case Opcode::I32X4_LT_S: case Opcode::I32X4_LT_U:
+            case Opcode::I32X4_GT_S: case Opcode::I32X4_GT_U: case Opcode::I32X4_LE_S: case Opcode::I32X4_GE_S:
+            case Opcode::F32X4_ADD: case Opcode::F32X4_SUB: case Opcode::F32X4_MUL: case Opcode::F32X4_DIV:
+            case Opcode::F32X4_EQ: case Opcode::F32X4_NE: case Opcode::F32X4_LT: case Opcode::F32X4_GT:
+            case Opcode::F32X4_LE: case Opcode::F32X4_GE:
+            case Opcode::F64X2_ADD: case Opcode::F64X2_SUB: case Opcode::F64X2_MUL: case Opcode::F64X2_DIV:
+            case Opcode::F64X2_EQ: case Opcode::F64X2_NE: case Opcode::F64X2_LT: case Opcode::F64X2_GT:
+            case Opcode::F64X2_LE: case Opcode::F64X2_GE:
+                binary(ValType::V128, ValType::V128);
+                break;
+            case Opcode::I32X4_SPLAT: unary(ValType::I32, ValType::V128); break;
+            case Opcode::F32X4_SPLAT: unary(ValType::F32, ValType::V128); break;
+            case Opcode::F64X2_SPLAT: unary(ValType::F64, ValType::V128); break;
+            case Opcode::I32X4_EXTRACT_LANE: unary(ValType::V128, ValType::I32); break;
+            case Opcode::F32X4_EXTRACT_LANE: unary(ValType::V128, ValType::F32); break;
+            case Opcode::F64X2_EXTRACT_LANE: unary(ValType::V128, ValType::F64); break;
+            case Opcode::I32X4_REPLACE_LANE: replaceLane(ValType::I32); break;
+            case Opcode::F32X4_REPLACE_LANE: replaceLane(ValType::F32); break;
+            case Opcode::F64X2_REPLACE_LANE: replaceLane(ValType::F64); break;
+
+            case Opcode::GLOBAL_GET:
+                push(toValType(module.module().globals[instr.index].type));
+                break;
+            case Opcode::GLOBAL_SET:
+                pop(toValType(module.module().globals[instr.index].type));
+                break;
+
+            case Opcode::CALL: {
+                const Type& sig = module.signature(module.calleeSignature(instr.index));
+                popAll(sig.paramTypes);
+                pushAll(sig.resultTypes);
+                break;
+            }
+            case Opcode::CALL_INDIRECT: {
+                const Type& sig = module.signature(instr.index);
+                pop(ValType::I32);
+                popAll(sig.paramTypes);
+                pushAll(sig.resultTypes);
+                break;
+            }
+
+            case Opcode::BLOCK:
+                if (blockEnd[pc] < 0) throw std::runtime_error("block without end");
+                controls.push_back({(uint32_t)stack.size(), slots, blockEnd[pc] + 1, false});
+                break;
+            case Opcode::IF:
+                pop(ValType::I32);
+                if (blockEnd[pc] < 0) throw std::runtime_error("if without end");
+                controls.push_back({(uint32_t)stack.size(), slots, blockEnd[pc] + 1, false});
+                break;
+            case Opcode::ELSE:
+                // The then-branch must end where an END would accept it
+                if (stack.size() != controls.back().height) {
+                    throw std::runtime_error("if branch leaves values on the stack");
+                }
+                controls.back().unreachable = false;
+                break;
+            case Opcode::LOOP:
+                controls.push_back({(uint32_t)stack.size(), slots, (int32_t)pc + 1, false});
+                break;
+            case Opcode::END:
+                if (controls.size() == 1) throw std::runtime_error("end without block");
+                if (stack.size() != controls.back().height) {
+                    throw std::runtime_error("block leaves values on the stack");
+                }
+                controls.pop_back();
+                break;
+            case Opcode::BR:
+                instr.i32 = (int32_t)branchTarget(instr.index).slots;
+                setUnreachable();
+                break;
+            case Opcode::BR_IF:
+                pop(ValType::I32);
+                instr.i32 = (int32_t)branchTarget(instr.index).slots;
+                break;
+            case Opcode::BR_TABLE:
+                pop(ValType::I32);
+                for (int32_t i = 0; i <= instr.i32; ++i) {
+                    BranchTarget& entry = branchTable[instr.index + i];
+                    entry.height = (int32_t)branchTarget(entry.pc).slots;
+                }
+                setUnreachable();
+                break;
+
+            case Opcode::RETURN:
+                if (pc == last) {
+                    if (controls.size() != 1) throw std::runtime_error("block without end");
+                    if (!controls.back().unreachable && stack.size() != results.size()) {
+                        throw std::runtime_error("function leaves " + std::to_string(stack.size()) +
+                                                 " values on the stack, expected " +
+                                                 std::to_string(results.size()));
+                    }
+                }
+                for (size_t i = results.size(); i > 0; --i) pop(results[i - 1]);
+                setUnreachable();
+                break;
+            case Opcode::UNREACHABLE:
+                setUnreachable();
+                break;
+            case Opcode::NOP:
+                break;
+            default:
+                throw std::runtime_error("unsupported opcode " + std::to_string((int)instr.opcode));
+        }
+    }
+    return maxDepth;
+}
+
+} // namespace
+
+Validator::Validator(const CompiledModule& module) : module(module) {}
+
+uint32_t Validator::validate(const CompiledFunction& func, std::vector<CompiledInstr>& code,
+                             std::vector<BranchTarget>& branchTable, std::vector<int32_t>* heights) const {
+    try {
+        return FunctionChecker(module, func, branchTable).run(code, heights);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error("Validation failed in " + func.source->name + ": " + e.what());
+    }
+}
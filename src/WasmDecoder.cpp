@@ -0,0 +1,429 @@
+#include "WasmDecoder.h"
+#include "MappedFile.h"
+#include <array>
+#include <stdexcept>
+
+namespace {
+
+enum SectionId : uint8_t {
+    SEC_CUSTOM = 0, SEC_TYPE = 1, SEC_IMPORT = 2, SEC_FUNCTION = 3, SEC_TABLE = 4,
+    SEC_MEMORY = 5, SEC_GLOBAL = 6, SEC_EXPORT = 7, SEC_START = 8, SEC_ELEM = 9,
+    SEC_CODE = 10, SEC_DATA = 11, SEC_DATACOUNT = 12
+};
+
+// Opcodes without immediates, indexed by their binary encoding; -1 if none
+const std::array<int, 256>& simpleOpcodes() {
+    static const std::array<int, 256> table = [] {
+        std::array<int, 256> t;
+        t.fill(-1);
+        const std::pair<uint8_t, Opcode> ops[] = {
+            {0x00, Opcode::UNREACHABLE}, {0x01, Opcode::NOP}, {0x0f, Opcode::RETURN},
+            {0x45, Opcode::I32_EQZ}, {0x46, Opcode::I32_EQ}, {0x47, Opcode::I32_NE},
+            {0x48, Opcode::I32_LT_S}, {0x49, Opcode::I32_LT_U}, {0x4a, Opcode::I32_GT_S},
+            {0x4b, Opcode::I32_GT_U}, {0x4c, Opcode::I32_LE_S}, {0x4d, Opcode::I32_LE_U},
+            {0x4e, Opcode::I32_GE_S}, {0x4f, Opcode::I32_GE_U},
+            {0x67, Opcode::I32_CLZ}, {0x68, Opcode::I32_CTZ}, {0x69, Opcode::I32_POPCNT},
+            {0x6a, Opcode::I32_ADD}, {0x6b, Opcode::I32_SUB}, {0x6c, Opcode::I32_MUL},
+            {0x6d, Opcode::I32_DIV_S}, {0x6e, Opcode::I32_DIV_U}, {0x6f, Opcode::I32_REM_S},
+            {0x70, Opcode::I32_REM_U}, {0x71, Opcode::I32_AND}, {0x72, Opcode::I32_OR},
+            {0x73, Opcode::I32_XOR}, {0x74, Opcode::I32_SHL}, {0x75, Opcode::I32_SHR_S},
+            {0x76, Opcode::I32_SHR_U}, {0x77, Opcode::I32_ROTL}, {0x78, Opcode::I32_ROTR},
+            {0xa0, Opcode::F64_ADD}, {0xa1, Opcode::F64_SUB}, {0xa2, Opcode::F64_MUL},
+            {0xa3, Opcode::F64_DIV},
+        };
+        for (const auto& op : ops) t[op.first] = (int)op.second;
+        return t;
+    }();
+    return table;
+}
+
+// Reads a LEB128 value if it is complete within [pos, size); returns false
+// when more input is needed.
+bool tryUleb(const uint8_t* data, size_t size, size_t& pos, uint64_t& value) {
+    value = 0;
+    int shift = 0;
+    for (size_t p = pos; p < size; ++p) {
+        if (shift >= 64) throw std::runtime_error("LEB128 value too long");
+        value |= (uint64_t)(data[p] & 0x7F) << shift;
+        shift += 7;
+        if (!(data[p] & 0x80)) {
+            pos = p + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string hexByte(uint8_t b) {
+    const char* digits = "0123456789abcdef";
+    return std::string("0x") + digits[b >> 4] + digits[b & 15];
+}
+
+} // namespace
+
+WasmDecoder::WasmDecoder() : headerSeen(false), finished(false), codeBodies(0) {}
+
+void WasmDecoder::feed(const uint8_t* data, size_t size) {
+    if (finished) throw std::runtime_error("WasmDecoder already finished");
+    if (pending.empty()) {
+        // Decode straight from the caller's chunk; keep only the tail
+        size_t used = consume(data, size);
+        pending.assign(data + used, data + size);
+    } else {
+        pending.insert(pending.end(), data, data + size);
+        size_t used = consume(pending.data(), pending.size());
+        pending.erase(pending.begin(), pending.begin() + used);
+    }
+}
+
+Module WasmDecoder::finish() {
+    if (!headerSeen || !pending.empty()) throw std::runtime_error("Truncated wasm module");
+    if (codeBodies != functionTypes.size()) {
+        throw std::runtime_error("Function and code section counts differ");
+    }
+    finished = true;
+
+    // Exported functions without a name section entry take the export name
+    size_t numImports = mod.imports.size();
+    for (const auto& exp : mod.exports) {
+        if (exp.kind != "func") continue;
+        size_t idx = std::stoul(exp.target);
+        if (idx >= numImports + mod.functions.size()) {
+            throw std::runtime_error("Export function index out of range: " + exp.target);
+        }
+        if (idx >= numImports && mod.functions[idx - numImports].name.empty()) {
+            mod.functions[idx - numImports].name = exp.name;
+        }
+    }
+    return std::move(mod);
+}
+
+Module WasmDecoder::decode(const uint8_t* data, size_t size) {
+    WasmDecoder decoder;
+    decoder.feed(data, size);
+    return decoder.finish();
+}
+
+Module WasmDecoder::decodeFile(const std::string& path) {
+    MappedFile file(path);
+    return decode(file.data(), file.size());
+}
+
+size_t WasmDecoder::consume(const uint8_t* data, size_t size) {
+    size_t pos = 0;
+    if (!headerSeen) {
+        if (size < 8) return 0;
+        static const uint8_t header[8] = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+        for (int i = 0; i < 8; ++i) {
+            if (data[i] != header[i]) throw std::runtime_error("Not a wasm module (bad magic or version)");
+        }
+        headerSeen = true;
+        pos = 8;
+    }
+
+    while (pos < size) {
+        size_t p = pos + 1;
+        uint64_t length;
+        if (!tryUleb(data, size, p, length)) break;
+        if (length > size - p) break;
+
+        ByteReader in(data + p, length);
+        decodeSection(data[pos], in);
+        if (!in.atEnd()) throw std::runtime_error("Section size mismatch");
+        pos = p + length;
+    }
+    return pos;
+}
+
+void WasmDecoder::decodeSection(uint8_t id, ByteReader& in) {
+    switch (id) {
+        case SEC_CUSTOM:
+            decodeCustom(in);
+            break;
+        case SEC_TYPE: {
+            uint64_t n = in.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                if (in.u8() != 0x60) throw std::runtime_error("Expected func type");
+                Type t;
+                uint64_t np = in.uleb();
+                for (uint64_t j = 0; j < np; ++j) t.paramTypes.push_back(valueType(in.u8()));
+                uint64_t nr = in.uleb();
+                for (uint64_t j = 0; j < nr; ++j) t.resultTypes.push_back(valueType(in.u8()));
+                mod.types.push_back(t);
+            }
+            break;
+        }
+        case SEC_IMPORT: {
+            uint64_t n = in.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                Import imp;
+                imp.module = in.str();
+                imp.field = in.str();
+                if (in.u8() != 0x00) throw std::runtime_error("Only func imports are supported");
+                readSignature((uint32_t)in.uleb(), imp.paramTypes, imp.resultTypes);
+                mod.imports.push_back(imp);
+            }
+            break;
+        }
+        case SEC_FUNCTION: {
+            uint64_t n = in.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                Function func;
+                uint32_t typeIndex = (uint32_t)in.uleb();
+                readSignature(typeIndex, func.paramTypes, func.resultTypes);
+                func.paramNames.resize(func.paramTypes.size());
+                functionTypes.push_back(typeIndex);
+                mod.functions.push_back(func);
+            }
+            break;
+        }
+        case SEC_TABLE: {
+            uint64_t n = in.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                if (in.u8() != 0x70) throw std::runtime_error("Expected funcref table");
+                Table tbl;
+                uint8_t flags = in.u8();
+                tbl.min = (uint32_t)in.uleb();
+                tbl.max = (flags & 1) ? (uint32_t)in.uleb() : tbl.min;
+                mod.tables.push_back(tbl);
+            }
+            break;
+        }
+        case SEC_GLOBAL: {
+            uint64_t n = in.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                Global g;
+                g.type = valueType(in.u8());
+                g.isMutable = in.u8() != 0;
+                g.init = constExpr(in);
+                mod.globals.push_back(g);
+            }
+            break;
+        }
+        case SEC_EXPORT: {
+            static const char* kinds[] = {"func", "table", "memory", "global"};
+            uint64_t n = in.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                Export exp;
+                exp.name = in.str();
+                uint8_t kind = in.u8();
+                if (kind > 3) throw std::runtime_error("Bad export kind");
+                exp.kind = kinds[kind];
+                exp.target = std::to_string(in.uleb());
+                mod.exports.push_back(exp);
+            }
+            break;
+        }
+        case SEC_ELEM: {
+            uint64_t n = in.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                if (in.uleb() != 0) throw std::runtime_error("Only active table 0 element segments are supported");
+                ElementSegment elem;
+                elem.tableIndex = 0;
+                elem.offset = constExpr(in);
+                uint64_t count = in.uleb();
+                for (uint64_t j = 0; j < count; ++j) {
+                    elem.functionNames.push_back(std::to_string(in.uleb()));
+                }
+                mod.elements.push_back(elem);
+            }
+            break;
+        }
+        case SEC_CODE: {
+            uint64_t n = in.uleb();
+            if (n != functionTypes.size()) throw std::runtime_error("Function and code section counts differ");
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t length = in.uleb();
+                if (length > in.remaining()) throw std::runtime_error("Function body out of bounds");
+                ByteReader body(in.current(), length);
+                decodeCode(body, mod.functions[i]);
+                if (!body.atEnd()) throw std::runtime_error("Function body size mismatch");
+                in.skip(length);
+                codeBodies++;
+            }
+            break;
+        }
+        case SEC_MEMORY:
+        case SEC_DATA:
+            throw std::runtime_error("Linear memory is not supported; use MemoryStore host functions");
+        case SEC_START:
+            throw std::runtime_error("Start functions are not supported");
+        case SEC_DATACOUNT:
+            in.skip(in.remaining());
+            break;
+        default:
+            throw std::runtime_error("Unknown section id " + std::to_string(id));
+    }
+}
+
+void WasmDecoder::decodeCustom(ByteReader& in) {
+    std::string name = in.str();
+    if (name == "name") {
+        decodeNames(in);
+    } else if (name == "optrich.strings") {
+        uint64_t n = in.uleb();
+        for (uint64_t i = 0; i < n; ++i) {
+            StringDefinition def;
+            def.name = in.str();
+            def.value = in.str();
+            mod.strings.push_back(def);
+        }
+    } else {
+        in.skip(in.remaining());
+    }
+}
+
+void WasmDecoder::decodeNames(ByteReader& in) {
+    size_t numImports = mod.imports.size();
+    while (!in.atEnd()) {
+        uint8_t id = in.u8();
+        uint64_t length = in.uleb();
+        if (length > in.remaining()) throw std::runtime_error("Name subsection out of bounds");
+        ByteReader sub(in.current(), length);
+        in.skip(length);
+
+        if (id == 1) {
+            // Function names, in the function index space
+            uint64_t n = sub.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t idx = sub.uleb();
+                std::string name = sub.str();
+                if (idx < numImports) {
+                    mod.imports[idx].alias = name;
+                } else if (idx - numImports < mod.functions.size()) {
+                    mod.functions[idx - numImports].name = name;
+                }
+            }
+        } else if (id == 2) {
+            // Local names: params first, then declared locals
+            uint64_t n = sub.uleb();
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t idx = sub.uleb();
+                uint64_t count = sub.uleb();
+                Function* func = nullptr;
+                if (idx >= numImports && idx - numImports < mod.functions.size()) {
+                    func = &mod.functions[idx - numImports];
+                }
+                for (uint64_t j = 0; j < count; ++j) {
+                    uint64_t local = sub.uleb();
+                    std::string name = sub.str();
+                    if (!func) continue;
+                    if (local < func->paramNames.size()) {
+                        func->paramNames[local] = name;
+                    } else if (local - func->paramNames.size() < func->localNames.size()) {
+                        func->localNames[local - func->paramNames.size()] = name;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void WasmDecoder::decodeCode(ByteReader& in, Function& func) {
+    uint64_t groups = in.uleb();
+    for (uint64_t i = 0; i < groups; ++i) {
+        uint64_t count = in.uleb();
+        if (count > in.remaining() * 8 + 1024) throw std::runtime_error("Too many locals");
+        std::string type = valueType(in.u8());
+        func.localTypes.insert(func.localTypes.end(), count, type);
+    }
+    func.localNames.resize(func.localTypes.size());
+
+    const auto& simple = simpleOpcodes();
+    int depth = 0;
+    while (true) {
+        uint8_t op = in.u8();
+        switch (op) {
+            case 0x02:
+            case 0x03:
+            case 0x04: {
+                if (in.u8() != 0x40) throw std::runtime_error("Block results are not supported");
+                Opcode construct = op == 0x02 ? Opcode::BLOCK : op == 0x03 ? Opcode::LOOP : Opcode::IF;
+                func.body.push_back(Instruction(construct, std::string("")));
+                depth++;
+                break;
+            }
+            case 0x05:
+                func.body.push_back(Instruction(Opcode::ELSE));
+                break;
+            case 0x0b:
+                if (depth == 0) return; // End of function body
+                depth--;
+                func.body.push_back(Instruction(Opcode::END));
+                break;
+            case 0x0c:
+                func.body.push_back(Instruction(Opcode::BR, std::to_string(in.uleb())));
+                break;
+            case 0x0d:
+                func.body.push_back(Instruction(Opcode::BR_IF, std::to_string(in.uleb())));
+                break;
+            case 0x0e: {
+                // vec(labelidx) then the default, all as relative depths
+                uint64_t count = in.uleb();
+                if (count > in.remaining()) throw std::runtime_error("br_table out of bounds");
+                std::string labels;
+                for (uint64_t j = 0; j <= count; ++j) {
+                    if (j) labels += ' ';
+                    labels += std::to_string(in.uleb());
+                }
+                func.body.push_back(Instruction(Opcode::BR_TABLE, labels));
+                break;
+            }
+            case 0x10:
+                func.body.push_back(Instruction(Opcode::CALL, std::to_string(in.uleb())));
+                break;
+            case 0x11: {
+                std::string typeIndex = std::to_string(in.uleb());
+                if (in.u8() != 0x00) throw std::runtime_error("Only table 0 is supported");
+                func.body.push_back(Instruction(Opcode::CALL_INDIRECT, typeIndex));
+                break;
+            }
+            case 0x20: func.body.push_back(Instruction(Opcode::LOCAL_GET, std::to_string(in.uleb()))); break;
+            case 0x21: func.body.push_back(Instruction(Opcode::LOCAL_SET, std::to_string(in.uleb()))); break;
+            case 0x22: func.body.push_back(Instruction(Opcode::LOCAL_TEE, std::to_string(in.uleb()))); break;
+            case 0x23: func.body.push_back(Instruction(Opcode::GLOBAL_GET, std::to_string(in.uleb()))); break;
+            case 0x24: func.body.push_back(Instruction(Opcode::GLOBAL_SET, std::to_string(in.uleb()))); break;
+            case 0x41: func.body.push_back(Instruction(Opcode::I32_CONST, (int32_t)in.sleb())); break;
+            case 0x42: func.body.push_back(Instruction(Opcode::I64_CONST, (int64_t)in.sleb())); break;
+            case 0x43: func.body.push_back(Instruction(Opcode::F32_CONST, in.raw<float>())); break;
+            case 0x44: func.body.push_back(Instruction(Opcode::F64_CONST, in.raw<double>())); break;
+            case kStringConstOpcode:
+                func.body.push_back(Instruction(Opcode::STRING_CONST, std::to_string(in.uleb())));
+                break;
+            default:
+                if (simple[op] < 0) throw std::runtime_error("Unsupported wasm opcode " + hexByte(op));
+                func.body.push_back(Instruction((Opcode)simple[op]));
+                break;
+        }
+    }
+}
+
+std::string WasmDecoder::valueType(uint8_t code) {
+    switch (code) {
+        case 0x7F: return "i32";
+        case 0x7E: return "i64";
+        case 0x7D: return "f32";
+        case 0x7C: return "f64";
+        default: throw std::runtime_error("Unsupported value type " + hexByte(code));
+    }
+}
+
+Instruction WasmDecoder::constExpr(ByteReader& in) {
+    Instruction instr;
+    uint8_t op = in.u8();
+    switch (op) {
+        case 0x41: instr = Instruction(Opcode::I32_CONST, (int32_t)in.sleb()); break;
+        case 0x42: instr = Instruction(Opcode::I64_CONST, (int64_t)in.sleb()); break;
+        case 0x43: instr = Instruction(Opcode::F32_CONST, in.raw<float>()); break;
+        case 0x44: instr = Instruction(Opcode::F64_CONST, in.raw<double>()); break;
+        default: throw std::runtime_error("Unsupported constant expression " + hexByte(op));
+    }
+    if (in.u8() != 0x0b) throw std::runtime_error("Expected end of constant expression");
+    return instr;
+}
+
+void WasmDecoder::readSignature(uint32_t typeIndex, std::vector<std::string>& params, std::vector<std::string>& results) {
+    if (typeIndex >= mod.types.size()) throw std::runtime_error("Type index out of range");
+    params = mod.types[typeIndex].paramTypes;
+    results = mod.types[typeIndex].resultTypes;
+}
@@ -5,13 +5,18 @@
 #include <fstream>
 #include <functional>
 #include <map>
-#include <list>
+#include <mutex>
 #include <sstream>
 
-#include "Lexer.h"
 #include "Parser.h"
 #include "Interpreter.h"
+#include "Linker.h"
+#include "MappedFile.h"
 #include "MemoryStore.h"
+#include "StdioHost.h"
+#include "ModuleCache.h"
+#include "ThreadPool.h"
+#include "WasmDecoder.h"
 
 namespace fs = std::filesystem;
 
@@ -42,11 +47,6 @@ WasmValue host_read_u8(MemoryStore* store, std::vector<WasmValue>& args) {
     return WasmValue(static_cast<int32_t>(store->read<uint8_t>(args[0].i32, args[1].i32)));
 }
 
-WasmValue host_putchar(std::vector<WasmValue>& args) {
-    std::cout << (char)args[0].i32;
-    return WasmValue();
-}
-
 std::string readFile(const std::string& path) {
     std::ifstream t(path);
     if (!t.is_open()) throw std::runtime_error("Could not open file: " + path);
@@ -55,7 +55,68 @@ std::string readFile(const std::string& path) {
     return buffer.str();
 }
 
-void registerStandardHostFunctions(Interpreter& vm, MemoryStore& store) {
+// Set by --cache: parsed modules persist there across runs.
+std::unique_ptr<ModuleCache> diskCache;
+// Set by --lazy: function bodies are parsed on first call.
+bool lazyParse = false;
+// Set by --link: main and its libraries run as one merged module.
+bool linkModules = false;
+
+// Modules are lexed, parsed and compiled on a shared pool; independent
+// files load concurrently and each is loaded only once per process, since
+// libraries are shared by several main_*.wat tests.
+ThreadPool& loaderPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// Function bodies of one module are parsed in chunks on their own pool:
+// the loader task waits for them, so they must not queue behind it.
+ThreadPool& parserPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+std::shared_ptr<const CompiledModule> compileFile(const fs::path& path) {
+    Module mod;
+    if (path.extension() == ".wasm") {
+        mod = WasmDecoder::decodeFile(path.string());
+    } else if (diskCache) {
+        mod = diskCache->loadFile(path.string());
+    } else if (lazyParse) {
+        // The module keeps the mapping alive for its unparsed bodies
+        auto file = std::make_shared<MappedFile>(path.string());
+        mod = Parser::parseLazy(std::string_view(reinterpret_cast<const char*>(file->data()), file->size()), file);
+    } else {
+        // Tokens are views into the mapping; it outlives the parse
+        MappedFile file(path.string());
+        mod = Parser::parseParallel(std::string_view(reinterpret_cast<const char*>(file.data()), file.size()),
+                                    parserPool());
+    }
+    return std::make_shared<const CompiledModule>(std::move(mod));
+}
+
+using ModuleFuture = std::shared_future<std::shared_ptr<const CompiledModule>>;
+
+ModuleFuture loadModuleAsync(const fs::path& path) {
+    static std::mutex mtx;
+    static std::map<std::string, ModuleFuture> cache;
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = cache.find(path.string());
+    if (it != cache.end()) return it->second;
+
+    ModuleFuture loaded = loaderPool().submit([path]() { return compileFile(path); }).share();
+    cache[path.string()] = loaded;
+    return loaded;
+}
+
+std::shared_ptr<const CompiledModule> loadModule(const fs::path& path) {
+    return loadModuleAsync(path).get();
+}
+
+// env.putchar and the rest of the stdio imports go to stdio, which every
+// instance of one program shares so that their output stays in order.
+void registerStandardHostFunctions(Interpreter& vm, MemoryStore& store, StdioHost& stdio) {
     using namespace std::placeholders;
     vm.registerHostFunction("env", "alloc", std::bind(host_alloc, &store, _1), {"i32"}, {"i32"});
     vm.registerHostFunction("env", "make_span", std::bind(host_make_span, &store, _1), {"i32", "i32", "i32"}, {"i32"});
@@ -63,49 +124,55 @@ void registerStandardHostFunctions(Interpreter& vm, MemoryStore& store) {
     vm.registerHostFunction("env", "read_i32", std::bind(host_read_i32, &store, _1), {"i32", "i32"}, {"i32"});
     vm.registerHostFunction("env", "write_u8", std::bind(host_write_u8, &store, _1), {"i32", "i32", "i32"}, {});
     vm.registerHostFunction("env", "read_u8", std::bind(host_read_u8, &store, _1), {"i32", "i32"}, {"i32"});
-    vm.registerHostFunction("env", "putchar", host_putchar, {"i32"}, {});
+    stdio.bind(vm, "env");
 }
 
 void runTest(const fs::path& mainPath) {
     try {
         MemoryStore store;
-        // Keep modules alive!
-        std::list<Module> moduleStore;
+        StdioHost stdio(store, std::cout);
         std::map<std::string, std::unique_ptr<Interpreter>> interpreters;
 
         // 1. Load Main Module
-        std::string mainCode = readFile(mainPath.string());
-        Lexer mainLexer(mainCode);
-        moduleStore.push_back(Parser(mainLexer.tokenize()).parse());
-        Module& mainMod = moduleStore.back();
+        auto mainCompiled = loadModule(mainPath);
+        const Module& mainMod = mainCompiled->module();
 
         // 2. Identify and Load Dependencies
-        // We look at imports to find "lib_*.wat"
+        // We look at imports to find "lib_*.wat"; all of them load in parallel
+        std::map<std::string, ModuleFuture> libs;
         for (const auto& imp : mainMod.imports) {
             if (imp.module == "env") continue; // Skip standard env
+            if (libs.count(imp.module)) continue;
 
-            // Check if we already loaded it
-            if (interpreters.find(imp.module) != interpreters.end()) continue;
-
-            // Look for testdata/lib_<module>.wat
-            fs::path libPath = mainPath.parent_path() / ("lib_" + imp.module + ".wat");
+            // Look for testdata/lib_<module>.wasm, then .wat
+            fs::path libPath = mainPath.parent_path() / ("lib_" + imp.module + ".wasm");
+            if (!fs::exists(libPath)) libPath.replace_extension(".wat");
             if (!fs::exists(libPath)) {
                 throw std::runtime_error("Missing library: " + libPath.string());
             }
-
-            std::string libCode = readFile(libPath.string());
-            Lexer libLexer(libCode);
-            moduleStore.push_back(Parser(libLexer.tokenize()).parse());
-            Module& libMod = moduleStore.back();
-
-            auto libVM = std::make_unique<Interpreter>(libMod, store);
-            registerStandardHostFunctions(*libVM, store);
-            interpreters[imp.module] = std::move(libVM);
+            libs[imp.module] = loadModuleAsync(libPath);
+        }
+        if (linkModules) {
+            // One Interpreter; library calls are direct calls
+            Linker linker;
+            for (auto& lib : libs) linker.addLibrary(lib.first, lib.second.get()->module());
+            auto linked = std::make_shared<const CompiledModule>(linker.link(mainMod, {"main"}));
+            Interpreter vm(linked, store);
+            registerStandardHostFunctions(vm, store, stdio);
+            WasmValue res = vm.run("main", {});
+            stdio.flush();
+            std::cout << "Result: " << res.i32 << std::endl;
+            return;
+        }
+        for (auto& lib : libs) {
+            auto libVM = std::make_unique<Interpreter>(lib.second.get(), store);
+            registerStandardHostFunctions(*libVM, store, stdio);
+            interpreters[lib.first] = std::move(libVM);
         }
 
         // 3. Setup Main Interpreter
-        Interpreter mainVM(mainMod, store);
-        registerStandardHostFunctions(mainVM, store);
+        Interpreter mainVM(mainCompiled, store);
+        registerStandardHostFunctions(mainVM, store, stdio);
 
         // 4. Link Libraries to Main
         // For every import in Main that isn't env, we find the function in the loaded module
@@ -133,6 +200,7 @@ void runTest(const fs::path& mainPath) {
         // We just print to stdout.
 
         WasmValue res = mainVM.run("main", {});
+        stdio.flush();
         std::cout << "Result: " << res.i32 << std::endl;
 
     } catch (const std::exception& e) {
@@ -146,7 +214,18 @@ int main(int argc, char** argv) {
     // User requirement: "scans WAT files in testdata and execute files starts with main_"
 
     fs::path testDir = "testdata";
-    if (argc > 1) testDir = argv[1];
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cache" && i + 1 < argc) {
+            diskCache = std::make_unique<ModuleCache>(argv[++i]);
+        } else if (arg == "--lazy") {
+            lazyParse = true;
+        } else if (arg == "--link") {
+            linkModules = true;
+        } else {
+            testDir = arg;
+        }
+    }
 
     if (!fs::exists(testDir)) {
         std::cerr << "Directory not found: " << testDir << std::endl;
@@ -157,16 +236,22 @@ int main(int argc, char** argv) {
     std::vector<fs::path> mainFiles;
     for (const auto& entry : fs::directory_iterator(testDir)) {
         std::string filename = entry.path().filename().string();
-        if (filename.rfind("main_", 0) == 0 && filename.substr(filename.length()-4) == ".wat") {
+        std::string ext = entry.path().extension().string();
+        if (filename.rfind("main_", 0) == 0 && (ext == ".wat" || ext == ".wasm")) {
             mainFiles.push_back(entry.path());
         }
     }
 
     if (mainFiles.empty()) {
-        std::cout << "No main_*.wat files found in " << testDir << std::endl;
+        std::cout << "No main_*.wat or main_*.wasm files found in " << testDir << std::endl;
         return 0;
     }
 
+    // Start loading every main module up front; runTest picks them up
+    for (const auto& path : mainFiles) {
+        loadModuleAsync(path);
+    }
+
     bool allPassed = true;
     for (const auto& path : mainFiles) {
         // We need to verify the output against expected_stdout.
@@ -0,0 +1,126 @@
+#include <deque>
+#include <iostream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+// A fake I/O service: requests queue up and are answered later, in order.
+struct Request {
+    int client;
+    int32_t key;
+};
+
+int main() {
+    std::string code = R"(
+        (module
+            (import "env" "fetch" (func $fetch (param i32) (result i32)))
+            (import "env" "log" (func $log (param i32)))
+            (import "env" "nested" (func $nested (result i32)))
+            ;; Sums fetch(base + i) for i in [0, n)
+            (func $sumFetched (param $base i32) (param $n i32) (result i32)
+                (local $i i32)
+                (local $acc i32)
+                (block $done
+                    (loop $next
+                        (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                        (local.set $acc (i32.add (local.get $acc)
+                                                 (call $fetch (i32.add (local.get $base) (local.get $i)))))
+                        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                        (br $next)
+                    )
+                )
+                (call $log (local.get $acc))
+                (local.get $acc)
+            )
+            (func $fetchOne (result i32) (call $fetch (i32.const 7)))
+            (func $callsHost (result i32) (call $nested))
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+
+    // One thread drives several instances that each wait on the service
+    const int clients = 3;
+    std::deque<Request> queue;
+    std::vector<std::unique_ptr<MemoryStore>> stores;
+    std::vector<std::unique_ptr<Interpreter>> vms;
+    for (int c = 0; c < clients; ++c) {
+        stores.push_back(std::make_unique<MemoryStore>());
+        vms.push_back(std::make_unique<Interpreter>(compiled, *stores.back()));
+        vms[c]->registerHostFunction("env", "fetch", [&queue, c](std::vector<WasmValue>& args) {
+            queue.push_back({c, args[0].i32});
+            return WasmValue::pending();
+        }, {"i32"}, {"i32"});
+        // A host function without a result may also complete later
+        vms[c]->registerHostFunction("env", "log", [&queue, c](std::vector<WasmValue>& args) {
+            std::cout << "client " << c << " logs " << args[0].i32 << std::endl;
+            queue.push_back({c, -1});
+            return WasmValue::pending();
+        }, {"i32"}, {});
+    }
+
+    std::vector<WasmValue> results(clients);
+    for (int c = 0; c < clients; ++c) {
+        results[c] = vms[c]->run("sumFetched", {WasmValue(c * 100), WasmValue(c + 2)});
+        std::cout << "client " << c << " pending: " << (results[c].isPending() ? "yes" : "no")
+                  << ", awaiting host: " << (vms[c]->awaitingHost() ? "yes" : "no") << std::endl;
+    }
+
+    int completions = 0;
+    while (!queue.empty()) {
+        Request req = queue.front();
+        queue.pop_front();
+        ++completions;
+        // The service answers fetches with key * 2; logs have no result
+        WasmValue answer = req.key < 0 ? WasmValue() : WasmValue(req.key * 2);
+        results[req.client] = vms[req.client]->resume(answer);
+    }
+    for (int c = 0; c < clients; ++c) {
+        std::cout << "client " << c << " result: " << results[c].i32 << std::endl;
+    }
+    std::cout << "completions: " << completions << std::endl;
+
+    Interpreter& vm = *vms[0];
+    std::cout << "fetchOne pending: " << (vm.run("fetchOne", {}).isPending() ? "yes" : "no") << std::endl;
+    queue.clear();
+    try {
+        vm.resume();
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    try {
+        vm.resume(WasmValue(1.5));
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    std::cout << "fetchOne = " << vm.resume(WasmValue(14)).i32 << std::endl;
+
+    try {
+        vm.resume(WasmValue(1));
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    // Cancel drops a waiting run
+    vm.run("fetchOne", {});
+    vm.cancel();
+    std::cout << "After cancel, suspended: " << (vm.suspended() ? "yes" : "no") << std::endl;
+
+    // A nested run cannot suspend across the host function that started it
+    MemoryStore store;
+    Interpreter outer(compiled, store);
+    Interpreter* self = &outer;
+    outer.registerHostFunction("env", "fetch", [](std::vector<WasmValue>&) { return WasmValue::pending(); },
+                               {"i32"}, {"i32"});
+    outer.registerHostFunction("env", "nested", [self](std::vector<WasmValue>&) {
+        return self->run("fetchOne", {});
+    }, {}, {"i32"});
+    try {
+        outer.run("callsHost", {});
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    std::cout << "Outer suspended: " << (outer.suspended() ? "yes" : "no") << std::endl;
+    return 0;
+}
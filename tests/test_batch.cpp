@@ -0,0 +1,104 @@
+#include <iostream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "InstancePool.h"
+#include "MemoryStore.h"
+
+int main() {
+    std::string code = R"(
+        (module
+            (global $calls (mut i32) (i32.const 0))
+            (func $score (param $a i32) (param $b i32) (result i32)
+                (global.set $calls (i32.add (global.get $calls) (i32.const 1)))
+                (i32.div_s (i32.add (i32.mul (local.get $a) (i32.const 3)) (local.get $b)) (local.get $b))
+            )
+            (func $calls (result i32) (global.get $calls))
+            (func $half (param $x f64) (result f64) (f64.div (local.get $x) (f64.const 2)))
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+
+    // Row-major (a, b) pairs
+    const size_t rows = 10000;
+    std::vector<WasmValue> args;
+    for (size_t i = 0; i < rows; ++i) {
+        args.push_back(WasmValue((int32_t)i));
+        args.push_back(WasmValue((int32_t)(i % 7 + 1)));
+    }
+
+    FunctionRef score = vm.lookup("score");
+    std::vector<WasmValue> results;
+    vm.runBatch(score, args, results);
+    bool matches = results.size() == rows;
+    for (size_t i = 0; i < rows && matches; ++i) {
+        int32_t b = (int32_t)(i % 7 + 1);
+        matches = results[i].type == WasmValue::I32 && results[i].i32 == ((int32_t)i * 3 + b) / b;
+    }
+    std::cout << "Batch of " << rows << " matches: " << (matches ? "yes" : "no") << std::endl;
+    std::cout << "Same as run(): " << (vm.run(score, {WasmValue(5), WasmValue(2)}).i32 == vm.run("score", {WasmValue(5), WasmValue(2)}).i32 ? "yes" : "no")
+              << std::endl;
+
+    // Rows share the instance, like consecutive run() calls
+    std::cout << "calls() = " << vm.run("calls", {}).i32 << std::endl;
+
+    // Functions without parameters take one call per presized result
+    std::vector<WasmValue> counts(3);
+    vm.runBatch(vm.lookup("calls"), {}, counts);
+    std::cout << "calls() x3 = " << counts[0].i32 << " " << counts[1].i32 << " " << counts[2].i32 << std::endl;
+
+    std::vector<WasmValue> halves;
+    vm.runBatch(vm.lookup("half"), {WasmValue(3.0), WasmValue(-1.0)}, halves);
+    std::cout << "half = " << halves[0].f64 << " " << halves[1].f64 << std::endl;
+
+    // The first error stops the batch; earlier rows keep their results
+    std::vector<WasmValue> bad = {WasmValue(1), WasmValue(1), WasmValue(2), WasmValue(0), WasmValue(3), WasmValue(1)};
+    std::vector<WasmValue> partial;
+    try {
+        vm.runBatch(score, bad, partial);
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    std::cout << "Row 0 before the error: " << partial[0].i32 << std::endl;
+
+    try {
+        vm.runBatch(score, {WasmValue(1), WasmValue(2), WasmValue(3)}, results);
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    // A reference from another module is rejected
+    Lexer otherLexer("(module (func $score (param i32) (param i32) (result i32) (local.get 0)))");
+    auto other = std::make_shared<const CompiledModule>(Parser(otherLexer).parse());
+    MemoryStore otherStore;
+    Interpreter otherVm(other, otherStore);
+    try {
+        vm.run(otherVm.lookup("score"), {WasmValue(1), WasmValue(2)});
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    // Fanned out over threads, each chunk on its own pooled instance
+    MemoryStore fresh;
+    Interpreter template_(compiled, fresh);
+    InstancePool pool(template_.snapshot(), nullptr);
+    ThreadPool threads(4);
+    std::vector<WasmValue> parallel;
+    pool.runBatch("score", args, parallel, threads);
+    bool same = parallel.size() == rows;
+    for (size_t i = 0; i < rows && same; ++i) same = parallel[i].i32 == results[i].i32;
+    std::cout << "Parallel batch matches: " << (same ? "yes" : "no") << std::endl;
+    std::cout << "Pooled instances: " << (pool.createdCount() <= threads.size() ? "at most one per thread" : "too many")
+              << std::endl;
+
+    try {
+        pool.runBatch("score", bad, parallel, threads, 1);
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    std::cout << "Other chunks still ran: " << parallel[0].i32 << " " << parallel[2].i32 << std::endl;
+    return 0;
+}
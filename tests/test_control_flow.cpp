@@ -0,0 +1,164 @@
+#include <iostream>
+#include "Parser.h"
+#include "WasmDecoder.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+// Binary form of:
+//
+// (func (export "classify") (param i32) (result i32)
+//   block block block
+//     local.get 0 br_table 0 1 2
+//   end i32.const 100 return
+//   end i32.const 200 return
+//   end i32.const 300)
+// (func (export "pick") (param i32) (result i32) (local i32)
+//   local.get 0 if i32.const 1 local.set 1 else i32.const 2 local.set 1 end
+//   local.get 1)
+std::vector<uint8_t> buildModule() {
+    ByteWriter out;
+    const uint8_t header[] = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+    out.bytes.assign(header, header + 8);
+    auto section = [&out](uint8_t id, const std::vector<uint8_t>& payload) {
+        out.u8(id);
+        out.uleb(payload.size());
+        out.bytes.insert(out.bytes.end(), payload.begin(), payload.end());
+    };
+
+    section(1, {0x01, 0x60, 0x01, 0x7f, 0x01, 0x7f});
+    section(3, {0x02, 0x00, 0x00});
+    ByteWriter exports;
+    exports.uleb(2);
+    exports.str("classify"); exports.u8(0x00); exports.uleb(0);
+    exports.str("pick"); exports.u8(0x00); exports.uleb(1);
+    section(7, exports.bytes);
+
+    const std::vector<uint8_t> classify = {
+        0x00, 0x02, 0x40, 0x02, 0x40, 0x02, 0x40, 0x20, 0x00, 0x0e, 0x02, 0x00, 0x01, 0x02, 0x0b,
+        0x41, 0xe4, 0x00, 0x0f, 0x0b, 0x41, 0xc8, 0x01, 0x0f, 0x0b, 0x41, 0xac, 0x02, 0x0b};
+    const std::vector<uint8_t> pick = {
+        0x01, 0x01, 0x7f, 0x20, 0x00, 0x04, 0x40, 0x41, 0x01, 0x21, 0x01, 0x05,
+        0x41, 0x02, 0x21, 0x01, 0x0b, 0x20, 0x01, 0x0b};
+    ByteWriter code;
+    code.uleb(2);
+    for (const auto* body : {&classify, &pick}) {
+        code.uleb(body->size());
+        code.bytes.insert(code.bytes.end(), body->begin(), body->end());
+    }
+    section(10, code.bytes);
+    return out.bytes;
+}
+
+int main() {
+    std::string code = R"(
+        (module
+            (func $sign (param $x i32) (result i32)
+                (local $r i32)
+                (if $check (i32.lt_s (local.get $x) (i32.const 0))
+                    (then (local.set $r (i32.const -1)))
+                    (else
+                        (if (local.get $x)
+                            (then (local.set $r (i32.const 1))))))
+                (local.get $r)
+            )
+            ;; Leaving an if early with br
+            (func $firstNonZero (param $a i32) (param $b i32) (result i32)
+                (local $r i32)
+                (block $done
+                    (if (local.get $a)
+                        (then (local.set $r (local.get $a)) (br $done)))
+                    (local.set $r (local.get $b))
+                )
+                (local.get $r)
+            )
+            ;; A tiny bytecode machine: the program is packed 4 bits per op,
+            ;; lowest first. 0 halts, 1 adds 1, 2 doubles, 3 negates, and any
+            ;; other op is ignored. Dispatch is a single br_table per step.
+            (func $run (param $program i32) (result i32)
+                (local $acc i32)
+                (local $op i32)
+                (block $halt
+                    (loop $step
+                        (local.set $op (i32.and (local.get $program) (i32.const 15)))
+                        (local.set $program (i32.shr_u (local.get $program) (i32.const 4)))
+                        (block $skip
+                            (block $neg
+                                (block $double
+                                    (block $inc
+                                        (br_table $halt $inc $double $neg $skip (local.get $op))
+                                    )
+                                    (local.set $acc (i32.add (local.get $acc) (i32.const 1)))
+                                    (br $step)
+                                )
+                                (local.set $acc (i32.mul (local.get $acc) (i32.const 2)))
+                                (br $step)
+                            )
+                            (local.set $acc (i32.sub (i32.const 0) (local.get $acc)))
+                            (br $step)
+                        )
+                        (br $step)
+                    )
+                )
+                (local.get $acc)
+            )
+            ;; br_table straight back to a loop and by relative depth
+            (func $countdown (param $n i32) (result i32)
+                (local $steps i32)
+                (block $out
+                    (loop $again
+                        (local.set $steps (i32.add (local.get $steps) (i32.const 1)))
+                        (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                        (br_table 1 $again (i32.ne (local.get $n) (i32.const 0)))
+                    )
+                )
+                (local.get $steps)
+            )
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+
+    int validated = 0;
+    for (size_t i = 0; i < compiled->functionCount(); ++i) {
+        if (compiled->function(i).validated) validated++;
+    }
+    std::cout << "Validated: " << validated << "/" << compiled->functionCount() << std::endl;
+
+    std::cout << "sign:";
+    for (int32_t x : {-7, 0, 9}) std::cout << " " << vm.run("sign", {WasmValue(x)}).i32;
+    std::cout << std::endl;
+    std::cout << "firstNonZero(0, 5) = " << vm.run("firstNonZero", {WasmValue(0), WasmValue(5)}).i32 << std::endl;
+    std::cout << "firstNonZero(3, 5) = " << vm.run("firstNonZero", {WasmValue(3), WasmValue(5)}).i32 << std::endl;
+
+    // inc inc double skip neg inc, then halt: -((1 + 1) * 2) + 1
+    std::cout << "run(0x139211) = " << vm.run("run", {WasmValue(0x139211)}).i32 << std::endl;
+    std::cout << "countdown(5) = " << vm.run("countdown", {WasmValue(5)}).i32 << std::endl;
+
+    std::vector<uint8_t> bytes = buildModule();
+    Module decoded = WasmDecoder::decode(bytes.data(), bytes.size());
+    MemoryStore decodedStore;
+    Interpreter decodedVm(decoded, decodedStore);
+    std::cout << "decoded classify:";
+    for (int32_t x : {0, 1, 2, 7, -1}) std::cout << " " << decodedVm.run("classify", {WasmValue(x)}).i32;
+    std::cout << std::endl;
+    std::cout << "decoded pick: " << decodedVm.run("pick", {WasmValue(1)}).i32 << " "
+              << decodedVm.run("pick", {WasmValue(0)}).i32 << std::endl;
+
+    try {
+        Lexer bad("(module (func $f (br_table $nowhere (i32.const 0))))");
+        CompiledModule(Parser(bad).parse());
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    try {
+        Lexer bad("(module (func $f (if (i32.const 1) (then (i32.const 2)))))");
+        Module mod = Parser(bad).parse();
+        std::cout << CompiledModule(std::move(mod)).function(0).validationError << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <iostream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+int main() {
+    std::string code = R"(
+        (module
+            (import "env" "nested" (func $nested (result i32)))
+            (func $sum (param $n i32) (result i32)
+                (local $i i32)
+                (local $acc i32)
+                (block $done
+                    (loop $next
+                        (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                        (local.set $acc (i32.add (local.get $acc) (local.get $i)))
+                        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                        (br $next)
+                    )
+                )
+                (local.get $acc)
+            )
+            (func $spin (loop $forever (br $forever)))
+            (func $recurse (param $n i32) (result i32)
+                (call $recurse (i32.add (local.get $n) (i32.const 1)))
+            )
+            (func $straight (result i32)
+                (i32.add (i32.const 40) (i32.const 2))
+            )
+            (func $callsHost (result i32) (call $nested))
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+    Interpreter* self = &vm;
+    vm.registerHostFunction("env", "nested", [self](std::vector<WasmValue>&) {
+        return self->run("sum", {WasmValue(1000000)});
+    }, {}, {"i32"});
+
+    std::cout << "Unmetered sum(1000) = " << vm.run("sum", {WasmValue(1000)}).i32 << std::endl;
+    std::cout << "Metered by default: " << (vm.metered() ? "yes" : "no") << std::endl;
+
+    // A runaway loop stops instead of pinning the thread
+    vm.setFuel(10000);
+    try {
+        vm.run("spin", {});
+    } catch (const FuelExhausted& e) {
+        std::cout << "spin: " << e.what() << ", resumable: " << (e.resumable ? "yes" : "no") << std::endl;
+    }
+    std::cout << "Suspended: " << (vm.suspended() ? "yes" : "no") << std::endl;
+    try {
+        vm.run("straight", {});
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    vm.cancel();
+    std::cout << "After cancel, suspended: " << (vm.suspended() ? "yes" : "no") << std::endl;
+
+    // Resuming in small slices gives the same result as one unmetered run
+    vm.setFuel(500);
+    int slices = 1;
+    WasmValue result;
+    try {
+        result = vm.run("sum", {WasmValue(1000)});
+    } catch (const FuelExhausted&) {
+        while (true) {
+            vm.setFuel(500);
+            ++slices;
+            try {
+                result = vm.resume();
+                break;
+            } catch (const FuelExhausted&) {
+            }
+        }
+    }
+    std::cout << "Sliced sum(1000) = " << result.i32 << " in " << slices << " slices" << std::endl;
+    std::cout << "Fuel left over: " << (vm.fuelRemaining() < 500 ? "some" : "too much") << std::endl;
+
+    // Straight-line code only pays for its call
+    vm.setFuel(1);
+    std::cout << "straight() with 1 unit = " << vm.run("straight", {}).i32
+              << ", remaining " << vm.fuelRemaining() << std::endl;
+
+    // Calls are charged, so unbounded recursion stops too
+    vm.setFuel(1000);
+    try {
+        vm.run("recurse", {WasmValue(0)});
+    } catch (const FuelExhausted& e) {
+        std::cout << "recurse: " << e.what() << ", resumable: " << (e.resumable ? "yes" : "no") << std::endl;
+    }
+    vm.cancel();
+
+    // A run nested in a host call cannot be suspended across the host frame
+    vm.setFuel(1000);
+    try {
+        vm.run("callsHost", {});
+    } catch (const FuelExhausted& e) {
+        std::cout << "callsHost: " << e.what() << ", resumable: " << (e.resumable ? "yes" : "no") << std::endl;
+    }
+    std::cout << "Suspended: " << (vm.suspended() ? "yes" : "no") << std::endl;
+
+    try {
+        vm.resume();
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    vm.clearFuel();
+    std::cout << "Unmetered again, sum(100) = " << vm.run("sum", {WasmValue(100)}).i32 << std::endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <memory>
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+const char* source = R"(
+    (module
+        (import "env" "read" (func $read (param i32) (result i32)))
+        (func $get (param $i i32) (result i32) (call $read (i32.add (local.get $i) (i32.const 4))))
+        (func $square (param $x i32) (result i32) (i32.mul (local.get $x) (local.get $x)))
+        (func $sumSquares (param $n i32) (result i32)
+            (local $i i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                    (local.set $acc (i32.add (local.get $acc) (call $square (call $get (local.get $i)))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        ;; Returns from the middle, with a value
+        (func $clamp (param $x i32) (result i32)
+            (if (i32.lt_s (local.get $x) (i32.const 0)) (then (return (i32.const 0))))
+            (if (i32.gt_s (local.get $x) (i32.const 100)) (then (return (i32.const 100))))
+            (local.get $x)
+        )
+        ;; Its local has to start at zero on every call
+        (func $fresh (param $x i32) (result i32)
+            (local $t i32)
+            (local.set $t (i32.add (local.get $t) (local.get $x)))
+            (local.get $t)
+        )
+        (func $pick (param $k i32) (result i32)
+            (block $c (block $b (block $a (br_table $a $b $c (local.get $k)))
+                (return (i32.const 10)))
+                (return (i32.const 20)))
+            (i32.const 30)
+        )
+        (func $lane (param $x f64) (result f64)
+            (local $v v128)
+            (local.set $v (f64x2.splat (local.get $x)))
+            (f64x2.extract_lane 1 (f64x2.add (local.get $v) (local.get $v)))
+        )
+        (func $mixed (param $a i32) (result i32)
+            (i32.add
+                (i32.add (call $clamp (local.get $a)) (call $clamp (i32.sub (i32.const 0) (local.get $a))))
+                (i32.add (i32.add (call $fresh (local.get $a)) (call $fresh (i32.const 1))) (call $pick (local.get $a))))
+        )
+        (func $double (param $x f64) (result f64) (f64.add (call $lane (local.get $x)) (call $lane (f64.const 0.25))))
+        (func $fib (param $n i32) (result i32)
+            (if (i32.lt_s (local.get $n) (i32.const 2)) (then (return (local.get $n))))
+            (i32.add (call $fib (i32.sub (local.get $n) (i32.const 1)))
+                     (call $fib (i32.sub (local.get $n) (i32.const 2))))
+        )
+        (func $even (param $n i32) (result i32)
+            (if (i32.eqz (local.get $n)) (then (return (i32.const 1))))
+            (call $odd (i32.sub (local.get $n) (i32.const 1)))
+        )
+        (func $odd (param $n i32) (result i32)
+            (if (i32.eqz (local.get $n)) (then (return (i32.const 0))))
+            (call $even (i32.sub (local.get $n) (i32.const 1)))
+        )
+        (func $level2 (param $x i32) (result i32) (i32.add (local.get $x) (i32.const 2)))
+        (func $level1 (param $x i32) (result i32) (call $level2 (i32.add (local.get $x) (i32.const 1))))
+        (func $level0 (param $x i32) (result i32) (call $level1 (local.get $x)))
+    )
+)";
+
+std::shared_ptr<const CompiledModule> load(OptimizerOptions options) {
+    Lexer lexer(source);
+    return std::make_shared<const CompiledModule>(Parser(lexer).parse(), options);
+}
+
+void describe(const CompiledModule& cm, const char* name) {
+    const CompiledFunction& cf = cm.function(cm.findFunction(name));
+    std::cout << "  " << name << ": inlined " << cf.optimizerStats.inlinedCalls << ", depth " << cf.inlineDepth
+              << ", locals " << cf.numLocals << ", " << (cf.validated ? "validated" : "not validated") << std::endl;
+}
+
+int main() {
+    auto inlined = load({});
+    OptimizerOptions off;
+    off.inlining = false;
+    auto calls = load(off);
+
+    MemoryStore store, otherStore;
+    Interpreter vm(inlined, store), plain(calls, otherStore);
+    for (Interpreter* i : {&vm, &plain}) {
+        i->registerHostFunction("env", "read", [](std::vector<WasmValue>& args) {
+            return WasmValue(args[0].i32 * 3);
+        }, {"i32"}, {"i32"});
+    }
+
+    std::cout << "Inlined:" << std::endl;
+    for (const char* name : {"get", "sumSquares", "mixed", "double", "fib", "even", "level0"}) {
+        describe(*inlined, name);
+    }
+    std::cout << "Module: " << inlined->optimizerStats().inlinedCalls << " calls inlined, "
+              << calls->optimizerStats().inlinedCalls << " with inlining off, "
+              << inlined->optimizerStats().revalidationFailures << " revalidation failures" << std::endl;
+    if (inlined->optimizerStats().revalidationFailures != 0) return 1;
+
+    struct Call {
+        const char* name;
+        WasmValue arg;
+    };
+    std::vector<Call> runs = {{"sumSquares", WasmValue(50)}, {"mixed", WasmValue(-7)}, {"mixed", WasmValue(0)},
+                              {"mixed", WasmValue(1)}, {"mixed", WasmValue(2)}, {"mixed", WasmValue(250)},
+                              {"double", WasmValue(1.5)}, {"fib", WasmValue(15)}, {"even", WasmValue(9)},
+                              {"level0", WasmValue(5)}};
+    for (const auto& call : runs) {
+        WasmValue a = vm.run(call.name, {call.arg});
+        WasmValue b = plain.run(call.name, {call.arg});
+        std::cout << call.name << " = " << (a.type == WasmValue::F64 ? a.f64 : a.i32) << ", "
+                  << (a.type == b.type && a.i64 == b.i64 ? "same" : "DIFFERENT") << " without inlining"
+                  << std::endl;
+    }
+
+    // Budgets: one level only, then only the smallest callees
+    OptimizerOptions shallow;
+    shallow.inlineMaxDepth = 1;
+    auto oneLevel = load(shallow);
+    std::cout << "Depth 1:" << std::endl;
+    describe(*oneLevel, "level1");
+    describe(*oneLevel, "level0");
+    OptimizerOptions tiny;
+    tiny.inlineMaxSize = 3;
+    auto small = load(tiny);
+    std::cout << "Size 3:" << std::endl;
+    describe(*small, "sumSquares");
+    describe(*small, "mixed");
+    return 0;
+}
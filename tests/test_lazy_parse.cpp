@@ -0,0 +1,79 @@
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "ModuleSerializer.h"
+
+int main() {
+    auto code = std::make_shared<const std::string>(R"(
+        (module
+            (func $square (param $x i32) (result i32)
+                (i32.mul (local.get $x) (local.get $x))
+            )
+            (func $cube (param $x i32) (result i32)
+                (i32.mul (local.get $x) (call $square (local.get $x)))
+            )
+            (func $unused (param $x i32) (result i32)
+                (i32.add (local.get $x) (i32.const 1))
+            )
+            ;; Only fails once something calls it
+            (func $broken (result i32)
+                (local.get $missing)
+            )
+            (func $main (result i32)
+                (call $cube (i32.const 3))
+            )
+        )
+    )");
+
+    Module mod = Parser::parseLazy(*code, code);
+    size_t deferred = 0;
+    for (const auto& f : mod.functions) {
+        if (f.body.empty() && !f.lazyBody.empty()) deferred++;
+    }
+    std::cout << "Deferred bodies: " << deferred << " of " << mod.functions.size() << std::endl;
+    std::cout << "Recorded: " << std::string(mod.functions[0].lazyBody) << std::endl;
+
+    // The serialized form carries full bodies
+    std::vector<uint8_t> bytes = ModuleWriter(mod).write();
+    Module roundTrip = ModuleReader(bytes.data(), bytes.size()).read();
+    std::cout << "Serialized body of cube: " << roundTrip.functions[1].body.size() << " instructions" << std::endl;
+
+    auto compiled = std::make_shared<const CompiledModule>(std::move(mod));
+    std::cout << "Compiled at load: " << compiled->lazyCompiledCount() << std::endl;
+
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+    std::cout << "main() = " << vm.run("main", {}).i32 << std::endl;
+    std::cout << "Compiled after main: " << compiled->lazyCompiledCount() << std::endl;
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        try {
+            vm.run("broken", {});
+            std::cout << "FAILED: expected error" << std::endl;
+        } catch (const std::runtime_error& e) {
+            std::cout << "Caught: " << e.what() << std::endl;
+        }
+    }
+
+    // Concurrent first calls compile the body exactly once
+    std::vector<std::thread> workers;
+    std::vector<int32_t> results(8);
+    for (int t = 0; t < 8; ++t) {
+        workers.emplace_back([&, t]() {
+            MemoryStore threadStore;
+            Interpreter threadVm(compiled, threadStore);
+            results[t] = threadVm.run("unused", {WasmValue(t)}).i32;
+        });
+    }
+    for (auto& w : workers) w.join();
+    bool ok = true;
+    for (int t = 0; t < 8; ++t) ok = ok && results[t] == t + 1;
+    std::cout << "Concurrent results: " << (ok ? "ok" : "wrong") << std::endl;
+    std::cout << "Compiled at end: " << compiled->lazyCompiledCount() << std::endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <functional>
+#include <iostream>
+#include <memory>
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "Linker.h"
+#include "MemoryStore.h"
+
+Module parse(const std::string& source) {
+    Lexer lexer(source);
+    return Parser(lexer).parse();
+}
+
+const char* mainSource = R"(
+    (module
+        (import "math" "square" (func $square (param i32) (result i32)))
+        (import "math" "cube" (func $cube (param i32) (result i32)))
+        (import "text" "greet" (func $greet (result i32)))
+        (import "env" "log" (func $log (param i32)))
+        (type $unary (func (param i32) (result i32)))
+        (table 2 funcref)
+        (elem (i32.const 0) $square $helper)
+        ;; Collides with the helper of both libraries
+        (func $helper (param $x i32) (result i32) (i32.add (local.get $x) (i32.const 1)))
+        (func $main (result i32)
+            (call $log (call $greet))
+            (i32.add
+                (call $square (i32.const 3))
+                (call_indirect (type $unary) (i32.const 4) (i32.const 1)))
+        )
+        (func $cubed (param $x i32) (result i32) (call $cube (local.get $x)))
+        (func $unused (result i32) (call $cube (i32.const 2)))
+        (export "cubed" (func $cubed))
+    )
+)";
+
+const char* mathSource = R"(
+    (module
+        (import "env" "log" (func $print (param i32)))
+        (type $binary (func (param i32 i32) (result i32)))
+        (global $calls (mut i32) (i32.const 0))
+        (global $spare i32 (i32.const 9))
+        (string $name "math")
+        (func $helper (param $x i32) (param $y i32) (result i32)
+            (global.set $calls (i32.add (global.get $calls) (i32.const 1)))
+            (i32.mul (local.get $x) (local.get $y))
+        )
+        (func $square (param $x i32) (result i32) (call $helper (local.get $x) (local.get $x)))
+        (func $cube (param $x i32) (result i32)
+            (call 1 (call $square (local.get $x)) (local.get $x))
+        )
+        (func $describe (result i32) (call $print (i32.const 0)) (string.const $name))
+    )
+)";
+
+// Imports from math too: one copy of it is linked in
+const char* textSource = R"(
+    (module
+        (import "math" "square" (func $sq (param i32) (result i32)))
+        (string $hello "hello")
+        (string $bye "bye")
+        (func $helper (result i32) (string.const $hello))
+        (func $greet (result i32) (i32.add (call $helper) (call $sq (i32.const 0))))
+        (func $farewell (result i32) (string.const $bye))
+    )
+)";
+
+void check(const std::string& what, const std::function<void()>& fn) {
+    try {
+        fn();
+        std::cout << what << ": linked" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << what << ": " << e.what() << std::endl;
+    }
+}
+
+int main() {
+    Linker linker;
+    linker.addLibrary("math", parse(mathSource));
+    linker.addLibrary("text", parse(textSource));
+    linker.addLibrary("unused", parse("(module (func $nothing))"));
+
+    Module linked = linker.link(parse(mainSource), {"main"});
+    const LinkStats& stats = linker.stats();
+    std::cout << "Modules: " << stats.modulesMerged << ", imports resolved: " << stats.importsResolved << std::endl;
+    std::cout << "Functions kept " << stats.functionsKept << ", dropped " << stats.functionsDropped << std::endl;
+    std::cout << "Dropped types " << stats.typesDropped << ", strings " << stats.stringsDropped << ", globals "
+              << stats.globalsDropped << ", imports " << stats.importsDropped << std::endl;
+    std::cout << "Functions:";
+    for (const auto& f : linked.functions) std::cout << " " << f.name;
+    std::cout << std::endl << "Imports:";
+    for (const auto& imp : linked.imports) std::cout << " " << imp.module << "." << imp.field << " as " << imp.alias;
+    std::cout << std::endl << "Strings:";
+    for (const auto& s : linked.strings) std::cout << " " << s.name << "=" << s.value;
+    std::cout << std::endl << "Globals:";
+    for (const auto& g : linked.globals) std::cout << " " << g.name;
+    std::cout << std::endl << "Table:";
+    for (const auto& name : linked.elements[0].functionNames) std::cout << " " << name;
+    std::cout << std::endl;
+
+    // One instance runs the whole program
+    auto compiled = std::make_shared<const CompiledModule>(std::move(linked));
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+    int logged = 0;
+    vm.registerHostFunction("env", "log", [&logged](std::vector<WasmValue>&) {
+        logged++;
+        return WasmValue();
+    }, {"i32"}, {});
+    std::cout << "main = " << vm.run("main", {}).i32 << std::endl;
+    std::cout << "cubed(3) = " << vm.run("cubed", {WasmValue(3)}).i32 << std::endl;
+    std::cout << "Host calls: " << logged << std::endl;
+
+    // Lazily parsed input: only reachable bodies get parsed
+    std::string lazySource = mainSource;
+    Module lazyMain = Parser::parseLazy(lazySource, nullptr);
+    Module lazyLinked = linker.link(lazyMain, {"main"});
+    std::cout << "Lazy input, functions kept: " << linker.stats().functionsKept << std::endl;
+
+    check("Signature mismatch", [&]() {
+        Linker l;
+        l.addLibrary("math", parse("(module (func $square (param i64) (result i32) (i32.const 0)))"));
+        l.link(parse("(module (import \"math\" \"square\" (func $sq (param i32) (result i32))))"));
+    });
+    check("Missing function", [&]() {
+        Linker l;
+        l.addLibrary("math", parse("(module)"));
+        l.link(parse("(module (import \"math\" \"square\" (func $sq (param i32) (result i32))))"));
+    });
+    check("Two tables", [&]() {
+        Linker l;
+        l.addLibrary("math", parse("(module (table 1 funcref) (func $f))"));
+        l.link(parse("(module (import \"math\" \"f\" (func $f)) (table 1 funcref))"));
+    });
+    check("Unknown entry point", [&]() { linker.link(parse(mainSource), {"start"}); });
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <iostream>
+#include <memory>
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+const char* source = R"(
+    (module
+        (import "env" "log" (func $log (param i32)))
+        ;; a * b and a + 4 do not change in the loop
+        (func $invariant (param $n i32) (param $a i32) (param $b i32) (result i32)
+            (local $i i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.ge_s (local.get $i) (i32.mul (local.get $n) (i32.const 2))))
+                    (local.set $acc (i32.add (local.get $acc)
+                        (i32.add (i32.mul (local.get $a) (local.get $b)) (i32.add (local.get $a) (i32.const 4)))))
+                    (local.set $acc (i32.xor (local.get $acc) (i32.mul (local.get $a) (local.get $b))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        ;; base + i * 4 is kept up to date as i steps
+        (func $addresses (param $n i32) (param $base i32) (result i32)
+            (local $i i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                    (local.set $acc (i32.add (local.get $acc) (i32.add (local.get $base) (i32.mul (local.get $i) (i32.const 4)))))
+                    (local.set $acc (i32.sub (local.get $acc)
+                        (i32.shr_u (i32.add (local.get $base) (i32.mul (local.get $i) (i32.const 4))) (i32.const 2))))
+                    (call $log (i32.add (local.get $base) (i32.mul (local.get $i) (i32.const 4))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 3)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        ;; w * h is invariant in both loops, y * w only in the inner one
+        (func $nested (param $w i32) (param $h i32) (result i32)
+            (local $x i32)
+            (local $y i32)
+            (local $acc i32)
+            (block $rows
+                (loop $row
+                    (br_if $rows (i32.ge_s (local.get $y) (local.get $h)))
+                    (local.set $x (i32.const 0))
+                    (block $cols
+                        (loop $col
+                            (br_if $cols (i32.ge_s (local.get $x) (local.get $w)))
+                            (local.set $acc (i32.add (local.get $acc)
+                                (i32.sub (i32.mul (local.get $w) (local.get $h))
+                                         (i32.add (i32.mul (local.get $y) (local.get $w)) (local.get $x)))))
+                            (local.set $x (i32.add (local.get $x) (i32.const 1)))
+                            (br $col)
+                        )
+                    )
+                    (local.set $y (i32.add (local.get $y) (i32.const 1)))
+                    (br $row)
+                )
+            )
+            (local.get $acc)
+        )
+        (func $scaled (param $n i32) (param $x f64) (result f64)
+            (local $i i32)
+            (local $sum f64)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                    (local.set $sum (f64.add (local.get $sum) (f64.mul (local.get $x) (f64.const 0.5))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $sum)
+        )
+        ;; The division would trap if it ran, so it stays where it is
+        (func $guarded (param $n i32) (param $d i32) (result i32)
+            (local $i i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                    (if (local.get $d)
+                        (then (local.set $acc (i32.add (local.get $acc) (i32.div_s (local.get $n) (local.get $d))))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        ;; i is written twice, so it is no induction variable
+        (func $twoSteps (param $n i32) (result i32)
+            (local $i i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                    (local.set $acc (i32.add (local.get $acc) (i32.add (i32.mul (local.get $i) (i32.const 8)) (i32.const 1))))
+                    (local.set $acc (i32.add (local.get $acc) (i32.add (i32.mul (local.get $i) (i32.const 8)) (i32.const 1))))
+                    (local.set $acc (i32.add (local.get $acc) (i32.add (i32.mul (local.get $i) (i32.const 8)) (i32.const 1))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                    (if (i32.eq (local.get $i) (i32.const 5)) (then (local.set $i (i32.const 6))))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+    )
+)";
+
+std::shared_ptr<const CompiledModule> load(OptimizerOptions options) {
+    Lexer lexer(source);
+    return std::make_shared<const CompiledModule>(Parser(lexer).parse(), options);
+}
+
+int main() {
+    auto optimized = load({});
+    auto plain = load(OptimizerOptions::none());
+
+    MemoryStore store, plainStore;
+    Interpreter vm(optimized, store), plainVm(plain, plainStore);
+    int64_t logged[2] = {0, 0};
+    for (int k = 0; k < 2; ++k) {
+        Interpreter* i = k == 0 ? &vm : &plainVm;
+        int64_t* sum = &logged[k];
+        i->registerHostFunction("env", "log", [sum](std::vector<WasmValue>& args) {
+            *sum += args[0].i32;
+            return WasmValue();
+        }, {"i32"}, {});
+    }
+
+    struct Call {
+        const char* name;
+        std::vector<WasmValue> args;
+    };
+    std::vector<Call> calls = {{"invariant", {WasmValue(10), WasmValue(6), WasmValue(7)}},
+                               {"addresses", {WasmValue(30), WasmValue(1000)}},
+                               {"nested", {WasmValue(7), WasmValue(5)}},
+                               {"scaled", {WasmValue(8), WasmValue(2.5)}},
+                               {"guarded", {WasmValue(9), WasmValue(0)}},
+                               {"guarded", {WasmValue(9), WasmValue(2)}},
+                               {"twoSteps", {WasmValue(10)}}};
+    for (const auto& call : calls) {
+        const CompiledFunction& cf = optimized->function(optimized->findFunction(call.name));
+        WasmValue a = vm.run(call.name, call.args);
+        WasmValue b = plainVm.run(call.name, call.args);
+        std::cout << call.name << " = " << (a.type == WasmValue::F64 ? a.f64 : a.i32) << ", "
+                  << (a.type == b.type && a.i64 == b.i64 ? "same" : "DIFFERENT") << " result, hoisted "
+                  << cf.optimizerStats.invariantsHoisted << ", reduced " << cf.optimizerStats.strengthReduced
+                  << ", extra locals " << cf.extraLocals.size() << ", "
+                  << (cf.validated ? "validated" : "not validated") << std::endl;
+    }
+    std::cout << "log sums: " << logged[0] << " and " << logged[1] << std::endl;
+
+    OptimizerStats all = optimized->optimizerStats();
+    std::cout << "Module: hoisted " << all.invariantsHoisted << ", reduced " << all.strengthReduced
+              << ", revalidation failures " << all.revalidationFailures << std::endl;
+    if (all.revalidationFailures != 0) return 1;
+
+    // Each loop pass can be turned off on its own
+    OptimizerOptions noMotion, noReduction;
+    noMotion.loopInvariantMotion = false;
+    noReduction.strengthReduction = false;
+    OptimizerStats a = load(noMotion)->optimizerStats();
+    OptimizerStats b = load(noReduction)->optimizerStats();
+    std::cout << "No motion: hoisted " << a.invariantsHoisted << ", reduced " << a.strengthReduced << std::endl;
+    std::cout << "No reduction: hoisted " << b.invariantsHoisted << ", reduced " << b.strengthReduced << std::endl;
+    return 0;
+}
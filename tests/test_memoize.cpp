@@ -0,0 +1,125 @@
+#include <iostream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "PurityAnalysis.h"
+
+int main() {
+    std::string code = R"(
+        (module
+            (import "env" "log" (func $log (param i32)))
+            (global $limit i32 (i32.const 100))
+            (global $counter (mut i32) (i32.const 0))
+            (type $unary (func (param i32) (result i32)))
+            (table 1 funcref)
+            (elem (i32.const 0) $fib)
+
+            (func $fib (param $n i32) (result i32)
+                (if (i32.lt_s (local.get $n) (i32.const 2))
+                    (then (return (local.get $n))))
+                (i32.add
+                    (call $fib (i32.sub (local.get $n) (i32.const 1)))
+                    (call $fib (i32.sub (local.get $n) (i32.const 2))))
+            )
+            (func $clamp (param $x i32) (result i32)
+                (if (i32.gt_s (local.get $x) (global.get $limit))
+                    (then (return (global.get $limit))))
+                (local.get $x)
+            )
+            (func $scale (param $x f64) (param $k i64) (result f64)
+                (f64.mul (local.get $x) (local.get $x))
+            )
+            (func $mutates (param $x i32) (result i32)
+                ;; Overwrites its parameter; the cache key must be the original
+                (local.set $x (i32.add (local.get $x) (i32.const 1)))
+                (local.get $x)
+            )
+            (func $logs (param $x i32) (result i32) (call $log (local.get $x)) (local.get $x))
+            (func $counts (result i32)
+                (global.set $counter (i32.add (global.get $counter) (i32.const 1)))
+                (global.get $counter)
+            )
+            (func $usesLogs (param $x i32) (result i32) (call $logs (local.get $x)))
+            (func $indirect (param $x i32) (result i32) (call_indirect (type $unary) (local.get $x) (i32.const 0)))
+            (func $div (param $a i32) (param $b i32) (result i32) (i32.div_s (local.get $a) (local.get $b)))
+        )
+    )";
+
+    Lexer lexer(code);
+    // Calls stay calls, so impurity is reported through the callee
+    OptimizerOptions options;
+    options.inlining = false;
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse(), options);
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+    int logged = 0;
+    vm.registerHostFunction("env", "log", [&logged](std::vector<WasmValue>&) {
+        logged++;
+        return WasmValue();
+    }, {"i32"}, {});
+
+    PurityAnalysis purity(*compiled);
+    const char* names[] = {"fib", "clamp", "scale", "mutates", "logs", "counts", "usesLogs", "indirect", "div"};
+    for (size_t f = 0; f < compiled->functionCount(); ++f) {
+        std::cout << names[f] << ": " << (purity.isPure(f) ? "pure" : "impure (" + purity.reason(f) + ")")
+                  << std::endl;
+    }
+    std::cout << "Pure functions: " << purity.pureCount() << std::endl;
+
+    vm.setMemoization(purity, 256);
+
+    // Each fib(k) runs once; every other call is a hit
+    std::cout << "fib(40) = " << vm.run("fib", {WasmValue(40)}).i32 << std::endl;
+    Interpreter::MemoStats fib = vm.memoStats(0);
+    std::cout << "fib hits=" << fib.hits << " misses=" << fib.misses << std::endl;
+    std::cout << "fib(40) again = " << vm.run("fib", {WasmValue(40)}).i32 << std::endl;
+    std::cout << "fib hits=" << vm.memoStats(0).hits << " misses=" << vm.memoStats(0).misses << std::endl;
+
+    std::cout << "clamp(500) = " << vm.run("clamp", {WasmValue(500)}).i32 << ", clamp(5) = "
+              << vm.run("clamp", {WasmValue(5)}).i32 << ", clamp(500) = " << vm.run("clamp", {WasmValue(500)}).i32
+              << std::endl;
+    std::cout << "scale(1.5, 7) = " << vm.run("scale", {WasmValue(1.5), WasmValue((int64_t)7)}).f64
+              << ", scale(1.5, 8) = " << vm.run("scale", {WasmValue(1.5), WasmValue((int64_t)8)}).f64 << std::endl;
+    std::cout << "scale hits=" << vm.memoStats(2).hits << " misses=" << vm.memoStats(2).misses << std::endl;
+    std::cout << "mutates(1) = " << vm.run("mutates", {WasmValue(1)}).i32 << ", mutates(2) = "
+              << vm.run("mutates", {WasmValue(2)}).i32 << ", mutates(1) = " << vm.run("mutates", {WasmValue(1)}).i32
+              << std::endl;
+
+    // Impure functions always run
+    vm.run("logs", {WasmValue(1)});
+    vm.run("logs", {WasmValue(1)});
+    std::cout << "log calls: " << logged << ", logs hits: " << vm.memoStats(4).hits << std::endl;
+    vm.run("counts", {});
+    std::cout << "counts() = " << vm.run("counts", {}).i32 << std::endl;
+
+    // Traps are not cached
+    for (int i = 0; i < 2; ++i) {
+        try {
+            vm.run("div", {WasmValue(1), WasmValue(0)});
+        } catch (const std::exception& e) {
+            std::cout << "Caught: " << e.what() << std::endl;
+        }
+    }
+    std::cout << "div(7, 2) = " << vm.run("div", {WasmValue(7), WasmValue(2)}).i32 << ", div hits: "
+              << vm.memoStats(8).hits << std::endl;
+
+    // A tiny cache still gives correct results, just fewer hits
+    MemoryStore smallStore;
+    Interpreter small(compiled, smallStore);
+    small.setMemoization(purity, 2);
+    std::cout << "fib(25) with 2 entries = " << small.run("fib", {WasmValue(25)}).i32 << std::endl;
+
+    vm.setMemoization(purity, 0);
+    std::cout << "Off: fib(20) = " << vm.run("fib", {WasmValue(20)}).i32 << ", fib hits=" << vm.memoStats(0).hits
+              << std::endl;
+
+    Lexer otherLexer("(module (func $f (result i32) (i32.const 1)))");
+    auto other = std::make_shared<const CompiledModule>(Parser(otherLexer).parse());
+    PurityAnalysis otherPurity(*other);
+    try {
+        vm.setMemoization(otherPurity);
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    return 0;
+}
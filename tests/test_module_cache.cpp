@@ -0,0 +1,119 @@
+#include <iostream>
+#include <filesystem>
+#include <unistd.h>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "ModuleCache.h"
+#include "ModuleSerializer.h"
+
+namespace fs = std::filesystem;
+
+WasmValue host_read_i32(MemoryStore* store, std::vector<WasmValue>& args) {
+    return WasmValue(store->read<int32_t>(args[0].i32, args[1].i32));
+}
+
+int32_t runMain(const Module& mod) {
+    MemoryStore store;
+    Interpreter vm(std::make_shared<const CompiledModule>(mod), store);
+    using namespace std::placeholders;
+    vm.registerHostFunction("env", "read_i32", std::bind(host_read_i32, &store, _1), {"i32", "i32"}, {"i32"});
+    return vm.run("main", {}).i32;
+}
+
+int main() {
+    // Exercises every Module section
+    std::string code = R"(
+        (module
+            (import "env" "read_i32" (func $read_i32 (param i32 i32) (result i32)))
+            (type $bin_t (func (param i32 i32) (result i32)))
+            (table 2 funcref)
+            (elem (i32.const 0) $add $sub)
+            (global $bias (mut i32) (i32.const -7))
+            (global $scale f64 (f64.const 2.5))
+            (string $word "cache")
+
+            (func $add (param $a i32) (param $b i32) (result i32)
+                (i32.add (local.get $a) (local.get $b))
+            )
+            (func $sub (param $a i32) (param $b i32) (result i32)
+                (i32.sub (local.get $a) (local.get $b))
+            )
+            (func $main (result i32)
+                (local $i i32)
+                (block $done
+                    (loop $again
+                        (br_if $done (i32.ge_s (local.get $i) (i32.const 3)))
+                        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                        (br $again)
+                    )
+                )
+                (i32.add
+                    (call_indirect (type $bin_t) (global.get $bias) (local.get $i) (i32.const 1))
+                    (call $read_i32 (string.const $word) (i32.const 0)))
+            )
+        )
+    )";
+
+    try {
+        // 1. Round trip through the binary format
+        Lexer lexer(code);
+        Module parsed = Parser(lexer.tokenize()).parse();
+        std::vector<uint8_t> bytes = ModuleWriter(parsed).write();
+        Module decoded = ModuleReader(bytes.data(), bytes.size()).read();
+        bool stable = ModuleWriter(decoded).write() == bytes;
+        std::cout << "Round trip stable: " << (stable ? "yes" : "no") << std::endl;
+        std::cout << "Parsed result: " << runMain(parsed) << std::endl;
+        std::cout << "Decoded result: " << runMain(decoded) << std::endl;
+
+        // 2. Corrupt input is rejected
+        try {
+            std::vector<uint8_t> truncated(bytes.begin(), bytes.begin() + bytes.size() / 2);
+            ModuleReader(truncated.data(), truncated.size()).read();
+            std::cerr << "FAILED: truncated module accepted" << std::endl;
+            return 1;
+        } catch (const std::runtime_error& e) {
+            std::cout << "Caught truncated module" << std::endl;
+        }
+
+        // 3. Cold then warm load through the on-disk cache
+        fs::path dir = fs::temp_directory_path() / ("optrich_cache_test_" + std::to_string(getpid()));
+        fs::remove_all(dir);
+        {
+            ModuleCache cache(dir.string());
+            Module cold = cache.load(code);
+            Module warm = cache.load(code);
+            std::cout << "Cache hits: " << cache.hits() << ", misses: " << cache.misses() << std::endl;
+            std::cout << "Warm result: " << runMain(warm) << std::endl;
+            (void)cold;
+
+            // A second cache over the same directory starts warm
+            ModuleCache reopened(dir.string());
+            reopened.load(code);
+            std::cout << "Reopened hits: " << reopened.hits() << std::endl;
+
+            // Changed source gets a different entry
+            std::string edited = code + " ";
+            reopened.load(edited);
+            std::cout << "Edited misses: " << reopened.misses() << std::endl;
+
+            // 4. An entry written for other source under this file name (as
+            // on a hash collision) is a miss and gets replaced
+            std::string other = "(module (func $main (result i32) (i32.const 42)))";
+            std::string otherPath = reopened.entryPath(ModuleCache::contentHash(other.data(), other.size()));
+            fs::copy_file(reopened.entryPath(ModuleCache::contentHash(code.data(), code.size())), otherPath,
+                          fs::copy_options::overwrite_existing);
+            ModuleCache collided(dir.string());
+            Module loaded = collided.load(other);
+            std::cout << "Collided entry misses: " << collided.misses() << ", result: " << runMain(loaded)
+                      << std::endl;
+            collided.load(other);
+            std::cout << "Replaced entry hits: " << collided.hits() << std::endl;
+        }
+        fs::remove_all(dir);
+
+    } catch (const std::exception& e) {
+        std::cerr << "Runtime Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
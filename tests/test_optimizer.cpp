@@ -0,0 +1,142 @@
+#include <iostream>
+#include <memory>
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+const char* source = R"(
+    (module
+        (import "env" "log" (func $log (param i32)))
+        (func $identity (param $x i32) (result i32)
+            (i32.mul (i32.add (local.get $x) (i32.const 0)) (i32.const 1))
+        )
+        (func $constant (result i32)
+            (i32.mul (i32.add (i32.const 2) (i32.const 3)) (i32.sub (i32.const 10) (i32.eqz (i32.const 0))))
+        )
+        (func $half (result f64) (f64.div (f64.const 7) (f64.const 2)))
+        (func $choose (param $x i32) (result i32)
+            (if (i32.gt_s (i32.const 3) (i32.const 1))
+                (then (local.set $x (i32.add (local.get $x) (i32.const 100))))
+                (else (call $log (local.get $x))))
+            (if (i32.const 0)
+                (then (call $log (local.get $x))))
+            (local.get $x)
+        )
+        (func $copies (param $a i32) (result i32)
+            (local $b i32)
+            (local $c i32)
+            (local.set $b (local.get $a))
+            (local.set $c (i32.const 5))
+            (i32.add (local.get $b) (local.get $c))
+        )
+        (func $overwritten (param $x i32) (result i32)
+            (local $t i32)
+            (local.set $t (i32.const 9))
+            (local.set $t (i32.mul (local.get $x) (local.get $x)))
+            (local.get $t)
+        )
+        (func $early (param $x i32) (result i32)
+            (block $out
+                (br $out)
+                (call $log (local.get $x))
+            )
+            (return (local.get $x))
+            (call $log (i32.const 1))
+            (i32.const 0)
+        )
+        (func $sum (param $n i32) (result i32)
+            (local $i i32)
+            (local $acc i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                    (br_if $done (i32.const 0))
+                    (local.set $acc (i32.add (local.get $acc) (i32.shl (local.get $i) (i32.const 0))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                    (br $next)
+                )
+            )
+            (local.get $acc)
+        )
+        (func $trap (result i32) (i32.div_s (i32.const 1) (i32.const 0)))
+    )
+)";
+
+std::shared_ptr<const CompiledModule> load(OptimizerOptions options) {
+    Lexer lexer(source);
+    return std::make_shared<const CompiledModule>(Parser(lexer).parse(), options);
+}
+
+void printStats(const std::string& label, const OptimizerStats& s) {
+    std::cout << label << ": folded " << s.constantsFolded << ", copies " << s.copiesPropagated << ", dead stores "
+              << s.deadStores << ", unreachable " << s.unreachableRemoved << ", instructions "
+              << s.instructionsBefore << " -> " << s.instructionsAfter << std::endl;
+}
+
+int main() {
+    auto optimized = load({});
+    auto plain = load(OptimizerOptions::none());
+
+    MemoryStore store, plainStore;
+    Interpreter vm(optimized, store), plainVm(plain, plainStore);
+    int logged = 0;
+    for (Interpreter* i : {&vm, &plainVm}) {
+        i->registerHostFunction("env", "log", [&logged](std::vector<WasmValue>&) {
+            logged++;
+            return WasmValue();
+        }, {"i32"}, {});
+    }
+
+    struct Call {
+        const char* name;
+        std::vector<WasmValue> args;
+    };
+    std::vector<Call> calls = {{"identity", {WasmValue(42)}}, {"constant", {}}, {"half", {}},
+                               {"choose", {WasmValue(1)}}, {"copies", {WasmValue(37)}},
+                               {"overwritten", {WasmValue(6)}}, {"early", {WasmValue(8)}},
+                               {"sum", {WasmValue(100)}}};
+    for (const auto& call : calls) {
+        const CompiledFunction& cf = optimized->function(optimized->findFunction(call.name));
+        const CompiledFunction& before = plain->function(plain->findFunction(call.name));
+        WasmValue a = vm.run(call.name, call.args);
+        WasmValue b = plainVm.run(call.name, call.args);
+        std::cout << call.name << " = " << (a.type == WasmValue::F64 ? a.f64 : a.i32) << ", "
+                  << before.code.size() << " -> " << cf.code.size() << " instructions, "
+                  << (a.type == b.type && a.i64 == b.i64 ? "same" : "DIFFERENT") << " result, "
+                  << (cf.validated ? "validated" : "not validated") << std::endl;
+    }
+    std::cout << "log calls: " << logged << std::endl;
+    printStats("sum", optimized->function(optimized->findFunction("sum")).optimizerStats);
+
+    // Operations that trap are left alone
+    try {
+        vm.run("trap", {});
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    printStats("All passes", optimized->optimizerStats());
+    printStats("None", plain->optimizerStats());
+    std::cout << "Revalidation failures: " << optimized->optimizerStats().revalidationFailures << std::endl;
+    if (optimized->optimizerStats().revalidationFailures != 0) return 1;
+
+    // Each pass can be turned off on its own
+    OptimizerOptions noFolding, noCopies, noDeadStores, noUnreachable;
+    noFolding.constantFolding = false;
+    noCopies.copyPropagation = false;
+    noDeadStores.deadStoreElimination = false;
+    noUnreachable.unreachableCode = false;
+    printStats("No folding", load(noFolding)->optimizerStats());
+    printStats("No copy propagation", load(noCopies)->optimizerStats());
+    printStats("No dead stores", load(noDeadStores)->optimizerStats());
+    printStats("No unreachable", load(noUnreachable)->optimizerStats());
+
+    // Lazily recorded bodies are optimized when first compiled
+    auto text = std::make_shared<const std::string>(source);
+    CompiledModule lazy(Parser::parseLazy(*text, text));
+    printStats("Lazy before use", lazy.optimizerStats());
+    lazy.function(lazy.findFunction("constant"));
+    printStats("Lazy after constant()", lazy.optimizerStats());
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "ThreadPool.h"
+
+// Builds a module with many small functions interleaved with other fields.
+std::string buildModule(int numFuncs) {
+    std::ostringstream out;
+    out << "(module\n";
+    out << "  (type $unary (func (param i32) (result i32)))\n";
+    out << "  (string $label \"paren ( in \\\"string\\\"\")\n";
+    for (int i = 0; i < numFuncs; ++i) {
+        out << "  ;; function " << i << " (with a stray paren in a comment\n";
+        out << "  (func $f" << i << " (param $x i32) (result i32)\n";
+        out << "    (i32.add (local.get $x) (i32.const " << i << ")))\n";
+        if (i % 50 == 0) out << "  (global $g" << i << " i32 (i32.const " << i << "))\n";
+    }
+    out << "  (table 2 funcref)\n";
+    out << "  (elem (i32.const 0) $f1 $f2)\n";
+    out << "  (func $main (result i32)\n";
+    out << "    (call_indirect (type $unary) (call $f" << numFuncs - 1 << " (i32.const 1)) (i32.const 1)))\n";
+    out << "  (export \"entry\" (func $main))\n";
+    out << ")\n";
+    return out.str();
+}
+
+bool sameModule(const Module& a, const Module& b) {
+    if (a.functions.size() != b.functions.size() || a.globals.size() != b.globals.size() ||
+        a.strings.size() != b.strings.size() || a.exports.size() != b.exports.size() ||
+        a.elements.size() != b.elements.size() || a.types.size() != b.types.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.functions.size(); ++i) {
+        const Function& fa = a.functions[i];
+        const Function& fb = b.functions[i];
+        if (fa.name != fb.name || fa.paramTypes != fb.paramTypes || fa.body.size() != fb.body.size()) return false;
+        for (size_t j = 0; j < fa.body.size(); ++j) {
+            if (fa.body[j].opcode != fb.body[j].opcode || fa.body[j].operand != fb.body[j].operand) return false;
+        }
+    }
+    return a.strings[0].value == b.strings[0].value;
+}
+
+int main() {
+    const int numFuncs = 1000;
+    std::string code = buildModule(numFuncs);
+
+    Lexer lexer(code);
+    Module sequential = Parser(lexer).parse();
+
+    ThreadPool pool(4);
+    Module parallel = Parser::parseParallel(code, pool);
+
+    std::cout << "Functions: " << parallel.functions.size() << std::endl;
+    std::cout << "Globals: " << parallel.globals.size() << std::endl;
+    std::cout << "Matches sequential: " << (sameModule(sequential, parallel) ? "yes" : "no") << std::endl;
+
+    MemoryStore store;
+    Interpreter vm(parallel, store);
+    // f999(1) = 1000, then table slot 1 ($f2): 1000 + 2
+    std::cout << "entry() = " << vm.run("entry", {}).i32 << std::endl;
+
+    // A parse error inside a worker surfaces on the calling thread
+    try {
+        Parser::parseParallel("(module (func $ok (result i32) (i32.const 1)) (func $bad (param i32) 7))", pool);
+        std::cout << "FAILED: expected parse error" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    // Errors raised while other chunks are still being parsed: a malformed
+    // field parsed on the calling thread, and a bad body in a middle chunk
+    std::string badTable = buildModule(20000);
+    badTable.insert(badTable.rfind("  (table"), "  (table oops funcref)\n");
+    try {
+        Parser::parseParallel(badTable, pool);
+        std::cout << "FAILED: expected table error" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    std::string badBody = buildModule(20000);
+    size_t middle = badBody.find("(func $f10000 ");
+    badBody.insert(badBody.find("(i32.add", middle), "7 ");
+    try {
+        Parser::parseParallel(badBody, pool);
+        std::cout << "FAILED: expected body error" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    // The pool is still usable afterwards
+    std::cout << "Functions after errors: " << Parser::parseParallel(code, pool).functions.size() << std::endl;
+
+    try {
+        Parser::parseParallel("(module (func $open (result i32)", pool);
+        std::cout << "FAILED: expected scan error" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <sstream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "Profiler.h"
+
+int main() {
+    std::string code = R"(
+        (module
+            (import "env" "tick" (func $tick (param i32)))
+            (func $fib (param $n i32) (result i32)
+                (if (i32.lt_s (local.get $n) (i32.const 2))
+                    (then (return (local.get $n))))
+                (i32.add
+                    (call $fib (i32.sub (local.get $n) (i32.const 1)))
+                    (call $fib (i32.sub (local.get $n) (i32.const 2))))
+            )
+            (func $main (result i32)
+                (call $tick (i32.const 1))
+                (call $fib (i32.const 10))
+            )
+            (func $trap (unreachable))
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+    vm.registerHostFunction("env", "tick", [](std::vector<WasmValue>&) { return WasmValue(); }, {"i32"}, {});
+
+    Profiler profiler(compiled);
+    vm.setProfiler(&profiler);
+    std::cout << "main() = " << vm.run("main", {}).i32 << std::endl;
+    try {
+        vm.run("trap", {});
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    std::cout << "Open activations after trap: " << profiler.depth() << std::endl;
+
+    std::cout << "i32.add executed: " << profiler.opcodeCount(Opcode::I32_ADD) << std::endl;
+    std::cout << "call executed: " << profiler.opcodeCount(Opcode::CALL) << std::endl;
+    const char* names[] = {"fib", "main", "trap"};
+    for (int i = 0; i < 3; ++i) {
+        const Profiler::FunctionStats& f = profiler.function(i);
+        std::cout << names[i] << ": calls=" << f.calls
+                  << " inclusive>=exclusive=" << (f.inclusiveNanos >= f.exclusiveNanos ? "yes" : "no") << std::endl;
+    }
+    std::cout << "env.tick: calls=" << profiler.import(0).calls << std::endl;
+
+    // Folded stacks without their (timing dependent) values
+    std::stringstream folded;
+    profiler.writeFolded(folded);
+    std::string line;
+    int stacks = 0;
+    while (std::getline(folded, line)) {
+        if (stacks++ < 4) std::cout << "folded: " << line.substr(0, line.rfind(' ')) << std::endl;
+    }
+    std::cout << "folded stacks: " << stacks << std::endl;
+
+    std::stringstream json;
+    profiler.writeJson(json);
+    std::cout << "json has fib: " << (json.str().find("{\"name\": \"fib\", \"calls\": 177") != std::string::npos ? "yes" : "no")
+              << std::endl;
+    std::cout << "json has env.tick: " << (json.str().find("\"env.tick\"") != std::string::npos ? "yes" : "no")
+              << std::endl;
+
+    vm.setProfiler(nullptr);
+    vm.run("main", {});
+    std::cout << "Detached, fib calls still: " << profiler.function(0).calls << std::endl;
+    return 0;
+}
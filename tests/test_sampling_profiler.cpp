@@ -0,0 +1,80 @@
+#include <iostream>
+#include <sstream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "SamplingProfiler.h"
+
+int main() {
+    std::string code = R"(
+        (module
+            (func $spin (param $n i32) (result i32)
+                (local $i i32)
+                (local $acc i32)
+                (block $done
+                    (loop $next
+                        (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                        (local.set $acc (i32.xor (i32.mul (local.get $acc) (i32.const 31)) (local.get $i)))
+                        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                        (br $next)
+                    )
+                )
+                (local.get $acc)
+            )
+            (func $main (param $n i32) (result i32)
+                (call $spin (local.get $n))
+            )
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+
+    SamplingProfiler sampler(compiled, std::chrono::microseconds(500));
+    vm.setSampler(&sampler);
+    sampler.start();
+
+    SamplingProfiler other(compiled);
+    try {
+        other.start();
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    // Run until enough CPU time has been sampled; the timer counts CPU time
+    int32_t result = 0;
+    for (int round = 0; round < 200; ++round) {
+        result = vm.run("main", {WasmValue(200000)}).i32;
+        if (sampler.guestSamples() >= 50) break;
+    }
+    sampler.stop();
+    std::cout << "main(200000) = " << result << std::endl;
+
+    uint64_t samples = sampler.guestSamples();
+    std::cout << "Enough samples: " << (samples >= 50 ? "yes" : "no") << std::endl;
+
+    std::vector<SamplingProfiler::HotSpot> spots = sampler.hotSpots();
+    const CompiledFunction& spin = compiled->function(0);
+    bool hotInSpin = !spots.empty() && spots[0].func == 0;
+    // The innermost pc is the last taken branch target: the loop head or the exit
+    bool atLoopHead = hotInSpin && spin.code[spots[0].pc - 1].opcode == Opcode::LOOP;
+    std::cout << "Hottest function: " << (hotInSpin ? "spin" : "other") << std::endl;
+    std::cout << "Hottest pc is the loop head: " << (atLoopHead ? "yes" : "no") << std::endl;
+
+    std::stringstream folded;
+    sampler.writeFolded(folded);
+    std::string line;
+    uint64_t mainSpin = 0;
+    while (std::getline(folded, line)) {
+        if (line.rfind("main;spin ", 0) == 0) mainSpin += std::stoull(line.substr(10));
+    }
+    std::cout << "Folded main;spin share over 90%: " << (mainSpin * 10 >= samples * 9 ? "yes" : "no") << std::endl;
+
+    // After stop, the second sampler can take over the process timer
+    other.start();
+    other.stop();
+    std::cout << "Restarted: yes" << std::endl;
+    return 0;
+}
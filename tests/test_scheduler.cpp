@@ -0,0 +1,139 @@
+#include <deque>
+#include <iostream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "Scheduler.h"
+
+// One guest session: an instance with its own memory.
+struct Session {
+    MemoryStore store;
+    std::unique_ptr<Interpreter> vm;
+};
+
+int main() {
+    std::string code = R"(
+        (module
+            (import "env" "fetch" (func $fetch (param i32) (result i32)))
+            (func $sum (param $n i32) (result i32)
+                (local $i i32)
+                (local $acc i32)
+                (block $done
+                    (loop $next
+                        (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                        (local.set $acc (i32.add (local.get $acc) (local.get $i)))
+                        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                        (br $next)
+                    )
+                )
+                (local.get $acc)
+            )
+            (func $fetchTwice (param $key i32) (result i32)
+                (i32.add (call $fetch (local.get $key))
+                         (call $fetch (i32.add (local.get $key) (i32.const 1))))
+            )
+            (func $trap (result i32) (unreachable))
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+
+    // An I/O thread answers fetch(key) with key * 10; even keys are answered
+    // inline, before the host function has returned pending()
+    std::mutex ioMtx;
+    std::condition_variable ioCv;
+    std::deque<std::pair<std::shared_ptr<Scheduler::Task>, int32_t>> ioQueue;
+    bool ioStopping = false;
+    std::thread io([&]() {
+        std::unique_lock<std::mutex> lock(ioMtx);
+        while (true) {
+            ioCv.wait(lock, [&]() { return ioStopping || !ioQueue.empty(); });
+            if (ioQueue.empty()) return;
+            auto request = ioQueue.front();
+            ioQueue.pop_front();
+            lock.unlock();
+            request.first->complete(WasmValue(request.second * 10));
+            lock.lock();
+        }
+    });
+
+    const int sessions = 2000;
+    std::vector<std::unique_ptr<Session>> pool;
+    for (int i = 0; i < sessions; ++i) {
+        auto session = std::make_unique<Session>();
+        session->vm = std::make_unique<Interpreter>(compiled, session->store);
+        session->vm->registerHostFunction("env", "fetch", [&](std::vector<WasmValue>& args) {
+            std::shared_ptr<Scheduler::Task> task = Scheduler::currentTask();
+            int32_t key = args[0].i32;
+            if (key % 2 == 0) {
+                task->complete(WasmValue(key * 10));
+            } else {
+                std::lock_guard<std::mutex> lock(ioMtx);
+                ioQueue.emplace_back(task, key);
+                ioCv.notify_one();
+            }
+            return WasmValue::pending();
+        }, {"i32"}, {"i32"});
+        pool.push_back(std::move(session));
+    }
+
+    std::cout << "Outside a worker, current task is null: " << (Scheduler::currentTask() ? "no" : "yes")
+              << std::endl;
+
+    {
+        // Small slices, so every loop below yields several times
+        Scheduler scheduler(4, 200);
+        std::cout << "Workers: " << scheduler.size() << std::endl;
+
+        std::vector<std::future<WasmValue>> results;
+        for (int i = 0; i < sessions; ++i) {
+            if (i % 2 == 0) {
+                results.push_back(scheduler.spawn(*pool[i]->vm, "sum", {WasmValue(i % 500)}));
+            } else {
+                results.push_back(scheduler.spawn(*pool[i]->vm, "fetchTwice", {WasmValue(i)}));
+            }
+        }
+        bool allCorrect = true;
+        for (int i = 0; i < sessions; ++i) {
+            int32_t expected = i % 2 == 0 ? (i % 500) * (i % 500 - 1) / 2 : i * 10 + (i + 1) * 10;
+            allCorrect = allCorrect && results[i].get().i32 == expected;
+        }
+        std::cout << "All " << sessions << " results correct: " << (allCorrect ? "yes" : "no") << std::endl;
+        std::cout << "Slices yielded: " << (scheduler.yieldCount() > 0 ? "yes" : "no") << std::endl;
+        std::cout << "Host calls parked: " << scheduler.parkCount() << std::endl;
+
+        // Sessions are reusable once their future is ready
+        std::future<WasmValue> again = scheduler.spawn(*pool[0]->vm, "sum", {WasmValue(10)});
+        std::cout << "Reused session: sum(10) = " << again.get().i32 << std::endl;
+
+        std::future<WasmValue> trapped = scheduler.spawn(*pool[1]->vm, "trap", {});
+        try {
+            trapped.get();
+        } catch (const std::exception& e) {
+            std::cout << "Caught: " << e.what() << std::endl;
+        }
+        std::future<WasmValue> missing = scheduler.spawn(*pool[1]->vm, "nope", {});
+        try {
+            missing.get();
+        } catch (const std::exception& e) {
+            std::cout << "Caught: " << e.what() << std::endl;
+        }
+    }
+
+    {
+        // Unmetered: tasks run to completion in one slice
+        Scheduler scheduler(2, 0);
+        std::future<WasmValue> big = scheduler.spawn(*pool[2]->vm, "sum", {WasmValue(100000)});
+        std::cout << "Unmetered sum(100000) = " << big.get().i32 << ", yields: " << scheduler.yieldCount()
+                  << std::endl;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ioMtx);
+        ioStopping = true;
+    }
+    ioCv.notify_one();
+    io.join();
+    return 0;
+}
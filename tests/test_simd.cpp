@@ -0,0 +1,164 @@
+#include <iostream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "Simd.h"
+
+// Every dispatched kernel must agree bit for bit with its portable loop.
+bool kernelsMatchPortable() {
+    V128 a = simd::splat<int32_t>(0);
+    V128 b = simd::splat<int32_t>(0);
+    const int32_t ai[4] = {7, -3, INT32_MIN, 42};
+    const int32_t bi[4] = {7, 5, 1, -42};
+    std::memcpy(a.bytes, ai, 16);
+    std::memcpy(b.bytes, bi, 16);
+    V128 fa = simd::splat<float>(0);
+    V128 fb = simd::splat<float>(0);
+    const float af[4] = {1.5f, -2.0f, 9.0f, -0.0f};
+    const float bf[4] = {1.5f, 3.0f, -9.0f, 0.0f};
+    std::memcpy(fa.bytes, af, 16);
+    std::memcpy(fb.bytes, bf, 16);
+    V128 da = simd::splat<double>(0);
+    V128 db = simd::splat<double>(0);
+    const double ad[2] = {16.0, -1.25};
+    const double bd[2] = {-4.0, -1.25};
+    std::memcpy(da.bytes, ad, 16);
+    std::memcpy(db.bytes, bd, 16);
+
+    bool ok = true;
+    auto same = [&](V128 x, V128 y) { ok = ok && x == y; };
+    same(simd::v128Not(a), simd::portable::v128Not(a));
+    same(simd::v128AndNot(a, b), simd::portable::v128AndNot(a, b));
+    same(simd::i32x4Mul(a, b), simd::portable::i32x4Mul(a, b));
+    same(simd::i32x4Neg(a), simd::portable::i32x4Neg(a));
+    same(simd::i32x4MinS(a, b), simd::portable::i32x4MinS(a, b));
+    same(simd::i32x4MaxS(a, b), simd::portable::i32x4MaxS(a, b));
+    same(simd::i32x4Ne(a, b), simd::portable::i32x4Ne(a, b));
+    same(simd::i32x4LtU(a, b), simd::portable::i32x4LtU(a, b));
+    same(simd::i32x4GtU(a, b), simd::portable::i32x4GtU(a, b));
+    same(simd::i32x4LeS(a, b), simd::portable::i32x4LeS(a, b));
+    same(simd::i32x4GeS(a, b), simd::portable::i32x4GeS(a, b));
+    same(simd::f32x4Div(fa, fb), simd::portable::f32x4Div(fa, fb));
+    same(simd::f32x4Neg(fa), simd::portable::f32x4Neg(fa));
+    same(simd::f32x4Abs(fa), simd::portable::f32x4Abs(fa));
+    same(simd::f32x4Le(fa, fb), simd::portable::f32x4Le(fa, fb));
+    same(simd::f32x4Ne(fa, fb), simd::portable::f32x4Ne(fa, fb));
+    same(simd::f64x2Sqrt(da), simd::portable::f64x2Sqrt(da));
+    same(simd::f64x2Abs(da), simd::portable::f64x2Abs(da));
+    same(simd::f64x2Ge(da, db), simd::portable::f64x2Ge(da, db));
+    return ok;
+}
+
+int main() {
+    std::string code = R"(
+        (module
+            ;; Sum of x[i] * y[i] over n elements, n a multiple of 4
+            (func $dot (param $x i32) (param $y i32) (param $n i32) (result i32)
+                (local $acc v128)
+                (local $i i32)
+                (block $done
+                    (loop $next
+                        (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                        (local.set $acc (i32x4.add (local.get $acc)
+                            (i32x4.mul
+                                (v128.load (local.get $x) (i32.mul (local.get $i) (i32.const 4)))
+                                (v128.load (local.get $y) (i32.mul (local.get $i) (i32.const 4))))))
+                        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+                        (br $next)
+                    )
+                )
+                (call $hsum (local.get $acc))
+            )
+            (func $hsum (param $v v128) (result i32)
+                (i32.add
+                    (i32.add (i32x4.extract_lane 0 (local.get $v)) (i32x4.extract_lane 1 (local.get $v)))
+                    (i32.add (i32x4.extract_lane 2 (local.get $v)) (i32x4.extract_lane 3 (local.get $v))))
+            )
+            ;; Clamps every lane of a 4 x i32 buffer to [lo, hi] in place
+            (func $clamp (param $h i32) (param $lo i32) (param $hi i32)
+                (v128.store (local.get $h) (i32.const 0)
+                    (i32x4.min_s (i32x4.max_s (v128.load (local.get $h) (i32.const 0))
+                                              (i32x4.splat (local.get $lo)))
+                                 (i32x4.splat (local.get $hi))))
+            )
+            ;; Number of lanes where a < b, counting the all-ones masks
+            (func $countLess (result i32)
+                (call $hsum (i32x4.neg (i32x4.lt_s
+                    (v128.const i32x4 1 -5 7 0)
+                    (v128.const i32x4 2 -6 8 0))))
+            )
+            (func $norm (result f64)
+                (local $v v128)
+                (local.set $v (f64x2.mul (v128.const f64x2 3 -4) (v128.const f64x2 3 -4)))
+                (f64.add (f64x2.extract_lane 0 (local.get $v)) (f64x2.extract_lane 1 (local.get $v)))
+            )
+            (func $lanes (result f32)
+                (f32x4.extract_lane 2
+                    (f32x4.sqrt (f32x4.abs
+                        (f32x4.replace_lane 2 (f32x4.splat (f32.const 1)) (f32.const -6.25)))))
+            )
+            (func $bits (result i32)
+                (i32x4.extract_lane 1
+                    (v128.xor (v128.const i32x4 0 255 0 0)
+                              (v128.andnot (v128.const i32x4 0 -1 0 0) (v128.const i32x4 0 15 0 0))))
+            )
+            (func $tee (result i32)
+                (local $v v128)
+                (i32x4.extract_lane 3 (local.tee $v (v128.const i32x4 1 2 3 4)))
+            )
+            (func $identity (param $v v128) (result v128) (local.get $v))
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+
+    int validated = 0;
+    for (size_t i = 0; i < compiled->functionCount(); ++i) {
+        if (compiled->function(i).validated) validated++;
+    }
+    std::cout << "Validated: " << validated << "/" << compiled->functionCount() << std::endl;
+
+    const int n = 8;
+    MemoryStore::Handle x = store.alloc(n * 4);
+    MemoryStore::Handle y = store.alloc(n * 4);
+    for (int i = 0; i < n; ++i) {
+        store.write<int32_t>(x, i * 4, i + 1);
+        store.write<int32_t>(y, i * 4, 10 - i);
+    }
+    std::cout << "dot = " << vm.run("dot", {WasmValue(x), WasmValue(y), WasmValue(n)}).i32 << std::endl;
+
+    vm.run("clamp", {WasmValue(x), WasmValue(2), WasmValue(3)});
+    std::cout << "clamp:";
+    for (int i = 0; i < 4; ++i) std::cout << " " << store.read<int32_t>(x, i * 4);
+    std::cout << std::endl;
+
+    std::cout << "countLess = " << vm.run("countLess", {}).i32 << std::endl;
+    std::cout << "norm = " << vm.run("norm", {}).f64 << std::endl;
+    std::cout << "lanes = " << vm.run("lanes", {}).f32 << std::endl;
+    std::cout << "bits = " << vm.run("bits", {}).i32 << std::endl;
+    std::cout << "tee = " << vm.run("tee", {}).i32 << std::endl;
+
+    try {
+        vm.run("identity", {WasmValue(0)});
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+    try {
+        MemoryStore::Handle small = store.alloc(8);
+        vm.run("clamp", {WasmValue(small), WasmValue(0), WasmValue(1)});
+    } catch (const std::exception& e) {
+        std::cout << "Caught out of bounds v128.load" << std::endl;
+    }
+    try {
+        Lexer bad("(module (func $f (result i32) (i32x4.extract_lane 4 (v128.const i32x4 0 0 0 0))))");
+        CompiledModule(Parser(bad).parse());
+    } catch (const std::exception& e) {
+        std::cout << "Caught: " << e.what() << std::endl;
+    }
+
+    std::cout << "Kernels match portable: " << (kernelsMatchPortable() ? "yes" : "no") << std::endl;
+    return 0;
+}
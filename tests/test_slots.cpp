@@ -0,0 +1,51 @@
+#include <iostream>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+const char* tagName(WasmValue::Type t) {
+    switch (t) {
+        case WasmValue::I32: return "i32";
+        case WasmValue::I64: return "i64";
+        case WasmValue::F32: return "f32";
+        case WasmValue::F64: return "f64";
+        default: return "void";
+    }
+}
+
+int main() {
+    std::string code = R"(
+        (module
+            (import "env" "scale" (func $scale (param f64 i64) (result f64)))
+            (func $wide (result i64) (i64.const 1234567890123))
+            (func $single (result f32) (f32.const 2.5))
+            (func $zeroed (result i64) (local $z i64) (local.get $z))
+            (func $viaHost (param $x f64) (result f64)
+                (call $scale (local.get $x) (i64.const 3))
+            )
+        )
+    )";
+
+    std::cout << "Slot size: " << sizeof(Slot) << " bytes" << std::endl;
+
+    Lexer lexer(code);
+    Module mod = Parser(lexer).parse();
+    MemoryStore store;
+    Interpreter vm(mod, store);
+    vm.registerHostFunction("env", "scale", [](std::vector<WasmValue>& args) {
+        // Arguments arrive tagged from the import's signature
+        std::cout << "host got " << tagName(args[0].type) << " " << args[0].f64 << ", "
+                  << tagName(args[1].type) << " " << args[1].i64 << std::endl;
+        return WasmValue(args[0].f64 * args[1].i64);
+    }, {"f64", "i64"}, {"f64"});
+
+    WasmValue wide = vm.run("wide", {});
+    std::cout << "wide() = " << tagName(wide.type) << " " << wide.i64 << std::endl;
+    WasmValue single = vm.run("single", {});
+    std::cout << "single() = " << tagName(single.type) << " " << single.f32 << std::endl;
+    WasmValue zeroed = vm.run("zeroed", {});
+    std::cout << "zeroed() = " << tagName(zeroed.type) << " " << zeroed.i64 << std::endl;
+    WasmValue viaHost = vm.run("viaHost", {WasmValue(1.5)});
+    std::cout << "viaHost(1.5) = " << tagName(viaHost.type) << " " << viaHost.f64 << std::endl;
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "StdioHost.h"
+
+const char* source = R"(
+    (module
+        (import "stdio" "write" (func $write (param i32 i32 i32)))
+        (import "stdio" "putchar" (func $putchar (param i32)))
+        (import "stdio" "flush" (func $flush))
+        (string $line "a log line
+")
+        (string $long "a message longer than the whole buffer
+")
+        ;; A string constant is its length, then the bytes. Both strings end
+        ;; in a newline.
+        (func $print (param $s i32)
+            (call $write (local.get $s) (i32.const 4) (call $length (local.get $s)))
+        )
+        (func $length (param $s i32) (result i32)
+            (i32.add
+                (i32.add (call $byte (local.get $s) (i32.const 0)) (i32.shl (call $byte (local.get $s) (i32.const 1)) (i32.const 8)))
+                (i32.shl (call $byte (local.get $s) (i32.const 2)) (i32.const 16)))
+        )
+        (import "env" "byte" (func $byte (param i32 i32) (result i32)))
+        (func $logLines (param $n i32)
+            (block $done
+                (loop $next
+                    (br_if $done (i32.eqz (local.get $n)))
+                    (call $print (string.const $line))
+                    (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                    (br $next)
+                )
+            )
+        )
+        (func $logLong (call $print (string.const $long)))
+        (func $chars
+            (call $putchar (i32.const 111))
+            (call $putchar (i32.const 107))
+            (call $putchar (i32.const 10))
+            (call $flush)
+        )
+        (func $outOfBounds (call $write (string.const $line) (i32.const 4) (i32.const 100)))
+    )
+)";
+
+std::shared_ptr<const CompiledModule> compiled;
+
+std::string readPipe(int fd) {
+    std::string out;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof buf)) > 0) out.append(buf, n);
+    return out;
+}
+
+int main() {
+    Lexer lexer(source);
+    compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+
+    // 1. Ten messages, ten host calls, one write to the stream
+    {
+        MemoryStore store;
+        std::ostringstream out;
+        StdioHost stdio(store, out);
+        Interpreter vm(compiled, store);
+        stdio.bind(vm);
+        vm.registerHostFunction("env", "byte", [&store](std::vector<WasmValue>& args) {
+            return WasmValue((int32_t)store.read<uint8_t>(args[0].i32, args[1].i32));
+        }, {"i32", "i32"}, {"i32"});
+        vm.run("logLines", {WasmValue(10)});
+        std::cout << "Before flush: " << out.str().size() << " bytes, " << stdio.sinkWrites() << " writes" << std::endl;
+        stdio.flush();
+        std::cout << "After flush: " << out.str().size() << " bytes, " << stdio.sinkWrites() << " writes" << std::endl;
+        vm.run("chars", {});
+        std::cout << "Explicit flush: " << out.str().substr(out.str().size() - 3, 2) << ", " << stdio.sinkWrites()
+                  << " writes" << std::endl;
+        try {
+            vm.run("outOfBounds", {});
+        } catch (const std::exception& e) {
+            std::cout << "Trap: " << e.what() << std::endl;
+        }
+    }
+
+    // 2. A file descriptor and a small buffer: what does not fit goes out
+    // with the buffered bytes in one writev
+    {
+        int fds[2];
+        if (pipe(fds) != 0) return 1;
+        MemoryStore store;
+        StdioOptions options;
+        options.bufferSize = 16;
+        std::string text;
+        {
+            StdioHost stdio(store, fds[1], options);
+            Interpreter vm(compiled, store);
+            stdio.bind(vm);
+            vm.registerHostFunction("env", "byte", [&store](std::vector<WasmValue>& args) {
+                return WasmValue((int32_t)store.read<uint8_t>(args[0].i32, args[1].i32));
+            }, {"i32", "i32"}, {"i32"});
+            vm.run("logLines", {WasmValue(1)});
+            vm.run("logLong", {});
+            std::cout << "fd: " << stdio.sinkWrites() << " writes of " << stdio.bytesWritten() << " bytes" << std::endl;
+            vm.run("logLines", {WasmValue(1)});
+            // Destruction flushes the rest
+        }
+        close(fds[1]);
+        text = readPipe(fds[0]);
+        close(fds[0]);
+        std::cout << text;
+    }
+
+    // 3. Line buffered: every message as soon as it ends
+    {
+        MemoryStore store;
+        std::ostringstream out;
+        StdioOptions options;
+        options.lineBuffered = true;
+        StdioHost stdio(store, out, options);
+        Interpreter vm(compiled, store);
+        stdio.bind(vm);
+        vm.registerHostFunction("env", "byte", [&store](std::vector<WasmValue>& args) {
+            return WasmValue((int32_t)store.read<uint8_t>(args[0].i32, args[1].i32));
+        }, {"i32", "i32"}, {"i32"});
+        vm.run("logLines", {WasmValue(3)});
+        std::cout << "Line buffered: " << stdio.sinkWrites() << " writes" << std::endl;
+    }
+    return 0;
+}
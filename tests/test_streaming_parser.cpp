@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+int main() {
+    std::string code = R"(
+        (module
+            (string $greeting "say \"hi\"")
+            (func $sum (param $n i32) (result i32)
+                (local $acc i32)
+                (block $done
+                    (loop $next
+                        (br_if $done (i32.eqz (local.get $n)))
+                        (local.set $acc (i32.add (local.get $acc) (local.get $n)))
+                        (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+                        (br $next)
+                    )
+                )
+                (local.get $acc)
+            )
+            (export "total" (func $sum))
+        )
+    )";
+
+    // Token text points into the caller's buffer; nothing is copied.
+    Lexer viewLexer(code);
+    bool zeroCopy = true;
+    for (Token t = viewLexer.next(); t.type != TokenType::END_OF_FILE; t = viewLexer.next()) {
+        if (t.text.data() < code.data() || t.text.data() + t.text.size() > code.data() + code.size()) {
+            zeroCopy = false;
+        }
+    }
+    std::cout << "Tokens view source: " << (zeroCopy ? "yes" : "no") << std::endl;
+
+    // Pull-based parsing must produce the same module as the token vector path.
+    Lexer streamLexer(code);
+    Module streamed = Parser(streamLexer).parse();
+    Lexer batchLexer(code);
+    Module batched = Parser(batchLexer.tokenize()).parse();
+
+    bool same = streamed.functions.size() == batched.functions.size() &&
+                streamed.functions[0].body.size() == batched.functions[0].body.size();
+    for (size_t i = 0; same && i < streamed.functions[0].body.size(); ++i) {
+        same = streamed.functions[0].body[i].opcode == batched.functions[0].body[i].opcode &&
+               streamed.functions[0].body[i].operand == batched.functions[0].body[i].operand;
+    }
+    std::cout << "Streamed matches batched: " << (same ? "yes" : "no") << std::endl;
+    std::cout << "String constant: " << streamed.strings[0].value << std::endl;
+    std::cout << "Export: " << streamed.exports[0].name << " -> " << streamed.exports[0].target << std::endl;
+
+    // Every opcode name resolves through the perfect hash; unknown names fall back to nop.
+    const char* names[] = {"i32.add", "i32.rotr", "call_indirect", "f64.div", "string.const", "br_if"};
+    bool allFound = true;
+    for (const char* name : names) {
+        if (Parser::mapOpcode(name) == Opcode::NOP) allFound = false;
+    }
+    std::cout << "Opcode lookup: " << (allFound ? "ok" : "missing") << std::endl;
+    std::cout << "Unknown maps to nop: " << (Parser::mapOpcode("i32.bogus") == Opcode::NOP ? "yes" : "no") << std::endl;
+
+    MemoryStore store;
+    Interpreter vm(streamed, store);
+    std::cout << "total(10) = " << vm.run("total", {WasmValue(10)}).i32 << std::endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "Parser.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+WasmValue host_alloc(MemoryStore* store, std::vector<WasmValue>& args) {
+    return WasmValue(store->alloc(args[0].i32));
+}
+
+WasmValue host_write_i32(MemoryStore* store, std::vector<WasmValue>& args) {
+    store->write<int32_t>(args[0].i32, args[1].i32, args[2].i32);
+    return WasmValue();
+}
+
+WasmValue host_read_i32(MemoryStore* store, std::vector<WasmValue>& args) {
+    return WasmValue(store->read<int32_t>(args[0].i32, args[1].i32));
+}
+
+int main() {
+    std::string code = R"(
+        (module
+            (import "env" "alloc" (func $alloc (param i32) (result i32)))
+            (import "env" "write_i32" (func $write_i32 (param i32 i32 i32)))
+            (import "env" "read_i32" (func $read_i32 (param i32 i32) (result i32)))
+
+            (func $fib (param $n i32) (result i32)
+                (local $r i32)
+                (local.set $r (local.get $n))
+                (block $done
+                    (br_if $done (i32.lt_s (local.get $n) (i32.const 2)))
+                    (local.set $r (i32.add
+                        (call $fib (i32.sub (local.get $n) (i32.const 1)))
+                        (call $fib (i32.sub (local.get $n) (i32.const 2)))))
+                )
+                (local.get $r)
+            )
+
+            ;; Round-trips fib(n) through this instance's own MemoryStore
+            (func $main (param $n i32) (result i32)
+                (local $h i32)
+                (local.set $h (call $alloc (i32.const 4)))
+                (call $write_i32 (local.get $h) (i32.const 0) (call $fib (local.get $n)))
+                (call $read_i32 (local.get $h) (i32.const 0))
+            )
+        )
+    )";
+
+    // Parse and compile once per process
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer.tokenize()).parse());
+
+    const int numThreads = 4;
+    const int runsPerThread = 3;
+    std::vector<int32_t> results(numThreads * runsPerThread, 0);
+    std::vector<std::string> errors(numThreads);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; ++t) {
+        workers.emplace_back([&, t]() {
+            try {
+                // Per-thread execution state over the shared code
+                MemoryStore store;
+                Interpreter vm(compiled, store);
+                using namespace std::placeholders;
+                vm.registerHostFunction("env", "alloc", std::bind(host_alloc, &store, _1), {"i32"}, {"i32"});
+                vm.registerHostFunction("env", "write_i32", std::bind(host_write_i32, &store, _1), {"i32", "i32", "i32"}, {});
+                vm.registerHostFunction("env", "read_i32", std::bind(host_read_i32, &store, _1), {"i32", "i32"}, {"i32"});
+
+                for (int r = 0; r < runsPerThread; ++r) {
+                    results[t * runsPerThread + r] = vm.run("main", {WasmValue(18 + r)}).i32;
+                }
+            } catch (const std::exception& e) {
+                errors[t] = e.what();
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    for (int t = 0; t < numThreads; ++t) {
+        if (!errors[t].empty()) {
+            std::cerr << "Thread " << t << " failed: " << errors[t] << std::endl;
+            return 1;
+        }
+    }
+
+    const int32_t expected[runsPerThread] = {2584, 4181, 6765};
+    for (int t = 0; t < numThreads; ++t) {
+        for (int r = 0; r < runsPerThread; ++r) {
+            if (results[t * runsPerThread + r] != expected[r]) {
+                std::cerr << "FAILED: thread " << t << " run " << r << " got " << results[t * runsPerThread + r] << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::cout << "Threads: " << numThreads << std::endl;
+    std::cout << "fib(18..20): " << expected[0] << " " << expected[1] << " " << expected[2] << std::endl;
+    std::cout << "SUCCESS" << std::endl;
+    return 0;
+}
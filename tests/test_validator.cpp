@@ -0,0 +1,85 @@
+#include <iostream>
+#include <memory>
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+void report(const CompiledModule& cm, const std::string& name) {
+    const CompiledFunction& cf = cm.function(cm.findFunction(name));
+    if (cf.validated) {
+        std::cout << name << ": valid, max stack depth " << cf.maxStackDepth << std::endl;
+    } else {
+        std::cout << name << ": " << cf.validationError << std::endl;
+    }
+}
+
+int main() {
+    std::string code = R"(
+        (module
+            (global $scale (mut f64) (f64.const 1.5))
+            (func $fib (param $n i32) (result i32)
+                (local $r i32)
+                (local.set $r (local.get $n))
+                (block $done
+                    (br_if $done (i32.lt_s (local.get $n) (i32.const 2)))
+                    (local.set $r (i32.add
+                        (call $fib (i32.sub (local.get $n) (i32.const 1)))
+                        (call $fib (i32.sub (local.get $n) (i32.const 2)))))
+                )
+                (local.get $r)
+            )
+            ;; Each iteration leaves an operand behind when it branches; the
+            ;; branch must discard it or the fixed-size frame would overflow.
+            (func $spin (param $n i32) (result i32)
+                (local $i i32)
+                (block $done
+                    (loop $next
+                        (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                        (i32.const 5)
+                        (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+                        (br $next)
+                    )
+                )
+                (local.get $i)
+            )
+            (func $scaled (param $x f64) (result f64)
+                (f64.mul (local.get $x) (global.get $scale))
+            )
+            (func $mixed (param $x i32) (result i32)
+                (f64.add (local.get $x) (f64.const 1.0))
+            )
+            (func $short (result i32)
+                (i32.add (i32.const 1))
+            )
+            (func $leftover (result i32)
+                (block $b (i32.const 1))
+                (i32.const 2)
+            )
+            (func $badcall (result i32)
+                (call $fib)
+            )
+        )
+    )";
+
+    Lexer lexer(code);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    for (const char* name : {"fib", "spin", "scaled", "mixed", "short", "leftover", "badcall"}) {
+        report(*compiled, name);
+    }
+
+    MemoryStore store;
+    Interpreter vm(compiled, store);
+    std::cout << "fib(20) = " << vm.run("fib", {WasmValue(20)}).i32 << std::endl;
+    std::cout << "spin(100000) = " << vm.run("spin", {WasmValue(100000)}).i32 << std::endl;
+    std::cout << "scaled(4) = " << vm.run("scaled", {WasmValue(4.0)}).f64 << std::endl;
+
+    // Functions that fail validation still run, with runtime checks
+    try {
+        vm.run("short", {});
+        std::cout << "FAILED: expected underflow" << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cout << "short() trapped: " << e.what() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <iostream>
+#include <functional>
+#include "WasmDecoder.h"
+#include "ModuleSerializer.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+
+// Hand-assembled module equivalent to:
+//
+// (module
+//   (type (func (param i32 i32) (result i32)))          ;; 0
+//   (type (func (result i32)))                          ;; 1
+//   (import "env" "add" (func (type 0)))                ;; func 0
+//   (import "env" "read_i32" (func (type 0)))           ;; func 1
+//   (table 2 funcref)
+//   (global (mut i32) (i32.const 5))
+//   (export "main" (func 2)) (export "sum" (func 4))
+//   (export "greet" (func 5)) (export "early" (func 6))
+//   (elem (i32.const 0) 3 2)
+//   (func (type 1) i32.const 10 i32.const 32 call 0)    ;; 2: main
+//   (func $mul (type 0) local.get 0 local.get 1 i32.mul) ;; 3
+//   (func (type 1) (local $i i32) (local $acc i32)      ;; 4: sum of i * g
+//     block loop
+//       local.get 0 i32.const 10 i32.ge_s br_if 1
+//       local.get 1 local.get 0 global.get 0 i32.const 0 call_indirect (type 0)
+//       i32.add local.set 1
+//       local.get 0 i32.const 1 i32.add local.tee 0 local.set 0
+//       br 0
+//     end end
+//     local.get 1)
+//   (func (type 1) string.const 0 i32.const 0 call 1)   ;; 5: length of "wasm"
+//   (func (type 1) i32.const 7 return i32.const 9))     ;; 6
+std::vector<uint8_t> buildModule() {
+    ByteWriter out;
+    const uint8_t header[] = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+    out.bytes.assign(header, header + 8);
+
+    auto section = [&out](uint8_t id, const std::vector<uint8_t>& payload) {
+        out.u8(id);
+        out.uleb(payload.size());
+        out.bytes.insert(out.bytes.end(), payload.begin(), payload.end());
+    };
+    auto func = [](std::vector<uint8_t> locals, std::vector<uint8_t> code) {
+        ByteWriter body;
+        body.bytes = locals;
+        body.bytes.insert(body.bytes.end(), code.begin(), code.end());
+        ByteWriter f;
+        f.uleb(body.bytes.size());
+        f.bytes.insert(f.bytes.end(), body.bytes.begin(), body.bytes.end());
+        return f.bytes;
+    };
+
+    section(1, {0x02, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f, 0x60, 0x00, 0x01, 0x7f});
+
+    ByteWriter imports;
+    imports.uleb(2);
+    imports.str("env"); imports.str("add"); imports.u8(0x00); imports.uleb(0);
+    imports.str("env"); imports.str("read_i32"); imports.u8(0x00); imports.uleb(0);
+    section(2, imports.bytes);
+
+    section(3, {0x05, 0x01, 0x00, 0x01, 0x01, 0x01});
+    section(4, {0x01, 0x70, 0x00, 0x02});
+    section(6, {0x01, 0x7f, 0x01, 0x41, 0x05, 0x0b});
+
+    ByteWriter exports;
+    exports.uleb(4);
+    exports.str("main"); exports.u8(0x00); exports.uleb(2);
+    exports.str("sum"); exports.u8(0x00); exports.uleb(4);
+    exports.str("greet"); exports.u8(0x00); exports.uleb(5);
+    exports.str("early"); exports.u8(0x00); exports.uleb(6);
+    section(7, exports.bytes);
+
+    section(9, {0x01, 0x00, 0x41, 0x00, 0x0b, 0x02, 0x03, 0x02});
+
+    ByteWriter strings;
+    strings.str("optrich.strings");
+    strings.uleb(1);
+    strings.str("msg"); strings.str("wasm");
+    section(0, strings.bytes);
+
+    ByteWriter code;
+    code.uleb(5);
+    std::vector<std::vector<uint8_t>> bodies = {
+        func({0x00}, {0x41, 0x0a, 0x41, 0x20, 0x10, 0x00, 0x0b}),
+        func({0x00}, {0x20, 0x00, 0x20, 0x01, 0x6c, 0x0b}),
+        func({0x01, 0x02, 0x7f}, {
+            0x02, 0x40, 0x03, 0x40,
+            0x20, 0x00, 0x41, 0x0a, 0x4e, 0x0d, 0x01,
+            0x20, 0x01, 0x20, 0x00, 0x23, 0x00, 0x41, 0x00, 0x11, 0x00, 0x00,
+            0x6a, 0x21, 0x01,
+            0x20, 0x00, 0x41, 0x01, 0x6a, 0x22, 0x00, 0x21, 0x00,
+            0x0c, 0x00,
+            0x0b, 0x0b,
+            0x20, 0x01, 0x0b}),
+        func({0x00}, {WasmDecoder::kStringConstOpcode, 0x00, 0x41, 0x00, 0x10, 0x01, 0x0b}),
+        func({0x00}, {0x41, 0x07, 0x0f, 0x41, 0x09, 0x0b}),
+    };
+    for (const auto& b : bodies) code.bytes.insert(code.bytes.end(), b.begin(), b.end());
+    section(10, code.bytes);
+
+    ByteWriter names;
+    names.str("name");
+    ByteWriter funcNames;
+    funcNames.uleb(1);
+    funcNames.uleb(3); funcNames.str("mul");
+    names.u8(1); names.uleb(funcNames.bytes.size());
+    names.bytes.insert(names.bytes.end(), funcNames.bytes.begin(), funcNames.bytes.end());
+    ByteWriter localNames;
+    localNames.uleb(1);
+    localNames.uleb(4); localNames.uleb(2);
+    localNames.uleb(0); localNames.str("i");
+    localNames.uleb(1); localNames.str("acc");
+    names.u8(2); names.uleb(localNames.bytes.size());
+    names.bytes.insert(names.bytes.end(), localNames.bytes.begin(), localNames.bytes.end());
+    section(0, names.bytes);
+
+    return out.bytes;
+}
+
+WasmValue host_add(std::vector<WasmValue>& args) {
+    return WasmValue(args[0].i32 + args[1].i32);
+}
+
+WasmValue host_read_i32(MemoryStore* store, std::vector<WasmValue>& args) {
+    return WasmValue(store->read<int32_t>(args[0].i32, args[1].i32));
+}
+
+int main() {
+    try {
+        std::vector<uint8_t> wasm = buildModule();
+
+        // 1. Whole buffer
+        Module mod = WasmDecoder::decode(wasm.data(), wasm.size());
+        std::cout << "Imports: " << mod.imports.size() << ", functions: " << mod.functions.size()
+                  << ", exports: " << mod.exports.size() << std::endl;
+        std::cout << "Names: " << mod.functions[0].name << " " << mod.functions[1].name << " "
+                  << mod.functions[2].name << " (locals " << mod.functions[2].localNames[0]
+                  << ", " << mod.functions[2].localNames[1] << ")" << std::endl;
+
+        // 2. Streaming one byte at a time yields the same module
+        WasmDecoder streaming;
+        for (uint8_t b : wasm) streaming.feed(&b, 1);
+        Module streamed = streaming.finish();
+        bool same = ModuleWriter(streamed).write() == ModuleWriter(mod).write();
+        std::cout << "Streamed module identical: " << (same ? "yes" : "no") << std::endl;
+
+        // 3. Execute
+        MemoryStore store;
+        Interpreter vm(std::make_shared<const CompiledModule>(std::move(mod)), store);
+        using namespace std::placeholders;
+        vm.registerHostFunction("env", "add", host_add, {"i32", "i32"}, {"i32"});
+        vm.registerHostFunction("env", "read_i32", std::bind(host_read_i32, &store, _1), {"i32", "i32"}, {"i32"});
+        std::cout << "main: " << vm.run("main", {}).i32 << std::endl;
+        std::cout << "mul: " << vm.run("mul", {WasmValue(6), WasmValue(7)}).i32 << std::endl;
+        std::cout << "sum: " << vm.run("sum", {}).i32 << std::endl;
+        std::cout << "greet: " << vm.run("greet", {}).i32 << std::endl;
+        std::cout << "early: " << vm.run("early", {}).i32 << std::endl;
+
+        // 4. Truncated input
+        try {
+            WasmDecoder partial;
+            partial.feed(wasm.data(), wasm.size() - 3);
+            partial.finish();
+            std::cerr << "FAILED: truncated module accepted" << std::endl;
+            return 1;
+        } catch (const std::runtime_error& e) {
+            std::cout << "Caught: " << e.what() << std::endl;
+        }
+
+        // 5. An export of function 7 in a module without functions
+        try {
+            const uint8_t exportOnly[] = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,
+                                          0x07, 0x05, 0x01, 0x01, 'f', 0x00, 0x07};
+            WasmDecoder::decode(exportOnly, sizeof exportOnly);
+            std::cerr << "FAILED: malformed export accepted" << std::endl;
+            return 1;
+        } catch (const std::runtime_error& e) {
+            std::cout << "Caught: " << e.what() << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Runtime Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
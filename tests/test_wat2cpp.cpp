@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include "Lexer.h"
+#include "Parser.h"
+#include "CompiledModule.h"
+#include "Interpreter.h"
+#include "MemoryStore.h"
+#include "NativeModule.h"
+#include "WasmDecoder.h"
+
+// Linked against native/*.o, which make generates with wat2cpp from
+// testdata/*.wat, testdata/*.wasm and tests/test_wat2cpp.wat.
+
+namespace fs = std::filesystem;
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+// The env imports run_testdata gives every module
+template <typename Instance>
+void registerStandardHostFunctions(Instance& vm, MemoryStore& store) {
+    MemoryStore* s = &store;
+    vm.registerHostFunction("env", "alloc", [s](std::vector<WasmValue>& args) {
+        return WasmValue(s->alloc(args[0].i32));
+    }, {"i32"}, {"i32"});
+    vm.registerHostFunction("env", "make_span", [s](std::vector<WasmValue>& args) {
+        return WasmValue(s->make_span(args[0].i32, args[1].i32, args[2].i32));
+    }, {"i32", "i32", "i32"}, {"i32"});
+    vm.registerHostFunction("env", "write_i32", [s](std::vector<WasmValue>& args) {
+        s->write<int32_t>(args[0].i32, args[1].i32, args[2].i32);
+        return WasmValue();
+    }, {"i32", "i32", "i32"}, {});
+    vm.registerHostFunction("env", "read_i32", [s](std::vector<WasmValue>& args) {
+        return WasmValue(s->read<int32_t>(args[0].i32, args[1].i32));
+    }, {"i32", "i32"}, {"i32"});
+    vm.registerHostFunction("env", "write_u8", [s](std::vector<WasmValue>& args) {
+        s->write<uint8_t>(args[0].i32, args[1].i32, static_cast<uint8_t>(args[2].i32));
+        return WasmValue();
+    }, {"i32", "i32", "i32"}, {});
+    vm.registerHostFunction("env", "read_u8", [s](std::vector<WasmValue>& args) {
+        return WasmValue(static_cast<int32_t>(s->read<uint8_t>(args[0].i32, args[1].i32)));
+    }, {"i32", "i32"}, {"i32"});
+    vm.registerHostFunction("env", "putchar", [](std::vector<WasmValue>& args) {
+        std::cout << (char)args[0].i32;
+        return WasmValue();
+    }, {"i32"}, {});
+}
+
+// A testdata main_* program with its lib_* imports, all native
+std::string runNative(const fs::path& mainPath) {
+    std::streambuf* oldCout = std::cout.rdbuf();
+    std::stringstream capture;
+    std::cout.rdbuf(capture.rdbuf());
+    try {
+        MemoryStore store;
+        auto mainVM = NativeModule::create(mainPath.stem().string(), store);
+        registerStandardHostFunctions(*mainVM, store);
+
+        Module mod;
+        std::string source = readFile(mainPath);
+        if (mainPath.extension() == ".wasm") {
+            mod = WasmDecoder::decodeFile(mainPath.string());
+        } else {
+            Lexer lexer(source);
+            mod = Parser(lexer).parse();
+        }
+        std::map<std::string, std::unique_ptr<NativeModule>> libs;
+        for (const auto& imp : mod.imports) {
+            if (imp.module == "env") continue;
+            auto& lib = libs[imp.module];
+            if (!lib) {
+                lib = NativeModule::create("lib_" + imp.module, store);
+                registerStandardHostFunctions(*lib, store);
+            }
+            NativeModule* libVM = lib.get();
+            std::string funcName = imp.field;
+            mainVM->registerHostFunction(imp.module, imp.field, [libVM, funcName](std::vector<WasmValue>& args) {
+                return libVM->run(funcName, args);
+            }, imp.paramTypes, imp.resultTypes);
+        }
+        WasmValue res = mainVM->run("main", {});
+        std::cout << "Result: " << res.i32 << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Trap: " << e.what() << std::endl;
+    }
+    std::cout.rdbuf(oldCout);
+    return capture.str();
+}
+
+template <typename Instance>
+std::string call(Instance& vm, const std::string& func, std::vector<WasmValue> args) {
+    try {
+        WasmValue res = vm.run(func, args);
+        std::ostringstream out;
+        switch (res.type) {
+            case WasmValue::F64: out << res.f64; break;
+            case WasmValue::VOID: out << "void"; break;
+            default: out << res.i32; break;
+        }
+        return out.str();
+    } catch (const std::exception& e) {
+        return std::string("trap: ") + e.what();
+    }
+}
+
+int main() {
+    // 1. The testdata programs against their expected output
+    std::vector<fs::path> mains;
+    for (const auto& entry : fs::directory_iterator("testdata")) {
+        std::string ext = entry.path().extension().string();
+        if (entry.path().filename().string().rfind("main_", 0) == 0 && (ext == ".wat" || ext == ".wasm")) {
+            mains.push_back(entry.path());
+        }
+    }
+    std::sort(mains.begin(), mains.end());
+    for (const auto& path : mains) {
+        fs::path expected = path;
+        expected.replace_extension(".expected_stdout");
+        std::string actual = runNative(path);
+        std::cout << (actual == readFile(expected) ? "[PASS] " : "[FAIL] ") << path.filename().string() << std::endl;
+        if (actual != readFile(expected)) std::cout << actual;
+    }
+
+    // 2. Native and interpreted runs of the same module agree
+    std::string source = readFile("tests/test_wat2cpp.wat");
+    Lexer lexer(source);
+    auto compiled = std::make_shared<const CompiledModule>(Parser(lexer).parse());
+    MemoryStore store;
+    Interpreter interp(compiled, store);
+    auto native = NativeModule::create("test_wat2cpp", store);
+    std::ostringstream logged;
+    auto log = [&logged](std::vector<WasmValue>& args) {
+        logged << args[0].i32 << " ";
+        return WasmValue(args[0].i32 * 10);
+    };
+    interp.registerHostFunction("env", "log", log, {"i32"}, {"i32"});
+    native->registerHostFunction("env", "log", log, {"i32"}, {"i32"});
+
+    const int n = 8;
+    MemoryStore::Handle x = store.alloc(n * 4);
+    MemoryStore::Handle y = store.alloc(n * 4);
+    for (int i = 0; i < n; ++i) {
+        store.write<int32_t>(x, i * 4, i + 1);
+        store.write<int32_t>(y, i * 4, 10 - i);
+    }
+
+    struct Case {
+        const char* func;
+        std::vector<WasmValue> args;
+    };
+    std::vector<Case> cases = {
+        {"apply", {WasmValue(0), WasmValue(7), WasmValue(5)}},
+        {"apply", {WasmValue(1), WasmValue(7), WasmValue(5)}},
+        {"apply", {WasmValue(2), WasmValue(7), WasmValue(5)}},
+        {"apply", {WasmValue(3), WasmValue(7), WasmValue(5)}},
+        {"apply", {WasmValue(-1), WasmValue(7), WasmValue(5)}},
+        {"calls", {}},
+        {"machine", {WasmValue(0x31121)}},
+        {"machine", {WasmValue(0x4f2211)}},
+        {"bits", {WasmValue(0x12345678), WasmValue(5)}},
+        {"bits", {WasmValue(-3), WasmValue(31)}},
+        {"bits", {WasmValue(0), WasmValue(0)}},
+        {"divide", {WasmValue(-17), WasmValue(5)}},
+        {"divide", {WasmValue(1), WasmValue(0)}},
+        {"divide", {WasmValue(INT32_MIN), WasmValue(-1)}},
+        {"never", {}},
+        {"echo", {WasmValue(4)}},
+        {"mean", {WasmValue(3.0), WasmValue(4.5)}},
+        {"dot", {WasmValue(x), WasmValue(y), WasmValue(n)}},
+        {"lanes", {}},
+        {"hsum", {}},
+        {"missing", {}},
+    };
+    int agreed = 0;
+    for (const auto& c : cases) {
+        std::string expected = call(interp, c.func, c.args);
+        std::string actual = call(*native, c.func, c.args);
+        if (expected == actual) agreed++;
+        else std::cout << "MISMATCH ";
+        std::cout << c.func << " = " << actual << std::endl;
+    }
+    std::cout << "Agreed: " << agreed << "/" << cases.size() << std::endl;
+    std::cout << "Host saw: " << logged.str() << std::endl;
+
+    MemoryStore::Handle greeting = native->run("greeting", {}).i32;
+    int32_t len = store.read<int32_t>(greeting, 0);
+    std::string text;
+    for (int32_t i = 0; i < len; ++i) text += (char)store.read<uint8_t>(greeting, 4 + i);
+    std::cout << "greeting = " << text << std::endl;
+    return 0;
+}
@@ -0,0 +1,130 @@
+;; Compiled ahead of time by wat2cpp for test_wat2cpp, which runs every
+;; function here both natively and in the Interpreter.
+(module
+  (import "env" "log" (func $log (param i32) (result i32)))
+  (type $t_ii (func (param i32 i32) (result i32)))
+  (type $t_i (func (param i32) (result i32)))
+
+  (table 4 funcref)
+  (elem (i32.const 0) $add $sub $twice)
+
+  (global $calls (mut i32) (i32.const 0))
+  (global $scale f64 (f64.const 0.5))
+
+  (func $add (param $a i32) (param $b i32) (result i32) (i32.add (local.get $a) (local.get $b)))
+  (func $sub (param $a i32) (param $b i32) (result i32) (i32.sub (local.get $a) (local.get $b)))
+  (func $twice (param $a i32) (result i32) (i32.mul (local.get $a) (i32.const 2)))
+
+  ;; Table index k applied to (a, b); a wrong type traps
+  (func $apply (param $k i32) (param $a i32) (param $b i32) (result i32)
+    (global.set $calls (i32.add (global.get $calls) (i32.const 1)))
+    (call_indirect (type $t_ii) (local.get $a) (local.get $b) (local.get $k))
+  )
+  (func $calls (result i32) (global.get $calls))
+
+  ;; The bytecode machine of test_control_flow
+  (func $machine (param $program i32) (result i32)
+    (local $acc i32)
+    (local $op i32)
+    (block $halt
+      (loop $step
+        (local.set $op (i32.and (local.get $program) (i32.const 15)))
+        (local.set $program (i32.shr_u (local.get $program) (i32.const 4)))
+        (block $skip
+          (block $neg
+            (block $double
+              (block $inc
+                (br_table $halt $inc $double $neg $skip (local.get $op))
+              )
+              (local.set $acc (i32.add (local.get $acc) (i32.const 1)))
+              (br $step)
+            )
+            (local.set $acc (i32.mul (local.get $acc) (i32.const 2)))
+            (br $step)
+          )
+          (local.set $acc (i32.sub (i32.const 0) (local.get $acc)))
+          (br $step)
+        )
+        (br $step)
+      )
+    )
+    (local.get $acc)
+  )
+
+  ;; Mixes every i32 operator into one value
+  (func $bits (param $a i32) (param $b i32) (result i32)
+    (local $r i32)
+    (local.set $r (i32.xor (i32.rotl (local.get $a) (local.get $b)) (i32.rotr (local.get $b) (local.get $a))))
+    (local.set $r (i32.add (local.get $r) (i32.clz (local.get $a))))
+    (local.set $r (i32.add (local.get $r) (i32.ctz (local.get $b))))
+    (local.set $r (i32.add (local.get $r) (i32.popcnt (i32.or (local.get $a) (local.get $b)))))
+    (local.set $r (i32.add (local.get $r) (i32.shr_s (local.get $a) (local.get $b))))
+    (local.set $r (i32.sub (local.get $r) (i32.shl (local.get $b) (local.get $a))))
+    (local.set $r (i32.add (local.get $r) (i32.lt_u (local.get $a) (local.get $b))))
+    (local.set $r (i32.add (local.get $r) (i32.ge_s (local.get $a) (local.get $b))))
+    (local.set $r (i32.add (local.get $r) (i32.eqz (i32.and (local.get $a) (local.get $b)))))
+    (if (i32.gt_u (local.get $a) (local.get $b))
+      (then (local.set $r (i32.mul (local.get $r) (i32.const 3))))
+      (else (local.set $r (i32.sub (local.get $r) (i32.const 7)))))
+    (local.get $r)
+  )
+
+  ;; Traps on b = 0 and on INT32_MIN / -1
+  (func $divide (param $a i32) (param $b i32) (result i32)
+    (i32.add (i32.div_s (local.get $a) (local.get $b)) (i32.rem_u (local.get $a) (local.get $b)))
+  )
+  (func $never (result i32) (unreachable))
+
+  ;; Each number through the host, summing what it returns
+  (func $echo (param $n i32) (result i32)
+    (local $sum i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.eqz (local.get $n)))
+        (local.set $sum (i32.add (local.get $sum) (call $log (local.get $n))))
+        (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+        (br $next)
+      )
+    )
+    (local.get $sum)
+  )
+
+  (func $mean (param $a f64) (param $b f64) (result f64)
+    (f64.mul (f64.add (local.get $a) (local.get $b)) (global.get $scale))
+  )
+
+  ;; Sum of x[i] * y[i] over n elements, n a multiple of 4
+  (func $dot (param $x i32) (param $y i32) (param $n i32) (result i32)
+    (local $acc v128)
+    (local $i i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.ge_s (local.get $i) (local.get $n)))
+        (local.set $acc (i32x4.add (local.get $acc)
+          (i32x4.mul
+            (v128.load (local.get $x) (i32.mul (local.get $i) (i32.const 4)))
+            (v128.load (local.get $y) (i32.mul (local.get $i) (i32.const 4))))))
+        (local.set $i (i32.add (local.get $i) (i32.const 4)))
+        (br $next)
+      )
+    )
+    (call $hsum (local.get $acc))
+  )
+  (func $hsum (param $v v128) (result i32)
+    (i32.add
+      (i32.add (i32x4.extract_lane 0 (local.get $v)) (i32x4.extract_lane 1 (local.get $v)))
+      (i32.add (i32x4.extract_lane 2 (local.get $v)) (i32x4.extract_lane 3 (local.get $v))))
+  )
+  (func $lanes (result f64)
+    (local $v v128)
+    (local.set $v (f64x2.mul (v128.const f64x2 3 -4) (f64x2.splat (f64.const 1.5))))
+    (f64.add
+      (f64x2.extract_lane 0 (local.get $v))
+      (f64.add (f64x2.extract_lane 1 (local.get $v))
+               (f64x2.extract_lane 0 (f64x2.sqrt (f64x2.replace_lane 0 (local.get $v) (f64.const 6.25))))))
+  )
+  (string $hello "native")
+  (func $greeting (result i32) (string.const $hello))
+
+  (export "apply" (func $apply))
+)
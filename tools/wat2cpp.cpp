@@ -0,0 +1,69 @@
+// Compiles a module ahead of time: reads a .wat or .wasm file and writes a
+// C++ translation unit that, linked with the runtime, registers the module
+// under NativeModule::create(name).
+//
+//   wat2cpp <in.wat|in.wasm> [-o out.cpp] [--name NAME]
+//
+// NAME defaults to the input file's stem, so testdata/lib_math.wat becomes
+// "lib_math". Without -o the code goes to stdout.
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "CompiledModule.h"
+#include "CppEmitter.h"
+#include "Lexer.h"
+#include "MappedFile.h"
+#include "Parser.h"
+#include "WasmDecoder.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    std::string input, output, name;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (input.empty()) {
+            input = arg;
+        } else {
+            input.clear();
+            break;
+        }
+    }
+    if (input.empty()) {
+        std::cerr << "usage: wat2cpp <in.wat|in.wasm> [-o out.cpp] [--name NAME]" << std::endl;
+        return 2;
+    }
+    if (name.empty()) name = fs::path(input).stem().string();
+
+    try {
+        Module mod;
+        if (fs::path(input).extension() == ".wasm") {
+            mod = WasmDecoder::decodeFile(input);
+        } else {
+            MappedFile file(input);
+            Lexer lexer(std::string_view(reinterpret_cast<const char*>(file.data()), file.size()));
+            mod = Parser(lexer).parse();
+        }
+        CompiledModule compiled(std::move(mod));
+        std::string code = CppEmitter(compiled).emit(name);
+
+        if (output.empty()) {
+            std::cout << code;
+        } else {
+            std::ofstream out(output);
+            if (!out) throw std::runtime_error("Could not open file: " + output);
+            out << code;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "wat2cpp: " << input << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}